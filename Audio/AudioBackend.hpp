@@ -0,0 +1,253 @@
+#pragma once
+#ifndef WILDCAT_AUDIO_AUDIO_BACKEND_HPP
+#define WILDCAT_AUDIO_AUDIO_BACKEND_HPP
+
+/* Wildcat: AudioBackend
+	#include <Audio/AudioBackend.hpp>
+
+	The calls AudioVoiceManager needs from an audio library: PCM buffers, sources which play them, and whether a
+	source is still playing. AudioStream also queues buffers on a source, and refills them once they have played.
+	AudioPlayer_OpenAL provides an OpenAL backend.
+
+	AudioBackend_Null is a loopback backend which doesn't need a sound card. Buffers keep a copy of the PCM data like
+	a real device would, sources play for the length of their sound, in time given to advance(), and every call is
+	counted. It allows the voice manager to be tested and benchmarked headlessly, and is a fallback if no audio
+	device can be opened.
+*/
+
+#include <Audio/Sound.hpp>
+#include <Container/Vector/Vector.hpp>
+
+#include <vector>
+
+class AudioBackend
+{
+	public:
+
+	virtual ~AudioBackend() {}
+
+	/* Upload the sound's PCM data. Returns 0 if it couldn't be done. */
+	virtual unsigned int createBuffer(Sound*)=0;
+	virtual void deleteBuffer(unsigned int)=0;
+
+	/* A buffer for fillBuffer(). Returns 0 if it couldn't be made. */
+	virtual unsigned int createEmptyBuffer()=0;
+	/* Replace a buffer's PCM data. The buffer must not be attached to or queued on a source. */
+	virtual bool fillBuffer(unsigned int /* buffer */, const char* /* data */, int /* nBytes */, int /* nChannels */,
+		int /* bitsPerSample */, int /* samplesPerSecond */)=0;
+
+	/* Returns 0 if no more sources can be made. */
+	virtual unsigned int createSource()=0;
+	virtual void deleteSource(unsigned int)=0;
+
+	virtual void setBuffer(unsigned int /* source */, unsigned int /* buffer */)=0;
+	virtual void setGain(unsigned int /* source */, float)=0;
+	virtual void setLooping(unsigned int /* source */, bool)=0;
+	virtual void play(unsigned int /* source */)=0;
+	virtual void stop(unsigned int /* source */)=0;
+	virtual bool isPlaying(unsigned int /* source */)=0;
+
+	/* Add a buffer to the end of a source's queue. A source with queued buffers plays them in order. */
+	virtual void queueBuffer(unsigned int /* source */, unsigned int /* buffer */)=0;
+	/* Take a buffer which has finished playing off the front of the queue. Returns 0 if there isn't one. */
+	virtual unsigned int unqueueBuffer(unsigned int /* source */)=0;
+};
+
+class AudioBackend_Null: public AudioBackend
+{
+	private:
+
+	class NullSource
+	{
+		public:
+		unsigned int buffer;
+		bool playing;
+		bool looping;
+		double secondsLeft; // of the buffer, or the front of the queue
+		std::vector <unsigned int> vQueue;
+		std::vector <unsigned int> vProcessed;
+	};
+
+	Vector <double> vBufferSeconds; // index is buffer id - 1. Negative once deleted.
+	std::vector < std::vector <char> > vBufferData;
+	Vector <NullSource> vSource; // index is source id - 1.
+
+	public:
+
+	int maxSources;
+
+	/* Counts of calls, for tests and benchmarks. */
+	unsigned long int nBuffersCreated;
+	unsigned long int nBuffersDeleted;
+	unsigned long int nSourcesCreated;
+	unsigned long int bytesUploaded;
+	unsigned long int nSetBuffer;
+	unsigned long int nPlays;
+
+	AudioBackend_Null()
+	{
+		maxSources=256;
+		nBuffersCreated=0;
+		nBuffersDeleted=0;
+		nSourcesCreated=0;
+		bytesUploaded=0;
+		nSetBuffer=0;
+		nPlays=0;
+	}
+
+	/* Length of a sound's PCM data in seconds. */
+	static double soundSeconds(const Sound* _sound)
+	{
+		const int bytesPerFrame = _sound->nChannels*_sound->bitsPerSample/8;
+		if ( bytesPerFrame<=0 || _sound->samplesPerSecond<=0 ) { return 0; }
+		return (double)_sound->nData/bytesPerFrame/_sound->samplesPerSecond;
+	}
+
+	unsigned int createBuffer(Sound* _sound) override
+	{
+		const unsigned int buffer = createEmptyBuffer();
+		fillBuffer(buffer,_sound->data,_sound->nData,_sound->nChannels,_sound->bitsPerSample,_sound->samplesPerSecond);
+		return buffer;
+	}
+	void deleteBuffer(const unsigned int _buffer) override
+	{
+		if ( _buffer==0 || (int)_buffer>vBufferSeconds.size() ) { return; }
+		vBufferSeconds(_buffer-1)=-1;
+		std::vector <char>().swap(vBufferData[_buffer-1]);
+		++nBuffersDeleted;
+	}
+
+	unsigned int createEmptyBuffer() override
+	{
+		vBufferSeconds.push(0);
+		vBufferData.push_back(std::vector <char> ());
+		++nBuffersCreated;
+		return vBufferSeconds.size();
+	}
+	bool fillBuffer(const unsigned int _buffer, const char* _data, const int _nBytes, const int _nChannels,
+		const int _bitsPerSample, const int _samplesPerSecond) override
+	{
+		if ( isBuffer(_buffer)==false ) { return false; }
+		const int bytesPerFrame = _nChannels*_bitsPerSample/8;
+		vBufferSeconds(_buffer-1) = bytesPerFrame<=0 || _samplesPerSecond<=0 ? 0 :
+			(double)_nBytes/bytesPerFrame/_samplesPerSecond;
+		vBufferData[_buffer-1].assign(_data,_data+_nBytes);
+		bytesUploaded+=_nBytes;
+		return true;
+	}
+
+	/* Whether a buffer has been made and not deleted. */
+	bool isBuffer(const unsigned int _buffer)
+	{
+		return _buffer!=0 && (int)_buffer<=vBufferSeconds.size() && vBufferSeconds(_buffer-1)>=0;
+	}
+	/* Bytes of PCM data held in buffers. */
+	unsigned long int bytesHeld()
+	{
+		unsigned long int bytes=0;
+		for (unsigned int i=0;i<vBufferData.size();++i)
+		{ bytes+=vBufferData[i].size(); }
+		return bytes;
+	}
+
+	unsigned int createSource() override
+	{
+		if ( vSource.size()>=maxSources ) { return 0; }
+		NullSource source;
+		source.buffer=0;
+		source.playing=false;
+		source.looping=false;
+		source.secondsLeft=0;
+		vSource.push(source);
+		++nSourcesCreated;
+		return vSource.size();
+	}
+	void deleteSource(const unsigned int _source) override
+	{
+		if ( _source==0 || (int)_source>vSource.size() ) { return; }
+		vSource(_source-1).playing=false;
+	}
+
+	void setBuffer(const unsigned int _source, const unsigned int _buffer) override
+	{
+		vSource(_source-1).buffer=_buffer;
+		vSource(_source-1).vQueue.clear();
+		vSource(_source-1).vProcessed.clear();
+		++nSetBuffer;
+	}
+	void setGain(const unsigned int /* _source */, const float /* _gain */) override
+	{
+	}
+	void setLooping(const unsigned int _source, const bool _looping) override
+	{
+		vSource(_source-1).looping=_looping;
+	}
+	void play(const unsigned int _source) override
+	{
+		NullSource& source = vSource(_source-1);
+		if ( source.vQueue.empty()==false )
+		{
+			source.playing=true;
+			source.secondsLeft=vBufferSeconds(source.vQueue[0]-1);
+		}
+		else
+		{
+			source.playing = isBuffer(source.buffer);
+			source.secondsLeft = source.playing ? vBufferSeconds(source.buffer-1) : 0;
+		}
+		++nPlays;
+	}
+	void stop(const unsigned int _source) override
+	{
+		NullSource& source = vSource(_source-1);
+		source.playing=false;
+		// Like OpenAL, stopping a source marks all its queued buffers as played.
+		source.vProcessed.insert(source.vProcessed.end(),source.vQueue.begin(),source.vQueue.end());
+		source.vQueue.clear();
+	}
+	bool isPlaying(const unsigned int _source) override
+	{
+		return vSource(_source-1).playing;
+	}
+
+	void queueBuffer(const unsigned int _source, const unsigned int _buffer) override
+	{
+		vSource(_source-1).vQueue.push_back(_buffer);
+	}
+	unsigned int unqueueBuffer(const unsigned int _source) override
+	{
+		NullSource& source = vSource(_source-1);
+		if ( source.vProcessed.empty() ) { return 0; }
+		const unsigned int buffer = source.vProcessed[0];
+		source.vProcessed.erase(source.vProcessed.begin());
+		return buffer;
+	}
+
+	/* Move time forward. Sources which reach the end of their sound stop, unless they loop. Sources with a queue
+		move on to the next buffer, and stop if they run out. */
+	void advance(const double _seconds)
+	{
+		for (int i=0;i<vSource.size();++i)
+		{
+			NullSource& source = vSource(i);
+			if ( source.playing==false ) { continue; }
+			if ( source.vQueue.empty() )
+			{
+				if ( source.looping ) { continue; }
+				source.secondsLeft-=_seconds;
+				if ( source.secondsLeft<=0 ) { source.playing=false; }
+				continue;
+			}
+			source.secondsLeft-=_seconds;
+			while ( source.secondsLeft<=0 && source.vQueue.empty()==false )
+			{
+				source.vProcessed.push_back(source.vQueue[0]);
+				source.vQueue.erase(source.vQueue.begin());
+				if ( source.vQueue.empty() ) { source.playing=false; }
+				else { source.secondsLeft+=vBufferSeconds(source.vQueue[0]-1); }
+			}
+		}
+	}
+};
+
+#endif /* #ifndef WILDCAT_AUDIO_AUDIO_BACKEND_HPP */
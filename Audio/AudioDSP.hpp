@@ -0,0 +1,432 @@
+#pragma once
+#ifndef WILDCAT_AUDIO_AUDIO_DSP_HPP
+#define WILDCAT_AUDIO_AUDIO_DSP_HPP
+
+/* Wildcat: AudioDSP
+	#include <Audio/AudioDSP.hpp>
+
+	Float DSP kernels for AudioMixer. Samples are floats from -1 to 1, with channels interleaved. Converting a Sound
+	to float is done once, with a separate loop for each format, so no loop branches on bitsPerSample or nChannels.
+
+	The kernels which work on each sample on its own (conversion, gain, mixing, peak) use SSE2 when it's available,
+	4 floats at a time. Each also has a scalar version, which is used without SSE2, and which the tests compare
+	against. Resampling is linear: the read positions are worked out 4 at a time and interpolated with SSE2.
+
+	AudioLowPass and AudioCompressor keep state between calls, so a stream can be processed in blocks. The low pass
+	filter is recursive, so it runs sample by sample for each channel. The compressor follows the peak of each block
+	of COMPRESSOR_BLOCK frames, and ramps the gain across the block with SSE2.
+*/
+
+#include <Audio/Sound.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+	#define WILDCAT_AUDIO_DSP_SSE2
+	#include <emmintrin.h>
+#endif
+
+class AudioDSP
+{
+	public:
+
+	/* Convert a Sound's 8 or 16 bit PCM data to floats. Returns false if the format isn't supported. */
+	static bool toFloat(const Sound* _sound, std::vector <float>& _vOut)
+	{
+		_vOut.clear();
+		if ( _sound==0 || _sound->data==0 || _sound->nData<=0 ) { return false; }
+
+		if ( _sound->bitsPerSample==16 )
+		{
+			const int nSamples = _sound->nData/2;
+			_vOut.resize(nSamples);
+			// Sound data is little endian and may not be aligned.
+			std::vector <short int> vSample (nSamples);
+			std::memcpy(vSample.data(),_sound->data,nSamples*2);
+			from16(vSample.data(),nSamples,_vOut.data());
+			return true;
+		}
+		if ( _sound->bitsPerSample==8 )
+		{
+			// 8 bit wav data is unsigned, with silence at 128.
+			const int nSamples = _sound->nData;
+			_vOut.resize(nSamples);
+			const unsigned char* sample = (const unsigned char*)_sound->data;
+			for (int i=0;i<nSamples;++i)
+			{ _vOut[i] = (sample[i]-128)*(1.0f/128); }
+			return true;
+		}
+		std::cout<<"ERROR: AudioDSP: "<<_sound->bitsPerSample<<" bit audio isn't supported.\n";
+		return false;
+	}
+
+	/* 16 bit samples to floats. */
+	static void from16Scalar(const short int* _in, const int _n, float* _out)
+	{
+		for (int i=0;i<_n;++i)
+		{ _out[i] = _in[i]*(1.0f/32768); }
+	}
+	static void from16(const short int* _in, const int _n, float* _out)
+	{
+		int i=0;
+#ifdef WILDCAT_AUDIO_DSP_SSE2
+		const __m128 scale = _mm_set1_ps(1.0f/32768);
+		for (;i+8<=_n;i+=8)
+		{
+			const __m128i sample = _mm_loadu_si128((const __m128i*)(_in+i));
+			// Sign extend to 32 bits by putting each sample in the top half and shifting it down.
+			const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(sample,sample),16);
+			const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(sample,sample),16);
+			_mm_storeu_ps(_out+i,_mm_mul_ps(_mm_cvtepi32_ps(low),scale));
+			_mm_storeu_ps(_out+i+4,_mm_mul_ps(_mm_cvtepi32_ps(high),scale));
+		}
+#endif
+		from16Scalar(_in+i,_n-i,_out+i);
+	}
+
+	/* Floats to 16 bit samples, rounded and clipped. */
+	static void to16Scalar(const float* _in, const int _n, short int* _out)
+	{
+		for (int i=0;i<_n;++i)
+		{
+			const float sample = std::nearbyint(_in[i]*32767);
+			_out[i] = sample>32767 ? 32767 : sample<-32768 ? -32768 : (short int)sample;
+		}
+	}
+	static void to16(const float* _in, const int _n, short int* _out)
+	{
+		int i=0;
+#ifdef WILDCAT_AUDIO_DSP_SSE2
+		const __m128 scale = _mm_set1_ps(32767);
+		for (;i+8<=_n;i+=8)
+		{
+			// cvtps rounds to nearest, and packs saturates to 16 bits.
+			const __m128i low = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(_in+i),scale));
+			const __m128i high = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(_in+i+4),scale));
+			_mm_storeu_si128((__m128i*)(_out+i),_mm_packs_epi32(low,high));
+		}
+#endif
+		to16Scalar(_in+i,_n-i,_out+i);
+	}
+
+	/* Multiply every sample by _gain. */
+	static void gainScalar(float* _data, const int _n, const float _gain)
+	{
+		for (int i=0;i<_n;++i)
+		{ _data[i]*=_gain; }
+	}
+	static void gain(float* _data, const int _n, const float _gain)
+	{
+		int i=0;
+#ifdef WILDCAT_AUDIO_DSP_SSE2
+		const __m128 gain = _mm_set1_ps(_gain);
+		for (;i+4<=_n;i+=4)
+		{ _mm_storeu_ps(_data+i,_mm_mul_ps(_mm_loadu_ps(_data+i),gain)); }
+#endif
+		gainScalar(_data+i,_n-i,_gain);
+	}
+
+	/* Add mono frames to stereo frames, with a gain for each side. */
+	static void mixMonoScalar(float* _stereo, const float* _mono, const int _nFrames, const float _gainLeft,
+		const float _gainRight)
+	{
+		for (int i=0;i<_nFrames;++i)
+		{
+			_stereo[i*2]+=_mono[i]*_gainLeft;
+			_stereo[i*2+1]+=_mono[i]*_gainRight;
+		}
+	}
+	static void mixMono(float* _stereo, const float* _mono, const int _nFrames, const float _gainLeft,
+		const float _gainRight)
+	{
+		int i=0;
+#ifdef WILDCAT_AUDIO_DSP_SSE2
+		const __m128 gain = _mm_set_ps(_gainRight,_gainLeft,_gainRight,_gainLeft);
+		for (;i+4<=_nFrames;i+=4)
+		{
+			const __m128 mono = _mm_loadu_ps(_mono+i);
+			// Each mono sample goes to both sides: m0 m0 m1 m1, then m2 m2 m3 m3.
+			const __m128 first = _mm_unpacklo_ps(mono,mono);
+			const __m128 second = _mm_unpackhi_ps(mono,mono);
+			float* out = _stereo+i*2;
+			_mm_storeu_ps(out,_mm_add_ps(_mm_loadu_ps(out),_mm_mul_ps(first,gain)));
+			_mm_storeu_ps(out+4,_mm_add_ps(_mm_loadu_ps(out+4),_mm_mul_ps(second,gain)));
+		}
+#endif
+		mixMonoScalar(_stereo+i*2,_mono+i,_nFrames-i,_gainLeft,_gainRight);
+	}
+
+	/* Add stereo frames to stereo frames, with a gain for each side. */
+	static void mixStereoScalar(float* _stereo, const float* _in, const int _nFrames, const float _gainLeft,
+		const float _gainRight)
+	{
+		for (int i=0;i<_nFrames;++i)
+		{
+			_stereo[i*2]+=_in[i*2]*_gainLeft;
+			_stereo[i*2+1]+=_in[i*2+1]*_gainRight;
+		}
+	}
+	static void mixStereo(float* _stereo, const float* _in, const int _nFrames, const float _gainLeft,
+		const float _gainRight)
+	{
+		int i=0;
+#ifdef WILDCAT_AUDIO_DSP_SSE2
+		const __m128 gain = _mm_set_ps(_gainRight,_gainLeft,_gainRight,_gainLeft);
+		for (;i+2<=_nFrames;i+=2)
+		{
+			float* out = _stereo+i*2;
+			_mm_storeu_ps(out,_mm_add_ps(_mm_loadu_ps(out),_mm_mul_ps(_mm_loadu_ps(_in+i*2),gain)));
+		}
+#endif
+		mixStereoScalar(_stereo+i*2,_in+i*2,_nFrames-i,_gainLeft,_gainRight);
+	}
+
+	/* The largest absolute sample. */
+	static float peakScalar(const float* _data, const int _n)
+	{
+		float peak=0;
+		for (int i=0;i<_n;++i)
+		{ peak = std::max(peak,std::fabs(_data[i])); }
+		return peak;
+	}
+	static float peak(const float* _data, const int _n)
+	{
+		int i=0;
+		float peak=0;
+#ifdef WILDCAT_AUDIO_DSP_SSE2
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		__m128 peak4 = _mm_setzero_ps();
+		for (;i+4<=_n;i+=4)
+		{ peak4 = _mm_max_ps(peak4,_mm_and_ps(_mm_loadu_ps(_data+i),absMask)); }
+		float aPeak[4];
+		_mm_storeu_ps(aPeak,peak4);
+		peak = std::max(std::max(aPeak[0],aPeak[1]),std::max(aPeak[2],aPeak[3]));
+#endif
+		return std::max(peak,peakScalar(_data+i,_n-i));
+	}
+
+	/* Multiply frames by a gain which goes linearly from _gainStart to _gainEnd. */
+	static void ramp(float* _data, const int _nFrames, const int _nChannels, const float _gainStart,
+		const float _gainEnd)
+	{
+		if ( _nFrames<=0 ) { return; }
+		const float step = (_gainEnd-_gainStart)/_nFrames;
+		const int nSamples = _nFrames*_nChannels;
+		int sample=0;
+#ifdef WILDCAT_AUDIO_DSP_SSE2
+		if ( _nChannels==1 || _nChannels==2 || _nChannels==4 )
+		{
+			// Each vector covers 4/_nChannels frames.
+			float aGain[4];
+			for (int lane=0;lane<4;++lane) { aGain[lane] = _gainStart+step*(lane/_nChannels); }
+			__m128 gain = _mm_loadu_ps(aGain);
+			const __m128 gainStep = _mm_set1_ps(step*(4/_nChannels));
+			for (;sample+4<=nSamples;sample+=4)
+			{
+				_mm_storeu_ps(_data+sample,_mm_mul_ps(_mm_loadu_ps(_data+sample),gain));
+				gain = _mm_add_ps(gain,gainStep);
+			}
+		}
+#endif
+		for (;sample<nSamples;++sample)
+		{ _data[sample]*=_gainStart+step*(sample/_nChannels); }
+	}
+
+	/* Linear resampling. Reads _in from _position, which moves by _step input frames for each output frame, and
+		writes up to _nFrames frames to _out. Returns how many frames were written, which is less than _nFrames if
+		the input runs out. When _looping, the frame after the last one is the first one. */
+	static int resample(const float* _in, const int _nFramesIn, const int _nChannels, double& _position,
+		const double _step, float* _out, const int _nFrames, const bool _looping)
+	{
+		if ( _nChannels==1 )
+		{ return resampleChannels<1>(_in,_nFramesIn,_position,_step,_out,_nFrames,_looping); }
+		if ( _nChannels==2 )
+		{ return resampleChannels<2>(_in,_nFramesIn,_position,_step,_out,_nFrames,_looping); }
+
+		int i=0;
+		for (;i<_nFrames;++i)
+		{
+			const int frame = (int)_position;
+			if ( frame>=_nFramesIn ) { break; }
+			const int next = frame+1<_nFramesIn ? frame+1 : _looping ? 0 : frame;
+			const float fraction = (float)(_position-frame);
+			for (int channel=0;channel<_nChannels;++channel)
+			{
+				const float a = _in[frame*_nChannels+channel];
+				const float b = _in[next*_nChannels+channel];
+				_out[i*_nChannels+channel] = a+(b-a)*fraction;
+			}
+			_position+=_step;
+		}
+		return i;
+	}
+
+	private:
+
+	template <int N_CHANNELS>
+	static int resampleChannels(const float* _in, const int _nFramesIn, double& _position, const double _step,
+		float* _out, const int _nFrames, const bool _looping)
+	{
+		int i=0;
+
+		// Without a pitch change it's a copy.
+		if ( _step==1 && _position==(int)_position )
+		{
+			const int frame = (int)_position;
+			const int nCopy = std::max(0,std::min(_nFrames,_nFramesIn-frame));
+			std::memcpy(_out,_in+frame*N_CHANNELS,nCopy*N_CHANNELS*sizeof(float));
+			_position+=nCopy;
+			return nCopy;
+		}
+
+#ifdef WILDCAT_AUDIO_DSP_SSE2
+		// 4 frames at a time while every frame and the one after it are in the input.
+		while ( i+4<=_nFrames && (int)(_position+_step*3)+1<_nFramesIn )
+		{
+			int aFrame[4];
+			float aFraction[4];
+			for (int j=0;j<4;++j)
+			{
+				const double position = _position+_step*j;
+				aFrame[j] = (int)position;
+				aFraction[j] = (float)(position-aFrame[j]);
+			}
+			const __m128 fraction = _mm_loadu_ps(aFraction);
+			for (int channel=0;channel<N_CHANNELS;++channel)
+			{
+				const __m128 a = _mm_set_ps(_in[aFrame[3]*N_CHANNELS+channel],_in[aFrame[2]*N_CHANNELS+channel],
+					_in[aFrame[1]*N_CHANNELS+channel],_in[aFrame[0]*N_CHANNELS+channel]);
+				const __m128 b = _mm_set_ps(_in[(aFrame[3]+1)*N_CHANNELS+channel],
+					_in[(aFrame[2]+1)*N_CHANNELS+channel],_in[(aFrame[1]+1)*N_CHANNELS+channel],
+					_in[(aFrame[0]+1)*N_CHANNELS+channel]);
+				float aResult[4];
+				_mm_storeu_ps(aResult,_mm_add_ps(a,_mm_mul_ps(_mm_sub_ps(b,a),fraction)));
+				for (int j=0;j<4;++j) { _out[(i+j)*N_CHANNELS+channel]=aResult[j]; }
+			}
+			_position+=_step*4;
+			i+=4;
+		}
+#endif
+
+		for (;i<_nFrames;++i)
+		{
+			const int frame = (int)_position;
+			if ( frame>=_nFramesIn ) { break; }
+			const int next = frame+1<_nFramesIn ? frame+1 : _looping ? 0 : frame;
+			const float fraction = (float)(_position-frame);
+			for (int channel=0;channel<N_CHANNELS;++channel)
+			{
+				const float a = _in[frame*N_CHANNELS+channel];
+				const float b = _in[next*N_CHANNELS+channel];
+				_out[i*N_CHANNELS+channel] = a+(b-a)*fraction;
+			}
+			_position+=_step;
+		}
+		return i;
+	}
+};
+
+/* One pole low pass filter, which keeps its state between blocks. */
+class AudioLowPass
+{
+	private:
+
+	float coefficient;
+	float aState[8]; // the last output of each channel
+
+	public:
+
+	AudioLowPass()
+	{
+		coefficient=1;
+		reset();
+	}
+
+	/* Frequencies well above _cutoffHz are cut by 6 dB per octave. */
+	void init(const double _cutoffHz, const double _sampleRate)
+	{
+		coefficient = (float)(1-std::exp(-2*M_PI*_cutoffHz/_sampleRate));
+		reset();
+	}
+
+	void reset()
+	{
+		for (int i=0;i<8;++i) { aState[i]=0; }
+	}
+
+	void process(float* _data, const int _nFrames, const int _nChannels)
+	{
+		const int nChannels = std::min(_nChannels,8);
+		for (int channel=0;channel<nChannels;++channel)
+		{
+			float state = aState[channel];
+			for (int i=0;i<_nFrames;++i)
+			{
+				float& sample = _data[i*_nChannels+channel];
+				state+=(sample-state)*coefficient;
+				sample=state;
+			}
+			aState[channel]=state;
+		}
+	}
+};
+
+/* Peak compressor. Above threshold, the level is divided by ratio, so loud voices don't clip the mix. */
+class AudioCompressor
+{
+	private:
+
+	float envelope; // follows the peak level
+	float currentGain;
+
+	public:
+
+	static const int COMPRESSOR_BLOCK = 32;
+
+	float threshold;
+	float ratio;
+	float attack; // how much of the way to a higher peak the envelope moves each block, 0 to 1
+	float release; // the same for a lower peak
+
+	AudioCompressor()
+	{
+		threshold=0.5f;
+		ratio=4;
+		attack=0.9f;
+		release=0.01f;
+		reset();
+	}
+
+	void reset()
+	{
+		envelope=0;
+		currentGain=1;
+	}
+
+	inline float getGain() const
+	{ return currentGain; }
+
+	void process(float* _data, const int _nFrames, const int _nChannels)
+	{
+		for (int i=0;i<_nFrames;i+=COMPRESSOR_BLOCK)
+		{
+			const int nBlock = std::min(COMPRESSOR_BLOCK,_nFrames-i);
+			float* block = _data+i*_nChannels;
+
+			const float peak = AudioDSP::peak(block,nBlock*_nChannels);
+			envelope+=(peak-envelope)*(peak>envelope ? attack : release);
+
+			float gain = 1;
+			if ( envelope>threshold )
+			{ gain = (threshold+(envelope-threshold)/ratio)/envelope; }
+
+			AudioDSP::ramp(block,nBlock,_nChannels,currentGain,gain);
+			currentGain=gain;
+		}
+	}
+};
+
+#endif /* #ifndef WILDCAT_AUDIO_AUDIO_DSP_HPP */
@@ -0,0 +1,335 @@
+#pragma once
+#ifndef WILDCAT_AUDIO_AUDIO_MIXER_HPP
+#define WILDCAT_AUDIO_AUDIO_MIXER_HPP
+
+/* Wildcat: AudioMixer
+	#include <Audio/AudioMixer.hpp>
+
+	Software mixer. Mixes any number of voices, each with its own gain, pan and pitch, into float stereo output at
+	sampleRate. Each Sound is converted to float once, the first time it is played, and kept until unloadSound().
+	Voices are resampled to the output rate, mixed in blocks of MIX_BLOCK frames, then the mix goes through the
+	optional low pass filter and compressor, and masterGain.
+
+	Output can be taken three ways:
+		mix() renders frames straight into a buffer.
+		render() renders into a ring buffer, which read() takes from. One thread can render while another (such as
+		an audio callback) reads, without a lock.
+		renderOffline() and renderToSound() render a length of time, which doesn't need an audio device, so the mix
+		can be tested, benchmarked or saved with Wav::writeFile().
+
+	Voice functions and render() must be called from the same thread.
+*/
+
+#include <Audio/AudioDSP.hpp>
+#include <Audio/Sound.hpp>
+#include <Container/Vector/Vector.hpp>
+
+#include <atomic>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+class AudioMixerVoice
+{
+	public:
+	const Sound* sound; // 0 if the voice is free
+	const std::vector <float> * vSample;
+	int nFrames;
+	int nChannels;
+	double position; // in frames of the sound
+	double step; // sound frames for each output frame
+	float gain;
+	float pan; // -1 is left, 1 is right
+	bool looping;
+	unsigned long int playID;
+};
+
+class AudioMixer
+{
+	private:
+
+	std::unordered_map <const Sound*, std::vector <float> > mSample;
+	Vector <AudioMixerVoice> vVoice;
+	unsigned long int nextPlayID;
+
+	std::vector <float> vScratch; // one voice's resampled block
+
+	std::vector <float> vRing;
+	int ringFrames;
+	std::atomic <unsigned long int> framesWritten;
+	std::atomic <unsigned long int> framesRead;
+
+	AudioMixerVoice* findVoice(const unsigned long int _playID)
+	{
+		for (int i=0;i<vVoice.size();++i)
+		{
+			if ( vVoice(i).sound!=0 && vVoice(i).playID==_playID ) { return &vVoice(i); }
+		}
+		return 0;
+	}
+
+	// Mix one voice into _out. Returns false once the voice has finished.
+	bool mixVoice(AudioMixerVoice& _voice, float* _out, const int _nFrames)
+	{
+		// Equal power panning.
+		const float angle = (float)((_voice.pan+1)*M_PI/4);
+		const float gainLeft = _voice.gain*std::cos(angle);
+		const float gainRight = _voice.gain*std::sin(angle);
+
+		int nDone=0;
+		while ( nDone<_nFrames )
+		{
+			const int nGot = AudioDSP::resample(_voice.vSample->data(),_voice.nFrames,_voice.nChannels,
+				_voice.position,_voice.step,vScratch.data(),_nFrames-nDone,_voice.looping);
+
+			if ( _voice.nChannels==1 )
+			{ AudioDSP::mixMono(_out+nDone*2,vScratch.data(),nGot,gainLeft,gainRight); }
+			else if ( _voice.nChannels==2 )
+			{ AudioDSP::mixStereo(_out+nDone*2,vScratch.data(),nGot,gainLeft,gainRight); }
+			nDone+=nGot;
+
+			if ( nDone<_nFrames )
+			{
+				if ( _voice.looping==false ) { return false; }
+				_voice.position = std::fmod(_voice.position,(double)_voice.nFrames);
+			}
+		}
+		return true;
+	}
+
+	public:
+
+	static const int MIX_BLOCK = 256;
+
+	int sampleRate;
+	float masterGain;
+
+	bool filtering;
+	AudioLowPass lowPass;
+	bool compressing;
+	AudioCompressor compressor;
+
+	unsigned long int framesMixed;
+
+	AudioMixer(): framesWritten(0), framesRead(0)
+	{
+		nextPlayID=1;
+		ringFrames=0;
+		sampleRate=44100;
+		masterGain=1;
+		filtering=false;
+		compressing=true;
+		framesMixed=0;
+	}
+
+	/* Set the output rate, and the size of the ring buffer for render() and read(). */
+	void init(const int _sampleRate=44100, const int _ringFrames=4096)
+	{
+		sampleRate=_sampleRate;
+		ringFrames=_ringFrames;
+		vRing.assign(ringFrames*2,0);
+		framesWritten=0;
+		framesRead=0;
+		// Enough for a block of stereo.
+		vScratch.assign(MIX_BLOCK*2,0);
+		lowPass.reset();
+		compressor.reset();
+	}
+
+	/* Convert the sound to float now, so it doesn't need to be done when it's first played. */
+	bool preloadSound(const Sound* _sound)
+	{
+		if ( _sound==0 ) { return false; }
+		if ( mSample.count(_sound)!=0 ) { return true; }
+		if ( _sound->nChannels!=1 && _sound->nChannels!=2 )
+		{
+			std::cout<<"ERROR: AudioMixer: Only mono and stereo sounds can be mixed.\n";
+			return false;
+		}
+		std::vector <float> vSample;
+		if ( AudioDSP::toFloat(_sound,vSample)==false ) { return false; }
+		mSample[_sound].swap(vSample);
+		return true;
+	}
+
+	/* Stop the sound and drop its float data. */
+	void unloadSound(const Sound* _sound)
+	{
+		stopSound(_sound);
+		mSample.erase(_sound);
+	}
+
+	/* Play a sound. _pitch of 2 plays it twice as fast, an octave up. Returns an ID, or 0 if it can't be played. */
+	unsigned long int play(const Sound* _sound, const float _gain=1, const float _pan=0, const bool _looping=false,
+		const double _pitch=1)
+	{
+		if ( preloadSound(_sound)==false ) { return 0; }
+		const std::vector <float>& vSample = mSample[_sound];
+
+		AudioMixerVoice voice;
+		voice.sound=_sound;
+		voice.vSample=&vSample;
+		voice.nChannels=_sound->nChannels;
+		voice.nFrames=vSample.size()/voice.nChannels;
+		voice.position=0;
+		voice.step=_pitch*_sound->samplesPerSecond/sampleRate;
+		voice.gain=_gain;
+		voice.pan=_pan;
+		voice.looping=_looping;
+		voice.playID=nextPlayID++;
+		if ( voice.nFrames==0 || voice.step<=0 ) { return 0; }
+
+		for (int i=0;i<vVoice.size();++i)
+		{
+			if ( vVoice(i).sound==0 )
+			{
+				vVoice(i)=voice;
+				return voice.playID;
+			}
+		}
+		vVoice.push(voice);
+		return voice.playID;
+	}
+
+	void stop(const unsigned long int _playID)
+	{
+		AudioMixerVoice* voice = findVoice(_playID);
+		if ( voice!=0 ) { voice->sound=0; }
+	}
+
+	void stopSound(const Sound* _sound)
+	{
+		for (int i=0;i<vVoice.size();++i)
+		{
+			if ( vVoice(i).sound==_sound ) { vVoice(i).sound=0; }
+		}
+	}
+
+	void stopAll()
+	{
+		for (int i=0;i<vVoice.size();++i)
+		{ vVoice(i).sound=0; }
+	}
+
+	bool isPlaying(const unsigned long int _playID)
+	{ return findVoice(_playID)!=0; }
+
+	void setGain(const unsigned long int _playID, const float _gain)
+	{
+		AudioMixerVoice* voice = findVoice(_playID);
+		if ( voice!=0 ) { voice->gain=_gain; }
+	}
+
+	void setPan(const unsigned long int _playID, const float _pan)
+	{
+		AudioMixerVoice* voice = findVoice(_playID);
+		if ( voice!=0 ) { voice->pan = std::max(-1.0f,std::min(1.0f,_pan)); }
+	}
+
+	void setPitch(const unsigned long int _playID, const double _pitch)
+	{
+		AudioMixerVoice* voice = findVoice(_playID);
+		if ( voice!=0 && _pitch>0 ) { voice->step=_pitch*voice->sound->samplesPerSecond/sampleRate; }
+	}
+
+	int nPlaying()
+	{
+		int nPlaying=0;
+		for (int i=0;i<vVoice.size();++i)
+		{
+			if ( vVoice(i).sound!=0 ) { ++nPlaying; }
+		}
+		return nPlaying;
+	}
+
+	/* Render _nFrames of stereo into _out, which is overwritten. */
+	void mix(float* _out, const int _nFrames)
+	{
+		for (int start=0;start<_nFrames;start+=MIX_BLOCK)
+		{
+			const int nBlock = std::min(MIX_BLOCK,_nFrames-start);
+			float* out = _out+start*2;
+			std::fill(out,out+nBlock*2,0.0f);
+
+			for (int i=0;i<vVoice.size();++i)
+			{
+				if ( vVoice(i).sound!=0 && mixVoice(vVoice(i),out,nBlock)==false )
+				{ vVoice(i).sound=0; }
+			}
+
+			if ( filtering ) { lowPass.process(out,nBlock,2); }
+			if ( compressing ) { compressor.process(out,nBlock,2); }
+			if ( masterGain!=1 ) { AudioDSP::gain(out,nBlock*2,masterGain); }
+		}
+		framesMixed+=_nFrames;
+	}
+
+	/* Frames in the ring buffer which haven't been read. */
+	int nQueued()
+	{ return (int)(framesWritten.load()-framesRead.load()); }
+
+	/* Mix up to _nFrames into the ring buffer, or less if it's full. Returns how many were mixed. */
+	int render(const int _nFrames)
+	{
+		const unsigned long int written = framesWritten.load(std::memory_order_relaxed);
+		const int nFree = ringFrames-(int)(written-framesRead.load(std::memory_order_acquire));
+		const int nRender = std::min(_nFrames,nFree);
+		if ( nRender<=0 ) { return 0; }
+
+		// The free space may wrap around the end of the ring.
+		const int start = written%ringFrames;
+		const int nFirst = std::min(nRender,ringFrames-start);
+		mix(&vRing[start*2],nFirst);
+		if ( nRender>nFirst ) { mix(&vRing[0],nRender-nFirst); }
+
+		framesWritten.store(written+nRender,std::memory_order_release);
+		return nRender;
+	}
+
+	/* Take up to _nFrames of stereo from the ring buffer. Returns how many were taken. */
+	int read(float* _out, const int _nFrames)
+	{
+		const unsigned long int read = framesRead.load(std::memory_order_relaxed);
+		const int nAvailable = (int)(framesWritten.load(std::memory_order_acquire)-read);
+		const int nRead = std::min(_nFrames,nAvailable);
+		if ( nRead<=0 ) { return 0; }
+
+		const int start = read%ringFrames;
+		const int nFirst = std::min(nRead,ringFrames-start);
+		std::copy(&vRing[start*2],&vRing[start*2]+nFirst*2,_out);
+		if ( nRead>nFirst ) { std::copy(&vRing[0],&vRing[0]+(nRead-nFirst)*2,_out+nFirst*2); }
+
+		framesRead.store(read+nRead,std::memory_order_release);
+		return nRead;
+	}
+
+	/* Render _seconds of stereo. */
+	void renderOffline(const double _seconds, std::vector <float>& _vOut)
+	{
+		const int nFrames = (int)(_seconds*sampleRate);
+		_vOut.resize(nFrames*2);
+		mix(_vOut.data(),nFrames);
+	}
+
+	/* Render _seconds to a new 16 bit stereo Sound, which can be played or saved with Wav::writeFile(). */
+	Sound* renderToSound(const double _seconds)
+	{
+		std::vector <float> vMix;
+		renderOffline(_seconds,vMix);
+
+		Sound* sound = new Sound;
+		sound->nChannels=2;
+		sound->bitsPerSample=16;
+		sound->samplesPerSecond=sampleRate;
+		sound->byteRate=sampleRate*4;
+		sound->nData=vMix.size()*2;
+		sound->durationSeconds=(double)(vMix.size()/2)/sampleRate;
+		sound->data=new char [sound->nData];
+		std::vector <short int> vSample (vMix.size());
+		AudioDSP::to16(vMix.data(),vMix.size(),vSample.data());
+		std::memcpy(sound->data,vSample.data(),sound->nData);
+		return sound;
+	}
+};
+
+#endif /* #ifndef WILDCAT_AUDIO_AUDIO_MIXER_HPP */
@@ -0,0 +1,281 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <Audio/AudioMixer.hpp>
+#include <Audio/Wav.hpp>
+#include <System/Time/Timer.hpp>
+
+// g++ AudioMixer_Test.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX -D WILDCAT_AUDIO
+
+// Offline test of AudioMixer and the AudioDSP kernels. Checks the SSE2 kernels against the scalar ones, resampling,
+// panning, looping, the ring buffer, the compressor and saving a mix as a wav file. Then times mixing many voices
+// offline, and the SSE2 kernels against the scalar ones.
+
+const int SAMPLE_RATE = 44100;
+const int N_VOICES = 64;
+const double BENCHMARK_SECONDS = 20;
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+// 16 bit sine wave.
+void makeSound(Sound& _sound, const int _nChannels, const double _seconds, const double _hz, const double _volume)
+{
+	const int nFrames = (int)(_seconds*SAMPLE_RATE);
+	_sound.nChannels=_nChannels;
+	_sound.bitsPerSample=16;
+	_sound.samplesPerSecond=SAMPLE_RATE;
+	_sound.byteRate=SAMPLE_RATE*2*_nChannels;
+	_sound.durationSeconds=_seconds;
+	_sound.nData=nFrames*_nChannels*2;
+	_sound.data=new char [_sound.nData];
+	short int* sample = (short int*)_sound.data;
+	for (int i=0;i<nFrames;++i)
+	{
+		for (int channel=0;channel<_nChannels;++channel)
+		{ sample[i*_nChannels+channel] = (short int)(_volume*32767*std::sin(2*M_PI*_hz*i/SAMPLE_RATE)); }
+	}
+}
+
+bool near(const float a, const float b, const float tolerance=0.0001f)
+{
+	return std::fabs(a-b)<=tolerance;
+}
+
+int main (int nArgs, char ** arg)
+{
+	// Kernels against their scalar versions, with lengths which don't fill the last vector.
+	const int N_TEST = 1003;
+	std::vector <short int> v16 (N_TEST);
+	for (int i=0;i<N_TEST;++i) { v16[i] = (short int)(i*131-32768); }
+	std::vector <float> vFloat (N_TEST), vFloatScalar (N_TEST);
+	AudioDSP::from16(v16.data(),N_TEST,vFloat.data());
+	AudioDSP::from16Scalar(v16.data(),N_TEST,vFloatScalar.data());
+	check("from16 matches scalar", vFloat==vFloatScalar && vFloat[0]==-1);
+
+	vFloat[0]=2;
+	vFloat[1]=-2;
+	std::vector <short int> vBack (N_TEST), vBackScalar (N_TEST);
+	AudioDSP::to16(vFloat.data(),N_TEST,vBack.data());
+	AudioDSP::to16Scalar(vFloat.data(),N_TEST,vBackScalar.data());
+	check("to16 matches scalar and clips", vBack==vBackScalar && vBack[0]==32767 && vBack[1]==-32768
+		&& vBack[500]==(short int)std::nearbyint(vFloat[500]*32767));
+
+	std::vector <float> vMix (N_TEST*2,0.5f), vMixScalar (N_TEST*2,0.5f);
+	AudioDSP::mixMono(vMix.data(),vFloatScalar.data(),N_TEST,0.25f,0.75f);
+	AudioDSP::mixMonoScalar(vMixScalar.data(),vFloatScalar.data(),N_TEST,0.25f,0.75f);
+	AudioDSP::mixStereo(vMix.data(),vMixScalar.data(),N_TEST,0.5f,2);
+	AudioDSP::mixStereoScalar(vMixScalar.data(),vMixScalar.data(),N_TEST,0.5f,2);
+	check("mixMono and mixStereo match scalar", vMix==vMixScalar);
+
+	AudioDSP::gain(vMix.data(),N_TEST*2,0.5f);
+	AudioDSP::gainScalar(vMixScalar.data(),N_TEST*2,0.5f);
+	vMix[N_TEST*2-1]=-7;
+	vMixScalar[N_TEST*2-1]=-7;
+	check("gain and peak match scalar", vMix==vMixScalar && AudioDSP::peak(vMix.data(),N_TEST*2)==7
+		&& AudioDSP::peakScalar(vMix.data(),N_TEST*2)==7);
+
+	std::vector <float> vRamp (10*2,1);
+	AudioDSP::ramp(vRamp.data(),10,2,0,1);
+	check("ramp", vRamp[0]==0 && vRamp[1]==0 && near(vRamp[2],0.1f) && near(vRamp[19],0.9f));
+
+	Sound sound8;
+	sound8.nChannels=1;
+	sound8.bitsPerSample=8;
+	sound8.nData=3;
+	sound8.data=new char [3];
+	sound8.data[0]=(char)0;
+	sound8.data[1]=(char)128;
+	sound8.data[2]=(char)255;
+	std::vector <float> vSound8;
+	check("8 bit sounds are unsigned", AudioDSP::toFloat(&sound8,vSound8) && vSound8[0]==-1 && vSound8[1]==0
+		&& near(vSound8[2],127/128.0f));
+
+	// Resampling.
+	std::vector <float> vRamp4 (8);
+	for (int i=0;i<8;++i) { vRamp4[i]=i; }
+	std::vector <float> vOut (32,-1);
+	double position = 0;
+	int nGot = AudioDSP::resample(vRamp4.data(),8,1,position,0.5,vOut.data(),32,false);
+	check("Half speed interpolates", nGot==16 && vOut[0]==0 && vOut[1]==0.5f && vOut[5]==2.5f && vOut[14]==7
+		&& vOut[15]==7);
+	position = 0.25;
+	nGot = AudioDSP::resample(vRamp4.data(),4,2,position,2,vOut.data(),32,false);
+	check("Double speed stereo", nGot==2 && vOut[0]==0.5f && vOut[1]==1.5f && vOut[2]==4.5f && vOut[3]==5.5f);
+	position = 7.5;
+	nGot = AudioDSP::resample(vRamp4.data(),8,1,position,1,vOut.data(),32,true);
+	check("Looping interpolates to the first frame", nGot==1 && vOut[0]==3.5f);
+
+	// Mixing.
+	Sound tone, toneStereo, loud, shortSound;
+	makeSound(tone,1,1,441,0.5);
+	makeSound(toneStereo,2,1,441,0.5);
+	makeSound(loud,1,1,441,1);
+	makeSound(shortSound,1,0.01,441,0.5);
+
+	AudioMixer mixer;
+	mixer.init(SAMPLE_RATE,4096);
+	mixer.compressing=false;
+
+	std::vector <float> vRender;
+	mixer.play(&tone,1,-1);
+	mixer.renderOffline(0.1,vRender);
+	float maxRight=0;
+	for (unsigned int i=0;i<vRender.size();i+=2) { maxRight = std::max(maxRight,std::fabs(vRender[i+1])); }
+	check("Pan left is only on the left", near(AudioDSP::peak(vRender.data(),vRender.size()),0.5f,0.001f)
+		&& maxRight<0.0001f);
+	mixer.stopAll();
+
+	const unsigned long int centre = mixer.play(&toneStereo);
+	mixer.renderOffline(0.1,vRender);
+	check("Centre pan is equal power", near(vRender[50*2],vRender[50*2+1]) && near(AudioDSP::peak(vRender.data(),
+		vRender.size()),0.5f*std::sqrt(0.5f),0.001f));
+	mixer.setGain(centre,2);
+	mixer.renderOffline(0.1,vRender);
+	check("setGain", near(AudioDSP::peak(vRender.data(),vRender.size()),std::sqrt(0.5f),0.002f));
+	mixer.stop(centre);
+	check("stop", mixer.isPlaying(centre)==false && mixer.nPlaying()==0);
+
+	const unsigned long int once = mixer.play(&shortSound);
+	const unsigned long int loop = mixer.play(&shortSound,1,0,true);
+	mixer.renderOffline(0.1,vRender);
+	check("Sounds finish unless they loop", mixer.isPlaying(once)==false && mixer.isPlaying(loop)
+		&& mixer.nPlaying()==1);
+	check("Looping keeps playing", AudioDSP::peak(&vRender[vRender.size()-200],200)>0.1f);
+	mixer.stopAll();
+
+	// Two tones at half volume add up.
+	mixer.play(&tone);
+	mixer.play(&tone);
+	mixer.renderOffline(0.1,vRender);
+	check("Voices add up", near(AudioDSP::peak(vRender.data(),vRender.size()),2*0.5f*std::sqrt(0.5f),0.002f));
+	mixer.stopAll();
+
+	// An octave up has twice as many cycles.
+	mixer.play(&tone,1,0,false,2);
+	mixer.renderOffline(0.1,vRender);
+	int nCrossings=0;
+	for (unsigned int i=2;i<vRender.size();i+=2)
+	{
+		if ( (vRender[i-2]<0)!=(vRender[i]<0) ) { ++nCrossings; }
+	}
+	check("Pitch 2 is an octave up", nCrossings>=175 && nCrossings<=177);
+	mixer.stopAll();
+
+	// The compressor keeps loud mixes under control.
+	mixer.compressing=true;
+	for (int i=0;i<8;++i) { mixer.play(&loud,1,0,true); }
+	mixer.renderOffline(0.5,vRender);
+	const float compressedPeak = AudioDSP::peak(&vRender[vRender.size()/2],vRender.size()/2);
+	check("Compressor reduces loud mixes", compressedPeak<2.5f && mixer.compressor.getGain()<0.5f);
+	mixer.stopAll();
+	mixer.compressing=false;
+
+	// The ring buffer gives the same output as mixing directly, across wraps.
+	AudioMixer direct;
+	direct.init(SAMPLE_RATE);
+	direct.compressing=false;
+	direct.play(&tone,0.7f,0.3f,true,1.3);
+	std::vector <float> vDirect;
+	direct.renderOffline(1,vDirect);
+
+	AudioMixer ring;
+	ring.init(SAMPLE_RATE,1000);
+	ring.compressing=false;
+	ring.play(&tone,0.7f,0.3f,true,1.3);
+	std::vector <float> vRing;
+	std::vector <float> vRead (700*2);
+	bool ringFull = true;
+	while ( (int)vRing.size()<(int)vDirect.size() )
+	{
+		ring.render(900);
+		if ( ring.nQueued()>1000 ) { ringFull=false; }
+		const int nRead = ring.read(vRead.data(),700);
+		vRing.insert(vRing.end(),vRead.begin(),vRead.begin()+nRead*2);
+	}
+	vRing.resize(vDirect.size());
+	check("Ring buffer matches direct mixing", vRing==vDirect && ringFull && ring.render(2000)<=1000);
+
+	// Offline render to a wav file and back.
+	AudioMixer offline;
+	offline.init(SAMPLE_RATE);
+	offline.play(&toneStereo,1,0.5f);
+	Sound* rendered = offline.renderToSound(0.5);
+	check("renderToSound", rendered->nData==(int)(0.5*SAMPLE_RATE)*4 && rendered->nChannels==2);
+	check("Wav::writeFile", Wav::writeFile("AudioMixer_Test.wav",rendered));
+	Wav wav;
+	wav.readFile("AudioMixer_Test.wav");
+	check("The wav file reads back the same", wav.nAudioBytes==rendered->nData && wav.NumChannels==2
+		&& wav.SampleRate==SAMPLE_RATE && std::equal(wav.data,wav.data+wav.nAudioBytes,rendered->data));
+	std::remove("AudioMixer_Test.wav");
+
+	// Benchmark: many voices at different pitches and pans, mixed offline.
+	AudioMixer bench;
+	bench.init(SAMPLE_RATE);
+	bench.filtering=true;
+	bench.lowPass.init(8000,SAMPLE_RATE);
+	for (int i=0;i<N_VOICES;++i)
+	{ bench.play(i%2==0 ? &tone : &toneStereo,0.1f,(i%9-4)/4.0f,true,0.5+i/(double)N_VOICES); }
+
+	Timer timer;
+	timer.init();
+	timer.start();
+	bench.renderOffline(BENCHMARK_SECONDS,vRender);
+	timer.update();
+	const double mixSeconds = timer.fullSeconds;
+	std::cout<<N_VOICES<<" voices, "<<BENCHMARK_SECONDS<<"s of audio mixed in "<<mixSeconds<<"s ("
+		<<BENCHMARK_SECONDS/mixSeconds<<"x realtime).\n";
+
+	// Kernels against their scalar versions.
+	const int N_BENCH = 1<<20;
+	const int N_REPEATS = 50;
+	std::vector <short int> vBench16 (N_BENCH*2);
+	std::vector <float> vBenchFloat (N_BENCH*2);
+	std::vector <float> vBenchMix (N_BENCH*2);
+	for (int i=0;i<N_BENCH*2;++i) { vBench16[i] = (short int)(i*7); }
+	double aSeconds[2][3];
+	for (int scalar=0;scalar<2;++scalar)
+	{
+		timer.init();
+		timer.start();
+		for (int i=0;i<N_REPEATS;++i)
+		{
+			if ( scalar ) { AudioDSP::from16Scalar(vBench16.data(),N_BENCH*2,vBenchFloat.data()); }
+			else { AudioDSP::from16(vBench16.data(),N_BENCH*2,vBenchFloat.data()); }
+		}
+		timer.update();
+		aSeconds[scalar][0]=timer.fullSeconds;
+
+		timer.init();
+		timer.start();
+		for (int i=0;i<N_REPEATS;++i)
+		{
+			if ( scalar ) { AudioDSP::mixMonoScalar(vBenchMix.data(),vBenchFloat.data(),N_BENCH,0.5f,0.25f); }
+			else { AudioDSP::mixMono(vBenchMix.data(),vBenchFloat.data(),N_BENCH,0.5f,0.25f); }
+		}
+		timer.update();
+		aSeconds[scalar][1]=timer.fullSeconds;
+
+		timer.init();
+		timer.start();
+		for (int i=0;i<N_REPEATS;++i)
+		{
+			if ( scalar ) { AudioDSP::to16Scalar(vBenchMix.data(),N_BENCH*2,vBench16.data()); }
+			else { AudioDSP::to16(vBenchMix.data(),N_BENCH*2,vBench16.data()); }
+		}
+		timer.update();
+		aSeconds[scalar][2]=timer.fullSeconds;
+	}
+	std::cout<<N_REPEATS<<" x "<<N_BENCH<<" frames. SSE2 / scalar seconds: from16 "<<aSeconds[0][0]<<" / "
+		<<aSeconds[1][0]<<", mixMono "<<aSeconds[0][1]<<" / "<<aSeconds[1][1]<<", to16 "<<aSeconds[0][2]<<" / "
+		<<aSeconds[1][2]<<". ("<<vBench16[N_BENCH]%2<<")\n";
+
+	std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+	return nFailed==0 ? 0 : 1;
+}
@@ -33,6 +33,12 @@ class AudioPlayer
 	
 	/* Playing audio can lag if the sound isn't prepared earlier. This function is used to prepare a sound to be played later. */
 	virtual void preloadSound(Sound*){};
+	/* Free the memory used by a preloaded sound, once it has finished playing. */
+	virtual void unloadSound(Sound*){};
+	
+	/* Play a wav file from disk without loading it all into memory. Returns an ID for stopStream(), or 0 if it can't be played. */
+	virtual unsigned long int playStream(const char* /* Path. */, bool /* Loop. */) { return 0; };
+	virtual void stopStream(unsigned long int) {};
 	
 	/* Free up memory and close audio devices, etc. */
 	virtual void close() {};
@@ -7,6 +7,13 @@
    
    OpenAL implementation of AudioPlayer.
    
+   Sounds are played through AudioVoiceManager, which uploads each Sound once and recycles a pool of maxSounds
+   sources, instead of making a new buffer and source for every play. If no audio device can be opened, a null
+   backend is used so the game still runs.
+   
+   Long files such as music can be streamed from disk with playStream(), which keeps only a few small buffers in
+   memory. Streams are refilled by garbageCollect(), so it should be called every frame while they play.
+   
    Note that WILDCAT_AUDIO must be defined in order for any audio to play.
 */
 
@@ -15,8 +22,13 @@
 #include <Audio/OpenAL/alext.h>
 
 #include <Audio/AudioPlayer.hpp>
+#include <Audio/AudioBackend.hpp>
+#include <Audio/AudioStream.hpp>
+#include <Audio/AudioVoiceManager.hpp>
 #include <Container/Vector/Vector.hpp>
 
+#include <map>
+
 
 // load a bunch of sources to allow overlapping sounds
 class ALRevolver
@@ -109,6 +121,149 @@ class ALRevolver
    
 };
 
+// AudioBackend calls for AudioVoiceManager.
+class AudioBackend_OpenAL: public AudioBackend
+{
+	public:
+	
+	unsigned int createBuffer(Sound* sound) override
+	{
+		const unsigned int buffer = createEmptyBuffer();
+		if ( buffer==0 ) { return 0; }
+		if ( fillBuffer(buffer,sound->data,sound->nData,sound->nChannels,sound->bitsPerSample,
+			sound->samplesPerSecond)==false )
+		{
+			deleteBuffer(buffer);
+			return 0;
+		}
+		return buffer;
+	}
+	void deleteBuffer(unsigned int buffer) override
+	{
+#ifdef WILDCAT_AUDIO
+		ALuint soundBuffer = buffer;
+		alDeleteBuffers(1,&soundBuffer);
+#endif
+	}
+	
+	unsigned int createEmptyBuffer() override
+	{
+#ifdef WILDCAT_AUDIO
+		ALuint soundBuffer = 0;
+		alGetError();
+		alGenBuffers(1, &soundBuffer);
+		if ( alGetError()!=AL_NO_ERROR ) { return 0; }
+		return soundBuffer;
+#else
+		return 0;
+#endif
+	}
+	bool fillBuffer(unsigned int buffer, const char* data, int nBytes, int nChannels, int bitsPerSample,
+		int samplesPerSecond) override
+	{
+#ifdef WILDCAT_AUDIO
+		ALenum format;
+		if ( bitsPerSample==8 && nChannels==1 ) { format=AL_FORMAT_MONO8; }
+		else if ( bitsPerSample==8 && nChannels==2 ) { format=AL_FORMAT_STEREO8; }
+		else if ( bitsPerSample==16 && nChannels==1 ) { format=AL_FORMAT_MONO16; }
+		else if ( bitsPerSample==16 && nChannels==2 ) { format=AL_FORMAT_STEREO16; }
+		else
+		{
+			std::cout<<"Error: Sound needs to be 8 or 16 bit, with 1 or 2 channels.\n";
+			return false;
+		}
+		
+		alGetError();
+		alBufferData(buffer,format,data,nBytes,samplesPerSecond);
+		return alGetError()==AL_NO_ERROR;
+#else
+		return false;
+#endif
+	}
+	
+	unsigned int createSource() override
+	{
+#ifdef WILDCAT_AUDIO
+		ALuint source = 0;
+		alGetError();
+		alGenSources(1,&source);
+		if ( alGetError()!=AL_NO_ERROR ) { return 0; }
+		return source;
+#else
+		return 0;
+#endif
+	}
+	void deleteSource(unsigned int source) override
+	{
+#ifdef WILDCAT_AUDIO
+		ALuint alSource = source;
+		alDeleteSources(1,&alSource);
+#endif
+	}
+	
+	void setBuffer(unsigned int source, unsigned int buffer) override
+	{
+#ifdef WILDCAT_AUDIO
+		alSourcei(source, AL_BUFFER, buffer);
+#endif
+	}
+	void setGain(unsigned int source, float gain) override
+	{
+#ifdef WILDCAT_AUDIO
+		alSourcef(source, AL_GAIN, gain);
+#endif
+	}
+	void setLooping(unsigned int source, bool looping) override
+	{
+#ifdef WILDCAT_AUDIO
+		alSourcei(source, AL_LOOPING, looping ? AL_TRUE : AL_FALSE);
+#endif
+	}
+	void play(unsigned int source) override
+	{
+#ifdef WILDCAT_AUDIO
+		alSourcePlay(source);
+#endif
+	}
+	void stop(unsigned int source) override
+	{
+#ifdef WILDCAT_AUDIO
+		alSourceStop(source);
+#endif
+	}
+	bool isPlaying(unsigned int source) override
+	{
+#ifdef WILDCAT_AUDIO
+		ALint state;
+		alGetSourcei(source, AL_SOURCE_STATE, &state);
+		return state==AL_PLAYING;
+#else
+		return false;
+#endif
+	}
+	
+	void queueBuffer(unsigned int source, unsigned int buffer) override
+	{
+#ifdef WILDCAT_AUDIO
+		ALuint alBuffer = buffer;
+		alSourceQueueBuffers(source,1,&alBuffer);
+#endif
+	}
+	unsigned int unqueueBuffer(unsigned int source) override
+	{
+#ifdef WILDCAT_AUDIO
+		ALint nProcessed = 0;
+		alGetSourcei(source, AL_BUFFERS_PROCESSED, &nProcessed);
+		if ( nProcessed<=0 ) { return 0; }
+		ALuint buffer = 0;
+		alSourceUnqueueBuffers(source,1,&buffer);
+		return buffer;
+#else
+		return 0;
+#endif
+	}
+};
+
 class AudioPlayer_OpenAL: public AudioPlayer
 {
 	public:
@@ -118,10 +273,13 @@ class AudioPlayer_OpenAL: public AudioPlayer
 	
 	//bool audioInitialised;
 	
-	Vector <Sound*> vSound;
-	Vector <ALuint> vSource;
-	Vector <ALuint> vBuffer;
+	AudioBackend_OpenAL backendOpenAL;
+	AudioBackend_Null backendNull; /* Used if there's no audio device. */
+	AudioBackend* backend; /* Whichever of the above is in use. */
+	AudioVoiceManager voiceManager;
 	
+	std::map <unsigned long int, AudioStream*> mStream;
+	unsigned long int nextStreamID;
 	
 	bool closed; /* Prevent closing multiple times which can cause crash */
    
@@ -137,9 +295,12 @@ class AudioPlayer_OpenAL: public AudioPlayer
 #ifdef WILDCAT_AUDIO
 		alcDevice=0;
 		alcContext=0;
+		backend=0;
+		nextStreamID=1;
 		globalVolume=50;
 		closed = false;
 #endif
+		maxSounds=32;
 	}
    
    int loadRevolver(Sound * sound, int nSounds)
@@ -264,7 +425,15 @@ class AudioPlayer_OpenAL: public AudioPlayer
 		{
 			alcContext=alcCreateContext(alcDevice,NULL); 
 			alcMakeContextCurrent(alcContext);
+			backend=&backendOpenAL;
 		}
+		else
+		{
+			std::cout<<"WARNING: AudioPlayer_OpenAL: No audio device. Sounds won't be heard.\n";
+			backend=&backendNull;
+		}
+		voiceManager.init(backend,maxSounds);
+		voiceManager.setGain((float)globalVolume/100);
 		//audioInitialised=true;
 #endif
 	}
@@ -274,9 +443,17 @@ class AudioPlayer_OpenAL: public AudioPlayer
 #ifdef WILDCAT_AUDIO
 		if (closed == false)
 		{
-			alcMakeContextCurrent(NULL); 
-			alcDestroyContext(alcContext); 
-			alcCloseDevice(alcDevice);
+			/* Sources and buffers must be deleted while the context exists. */
+			for (std::map <unsigned long int, AudioStream*>::iterator it=mStream.begin();it!=mStream.end();++it)
+			{ delete it->second; }
+			mStream.clear();
+			voiceManager.close();
+			if ( alcDevice!=0 )
+			{
+				alcMakeContextCurrent(NULL); 
+				alcDestroyContext(alcContext); 
+				alcCloseDevice(alcDevice);
+			}
 			closed = true;
 		}
 #endif
@@ -286,7 +463,33 @@ class AudioPlayer_OpenAL: public AudioPlayer
 	void preloadSound(Sound* sound)
 	{
 #ifdef WILDCAT_AUDIO
-
+		voiceManager.preloadSound(sound);
+#endif
+	}
+	
+	/* Free the sound's buffer once it has finished playing. */
+	void unloadSound(Sound* sound)
+	{
+#ifdef WILDCAT_AUDIO
+		voiceManager.unloadSound(sound);
+#endif
+	}
+	
+	/* Play a sound on the voice pool. If every voice is busy, the lowest priority and oldest voice is taken, unless
+		they are all more important. Returns an ID for stopPlay(), or 0 if the sound was dropped. */
+	unsigned long int playSound(Sound* sound, const int priority, const int maxInstances=0, const bool loop=false)
+	{
+#ifdef WILDCAT_AUDIO
+		return voiceManager.play(sound,priority,maxInstances,loop);
+#else
+		return 0;
+#endif
+	}
+	
+	void stopPlay(const unsigned long int playID)
+	{
+#ifdef WILDCAT_AUDIO
+		voiceManager.stop(playID);
 #endif
 	}
 	
@@ -294,154 +497,82 @@ class AudioPlayer_OpenAL: public AudioPlayer
 	void playSoundOnce(Sound* sound)
 	{
 #ifdef WILDCAT_AUDIO
-		ALuint soundBuffer;
-		alGenBuffers(1, &soundBuffer);
-		
-		//std::cout<<"sound->bitsPerSample: "<<sound->bitsPerSample<<".\n";
-		
-		if(sound->bitsPerSample==8)
-		{
-			//std::cout<<"Nchannels: "<<sound->nChannels<<".\n";
-			//std::cout<<"8 bit.\n";
-			if(sound->nChannels==1)
-			{ alBufferData(soundBuffer,AL_FORMAT_MONO8,sound->data,sound->nData,sound->samplesPerSecond); }
-			else if (sound->nChannels==2)
-			{ alBufferData(soundBuffer,AL_FORMAT_STEREO8,sound->data,sound->nData,sound->samplesPerSecond); }
-			else
-			{ std::cout<<"Error: WAV needs to have 1 or 2 channels.\n"; }
-		}
-		else if(sound->bitsPerSample==16)
-		{
-			//std::cout<<"Nchannels: "<<sound->nChannels<<".\n";
-			//std::cout<<"16 bit.\n";
-			if(sound->nChannels==1)
-			{ alBufferData(soundBuffer,AL_FORMAT_MONO16,sound->data,sound->nData,sound->samplesPerSecond); }
-			else if (sound->nChannels==2)
-			{ alBufferData(soundBuffer,AL_FORMAT_STEREO16,sound->data,sound->nData,sound->samplesPerSecond); }
-			else
-			{ std::cout<<"Error: WAV needs to have 1 or 2 channels.\n"; }
-		}
-		else
-		{ std::cout<<"Error: Sound needs to be 8 or 16 bit.\n"; }
-
-		
-		ALuint source;
-		alGenSources(1,&source);
-		/* Load buffer into source. */
-		alSourcei(source, AL_BUFFER, soundBuffer);
-		/* Set volume. */
-		const float volume = (float)globalVolume/100;
-		alSourcef(source, AL_GAIN, volume);
-		/* Play source in new thread. */
-		alSourcePlay(source);
-		
-		vSound.push(sound);
-		vSource.push(source);
-		vBuffer.push(soundBuffer);
-		
+		voiceManager.play(sound);
 #endif
 	}
 	
+	/* If maxInstances copies of the sound are already playing, the oldest one is restarted. */
 	void playSoundOnce (Sound* sound, const int maxInstances)
 	{
 #ifdef WILDCAT_AUDIO
-		//std::cout<<"Playing sound with max "<<maxInstances<<" instances.\n";
-		
+		voiceManager.play(sound,0,maxInstances);
 #endif
 	}
 	
 	void playSoundLoop(Sound* sound)
 	{
 #ifdef WILDCAT_AUDIO
-		ALuint soundBuffer;
-		alGenBuffers(1, &soundBuffer);
-		
-		if(sound->bitsPerSample==8)
-		{
-			if(sound->nChannels==1)
-			{ alBufferData(soundBuffer,AL_FORMAT_MONO8,sound->data,sound->nData,sound->samplesPerSecond); }
-			else if (sound->nChannels==2)
-			{ alBufferData(soundBuffer,AL_FORMAT_STEREO8,sound->data,sound->nData,sound->samplesPerSecond); }
-			else
-			{ std::cout<<"Error: WAV needs to have 1 or 2 channels.\n"; }
-		}
-		else if(sound->bitsPerSample==16)
-		{
-			//std::cout<<"Playing 16 bit sound.\n";
-			if(sound->nChannels==1)
-			{ alBufferData(soundBuffer,AL_FORMAT_MONO16,sound->data,sound->nData,sound->samplesPerSecond); }
-			else if (sound->nChannels==2)
-			{ alBufferData(soundBuffer,AL_FORMAT_STEREO16,sound->data,sound->nData,sound->samplesPerSecond); }
-			else
-			{ std::cout<<"Error: WAV needs to have 1 or 2 channels.\n"; }
-		}
-		else
-		{ std::cout<<"Error: Sound needs to be 8 or 16 bit.\n"; }
-		
-		ALuint source;
-		alGenSources(1,&source);
-		/* Load buffer into source. */
-		alSourcei(source, AL_BUFFER, soundBuffer);
-		/* Set to loop. */
-		alSourcei(source, AL_LOOPING, AL_TRUE);
-		/* Set volume. */
-		const float volume = (float)globalVolume/100;
-		alSourcef(source, AL_GAIN, volume);
-		/* Play source in new thread. */
-		alSourcePlay(source);
-		
-		
-		vSound.push(sound);
-		vSource.push(source);
+		voiceManager.play(sound,0,0,true);
 #endif
 	}
 	
 	void stopSound(Sound* sound)
 	{
 #ifdef WILDCAT_AUDIO
-		int nStops=0;
-		for(int i=0;i<vSound.size();++i)
-		{
-			if(vSound(i)==sound)
-			{
-				alSourceStop(vSource(i));
-				++nStops;
-			}
-		}
-	//	std::cout<<"Num stops: "<<nStops<<".\n";
+		voiceManager.stopSound(sound);
 #endif
 	}
 	void stopAllSounds()
 	{
 #ifdef WILDCAT_AUDIO
-		for(int i=0;i<vSound.size();++i)
+		voiceManager.stopAll();
+#endif
+	}
+	
+	/* Stream a wav file from disk, for music and other long sounds. Playback starts once the first block is read.
+		Returns an ID for stopStream(), or 0 if the file can't be streamed. */
+	unsigned long int playStream(const char* path, const bool loop=false)
+	{
+#ifdef WILDCAT_AUDIO
+		if ( backend==0 ) { return 0; }
+		AudioStream* stream = new AudioStream;
+		if ( stream->open(backend,path,loop)==false )
 		{
-			//alSourcei(vSource(i), AL_LOOPING, AL_FALSE);
-			//stopSound(vSound(i));
-			//std::cout<<"Stopping.\n";
-			alSourceStop(vSource(i));
+			delete stream;
+			return 0;
 		}
+		stream->setGain((float)globalVolume/100);
+		stream->play();
+		mStream[nextStreamID]=stream;
+		return nextStreamID++;
+#else
+		return 0;
+#endif
+	}
+	
+	void stopStream(const unsigned long int streamID)
+	{
+#ifdef WILDCAT_AUDIO
+		std::map <unsigned long int, AudioStream*>::iterator it = mStream.find(streamID);
+		if ( it==mStream.end() ) { return; }
+		delete it->second;
+		mStream.erase(it);
 #endif
 	}
 	
+	/* Reclaim voices which have finished playing, refill streams, and free streams which have finished. Should be
+		called periodically, and every frame while streams are playing. */
 	void garbageCollect()
 	{
 #ifdef WILDCAT_AUDIO
-// This should be called periodically to free up memory from sounds that have finished playing
-         for (int i=0;i<vSource.size();++i)
-         {
-            ALenum state;
-            alGetSourcei(vSource(i), AL_SOURCE_STATE, &state);
-            if (state != AL_PLAYING)
-            {
-               alDeleteSources(1,&vSource(i));
-               alDeleteBuffers(1,&vBuffer(i));
-               vSource(i)=0;
-               vBuffer(i)=0;
-            }
-         }
-         vSource.removeNulls();
-         vBuffer.removeNulls();
+		voiceManager.update();
+		for (std::map <unsigned long int, AudioStream*>::iterator it=mStream.begin();it!=mStream.end();)
+		{
+			it->second->update();
+			if ( it->second->isPlaying() ) { ++it; continue; }
+			delete it->second;
+			mStream.erase(it++);
+		}
 #endif
 	}
 	
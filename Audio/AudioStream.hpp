@@ -0,0 +1,195 @@
+#pragma once
+#ifndef WILDCAT_AUDIO_AUDIO_STREAM_HPP
+#define WILDCAT_AUDIO_AUDIO_STREAM_HPP
+
+/* Wildcat: AudioStream
+	#include <Audio/AudioStream.hpp>
+
+	Plays a wav file from disk without loading it, for music and long ambient loops. The file is read by WavStream
+	into a ring of nBuffers buffers of blockSeconds each, which are queued on one source. Playback starts as soon as
+	the first block is queued. update() refills each buffer once it has played and queues it again, so memory stays
+	at nBuffers blocks however long the file is.
+
+	update() must be called more often than blockSeconds*(nBuffers-1), or the source runs out of data. If it does,
+	update() restarts it and counts an underrun.
+*/
+
+#include <Audio/AudioBackend.hpp>
+#include <Audio/WavStream.hpp>
+
+#include <vector>
+
+class AudioStream
+{
+	private:
+
+	AudioBackend* backend;
+	WavStream wav;
+	unsigned int source;
+	std::vector <unsigned int> vBuffer;
+	std::vector <char> vBlock; // one block of PCM data, read from the file
+	int nQueued;
+	bool playing;
+
+	// Read the next block into a buffer and queue it. Returns false at the end of the file.
+	bool queueNext(const unsigned int _buffer)
+	{
+		const int nBytes = wav.read(vBlock.data(),vBlock.size());
+		if ( nBytes<=0 ) { return false; }
+		if ( backend->fillBuffer(_buffer,vBlock.data(),nBytes,wav.nChannels,wav.bitsPerSample,wav.samplesPerSecond)
+			==false )
+		{ return false; }
+		backend->queueBuffer(source,_buffer);
+		++nQueued;
+		++nBlocksQueued;
+		return true;
+	}
+
+	public:
+
+	int nBuffers;
+	double blockSeconds;
+
+	/* Stats, for tests and benchmarks. */
+	unsigned long int nBlocksQueued;
+	unsigned long int nUnderruns;
+
+	AudioStream()
+	{
+		backend=0;
+		source=0;
+		nQueued=0;
+		playing=false;
+		nBuffers=4;
+		blockSeconds=0.25;
+		nBlocksQueued=0;
+		nUnderruns=0;
+	}
+	~AudioStream()
+	{
+		close();
+	}
+
+	/* Open the file and make the source and buffers. Returns false if the file can't be streamed. */
+	bool open(AudioBackend* _backend, const char* _path, const bool _looping=false)
+	{
+		close();
+		if ( _backend==0 || wav.open(_path)==false ) { return false; }
+		if ( wav.nChannels>2 )
+		{
+			std::cout<<"ERROR: AudioStream: Only mono and stereo files can be streamed.\n";
+			wav.close();
+			return false;
+		}
+		wav.looping=_looping;
+
+		backend=_backend;
+		source = backend->createSource();
+		if ( source==0 )
+		{
+			std::cout<<"ERROR: AudioStream: No source for the stream.\n";
+			close();
+			return false;
+		}
+		for (int i=0;i<nBuffers;++i)
+		{
+			const unsigned int buffer = backend->createEmptyBuffer();
+			if ( buffer==0 ) { break; }
+			vBuffer.push_back(buffer);
+		}
+		if ( vBuffer.empty() )
+		{
+			close();
+			return false;
+		}
+
+		int blockFrames = (int)(blockSeconds*wav.samplesPerSecond);
+		if ( blockFrames<1 ) { blockFrames=1; }
+		vBlock.resize(blockFrames*wav.blockAlign);
+		return true;
+	}
+
+	/* Stop and free the source and buffers. */
+	void close()
+	{
+		if ( backend!=0 )
+		{
+			stop();
+			backend->setBuffer(source,0);
+			for (unsigned int i=0;i<vBuffer.size();++i)
+			{ backend->deleteBuffer(vBuffer[i]); }
+			backend->deleteSource(source);
+		}
+		vBuffer.clear();
+		std::vector <char>().swap(vBlock);
+		wav.close();
+		backend=0;
+		source=0;
+		nQueued=0;
+		playing=false;
+	}
+
+	/* Start from the beginning. Playback starts once the first block is queued, then the other buffers are filled. */
+	void play()
+	{
+		if ( backend==0 ) { return; }
+		stop();
+		wav.rewind();
+		if ( queueNext(vBuffer[0])==false ) { return; }
+		backend->play(source);
+		playing=true;
+		for (unsigned int i=1;i<vBuffer.size() && queueNext(vBuffer[i]);++i) {}
+	}
+
+	void stop()
+	{
+		if ( backend==0 ) { return; }
+		backend->stop(source);
+		while ( backend->unqueueBuffer(source)!=0 ) {}
+		nQueued=0;
+		playing=false;
+	}
+
+	/* Refill the buffers which have played. Should be called every frame or so. */
+	void update()
+	{
+		if ( backend==0 || playing==false ) { return; }
+
+		unsigned int buffer;
+		while ( (buffer=backend->unqueueBuffer(source))!=0 )
+		{
+			--nQueued;
+			queueNext(buffer);
+		}
+
+		if ( backend->isPlaying(source)==false )
+		{
+			if ( nQueued>0 )
+			{
+				// It ran out before the buffers were refilled.
+				++nUnderruns;
+				backend->play(source);
+			}
+			else
+			{ playing=false; }
+		}
+	}
+
+	void setGain(const float _gain)
+	{
+		if ( backend!=0 ) { backend->setGain(source,_gain); }
+	}
+
+	/* Whether there is still data to play. */
+	inline bool isPlaying() const
+	{ return playing; }
+
+	/* Bytes of PCM data in memory: the block and each buffer. */
+	inline unsigned long int bytesBuffered() const
+	{ return vBlock.size()*(vBuffer.size()+1); }
+
+	inline const WavStream& getWav() const
+	{ return wav; }
+};
+
+#endif /* #ifndef WILDCAT_AUDIO_AUDIO_STREAM_HPP */
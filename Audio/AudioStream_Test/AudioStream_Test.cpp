@@ -0,0 +1,223 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <Audio/AudioBackend.hpp>
+#include <Audio/AudioStream.hpp>
+#include <Audio/Wav.hpp>
+#include <Audio/WavStream.hpp>
+#include <System/Time/Timer.hpp>
+
+// g++ AudioStream_Test.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX -D WILDCAT_AUDIO
+
+// Headless test of WavStream and AudioStream on the null backend. Writes wav files with metadata chunks in awkward
+// places and checks they read back the same in blocks, that a stream plays a whole file with bounded memory, starts
+// after the first block, loops, and recovers from running out. Then compares the time to start playing and the
+// memory used with loading the whole file through Wav and Sound.
+
+const int SAMPLE_RATE = 44100;
+const double LONG_SECONDS = 60;
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+void writeU32(FILE* _file, const unsigned int _value)
+{
+	const unsigned char bytes[4] = {(unsigned char)_value,(unsigned char)(_value>>8),(unsigned char)(_value>>16),
+		(unsigned char)(_value>>24)};
+	fwrite(bytes,1,4,_file);
+}
+void writeU16(FILE* _file, const unsigned short _value)
+{
+	const unsigned char bytes[2] = {(unsigned char)_value,(unsigned char)(_value>>8)};
+	fwrite(bytes,1,2,_file);
+}
+
+// 16 bit stereo PCM data, which is different for every frame.
+std::vector <char> makeData(const int _nFrames)
+{
+	std::vector <char> vData (_nFrames*4);
+	short int* sample = (short int*)vData.data();
+	for (int i=0;i<_nFrames*2;++i) { sample[i] = (short int)(i*37); }
+	return vData;
+}
+
+// A wav file with an odd sized LIST chunk before fmt, an 18 byte fmt chunk, and a JUNK chunk before data. Extensible
+// writes WAVE_FORMAT_EXTENSIBLE. _claimedBytes is written as the data size, like a recording which was cut short.
+void writeAwkwardWav(const char* _path, const std::vector <char>& _vData, const bool _extensible,
+	const unsigned int _claimedBytes)
+{
+	FILE* file = fopen(_path,"wb");
+	fwrite("RIFF",1,4,file);
+	writeU32(file,0); // wrong, but only the chunks matter
+	fwrite("WAVE",1,4,file);
+
+	fwrite("LIST",1,4,file);
+	writeU32(file,5);
+	fwrite("INFOx",1,5,file);
+	fwrite("\0",1,1,file); // pad byte
+
+	fwrite("fmt ",1,4,file);
+	writeU32(file,_extensible ? 40 : 18);
+	writeU16(file,_extensible ? 0xFFFE : 1);
+	writeU16(file,2);
+	writeU32(file,SAMPLE_RATE);
+	writeU32(file,SAMPLE_RATE*4);
+	writeU16(file,4);
+	writeU16(file,16);
+	writeU16(file,_extensible ? 22 : 0);
+	if ( _extensible )
+	{
+		writeU16(file,16);
+		writeU32(file,3);
+		writeU16(file,1); // KSDATAFORMAT_SUBTYPE_PCM
+		const char guid[14] = {0,0,0,0,16,0,(char)128,0,0,(char)170,0,56,(char)155,113};
+		fwrite(guid,1,14,file);
+	}
+
+	fwrite("JUNK",1,4,file);
+	writeU32(file,28);
+	const char junk[28] = {0};
+	fwrite(junk,1,28,file);
+
+	fwrite("data",1,4,file);
+	writeU32(file,_claimedBytes);
+	fwrite(_vData.data(),1,_vData.size(),file);
+	fclose(file);
+}
+
+int main (int nArgs, char ** arg)
+{
+	const std::vector <char> vData = makeData(SAMPLE_RATE*3/2);
+	writeAwkwardWav("AudioStream_Test1.wav",vData,false,vData.size());
+	writeAwkwardWav("AudioStream_Test2.wav",vData,true,0xFFFFFFFF);
+
+	// Headers with metadata chunks.
+	WavStream wav;
+	check("Metadata chunks are skipped", wav.open("AudioStream_Test1.wav") && wav.nChannels==2
+		&& wav.bitsPerSample==16 && wav.samplesPerSecond==SAMPLE_RATE && wav.getDataBytes()==vData.size());
+	WavStream extensible;
+	check("Extensible format, and data cut short", extensible.open("AudioStream_Test2.wav")
+		&& extensible.getDataBytes()==vData.size() && extensible.getDurationSeconds()==1.5);
+
+	std::cout<<"Expecting an error:\n";
+	WavStream missing;
+	check("Missing files don't open", missing.open("AudioStream_Test_Missing.wav")==false && missing.read(0,100)==0);
+
+	// Reads in odd sized blocks give whole frames and the same data.
+	std::vector <char> vRead;
+	std::vector <char> vBlock (1001);
+	bool wholeFrames = true;
+	int nBytes;
+	while ( (nBytes=wav.read(vBlock.data(),vBlock.size()))>0 )
+	{
+		if ( nBytes%4!=0 ) { wholeFrames=false; }
+		vRead.insert(vRead.end(),vBlock.begin(),vBlock.begin()+nBytes);
+	}
+	check("Reads are whole frames", wholeFrames);
+	check("Reads give the data", vRead==vData && wav.atEnd());
+
+	wav.looping=true;
+	wav.rewind();
+	std::vector <char> vLoop (vData.size()+400);
+	check("Looping reads wrap around", wav.read(vLoop.data(),vLoop.size())==(int)vLoop.size()
+		&& std::equal(vData.begin(),vData.end(),vLoop.begin())
+		&& std::equal(vLoop.begin()+vData.size(),vLoop.end(),vData.begin()) && wav.atEnd()==false);
+
+	Wav wholeWav;
+	wholeWav.readFile("AudioStream_Test1.wav");
+	check("Wav::readFile skips metadata chunks", wholeWav.nAudioBytes==(int)vData.size() && wholeWav.NumChannels==2
+		&& std::equal(vData.begin(),vData.end(),wholeWav.data));
+
+	// Streaming on the null backend.
+	AudioBackend_Null backend;
+	AudioStream stream;
+	stream.nBuffers=3;
+	stream.blockSeconds=0.25;
+	check("Stream opens", stream.open(&backend,"AudioStream_Test1.wav"));
+	const unsigned long int blockBytes = SAMPLE_RATE/4*4;
+	stream.play();
+	check("Playback starts with the buffers queued", stream.isPlaying() && backend.isPlaying(1)
+		&& backend.nPlays==1 && stream.nBlocksQueued==3);
+
+	unsigned long int maxHeld=0;
+	double seconds=0;
+	while ( stream.isPlaying() && seconds<10 )
+	{
+		backend.advance(0.1);
+		seconds+=0.1;
+		stream.update();
+		maxHeld = std::max(maxHeld,backend.bytesHeld());
+	}
+	check("The whole file is played", stream.isPlaying()==false && backend.bytesUploaded==vData.size()
+		&& seconds>1.45 && seconds<1.65);
+	check("Memory is bounded", maxHeld<=3*blockBytes && stream.bytesBuffered()==4*blockBytes);
+	check("No underruns", stream.nUnderruns==0);
+
+	// Running out, then recovering.
+	stream.play();
+	backend.advance(1);
+	stream.update();
+	check("Running out is an underrun, and it restarts", stream.nUnderruns==1 && stream.isPlaying()
+		&& backend.isPlaying(1));
+	stream.stop();
+	check("stop", stream.isPlaying()==false && backend.isPlaying(1)==false);
+
+	// Looping keeps going.
+	AudioStream loop;
+	loop.open(&backend,"AudioStream_Test2.wav",true);
+	loop.play();
+	for (int i=0;i<100;++i)
+	{
+		backend.advance(0.1);
+		loop.update();
+	}
+	check("Looping streams keep playing", loop.isPlaying() && loop.nUnderruns==0
+		&& loop.getWav().getBytesRead()<vData.size());
+	loop.close();
+	stream.close();
+	check("close frees the buffers", backend.bytesHeld()==0 && backend.nBuffersDeleted==backend.nBuffersCreated);
+
+	std::remove("AudioStream_Test1.wav");
+	std::remove("AudioStream_Test2.wav");
+
+	// Benchmark: a long track, streamed or loaded.
+	const std::vector <char> vLong = makeData((int)(LONG_SECONDS*SAMPLE_RATE));
+	writeAwkwardWav("AudioStream_Test_Long.wav",vLong,false,vLong.size());
+
+	Timer timer;
+	timer.init();
+	timer.start();
+	AudioBackend_Null streamBackend;
+	AudioStream longStream;
+	longStream.open(&streamBackend,"AudioStream_Test_Long.wav");
+	longStream.play();
+	timer.update();
+	const double streamSeconds = timer.fullSeconds;
+
+	timer.init();
+	timer.start();
+	AudioBackend_Null loadBackend;
+	Wav longWav;
+	longWav.readFile("AudioStream_Test_Long.wav");
+	Sound* longSound = longWav.toSound();
+	const unsigned int longBuffer = loadBackend.createBuffer(longSound);
+	const unsigned int longSource = loadBackend.createSource();
+	loadBackend.setBuffer(longSource,longBuffer);
+	loadBackend.play(longSource);
+	timer.update();
+	const double loadSeconds = timer.fullSeconds;
+
+	std::cout<<LONG_SECONDS<<"s track. Stream: playing after "<<streamSeconds<<"s, "<<longStream.bytesBuffered()
+		<<" bytes in memory. Wav and Sound: playing after "<<loadSeconds<<"s, "<<longWav.nAudioBytes+longSound->nData
+		<<" bytes in memory, plus "<<loadBackend.bytesHeld()<<" in the buffer.\n";
+	std::remove("AudioStream_Test_Long.wav");
+
+	std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+	return nFailed==0 ? 0 : 1;
+}
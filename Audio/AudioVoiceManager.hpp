@@ -0,0 +1,370 @@
+#pragma once
+#ifndef WILDCAT_AUDIO_AUDIO_VOICE_MANAGER_HPP
+#define WILDCAT_AUDIO_AUDIO_VOICE_MANAGER_HPP
+
+/* Wildcat: AudioVoiceManager
+	#include <Audio/AudioVoiceManager.hpp>
+
+	Plays sounds on a fixed pool of sources, so playing a sound doesn't make a new buffer and source each time.
+
+	Each Sound's PCM data is uploaded once, the first time it is preloaded or played, and kept until unloadSound()
+	or close(). Buffers are reference counted: each playing voice holds a reference, as does the cache. A buffer is
+	only deleted once no voice is playing it, because a buffer can't be deleted while a source is using it.
+
+	There are maxVoices sources, made by init(). A finished voice is reclaimed by update(), or when a new sound
+	needs a voice. If all voices are busy, the voice with the lowest priority is taken, the oldest if there's a tie.
+	A voice with a higher priority than the new sound is never taken, so the new sound is dropped instead.
+
+	maxInstances limits how many copies of one sound can play at once. Past the limit, the oldest copy is restarted
+	rather than taking another voice, so repeated sounds like gunfire don't drown everything else out.
+*/
+
+#include <Audio/AudioBackend.hpp>
+#include <Audio/Sound.hpp>
+#include <Container/Vector/Vector.hpp>
+
+#include <iostream>
+#include <unordered_map>
+
+class AudioVoice
+{
+	public:
+	unsigned int source;
+	unsigned int buffer; // the buffer attached to the source, so it's only set when it changes
+	Sound* sound; // 0 if the voice is free
+	int priority;
+	unsigned long int playID; // increases with every play, so lower is older
+	bool looping;
+};
+
+class AudioVoiceManager
+{
+	private:
+
+	class AudioVoiceBuffer
+	{
+		public:
+		unsigned int buffer;
+		int nReferences;
+		bool cached; // whether the cache holds a reference
+	};
+
+	AudioBackend* backend;
+	Vector <AudioVoice> vVoice;
+	std::unordered_map <const Sound*, AudioVoiceBuffer> mBuffer;
+	unsigned long int nextPlayID;
+
+	void releaseBuffer(const Sound* _sound)
+	{
+		std::unordered_map <const Sound*, AudioVoiceBuffer>::iterator it = mBuffer.find(_sound);
+		if ( it==mBuffer.end() ) { return; }
+		if ( --it->second.nReferences > 0 ) { return; }
+
+		// Detach it from any free sources first.
+		for (int i=0;i<vVoice.size();++i)
+		{
+			if ( vVoice(i).buffer==it->second.buffer )
+			{
+				backend->setBuffer(vVoice(i).source,0);
+				vVoice(i).buffer=0;
+			}
+		}
+		backend->deleteBuffer(it->second.buffer);
+		mBuffer.erase(it);
+	}
+
+	/* The sound's buffer, uploading it the first time. Returns 0 if it can't be uploaded. */
+	unsigned int getBuffer(Sound* _sound)
+	{
+		std::unordered_map <const Sound*, AudioVoiceBuffer>::iterator it = mBuffer.find(_sound);
+		if ( it!=mBuffer.end() )
+		{
+			// It was unloaded while playing, so cache it again.
+			if ( it->second.cached==false )
+			{
+				it->second.cached=true;
+				++it->second.nReferences;
+			}
+			return it->second.buffer;
+		}
+
+		const unsigned int buffer = backend->createBuffer(_sound);
+		if ( buffer==0 ) { return 0; }
+		AudioVoiceBuffer record;
+		record.buffer=buffer;
+		record.nReferences=1; // the cache's reference
+		record.cached=true;
+		mBuffer[_sound]=record;
+		return buffer;
+	}
+
+	void freeVoice(AudioVoice& _voice)
+	{
+		if ( _voice.sound==0 ) { return; }
+		Sound* sound = _voice.sound;
+		_voice.sound=0;
+		releaseBuffer(sound);
+	}
+
+	void stopVoice(AudioVoice& _voice)
+	{
+		if ( _voice.sound==0 ) { return; }
+		backend->stop(_voice.source);
+		freeVoice(_voice);
+	}
+
+	/* The voice to play a new sound on, or -1 if every voice is playing something more important. */
+	int findVoice(Sound* _sound, const int _priority, const int _maxInstances)
+	{
+		if ( _maxInstances>0 )
+		{
+			int nInstances=0;
+			int oldest=-1;
+			for (int i=0;i<vVoice.size();++i)
+			{
+				if ( vVoice(i).sound==_sound )
+				{
+					++nInstances;
+					if ( oldest==-1 || vVoice(i).playID<vVoice(oldest).playID ) { oldest=i; }
+				}
+			}
+			if ( nInstances>=_maxInstances )
+			{
+				++nInstancesRestarted;
+				return oldest;
+			}
+		}
+
+		for (int pass=0;pass<2;++pass)
+		{
+			for (int i=0;i<vVoice.size();++i)
+			{
+				if ( vVoice(i).sound==0 ) { return i; }
+			}
+			// Nothing free, so reclaim finished voices and look again.
+			if ( pass==0 ) { update(); }
+		}
+
+		int steal=-1;
+		for (int i=0;i<vVoice.size();++i)
+		{
+			const AudioVoice& voice = vVoice(i);
+			if ( voice.priority>_priority ) { continue; }
+			if ( steal==-1 || voice.priority<vVoice(steal).priority
+				|| (voice.priority==vVoice(steal).priority && voice.playID<vVoice(steal).playID) )
+			{ steal=i; }
+		}
+		if ( steal!=-1 ) { ++nVoicesStolen; }
+		return steal;
+	}
+
+	public:
+
+	int maxVoices;
+	float gain; // for every voice
+
+	/* Stats, for tests and benchmarks. */
+	unsigned long int nVoicesStolen;
+	unsigned long int nInstancesRestarted;
+	unsigned long int nDropped;
+
+	AudioVoiceManager()
+	{
+		backend=0;
+		nextPlayID=1;
+		maxVoices=32;
+		gain=1;
+		nVoicesStolen=0;
+		nInstancesRestarted=0;
+		nDropped=0;
+	}
+	~AudioVoiceManager()
+	{
+		close();
+	}
+
+	/* Make the pool of sources. There may be fewer than _maxVoices if the backend runs out. */
+	void init(AudioBackend* _backend, const int _maxVoices=32)
+	{
+		close();
+		backend=_backend;
+		maxVoices=_maxVoices;
+		if ( backend==0 ) { return; }
+
+		for (int i=0;i<maxVoices;++i)
+		{
+			const unsigned int source = backend->createSource();
+			if ( source==0 )
+			{
+				std::cout<<"WARNING: AudioVoiceManager: Only "<<i<<" of "<<maxVoices<<" sources could be made.\n";
+				break;
+			}
+			AudioVoice voice;
+			voice.source=source;
+			voice.buffer=0;
+			voice.sound=0;
+			voice.priority=0;
+			voice.playID=0;
+			voice.looping=false;
+			vVoice.push(voice);
+		}
+	}
+
+	/* Stop everything and delete every source and buffer. */
+	void close()
+	{
+		if ( backend==0 ) { return; }
+		for (int i=0;i<vVoice.size();++i)
+		{
+			stopVoice(vVoice(i));
+			backend->setBuffer(vVoice(i).source,0);
+			backend->deleteSource(vVoice(i).source);
+		}
+		vVoice.clear();
+		for (std::unordered_map <const Sound*, AudioVoiceBuffer>::iterator it=mBuffer.begin();it!=mBuffer.end();++it)
+		{ backend->deleteBuffer(it->second.buffer); }
+		mBuffer.clear();
+		backend=0;
+	}
+
+	/* Upload the sound now, so it doesn't need to be done when it's first played. */
+	bool preloadSound(Sound* _sound)
+	{
+		if ( backend==0 || _sound==0 ) { return false; }
+		return getBuffer(_sound)!=0;
+	}
+
+	/* Drop the cached buffer. It is deleted once nothing is playing it. */
+	void unloadSound(Sound* _sound)
+	{
+		if ( backend==0 ) { return; }
+		std::unordered_map <const Sound*, AudioVoiceBuffer>::iterator it = mBuffer.find(_sound);
+		if ( it==mBuffer.end() || it->second.cached==false ) { return; }
+		it->second.cached=false;
+		releaseBuffer(_sound);
+	}
+
+	/* Play a sound. Returns an ID for stop(), or 0 if it was dropped. _maxInstances of 0 has no limit. */
+	unsigned long int play(Sound* _sound, const int _priority=0, const int _maxInstances=0, const bool _looping=false)
+	{
+		if ( backend==0 || _sound==0 ) { return 0; }
+
+		const unsigned int buffer = getBuffer(_sound);
+		if ( buffer==0 ) { return 0; }
+
+		const int slot = findVoice(_sound,_priority,_maxInstances);
+		if ( slot==-1 )
+		{
+			++nDropped;
+			return 0;
+		}
+
+		AudioVoice& voice = vVoice(slot);
+		// Take the buffer's reference before the old sound's is released, in case they're the same sound.
+		++mBuffer[_sound].nReferences;
+		if ( voice.sound!=0 )
+		{ backend->stop(voice.source); }
+		freeVoice(voice);
+
+		if ( voice.buffer!=buffer )
+		{
+			backend->setBuffer(voice.source,buffer);
+			voice.buffer=buffer;
+		}
+		if ( voice.looping!=_looping )
+		{ backend->setLooping(voice.source,_looping); }
+		backend->setGain(voice.source,gain);
+		backend->play(voice.source);
+
+		voice.sound=_sound;
+		voice.priority=_priority;
+		voice.playID=nextPlayID++;
+		voice.looping=_looping;
+		return voice.playID;
+	}
+
+	/* Stop one play of a sound, by the ID from play(). */
+	void stop(const unsigned long int _playID)
+	{
+		for (int i=0;i<vVoice.size();++i)
+		{
+			if ( vVoice(i).sound!=0 && vVoice(i).playID==_playID )
+			{ stopVoice(vVoice(i)); }
+		}
+	}
+
+	/* Stop every play of a sound. */
+	void stopSound(Sound* _sound)
+	{
+		for (int i=0;i<vVoice.size();++i)
+		{
+			if ( vVoice(i).sound==_sound )
+			{ stopVoice(vVoice(i)); }
+		}
+	}
+
+	void stopAll()
+	{
+		for (int i=0;i<vVoice.size();++i)
+		{ stopVoice(vVoice(i)); }
+	}
+
+	/* Reclaim voices which have finished playing. Should be called every frame or so. */
+	void update()
+	{
+		if ( backend==0 ) { return; }
+		for (int i=0;i<vVoice.size();++i)
+		{
+			if ( vVoice(i).sound!=0 && backend->isPlaying(vVoice(i).source)==false )
+			{ freeVoice(vVoice(i)); }
+		}
+	}
+
+	void setGain(const float _gain)
+	{
+		gain=_gain;
+		if ( backend==0 ) { return; }
+		for (int i=0;i<vVoice.size();++i)
+		{ backend->setGain(vVoice(i).source,gain); }
+	}
+
+	int nVoices()
+	{ return vVoice.size(); }
+
+	/* Voices which are playing something, as of the last update(). */
+	int nActive()
+	{
+		int nActive=0;
+		for (int i=0;i<vVoice.size();++i)
+		{
+			if ( vVoice(i).sound!=0 ) { ++nActive; }
+		}
+		return nActive;
+	}
+
+	/* How many voices are playing a sound. */
+	int nInstances(const Sound* _sound)
+	{
+		int nInstances=0;
+		for (int i=0;i<vVoice.size();++i)
+		{
+			if ( vVoice(i).sound==_sound ) { ++nInstances; }
+		}
+		return nInstances;
+	}
+
+	bool isLoaded(const Sound* _sound) const
+	{ return mBuffer.count(_sound)!=0; }
+
+	int nBuffers() const
+	{ return mBuffer.size(); }
+
+	/* References to a sound's buffer: 1 for the cache, and 1 for each voice playing it. */
+	int nReferences(const Sound* _sound) const
+	{
+		std::unordered_map <const Sound*, AudioVoiceBuffer>::const_iterator it = mBuffer.find(_sound);
+		return it==mBuffer.end() ? 0 : it->second.nReferences;
+	}
+};
+
+#endif /* #ifndef WILDCAT_AUDIO_AUDIO_VOICE_MANAGER_HPP */
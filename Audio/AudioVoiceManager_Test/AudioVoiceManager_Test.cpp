@@ -0,0 +1,160 @@
+#include <iostream>
+#include <string>
+
+#include <Audio/AudioBackend.hpp>
+#include <Audio/AudioVoiceManager.hpp>
+#include <System/Time/Timer.hpp>
+
+// g++ AudioVoiceManager_Test.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX
+
+// Headless test of AudioVoiceManager on the null backend. Checks that each sound is uploaded once, that buffers
+// are only deleted once nothing plays them, voice stealing by priority and age, and maxInstances. Then compares
+// many plays on the voice pool with making a buffer and source for every play, as playSoundOnce() used to.
+
+const int N_PLAYS = 100000;
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+// 16 bit mono sound of the given length.
+void makeSound(Sound& _sound, const double _seconds)
+{
+	_sound.nChannels=1;
+	_sound.bitsPerSample=16;
+	_sound.samplesPerSecond=44100;
+	_sound.byteRate=44100*2;
+	_sound.durationSeconds=_seconds;
+	_sound.nData=(int)(_seconds*44100)*2;
+	_sound.data=new char [_sound.nData]();
+}
+
+int main (int nArgs, char ** arg)
+{
+	Sound shot, step, music, alarm;
+	makeSound(shot,0.5);
+	makeSound(step,0.25);
+	makeSound(music,10);
+	makeSound(alarm,1);
+
+	AudioBackend_Null backend;
+	AudioVoiceManager voices;
+	voices.init(&backend,8);
+	check("Sources are made once", voices.nVoices()==8 && backend.nSourcesCreated==8);
+
+	check("Preload uploads the sound", voices.preloadSound(&shot) && backend.nBuffersCreated==1
+		&& voices.nReferences(&shot)==1);
+	for (int i=0;i<20;++i)
+	{
+		voices.play(&shot);
+		backend.advance(1);
+	}
+	check("Each sound is uploaded once", backend.nBuffersCreated==1 && backend.bytesUploaded==(unsigned long int)shot.nData);
+	check("Sources are recycled", backend.nSourcesCreated==8 && voices.nDropped==0);
+	check("The buffer is only attached when a source changes sound", backend.nSetBuffer==8);
+
+	voices.update();
+	check("Finished voices are reclaimed", voices.nActive()==0 && voices.nReferences(&shot)==1);
+
+	// maxInstances restarts the oldest copy instead of taking more voices.
+	unsigned long int firstStep = voices.play(&step,0,3);
+	for (int i=0;i<9;++i) { voices.play(&step,0,3); }
+	check("maxInstances is enforced", voices.nInstances(&step)==3 && voices.nInstancesRestarted==7
+		&& voices.nActive()==3 && voices.nReferences(&step)==4);
+	voices.stop(firstStep);
+	check("A restarted play has a new ID", voices.nInstances(&step)==3);
+	voices.stopSound(&step);
+	check("stopSound", voices.nInstances(&step)==0 && voices.nReferences(&step)==1);
+
+	// Fill every voice, then see which are taken.
+	const unsigned long int lowID = voices.play(&alarm,2);
+	for (int i=0;i<7;++i) { voices.play(&shot,5); }
+	check("Every voice busy", voices.nActive()==8);
+	check("Less important sounds are dropped", voices.play(&step,1)==0 && voices.nDropped==1);
+	voices.play(&step,9);
+	check("The lowest priority voice is taken first", voices.nInstances(&alarm)==0 && voices.nVoicesStolen==1);
+	const unsigned long int oldestShot = lowID+1;
+	voices.play(&step,5);
+	check("Then the oldest voice of equal priority", voices.nInstances(&shot)==6 && voices.nVoicesStolen==2);
+	voices.stop(oldestShot);
+	check("Stopping a stolen play does nothing", voices.nActive()==8);
+	voices.stopAll();
+	check("stopAll", voices.nActive()==0);
+
+	// Unloading a playing sound keeps its buffer until it finishes.
+	voices.play(&music);
+	voices.play(&alarm,0,0,true);
+	voices.unloadSound(&music);
+	voices.unloadSound(&music);
+	check("Unloaded buffer is kept while playing", voices.isLoaded(&music) && voices.nReferences(&music)==1
+		&& backend.nBuffersDeleted==0);
+	backend.advance(11);
+	voices.update();
+	check("Unloaded buffer is deleted once finished", voices.isLoaded(&music)==false && backend.nBuffersDeleted==1);
+	check("Looping sounds keep playing", voices.nInstances(&alarm)==1);
+	voices.unloadSound(&alarm);
+	voices.stopSound(&alarm);
+	check("Stopping deletes an unloaded buffer", voices.isLoaded(&alarm)==false && backend.nBuffersDeleted==2);
+
+	voices.close();
+	check("close deletes every buffer", backend.nBuffersDeleted==backend.nBuffersCreated);
+
+	AudioBackend_Null smallBackend;
+	smallBackend.maxSources=4;
+	AudioVoiceManager smallVoices;
+	std::cout<<"Expecting a warning:\n";
+	smallVoices.init(&smallBackend,8);
+	check("Fewer sources than asked for", smallVoices.nVoices()==4);
+
+	// Many short plays, with time passing between them.
+	AudioBackend_Null poolBackend;
+	AudioVoiceManager pool;
+	pool.init(&poolBackend,32);
+	Timer timer;
+	timer.init();
+	timer.start();
+	for (int i=0;i<N_PLAYS;++i)
+	{
+		pool.play(i%2==0 ? &shot : &step,i%3,4);
+		if ( i%8==0 )
+		{
+			poolBackend.advance(0.016);
+			pool.update();
+		}
+	}
+	timer.update();
+	const double poolSeconds = timer.fullSeconds;
+
+	// The old way: a new buffer and source per play, deleted again by garbageCollect().
+	AudioBackend_Null oldBackend;
+	oldBackend.maxSources=N_PLAYS;
+	timer.init();
+	timer.start();
+	for (int i=0;i<N_PLAYS;++i)
+	{
+		Sound* sound = i%2==0 ? &shot : &step;
+		const unsigned int buffer = oldBackend.createBuffer(sound);
+		const unsigned int source = oldBackend.createSource();
+		oldBackend.setBuffer(source,buffer);
+		oldBackend.setGain(source,1);
+		oldBackend.play(source);
+		oldBackend.stop(source);
+		oldBackend.deleteSource(source);
+		oldBackend.deleteBuffer(buffer);
+	}
+	timer.update();
+	const double oldSeconds = timer.fullSeconds;
+
+	check("Pool uploads each sound once", poolBackend.nBuffersCreated==2 && poolBackend.nSourcesCreated==32);
+
+	std::cout<<N_PLAYS<<" plays. Voice pool: "<<poolSeconds<<"s, "<<poolBackend.bytesUploaded<<" bytes uploaded, "
+		<<poolBackend.nSourcesCreated<<" sources. New buffer and source per play: "<<oldSeconds<<"s, "
+		<<oldBackend.bytesUploaded<<" bytes uploaded, "<<oldBackend.nSourcesCreated<<" sources.\n";
+
+	std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+	return nFailed==0 ? 0 : 1;
+}
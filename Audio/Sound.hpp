@@ -11,6 +11,8 @@ Class to store sound data in internally portable format. Sound objects may be pa
 
 #include <Data/DataTools.hpp>
 
+#include <cstring>
+
 
 class Sound
 {
@@ -351,10 +353,7 @@ class Sound
 		// } std::cout<<"\n";
 		
 		
-		for(int i=0;i<nData;++i)
-		{
-			data[i]=_data[i];
-		}
+		std::memcpy(data,_data,nData);
 		
 	}
 	/* 8 bit values have been passed. */
@@ -5,9 +5,9 @@
 /* Wildcat: Wav
    #include <Audio/Wav.hpp>
    
-   Class to load wav audio files. It is currently very touchy
-   and generally only loads files saved in Audacity with metadata
-   stripped.
+   Class to load wav audio files. Metadata chunks are skipped.
+   To play long files without loading them, use WavStream and
+   AudioStream instead.
    
    The wav files are loaded into a generic internal Sound object.
    
@@ -21,6 +21,11 @@
    to load properly.
 */
 
+#include <Audio/Sound.hpp>
+#include <Audio/WavStream.hpp>
+
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 
 class Wav
@@ -63,57 +68,38 @@ class Wav
 	{
 #ifdef WILDCAT_AUDIO
       
-		// Read the wave file
-		FILE *fhandle=fopen(PATH,"rb");
-		
-		if (!fhandle)
+		// The chunks are walked by WavStream, so metadata chunks don't break loading.
+		WavStream stream;
+		if (stream.open(PATH)==false)
 		{
 			std::cout<<"ERROR: Wav file couldn't be opened.\n";
 			return;
 		}
 		
-		fread(chunkID,1,4,fhandle);
+		std::memcpy(chunkID,"RIFF",4);
+		std::memcpy(format,"WAVE",4);
+		std::memcpy(Subchunk1ID,"fmt ",4);
+		std::memcpy(Subchunk2ID,"data",4);
+		fileSize=stream.riffSize;
+		ChunkSize=stream.riffSize;
+		Subchunk1Size=16;
+		AudioFormat=1;
+		NumChannels=stream.nChannels;
+		SampleRate=stream.samplesPerSecond;
+		BlockAlign=stream.blockAlign;
+		BitsPerSample=stream.bitsPerSample;
+		ByteRate=SampleRate*BlockAlign;
+		Subchunk2Size=stream.getDataBytes();
 		
-		if(chunkID[0]=='R'&&chunkID[1]=='I'&&chunkID[2]=='F'&&chunkID[3]=='F')
-		{
-			fread(&fileSize,4,1,fhandle);
-			fread(format,1,4,fhandle);
+		nAudioBytes=Subchunk2Size;
+		data=new char [nAudioBytes];
+		nAudioBytes=stream.read(data,nAudioBytes);
 		
-         if(format[0]=='W'&&format[1]=='A'&&format[2]=='V'&&format[3]=='E')
-         {
-            fread(Subchunk1ID,1,4,fhandle);
-            fread(&Subchunk1Size,4,1,fhandle);
-            fread(&AudioFormat,2,1,fhandle);
-            fread(&NumChannels,2,1,fhandle);
-            fread(&SampleRate,4,1,fhandle);
-            fread(&ByteRate,4,1,fhandle);
-            fread(&BlockAlign,2,1,fhandle);
-            fread(&BitsPerSample,2,1,fhandle);
-            fread(&Subchunk2ID,1,4,fhandle);
-            fread(&Subchunk2Size,4,1,fhandle);
-            nAudioBytes=Subchunk2Size/(BitsPerSample/8)*NumChannels;
-            data=new char [nAudioBytes]; // Create an element for every sample
-            fread(data,1,nAudioBytes,fhandle); // Reading raw audio data byte by byte.
-            fclose(fhandle);
-            
-            std::cout<<"fileSize: "<<fileSize<<".\n";
-            std::cout<<"nAudioBytes: "<<nAudioBytes<<".\n";
-
-            /* Exact audio length is ChunkSize/ByteRate. */
-            duration = (double)nAudioBytes/ByteRate;
-            std::cout<<"Duration: "<<duration<<".\n";
-
-         
-         }
-         else
-         {
-            std::cout<<"Wave header not found.\n";
-         }
-		}
-		else
-		{
-			std::cout<<"Wav.hpp Error: chunkID is invalid.\n";
-		}
+		std::cout<<"fileSize: "<<fileSize<<".\n";
+		std::cout<<"nAudioBytes: "<<nAudioBytes<<".\n";
+		
+		duration = (double)nAudioBytes/ByteRate;
+		std::cout<<"Duration: "<<duration<<".\n";
       
 #else
       std::cout<<"Wav loading disabled. Define WILDCAT_AUDIO to enable.\n";
@@ -146,6 +132,52 @@ class Wav
 		// }
 	}
 	
+	/* Save an 8 or 16 bit Sound as a PCM wav file. Returns false if it couldn't be written. */
+	static bool writeFile(const char* PATH, const Sound* sound)
+	{
+		if ( sound==0 || sound->data==0 || (sound->bitsPerSample!=8 && sound->bitsPerSample!=16) )
+		{
+			std::cout<<"ERROR: Wav: Only 8 and 16 bit sounds can be written.\n";
+			return false;
+		}
+		FILE *fhandle=fopen(PATH,"wb");
+		if (!fhandle)
+		{
+			std::cout<<"ERROR: Wav file couldn't be opened for writing.\n";
+			return false;
+		}
+		
+		const int dataSize = sound->nData;
+		const int chunkSize = 36+dataSize;
+		const int subchunk1Size = 16;
+		const short audioFormat = 1; // PCM
+		const short nChannels = sound->nChannels;
+		const int sampleRate = sound->samplesPerSecond;
+		const short blockAlign = sound->nChannels*sound->bitsPerSample/8;
+		const int byteRate = sampleRate*blockAlign;
+		const short bitsPerSample = sound->bitsPerSample;
+		
+		fwrite("RIFF",1,4,fhandle);
+		fwrite(&chunkSize,4,1,fhandle);
+		fwrite("WAVE",1,4,fhandle);
+		fwrite("fmt ",1,4,fhandle);
+		fwrite(&subchunk1Size,4,1,fhandle);
+		fwrite(&audioFormat,2,1,fhandle);
+		fwrite(&nChannels,2,1,fhandle);
+		fwrite(&sampleRate,4,1,fhandle);
+		fwrite(&byteRate,4,1,fhandle);
+		fwrite(&blockAlign,2,1,fhandle);
+		fwrite(&bitsPerSample,2,1,fhandle);
+		fwrite("data",1,4,fhandle);
+		fwrite(&dataSize,4,1,fhandle);
+		const bool written = (int)fwrite(sound->data,1,dataSize,fhandle)==dataSize;
+		fclose(fhandle);
+		
+		if ( written==false )
+		{ std::cout<<"ERROR: Wav file couldn't be written.\n"; }
+		return written;
+	}
+	
 };
 
 #endif /* #ifndef AUDIO_WAV_HPP */
@@ -0,0 +1,190 @@
+#pragma once
+#ifndef WILDCAT_AUDIO_WAV_STREAM_HPP
+#define WILDCAT_AUDIO_WAV_STREAM_HPP
+
+/* Wildcat: WavStream
+	#include <Audio/WavStream.hpp>
+
+	Reads the PCM data of a wav file a block at a time, so a long file doesn't need to be in memory at once.
+
+	open() walks the RIFF chunks instead of assuming a fixed header, so metadata chunks such as LIST, fact, bext,
+	cue and JUNK are skipped wherever they are. The fmt chunk can be longer than 16 bytes, and WAVE_FORMAT_EXTENSIBLE
+	files are read if they hold 8 or 16 bit PCM. Chunks with an odd size have a pad byte, which is skipped. If the
+	data chunk claims to be bigger than the file, as it does when a recording was cut short, the rest of the file
+	is used.
+
+	read() only returns whole frames. If looping is set, it goes back to the start of the data at the end.
+*/
+
+#include <cstdio>
+#include <iostream>
+
+class WavStream
+{
+	private:
+
+	FILE* file;
+	long dataStart; // file offset of the PCM data
+	unsigned int dataBytes;
+	unsigned int bytesRead; // from the start of the data
+
+	static unsigned int readU32(const unsigned char* _bytes)
+	{ return _bytes[0] | _bytes[1]<<8 | _bytes[2]<<16 | (unsigned int)_bytes[3]<<24; }
+	static unsigned short readU16(const unsigned char* _bytes)
+	{ return _bytes[0] | _bytes[1]<<8; }
+
+	bool fail(const char* _error)
+	{
+		std::cout<<"ERROR: WavStream: "<<_error<<"\n";
+		close();
+		return false;
+	}
+
+	public:
+
+	int nChannels;
+	int bitsPerSample;
+	int samplesPerSecond;
+	int blockAlign; // bytes per frame
+	unsigned int riffSize;
+
+	bool looping;
+
+	WavStream()
+	{
+		file=0;
+		dataStart=0;
+		dataBytes=0;
+		bytesRead=0;
+		nChannels=0;
+		bitsPerSample=0;
+		samplesPerSecond=0;
+		blockAlign=0;
+		riffSize=0;
+		looping=false;
+	}
+	~WavStream()
+	{
+		close();
+	}
+
+	/* Read the header and go to the start of the data. Returns false if it isn't an 8 or 16 bit PCM wav file. */
+	bool open(const char* _path)
+	{
+		close();
+		file = fopen(_path,"rb");
+		if ( file==0 ) { return fail("File couldn't be opened."); }
+
+		fseek(file,0,SEEK_END);
+		const long fileSize = ftell(file);
+		fseek(file,0,SEEK_SET);
+
+		unsigned char header[12];
+		if ( fread(header,1,12,file)!=12 ) { return fail("File is too short."); }
+		if ( header[0]!='R' || header[1]!='I' || header[2]!='F' || header[3]!='F' ) { return fail("No RIFF header."); }
+		if ( header[8]!='W' || header[9]!='A' || header[10]!='V' || header[11]!='E' ) { return fail("Not a wave file."); }
+		riffSize = readU32(header+4);
+
+		bool foundFormat = false;
+		while ( true )
+		{
+			unsigned char chunk[8];
+			if ( fread(chunk,1,8,file)!=8 ) { return fail("No data chunk."); }
+			const unsigned int chunkSize = readU32(chunk+4);
+			const long chunkStart = ftell(file);
+
+			if ( chunk[0]=='f' && chunk[1]=='m' && chunk[2]=='t' && chunk[3]==' ' )
+			{
+				unsigned char format[40] = {0};
+				if ( chunkSize<16 || fread(format,1,chunkSize<40 ? chunkSize : 40,file)<16 )
+				{ return fail("fmt chunk is too short."); }
+				unsigned short audioFormat = readU16(format);
+				// WAVE_FORMAT_EXTENSIBLE keeps the real format at the start of the sub format GUID.
+				if ( audioFormat==0xFFFE && chunkSize>=26 ) { audioFormat = readU16(format+24); }
+				nChannels = readU16(format+2);
+				samplesPerSecond = readU32(format+4);
+				blockAlign = readU16(format+12);
+				bitsPerSample = readU16(format+14);
+				if ( audioFormat!=1 ) { return fail("Only PCM data can be read."); }
+				if ( bitsPerSample!=8 && bitsPerSample!=16 ) { return fail("Only 8 and 16 bit data can be read."); }
+				if ( nChannels<=0 || blockAlign!=nChannels*bitsPerSample/8 ) { return fail("Bad fmt chunk."); }
+				foundFormat=true;
+			}
+			else if ( chunk[0]=='d' && chunk[1]=='a' && chunk[2]=='t' && chunk[3]=='a' )
+			{
+				if ( foundFormat==false ) { return fail("data chunk is before the fmt chunk."); }
+				dataStart = chunkStart;
+				dataBytes = chunkSize;
+				if ( (long)dataBytes>fileSize-dataStart ) { dataBytes = fileSize-dataStart; }
+				dataBytes-=dataBytes%blockAlign;
+				bytesRead=0;
+				return true;
+			}
+
+			// Skip anything else, and the pad byte after an odd sized chunk.
+			if ( fseek(file,chunkStart+chunkSize+(chunkSize&1),SEEK_SET)!=0 ) { return fail("No data chunk."); }
+		}
+	}
+
+	void close()
+	{
+		if ( file!=0 ) { fclose(file); }
+		file=0;
+		dataBytes=0;
+		bytesRead=0;
+	}
+
+	inline bool isOpen() const
+	{ return file!=0; }
+
+	/* Read up to _maxBytes of PCM data, rounded down to whole frames. Returns the number of bytes read, which is
+		only 0 at the end of the data, or if it couldn't be read. */
+	int read(char* _out, const int _maxBytes)
+	{
+		if ( file==0 || blockAlign<=0 ) { return 0; }
+		int nTotal=0;
+		int maxBytes = _maxBytes-_maxBytes%blockAlign;
+		while ( nTotal<maxBytes )
+		{
+			if ( bytesRead>=dataBytes )
+			{
+				if ( looping==false || dataBytes==0 ) { break; }
+				rewind();
+			}
+			unsigned int nWant = maxBytes-nTotal;
+			if ( nWant>dataBytes-bytesRead ) { nWant=dataBytes-bytesRead; }
+			const unsigned int nGot = fread(_out+nTotal,1,nWant,file);
+			nTotal+=nGot;
+			bytesRead+=nGot;
+			if ( nGot<nWant )
+			{
+				std::cout<<"ERROR: WavStream: Data couldn't be read.\n";
+				dataBytes=bytesRead;
+				break;
+			}
+		}
+		return nTotal;
+	}
+
+	/* Go back to the start of the data. */
+	void rewind()
+	{
+		if ( file==0 ) { return; }
+		fseek(file,dataStart,SEEK_SET);
+		bytesRead=0;
+	}
+
+	inline bool atEnd() const
+	{ return looping==false && bytesRead>=dataBytes; }
+
+	inline unsigned int getDataBytes() const
+	{ return dataBytes; }
+
+	inline unsigned int getBytesRead() const
+	{ return bytesRead; }
+
+	inline double getDurationSeconds() const
+	{ return blockAlign==0 || samplesPerSecond==0 ? 0 : (double)dataBytes/blockAlign/samplesPerSecond; }
+};
+
+#endif /* #ifndef WILDCAT_AUDIO_WAV_STREAM_HPP */
@@ -12,7 +12,10 @@
 */
 
 template <class ARRAYS2_T>
-ArrayS2<ARRAYS2_T>::~ArrayS2() { delete[] data; }
+ArrayS2<ARRAYS2_T>::~ArrayS2()
+{
+	if ( ownsData ) { delete[] data; }
+}
 
 template <class ARRAYS2_T>
 ArrayS2<ARRAYS2_T>::ArrayS2()
@@ -25,6 +28,7 @@ ArrayS2<ARRAYS2_T>::ArrayS2()
 	data=0;
 	name="unnamed";
 	neighborNumber=0;
+	ownsData=true;
 }
 
 template <class ARRAYS2_T>
@@ -38,6 +42,7 @@ ArrayS2<ARRAYS2_T>::ArrayS2(const unsigned int _nX, const unsigned int _nY, cons
 	data=0;
 	name="unnamed";
 	neighborNumber=0;
+	ownsData=true;
 	init(_nX,_nY,_nullValue);
 }
 
@@ -47,8 +52,13 @@ ArrayS2<ARRAYS2_T>::ArrayS2 (const ArrayS2 <ARRAYS2_T> &array)
 	nX=array.nX;
 	nY=array.nY;
 
+	currentElement=0;
+	overFlow=false;
+	name=array.name;
+	neighborNumber=0;
+	ownsData=true;
+
 	int memSize=array.nullAddress-array.data;
-	delete [] data;
 	data=new ARRAYS2_T[memSize];
 	nullAddress=data+memSize;
 	nullValue=array.nullValue;
@@ -66,7 +76,14 @@ ArrayS2<ARRAYS2_T>::ArrayS2 (const ArrayS2 <ARRAYS2_T> &array)
 template <class ARRAYS2_T>
 void ArrayS2<ARRAYS2_T>::init(const unsigned int x, const unsigned int y, const ARRAYS2_T _nullValue)
 {
-	delete[] data;	
+	if ( ownsData==false && (int)x==nX && (int)y==nY )
+	{
+		nullValue=_nullValue;
+		fill(_nullValue);
+		return;
+	}
+	if ( ownsData ) { delete[] data; }
+	ownsData=true;
 	nX=x;
 	nY=y;
 	data = new ARRAYS2_T [x*y];
@@ -79,7 +96,8 @@ void ArrayS2<ARRAYS2_T>::init(const unsigned int x, const unsigned int y, const
 template <class ARRAYS2_T>
 void ArrayS2<ARRAYS2_T>::initClass(const unsigned int x, const unsigned int y)
 {
-	delete[] data;	
+	if ( ownsData ) { delete[] data; }
+	ownsData=true;
 	nX=x;
 	nY=y;
 	data = new ARRAYS2_T [x*y];
@@ -87,6 +105,18 @@ void ArrayS2<ARRAYS2_T>::initClass(const unsigned int x, const unsigned int y)
 	currentElement=&data[0];
 }
 
+template <class ARRAYS2_T>
+void ArrayS2<ARRAYS2_T>::initView(ARRAYS2_T * const _data, const unsigned int x, const unsigned int y)
+{
+	if ( ownsData ) { delete[] data; }
+	ownsData=false;
+	nX=x;
+	nY=y;
+	data = _data;
+	nullAddress=&data[x*y];
+	currentElement=&data[0];
+}
+
 
 
 template <class ARRAYS2_T>
@@ -20,8 +20,12 @@
 #include <string>
 #include <iostream>
 #include <Container/Vector/Vector.hpp>
+#include <Container/Bitfield/Bitfield.hpp> // Visited tiles for flood fill.
 #include <Data/DataTools.hpp> // Swap()
 
+#include <vector> // Flood fill span stack.
+#include <algorithm> // std::fill
+
 //#define CONTAINER_ARRAYS2_DEBUG
 
 /* Debug macro */
@@ -40,6 +44,15 @@
 // USED TO RECIEVE AND PASS ARRAY INDEXES.
 #include <Interface/HasXY.hpp>
 
+// ALLOCATION-FREE NEIGHBOUR LIST, RETURNED BY VALUE.
+#include <Container/ArrayS2/ArrayS2_NeighborList.hpp>
+// REGION SUMMARY FOR CONNECTED COMPONENT LABELLING.
+#include <Container/ArrayS2/ArrayS2_Region.hpp>
+
+#ifdef WILDCAT_THREADING
+#include <thread> // Labelling bands in parallel.
+#endif
+
 template <class ARRAYS2_T>
 class ArrayS2
 {
@@ -58,6 +71,9 @@ class ArrayS2
 
 	std::string name;
 
+		// False if data belongs to something else, for example a plane of an ArrayS2_LayerSet.
+	bool ownsData;
+
 		// DESTRUCTOR
 	~ArrayS2();
 
@@ -72,6 +88,12 @@ class ArrayS2
 		// When initializing without pointers, we can't pass a default address. Instead we must construct a class on each address.
 	void initClass(const unsigned int x, const unsigned int y);
 
+		// Use memory owned by something else. The array won't delete it. Calling init() with the same size
+		// just fills the existing memory, so the array stays a view. A different size gives it its own memory.
+	void initView(ARRAYS2_T * const _data, const unsigned int x, const unsigned int y);
+	inline bool isView() const
+	{ return ownsData==false; }
+
 		// SET FUNCTIONS
 		// 0223626497
 		// Only sets value if it is safe, otherwise it does nothing.
@@ -81,11 +103,21 @@ class ArrayS2
 	//void operator = (const ArrayS2 <T> &array);
 	void operator = (const ArrayS2 <ARRAYS2_T> &array)
 	{
+		int memSize=array.nullAddress-array.data;
+
+			// Views keep writing into their own memory if they can.
+		if ( ownsData==false && nX==array.nX && nY==array.nY )
+		{
+			nullValue=array.nullValue;
+			std::copy(array.data,array.nullAddress,data);
+			return;
+		}
+
 		nX=array.nX;
 		nY=array.nY;
 
-		int memSize=array.nullAddress-array.data;
-		delete [] data;
+		if ( ownsData ) { delete [] data; }
+		ownsData=true;
 		data=new ARRAYS2_T[memSize];
 		nullAddress=data+memSize;
 		nullValue=array.nullValue;
@@ -308,31 +340,143 @@ void setNeighbors(const int _x, const int _y, const ARRAYS2_T _value, const int
 	}
 }
 
+	/* ALLOCATION-FREE NEIGHBOUR ITERATION
+		These pass each valid neighbour coordinate by value to a callable taking (const int x, const int y),
+		and never touch the heap. Use these instead of the getNeighbors() family in hot loops.
+
+		The visit order is the same as the equivalent Vector function, so seeded shuffles still give
+		the same results. Coordinates off the edge are skipped, unless wrapX/wrapY is set, in which case
+		they are wrapped around to the other side.
+
+		Example:
+			aMap.forEachNeighbor(x,y, [&](const int _x, const int _y) { total+=aMap(_x,_y); });
+	*/
+
+		// Wrap the coordinates if wrapping is enabled, and return true if they end up in bounds.
+	inline bool wrapCoords(int& _x, int& _y, const bool _wrapX, const bool _wrapY) const
+	{
+		if ( _wrapX && nX > 0 )
+		{
+			_x%=nX;
+			if ( _x<0 ) { _x+=nX; }
+		}
+		if ( _wrapY && nY > 0 )
+		{
+			_y%=nY;
+			if ( _y<0 ) { _y+=nY; }
+		}
+		return (_x<nX && _y<nY && _x>=0 && _y>=0);
+	}
+
+		// 8-way neighbours.
+	template<class Function>
+	void forEachNeighbor(const int _x, const int _y, Function fn, const bool _includeSelf=false, const bool _wrapX=false, const bool _wrapY=false)
+	{
+		static const int aOffsetX [9] = { 0, -1, -1, -1, 0, 0, 1, 1, 1 };
+		static const int aOffsetY [9] = { 0, -1, 0, 1, -1, 1, -1, 0, 1 };
+
+		for (int i = (_includeSelf ? 0 : 1); i<9; ++i)
+		{
+			int neighborX = _x+aOffsetX[i];
+			int neighborY = _y+aOffsetY[i];
+			if ( wrapCoords(neighborX,neighborY,_wrapX,_wrapY) )
+			{ fn(neighborX,neighborY); }
+		}
+	}
+
+		// 4-way (NESW) neighbours.
+	template<class Function>
+	void forEachNeighborOrthogonal(const int _x, const int _y, Function fn, const bool _includeSelf=false, const bool _wrapX=false, const bool _wrapY=false)
+	{
+		static const int aOffsetX [5] = { 0, -1, 0, 0, 1 };
+		static const int aOffsetY [5] = { 0, 0, -1, 1, 0 };
+
+		for (int i = (_includeSelf ? 0 : 1); i<5; ++i)
+		{
+			int neighborX = _x+aOffsetX[i];
+			int neighborY = _y+aOffsetY[i];
+			if ( wrapCoords(neighborX,neighborY,_wrapX,_wrapY) )
+			{ fn(neighborX,neighborY); }
+		}
+	}
+
+		// Every coordinate within radius (square area). Goes column by column, like getNeighbors2().
+	template<class Function>
+	void forEachNeighborRadius(const int _x, const int _y, const int radius, Function fn, const bool _includeSelf=false, const bool _wrapX=false, const bool _wrapY=false)
+	{
+		for(int currentX=_x-radius;currentX<=_x+radius;++currentX)
+		{
+			for(int currentY=_y-radius;currentY<=_y+radius;++currentY)
+			{
+				if ( _includeSelf==false && currentX==_x && currentY==_y )
+				{ continue; }
+
+				int neighborX = currentX;
+				int neighborY = currentY;
+				if ( wrapCoords(neighborX,neighborY,_wrapX,_wrapY) )
+				{ fn(neighborX,neighborY); }
+			}
+		}
+	}
+
+		// Every coordinate on the edge of the square with the given radius. Same order as getBorder().
+	template<class Function>
+	void forEachBorder(const int _centerX, const int _centerY, const int _radius, Function fn, const bool _wrapX=false, const bool _wrapY=false)
+	{
+		const int topY=_centerY-_radius;
+		const int bottomY=_centerY+_radius;
+		for (int _x=_centerX-_radius;_x<=_centerX+_radius;++_x)
+		{
+			int neighborX=_x;
+			int neighborY=topY;
+			if ( wrapCoords(neighborX,neighborY,_wrapX,_wrapY) )
+			{ fn(neighborX,neighborY); }
+
+			neighborX=_x;
+			neighborY=bottomY;
+			if ( wrapCoords(neighborX,neighborY,_wrapX,_wrapY) )
+			{ fn(neighborX,neighborY); }
+		}
+
+		const int leftX=_centerX-_radius;
+		const int rightX=_centerX+_radius;
+		for (int _y=_centerY-_radius+1;_y<_centerY+_radius;++_y)
+		{
+			int neighborX=leftX;
+			int neighborY=_y;
+			if ( wrapCoords(neighborX,neighborY,_wrapX,_wrapY) )
+			{ fn(neighborX,neighborY); }
+
+			neighborX=rightX;
+			neighborY=_y;
+			if ( wrapCoords(neighborX,neighborY,_wrapX,_wrapY) )
+			{ fn(neighborX,neighborY); }
+		}
+	}
+
+		// Same as getNeighbors(), but returns a stack list by value.
+	ArrayS2_NeighborList getNeighborList(const int _x, const int _y, const bool _includeSelf=false, const bool _wrapX=false, const bool _wrapY=false)
+	{
+		ArrayS2_NeighborList list;
+		forEachNeighbor(_x,_y,[&list](const int _x2, const int _y2) { list.push(_x2,_y2); },_includeSelf,_wrapX,_wrapY);
+		return list;
+	}
+		// Same as getNeighborsOrthogonal(), but returns a stack list by value.
+	ArrayS2_NeighborList getNeighborListOrthogonal(const int _x, const int _y, const bool _includeSelf=false, const bool _wrapX=false, const bool _wrapY=false)
+	{
+		ArrayS2_NeighborList list;
+		forEachNeighborOrthogonal(_x,_y,[&list](const int _x2, const int _y2) { list.push(_x2,_y2); },_includeSelf,_wrapX,_wrapY);
+		return list;
+	}
+
 	// RETURN A VECTOR OF INDEXES SURROUNDING (AND POSSIBLY INCLUDING) THE PASSED COORDINATES.
   // Note that a request outside bounds will still provide any safe neighbors.
+  // The caller must delete the Vector and its contents. Prefer forEachNeighbor() or getNeighborList().
 Vector <HasXY*> * getNeighbors(const int _x, const int _y, const bool _includeSelf=false, const bool _shuffle=false)
 {
 	Vector <HasXY*> * vectorIndex = new Vector <HasXY*>;
 
-	if (_includeSelf==true && isSafe(_x,_y))
-	{ vectorIndex->push(new HasXY(_x,_y)); }
-
-	if(isSafe(_x-1,_y-1))
-	{ vectorIndex->push(new HasXY(_x-1,_y-1)); }
-	if(isSafe(_x-1,_y))
-	{ vectorIndex->push(new HasXY(_x-1,_y)); }
-	if(isSafe(_x-1,_y+1))
-	{ vectorIndex->push(new HasXY(_x-1,_y+1)); }
-	if(isSafe(_x,_y-1))
-	{ vectorIndex->push(new HasXY(_x,_y-1)); }
-	if(isSafe(_x,_y+1))
-	{ vectorIndex->push(new HasXY(_x,_y+1)); }
-	if(isSafe(_x+1,_y-1))
-	{ vectorIndex->push(new HasXY(_x+1,_y-1)); }
-	if(isSafe(_x+1,_y))
-	{ vectorIndex->push(new HasXY(_x+1,_y)); }
-	if(isSafe(_x+1,_y+1))
-	{ vectorIndex->push(new HasXY(_x+1,_y+1)); }
+	forEachNeighbor(_x,_y,[vectorIndex](const int _x2, const int _y2) { vectorIndex->push(new HasXY(_x2,_y2)); },_includeSelf);
 
   if (vectorIndex->size() == 0 ) { delete vectorIndex; return 0; }
 
@@ -347,21 +491,12 @@ Vector <HasXY*> * getNeighbors( HasXY* _index, const bool _includeSelf=false, co
 
   // Get neighbours in only NESW directions. Useful for situations where you don't want diagonal movement.
   // Note that a request outside bounds will still provide any safe neighbors.
+  // The caller must delete the Vector and its contents. Prefer forEachNeighborOrthogonal() or getNeighborListOrthogonal().
 Vector <HasXY*> * getNeighborsOrthogonal(const int _x, const int _y, const bool _includeSelf=false, const bool _shuffle=false)
 {
 	Vector <HasXY*> * vectorIndex = new Vector <HasXY*>;
 
-	if (_includeSelf && isSafe(_x,_y))
-	{ vectorIndex->push(new HasXY(_x,_y)); }
-	
-	if(isSafe(_x-1,_y))
-	{ vectorIndex->push(new HasXY(_x-1,_y)); }
-	if(isSafe(_x,_y-1))
-	{ vectorIndex->push(new HasXY(_x,_y-1)); }
-	if(isSafe(_x,_y+1))
-	{ vectorIndex->push(new HasXY(_x,_y+1)); }
-	if(isSafe(_x+1,_y))
-	{ vectorIndex->push(new HasXY(_x+1,_y)); }
+	forEachNeighborOrthogonal(_x,_y,[vectorIndex](const int _x2, const int _y2) { vectorIndex->push(new HasXY(_x2,_y2)); },_includeSelf);
 
 if (vectorIndex->size() == 0 ) { delete vectorIndex; return 0; }
 
@@ -375,23 +510,14 @@ if (vectorIndex->size() == 0 ) { delete vectorIndex; return 0; }
 
 
 	// 0241794590: APPARENTLY THIS NEVER EXISTED BEFORE NOW. MAYBE MAKE THIS THE NEW STANDARD FUNCTION.
-	// ALSO THIS LOOKS TO BE A HUGE MESS.
-Vector <HasXY*> * getNeighbors2(const int _x, const int _y, const int radius, const bool _includeSelf=false)
+	// Note that this has always included the center tile, regardless of _includeSelf.
+	// Prefer forEachNeighborRadius().
+Vector <HasXY*> * getNeighbors2(const int _x, const int _y, const int radius, const bool /* _includeSelf */=false)
 {
 	Vector <HasXY*> * vectorIndex = new Vector <HasXY*>;
 
-	for(int currentX=_x-radius;currentX<=_x+radius;++currentX)
-	{
-		//int currentY=0;
-		for(int currentY=_y-radius;currentY<=_y+radius;++currentY)
-		{
-			if (isSafe(currentX,currentY))
-			{
-				vectorIndex->push(new HasXY(currentX,currentY));
-			}
-		}
-		//currentY=_y-radius;
-	}
+	forEachNeighborRadius(_x,_y,radius,[vectorIndex](const int _x2, const int _y2) { vectorIndex->push(new HasXY(_x2,_y2)); },true);
+
 	return vectorIndex;
 }
 
@@ -473,42 +599,12 @@ void setNeighborsConditional(const int _x, const int _y, const ARRAYS2_T _value,
 
 
 	// RETURN ALL VALID INDEXES AROUND THE BORDER.
+	// The caller must delete the Vector and its contents. Prefer forEachBorder().
 Vector <HasXY*>* getBorder ( const int _centerX, const int _centerY, int _radius )
 {
 	Vector <HasXY*> * retVect = new Vector <HasXY*>;
 
-	// // X SWEEP
-	{
-	const int topY=_centerY-_radius;
-	const int bottomY=_centerY+_radius;
-	for (int _x=_centerX-_radius;_x<=_centerX+_radius;++_x)
-	{
-		if ( isSafe(_x,topY)==true )
-		{
-			retVect->push( new HasXY (_x,topY) );
-		}
-		if ( isSafe(_x,bottomY)==true )
-		{
-			retVect->push( new HasXY (_x,bottomY) );
-		}
-	}
-	}
-
-	{
-	const int leftX=_centerX-_radius;
-	const int rightX=_centerX+_radius;
-	for (int _y=_centerY-_radius+1;_y<_centerY+_radius;++_y)
-	{
-		if ( isSafe(leftX,_y)==true )
-		{
-			retVect->push( new HasXY (leftX,_y) );
-		}
-		if ( isSafe(rightX,_y)==true )
-		{
-			retVect->push( new HasXY (rightX,_y) );
-		}
-	}
-	}
+	forEachBorder(_centerX,_centerY,_radius,[retVect](const int _x, const int _y) { retVect->push( new HasXY (_x,_y) ); });
 
 	return retVect;
 }
@@ -1404,6 +1500,8 @@ void resetNeighbor()
 	#include <Container/ArrayS2/ArrayS2_Neighbours.hpp>
 
 	#include <Container/ArrayS2/ArrayS2_FloodFill.hpp>
+
+	#include <Container/ArrayS2/ArrayS2_Label.hpp>
 };
 
 #include <Container/ArrayS2/ArrayS2.cpp>
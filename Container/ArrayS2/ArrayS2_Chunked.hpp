@@ -0,0 +1,494 @@
+#pragma once
+#ifndef WILDCAT_CONTAINER_ARRAYS2_ARRAYS2_CHUNKED_HPP
+#define WILDCAT_CONTAINER_ARRAYS2_ARRAYS2_CHUNKED_HPP
+
+/* Wildcat: ArrayS2_Chunked
+	#include <Container/ArrayS2/ArrayS2_Chunked.hpp>
+
+	A 2D array split into square tiles, for maps which are too big to keep in memory as one ArrayS2. For example
+	a 32768x32768 world.
+
+	Tiles are only allocated when they are written to. Every tile which hasn't been written to shares a single
+	null tile, so an untouched array costs almost nothing, and init() and fill() don't have to touch every
+	element.
+
+	It works like an ArrayS2 for the basics: operator()(x,y), isSafe(), fill(), and the neighbour functions.
+
+		ArrayS2_Chunked <unsigned char> aMap;
+		aMap.init(32768,32768,0);
+		aMap(100,100) = 5; // Allocates the tile containing (100,100).
+		const unsigned char value = aMap.get(5000,5000); // Doesn't allocate anything.
+
+	Note that the non-const operator() always allocates, because it can't know if you're going to write to the
+	reference. Use get() (or a const reference to the array) for reading, and set() if you might be writing
+	the null value.
+
+	The array can also be backed by a memory-mapped file using initMapped(). Tiles are then stored in the file,
+	and the OS pages them in and out as needed, so the array can be bigger than RAM. The file remembers which
+	tiles were written, so a world can be generated into a file and read back later by opening the same file.
+	Nothing else in Wildcat reads from it yet. In particular, a chunked world can be generated and saved, but
+	BoardViewer can't browse it: BoardViewer draws from the Board's ArrayS3 of object lists, which holds a pointer
+	per tile per layer, and BoardViewer_LOD and BoardViewer_ChunkCache are built from that Board. Browsing a world
+	this size would need a Board backed by chunked layers.
+	Mapped arrays must hold trivially copyable types. Memory-mapping needs WILDCAT_LINUX or WILDCAT_WINDOWS.
+
+	Allocating tiles isn't thread-safe. Threads can write to different tiles which are already allocated.
+
+	TILE_BITS sets the tile size. The default of 6 gives 64x64 tiles.
+*/
+
+#include <Container/ArrayS2/ArrayS2_NeighborList.hpp>
+
+#include <string>
+#include <cstring> // memcmp, memcpy
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+
+#if defined WILDCAT_LINUX
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#elif defined WILDCAT_WINDOWS
+	#include <windows.h>
+	#include <winioctl.h> // FSCTL_SET_SPARSE
+#endif
+
+template <class T, int TILE_BITS = 6>
+class ArrayS2_Chunked
+{
+	public:
+
+	static const int TILE_SIZE = 1<<TILE_BITS;
+	static const int TILE_MASK = TILE_SIZE-1;
+	static const int TILE_AREA = TILE_SIZE*TILE_SIZE;
+
+	int nX, nY;
+	int nTilesX, nTilesY;
+	T nullValue;
+
+	private:
+
+	T ** aTile; // 0 means the tile isn't allocated, and reads from nullTile.
+	T * nullTile;
+	int nAllocated;
+
+		// MEMORY MAPPING
+		// The file is a header, then the null value, then 1 byte per tile to say if it has been written,
+		// then the tiles, starting on a page boundary.
+	static const int HEADER_SIZE = 32;
+	static const int PAGE_SIZE = 65536; // Also satisfies the Windows mapping granularity.
+
+	bool mapped;
+	unsigned char * mapping;
+	size_t mappingSize;
+	unsigned char * tileWritten;
+	T * tileStore;
+
+#if defined WILDCAT_LINUX
+	int fileDescriptor;
+#elif defined WILDCAT_WINDOWS
+	HANDLE fileHandle;
+	HANDLE mappingHandle;
+#endif
+
+	public:
+
+	ArrayS2_Chunked()
+	{
+		nX=0; nY=0;
+		nTilesX=0; nTilesY=0;
+		aTile=0;
+		nullTile=0;
+		nAllocated=0;
+
+		mapped=false;
+		mapping=0;
+		mappingSize=0;
+		tileWritten=0;
+		tileStore=0;
+#if defined WILDCAT_LINUX
+		fileDescriptor=-1;
+#elif defined WILDCAT_WINDOWS
+		fileHandle=INVALID_HANDLE_VALUE;
+		mappingHandle=0;
+#endif
+	}
+	ArrayS2_Chunked(const int _nX, const int _nY, const T _nullValue): ArrayS2_Chunked()
+	{
+		init(_nX,_nY,_nullValue);
+	}
+	~ArrayS2_Chunked()
+	{
+		clear();
+	}
+
+		// Tiles are owned by the array, so it can't be copied.
+	ArrayS2_Chunked(const ArrayS2_Chunked&) = delete;
+	void operator = (const ArrayS2_Chunked&) = delete;
+
+		// Free everything.
+	void clear()
+	{
+		if ( mapped==false && aTile!=0 )
+		{
+			for (int i=0;i<nTilesX*nTilesY;++i)
+			{ delete [] aTile[i]; }
+		}
+		delete [] aTile;
+		aTile=0;
+		delete [] nullTile;
+		nullTile=0;
+		nAllocated=0;
+		unmap();
+
+		nX=0; nY=0;
+		nTilesX=0; nTilesY=0;
+	}
+
+		// Only allocates the tile table and the null tile.
+	void init(const int _nX, const int _nY, const T _nullValue)
+	{
+		clear();
+		initTable(_nX,_nY,_nullValue);
+	}
+
+		// Use a memory-mapped file for the tiles. If the file was made by an array with the same size, tile size,
+		// type size and null value, its tiles are kept. Otherwise it is reset. Returns false if the file can't
+		// be mapped, in which case the array is left empty.
+	bool initMapped(const int _nX, const int _nY, const T _nullValue, const std::string _path)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Memory-mapped ArrayS2_Chunked needs a trivially copyable type.");
+
+		clear();
+		initTable(_nX,_nY,_nullValue);
+
+		const size_t nTiles = (size_t)nTilesX*nTilesY;
+		const size_t tileOffset = roundUpToPage(HEADER_SIZE+sizeof(T)+nTiles);
+		const size_t fileSize = tileOffset + nTiles*TILE_AREA*sizeof(T);
+
+		bool keepTiles = false;
+		if ( mapFile(_path,fileSize,keepTiles)==false )
+		{
+			std::cout<<"WARNING: ArrayS2_Chunked couldn't map "<<_path<<".\n";
+			clear();
+			return false;
+		}
+
+		unsigned char header [HEADER_SIZE];
+		makeHeader(header);
+		if ( keepTiles && ( memcmp(mapping,header,HEADER_SIZE)!=0 || memcmp(mapping+HEADER_SIZE,&nullValue,sizeof(T))!=0 ) )
+		{
+			std::cout<<"WARNING: "<<_path<<" doesn't match this array. Resetting it.\n";
+			keepTiles=false;
+		}
+
+		tileWritten = mapping+HEADER_SIZE+sizeof(T);
+		tileStore = reinterpret_cast<T*>(mapping+tileOffset);
+
+		if ( keepTiles )
+		{
+			for (size_t i=0;i<nTiles;++i)
+			{
+				if ( tileWritten[i] )
+				{
+					aTile[i] = tileStore + i*TILE_AREA;
+					++nAllocated;
+				}
+			}
+		}
+		else
+		{
+			memcpy(mapping,header,HEADER_SIZE);
+			memcpy(mapping+HEADER_SIZE,&nullValue,sizeof(T));
+			memset(tileWritten,0,nTiles);
+		}
+		return true;
+	}
+
+		// Write any changes in a mapped array to the file.
+	void flush()
+	{
+		if ( mapped==false ) { return; }
+#if defined WILDCAT_LINUX
+		msync(mapping,mappingSize,MS_SYNC);
+#elif defined WILDCAT_WINDOWS
+		FlushViewOfFile(mapping,0);
+		FlushFileBuffers(fileHandle);
+#endif
+	}
+
+	inline bool isMapped() const
+	{ return mapped; }
+
+	inline bool isSafe(const int _x, const int _y) const
+	{
+		return (_x>=0 && _y>=0 && _x<nX && _y<nY);
+	}
+
+		// READ ACCESS. Never allocates.
+	inline const T& get(const int _x, const int _y) const
+	{
+		const T * tile = aTile[(_y>>TILE_BITS)*nTilesX + (_x>>TILE_BITS)];
+		if ( tile==0 ) { tile=nullTile; }
+		return tile[((_y&TILE_MASK)<<TILE_BITS) + (_x&TILE_MASK)];
+	}
+	inline const T& operator() (const int _x, const int _y) const
+	{ return get(_x,_y); }
+
+		// WRITE ACCESS. Allocates the tile if needed.
+	inline T& operator() (const int _x, const int _y)
+	{
+		T *& tile = aTile[(_y>>TILE_BITS)*nTilesX + (_x>>TILE_BITS)];
+		if ( tile==0 ) { allocateTile(tile,(_y>>TILE_BITS)*nTilesX + (_x>>TILE_BITS)); }
+		return tile[((_y&TILE_MASK)<<TILE_BITS) + (_x&TILE_MASK)];
+	}
+
+		// Doesn't allocate a tile just to write the null value.
+	inline void set(const int _x, const int _y, const T _value)
+	{
+		const int iTile = (_y>>TILE_BITS)*nTilesX + (_x>>TILE_BITS);
+		if ( aTile[iTile]==0 )
+		{
+			if ( _value==nullValue ) { return; }
+			allocateTile(aTile[iTile],iTile);
+		}
+		aTile[iTile][((_y&TILE_MASK)<<TILE_BITS) + (_x&TILE_MASK)] = _value;
+	}
+
+		// Set every element to the value, and free every tile. The value becomes the new null value.
+	void fill(const T _value)
+	{
+		const int nTiles = nTilesX*nTilesY;
+		for (int i=0;i<nTiles;++i)
+		{
+			if ( mapped==false ) { delete [] aTile[i]; }
+			aTile[i]=0;
+		}
+		nAllocated=0;
+
+		nullValue=_value;
+		for (int i=0;i<TILE_AREA;++i)
+		{ nullTile[i]=_value; }
+
+		if ( mapped )
+		{
+			memcpy(mapping+HEADER_SIZE,&nullValue,sizeof(T));
+			memset(tileWritten,0,nTiles);
+		}
+	}
+
+		// TILE INFO
+	inline bool isTileAllocated(const int _tileX, const int _tileY) const
+	{ return aTile[_tileY*nTilesX + _tileX]!=0; }
+	inline int nAllocatedTiles() const
+	{ return nAllocated; }
+		// Bytes used by allocated tiles. For a mapped array this is the most that can be resident.
+	inline size_t allocatedBytes() const
+	{ return (size_t)nAllocated*TILE_AREA*sizeof(T); }
+
+	/* NEIGHBOURS
+		Same as the ArrayS2 functions. They pass each neighbour coordinate to a callable taking
+		(const int x, const int y).
+	*/
+
+		// Wrap the coordinates if wrapping is enabled, and return true if they end up in bounds.
+	inline bool wrapCoords(int& _x, int& _y, const bool _wrapX, const bool _wrapY) const
+	{
+		if ( _wrapX && nX > 0 )
+		{
+			_x%=nX;
+			if ( _x<0 ) { _x+=nX; }
+		}
+		if ( _wrapY && nY > 0 )
+		{
+			_y%=nY;
+			if ( _y<0 ) { _y+=nY; }
+		}
+		return (_x<nX && _y<nY && _x>=0 && _y>=0);
+	}
+
+		// 8-way neighbours.
+	template<class Function>
+	void forEachNeighbor(const int _x, const int _y, Function fn, const bool _includeSelf=false, const bool _wrapX=false, const bool _wrapY=false) const
+	{
+		static const int aOffsetX [9] = { 0, -1, -1, -1, 0, 0, 1, 1, 1 };
+		static const int aOffsetY [9] = { 0, -1, 0, 1, -1, 1, -1, 0, 1 };
+
+		for (int i = (_includeSelf ? 0 : 1); i<9; ++i)
+		{
+			int neighborX = _x+aOffsetX[i];
+			int neighborY = _y+aOffsetY[i];
+			if ( wrapCoords(neighborX,neighborY,_wrapX,_wrapY) )
+			{ fn(neighborX,neighborY); }
+		}
+	}
+
+		// 4-way (NESW) neighbours.
+	template<class Function>
+	void forEachNeighborOrthogonal(const int _x, const int _y, Function fn, const bool _includeSelf=false, const bool _wrapX=false, const bool _wrapY=false) const
+	{
+		static const int aOffsetX [5] = { 0, -1, 0, 0, 1 };
+		static const int aOffsetY [5] = { 0, 0, -1, 1, 0 };
+
+		for (int i = (_includeSelf ? 0 : 1); i<5; ++i)
+		{
+			int neighborX = _x+aOffsetX[i];
+			int neighborY = _y+aOffsetY[i];
+			if ( wrapCoords(neighborX,neighborY,_wrapX,_wrapY) )
+			{ fn(neighborX,neighborY); }
+		}
+	}
+
+	ArrayS2_NeighborList getNeighborList(const int _x, const int _y, const bool _includeSelf=false, const bool _wrapX=false, const bool _wrapY=false) const
+	{
+		ArrayS2_NeighborList list;
+		forEachNeighbor(_x,_y,[&list](const int _x2, const int _y2) { list.push(_x2,_y2); },_includeSelf,_wrapX,_wrapY);
+		return list;
+	}
+	ArrayS2_NeighborList getNeighborListOrthogonal(const int _x, const int _y, const bool _includeSelf=false, const bool _wrapX=false, const bool _wrapY=false) const
+	{
+		ArrayS2_NeighborList list;
+		forEachNeighborOrthogonal(_x,_y,[&list](const int _x2, const int _y2) { list.push(_x2,_y2); },_includeSelf,_wrapX,_wrapY);
+		return list;
+	}
+
+	unsigned char nNeighborsEqual(const int _x, const int _y, const T _value) const
+	{
+		unsigned char nNeighbors = 0;
+		forEachNeighbor(_x,_y,[&](const int _x2, const int _y2)
+		{
+			if ( get(_x2,_y2)==_value ) { ++nNeighbors; }
+		});
+		return nNeighbors;
+	}
+
+	private:
+
+	void initTable(const int _nX, const int _nY, const T _nullValue)
+	{
+		nX=_nX;
+		nY=_nY;
+		nTilesX = (nX+TILE_SIZE-1)>>TILE_BITS;
+		nTilesY = (nY+TILE_SIZE-1)>>TILE_BITS;
+		nullValue=_nullValue;
+
+		const int nTiles = nTilesX*nTilesY;
+		aTile = new T* [nTiles];
+		for (int i=0;i<nTiles;++i)
+		{ aTile[i]=0; }
+
+		nullTile = new T [TILE_AREA];
+		for (int i=0;i<TILE_AREA;++i)
+		{ nullTile[i]=nullValue; }
+		nAllocated=0;
+	}
+
+	void allocateTile(T *& tile, const int iTile)
+	{
+		if ( mapped )
+		{
+			tile = tileStore + (size_t)iTile*TILE_AREA;
+			tileWritten[iTile]=1;
+		}
+		else
+		{
+			tile = new T [TILE_AREA];
+		}
+		for (int i=0;i<TILE_AREA;++i)
+		{ tile[i]=nullValue; }
+		++nAllocated;
+	}
+
+	static size_t roundUpToPage(const size_t _size)
+	{
+		return (_size+PAGE_SIZE-1)/PAGE_SIZE*PAGE_SIZE;
+	}
+
+	void makeHeader(unsigned char * header) const
+	{
+		memset(header,0,HEADER_SIZE);
+		memcpy(header,"WCCHUNK1",8);
+		const int32_t aValue [4] = { nX, nY, TILE_BITS, (int32_t)sizeof(T) };
+		memcpy(header+8,aValue,sizeof(aValue));
+	}
+
+		// Open or create the file at the given size, and map it. keepTiles is set if the file already existed
+		// with the right size.
+	bool mapFile(const std::string _path, const size_t _size, bool& keepTiles)
+	{
+		keepTiles=false;
+#if defined WILDCAT_LINUX
+		fileDescriptor = open(_path.c_str(), O_RDWR | O_CREAT, 0644);
+		if ( fileDescriptor==-1 ) { return false; }
+
+		struct stat fileStat;
+		if ( fstat(fileDescriptor,&fileStat)==0 && (size_t)fileStat.st_size==_size )
+		{ keepTiles=true; }
+		else if ( ftruncate(fileDescriptor,0)!=0 || ftruncate(fileDescriptor,_size)!=0 )
+		{ return false; } // The file is sparse, so untouched tiles don't use disk space.
+
+		void * address = mmap(0,_size,PROT_READ|PROT_WRITE,MAP_SHARED,fileDescriptor,0);
+		if ( address==MAP_FAILED ) { return false; }
+		mapping = static_cast<unsigned char*>(address);
+		mappingSize=_size;
+		mapped=true;
+		return true;
+#elif defined WILDCAT_WINDOWS
+		fileHandle = CreateFileA(_path.c_str(), GENERIC_READ|GENERIC_WRITE, 0, 0, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+		if ( fileHandle==INVALID_HANDLE_VALUE ) { return false; }
+
+		LARGE_INTEGER fileSize;
+		if ( GetFileSizeEx(fileHandle,&fileSize) && (size_t)fileSize.QuadPart==_size )
+		{ keepTiles=true; }
+		else
+		{
+			DWORD bytesReturned;
+			DeviceIoControl(fileHandle, FSCTL_SET_SPARSE, 0, 0, 0, 0, &bytesReturned, 0);
+			fileSize.QuadPart = 0;
+			SetFilePointerEx(fileHandle,fileSize,0,FILE_BEGIN);
+			SetEndOfFile(fileHandle);
+			fileSize.QuadPart = _size;
+			if ( SetFilePointerEx(fileHandle,fileSize,0,FILE_BEGIN)==0 || SetEndOfFile(fileHandle)==0 )
+			{ return false; }
+		}
+
+		mappingHandle = CreateFileMappingA(fileHandle, 0, PAGE_READWRITE, (DWORD)((unsigned long long)_size>>32), (DWORD)(_size&0xFFFFFFFF), 0);
+		if ( mappingHandle==0 ) { return false; }
+		void * address = MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, _size);
+		if ( address==0 ) { return false; }
+		mapping = static_cast<unsigned char*>(address);
+		mappingSize=_size;
+		mapped=true;
+		return true;
+#else
+		(void)_path;
+		(void)_size;
+		std::cout<<"WARNING: ArrayS2_Chunked memory-mapping needs WILDCAT_LINUX or WILDCAT_WINDOWS.\n";
+		return false;
+#endif
+	}
+
+	void unmap()
+	{
+#if defined WILDCAT_LINUX
+		if ( mapping!=0 ) { munmap(mapping,mappingSize); }
+		if ( fileDescriptor!=-1 ) { close(fileDescriptor); }
+		fileDescriptor=-1;
+#elif defined WILDCAT_WINDOWS
+		if ( mapping!=0 ) { UnmapViewOfFile(mapping); }
+		if ( mappingHandle!=0 ) { CloseHandle(mappingHandle); }
+		if ( fileHandle!=INVALID_HANDLE_VALUE ) { CloseHandle(fileHandle); }
+		mappingHandle=0;
+		fileHandle=INVALID_HANDLE_VALUE;
+#endif
+		mapped=false;
+		mapping=0;
+		mappingSize=0;
+		tileWritten=0;
+		tileStore=0;
+	}
+};
+
+#endif
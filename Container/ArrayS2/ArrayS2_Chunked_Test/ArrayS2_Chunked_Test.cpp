@@ -0,0 +1,117 @@
+#include <Container/ArrayS2/ArrayS2.hpp>
+#include <Container/ArrayS2/ArrayS2_Chunked.hpp>
+#include <Math/Random/RandomLehmer.hpp>
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+// g++ ArrayS2_Chunked_Test.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX
+
+// Tests for ArrayS2_Chunked. Random writes are checked against an ArrayS2, then a mapped array is written, closed
+// and reopened to check the tiles come back, and a file made by a different array is reset.
+
+const int MAP_X = 1000;
+const int MAP_Y = 700;
+const int N_WRITES = 20000;
+const char* MAP_PATH = "ArrayS2_Chunked_Test.map";
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+// Write the same random values to both arrays. Some writes are the null value, through set().
+void writeRandom(ArrayS2 <int>& aExpected, ArrayS2_Chunked <int>& aChunked, const int _seed)
+{
+	RandomLehmer rng;
+	rng.seed(_seed);
+	for (int i=0;i<N_WRITES;++i)
+	{
+		const int _x = rng.rand32(MAP_X);
+		const int _y = rng.rand32(MAP_Y);
+		const int value = rng.rand32(10);
+		aExpected(_x,_y)=value;
+		if ( i%2==0 ) { aChunked(_x,_y)=value; }
+		else { aChunked.set(_x,_y,value); }
+	}
+}
+
+bool matches(ArrayS2 <int>& aExpected, const ArrayS2_Chunked <int>& aChunked)
+{
+	for (int _y=0;_y<MAP_Y;++_y)
+	{
+		for (int _x=0;_x<MAP_X;++_x)
+		{
+			if ( aChunked.get(_x,_y)!=aExpected(_x,_y) ) { return false; }
+		}
+	}
+	return true;
+}
+
+int main(int nArgs, char ** arg)
+{
+	// Random writes against ArrayS2.
+	ArrayS2 <int> aExpected;
+	aExpected.init(MAP_X,MAP_Y,0);
+	ArrayS2_Chunked <int> aChunked;
+	aChunked.init(MAP_X,MAP_Y,0);
+	check("Untouched array allocates nothing", aChunked.nAllocatedTiles()==0 && aChunked.get(MAP_X-1,MAP_Y-1)==0);
+
+	writeRandom(aExpected,aChunked,1);
+	check("Random writes match ArrayS2", matches(aExpected,aChunked));
+	check("Edge tiles are in bounds", aChunked.nTilesX==(MAP_X+63)/64 && aChunked.nTilesY==(MAP_Y+63)/64);
+
+	unsigned char nEqual = 0;
+	aExpected.forEachNeighbor(10,10,[&](const int _x, const int _y) { if ( aExpected(_x,_y)==aExpected(10,10) ) { ++nEqual; } });
+	check("Neighbours match ArrayS2", aChunked.nNeighborsEqual(10,10,aChunked.get(10,10))==nEqual);
+
+	aChunked.fill(3);
+	check("fill frees every tile", aChunked.nAllocatedTiles()==0 && aChunked.get(500,500)==3);
+	aChunked.set(500,500,3);
+	check("Writing the null value with set() doesn't allocate", aChunked.nAllocatedTiles()==0);
+
+	// Reopening a mapped file.
+	std::remove(MAP_PATH);
+	ArrayS2_Chunked <int> aMapped;
+	check("Mapping a new file", aMapped.initMapped(MAP_X,MAP_Y,0,MAP_PATH) && aMapped.isMapped());
+	ArrayS2 <int> aMappedExpected;
+	aMappedExpected.init(MAP_X,MAP_Y,0);
+	writeRandom(aMappedExpected,aMapped,2);
+	const int nWritten = aMapped.nAllocatedTiles();
+	aMapped.flush();
+	aMapped.clear();
+
+	ArrayS2_Chunked <int> aReopened;
+	check("Reopening the file", aReopened.initMapped(MAP_X,MAP_Y,0,MAP_PATH));
+	check("Reopened file has the written tiles", aReopened.nAllocatedTiles()==nWritten);
+	check("Reopened file has the values", matches(aMappedExpected,aReopened));
+	aReopened.clear();
+
+	// A file from an array with a different size or null value is reset.
+	std::cout<<"Expecting a warning:\n";
+	ArrayS2_Chunked <int> aOtherNull;
+	check("Mismatched null value is reset", aOtherNull.initMapped(MAP_X,MAP_Y,7,MAP_PATH)
+		&& aOtherNull.nAllocatedTiles()==0 && aOtherNull.get(0,0)==7 && aOtherNull.get(MAP_X-1,MAP_Y-1)==7);
+	aOtherNull(5,5)=1;
+	aOtherNull.clear();
+
+	std::cout<<"Expecting a warning:\n";
+	ArrayS2_Chunked <int> aOtherSize;
+	check("Mismatched size is reset", aOtherSize.initMapped(MAP_Y,MAP_X,7,MAP_PATH)
+		&& aOtherSize.nAllocatedTiles()==0 && aOtherSize.get(5,5)==7);
+	aOtherSize.clear();
+
+	// The reset file has the new header, so it reopens.
+	ArrayS2_Chunked <int> aAgain;
+	aAgain.initMapped(MAP_Y,MAP_X,7,MAP_PATH);
+	check("Reset file reopens", aAgain.nAllocatedTiles()==0);
+	aAgain.clear();
+	std::remove(MAP_PATH);
+
+	std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+	return nFailed==0 ? 0 : 1;
+}
@@ -79,4 +79,22 @@ void ArrayS2<ARRAYS2_T>::fillBorder ( const ARRAYS2_T _value, const int _startX
 		set(_startX,_y,_value);
 		set(_endX,_y,_value);
 	}
+}
+
+
+
+// Fill everything connected to the starting tile with the same value. Uses the scanline fill from ArrayS2_FloodFill.hpp.
+template <class ARRAYS2_T>
+void ArrayS2<ARRAYS2_T>::floodFill ( const int _startX, const int _startY, const ARRAYS2_T _fillValue, bool includeDiagonals /* = true */)
+{
+	if ( isSafe(_startX,_startY)==false ) { return; }
+
+	Bitfield bVisited;
+	bVisited.init(nX,nY);
+	floodFillSpans(_startX,_startY,FloodFillEqual((*this)(_startX,_startY)),includeDiagonals,bVisited,
+		[this,_fillValue](const int _y, const int _x1, const int _x2)
+		{
+			ARRAYS2_T * const row = &data[nX*_y];
+			std::fill(row+_x1,row+_x2+1,_fillValue);
+		});
 }
\ No newline at end of file
@@ -5,451 +5,197 @@
 /* ArrayS2_FloodFill.cpp
 #include <Container/ArrayS2/ArrayS2_FloodFill.hpp> */
 
-/** @ brief Implementation of flood fill.
+/** @ brief Scanline flood fill.
 
-This function returns a vector of all the coordinates within the flood fill area. This particular version has no
-tolerance setting, it only checks for equality. Future versions will allow custom comparison and assignment.
+This is a span-based scanline fill. Instead of pushing single coordinates, it pushes spans of a row which still need
+to be scanned. When a span is popped, each run of matching cells in it is extended left and right as far as it goes,
+marked in a packed visited Bitfield, and passed to the output in one go. The rows above and below the run are then
+pushed as new spans (one tile wider on each side if diagonals are included).
 
-There seems to be a bug which is sometimes causing duplicate coordinates to be pushed. For now I temporarily fixed
-it by making an array to check if a coordinate has already been added. Obviously this is not a good solution
-but it fixes it for now. I guess there are too many coordinates being pushed to vToCheck, because this shouldn't be
-happening normally.
+Because a cell is marked as visited as soon as it is filled, and is never filled twice, there are no duplicates.
+The only memory used is the Bitfield (1 bit per tile) and the span stack, which stays small.
 
-I should try using a deque instead of vector for this.
+The predicate decides which cells belong in the fill. It is any callable taking a cell value and returning bool.
+The FloodFillEqual, FloodFillTolerance and FloodFillRange structs below cover the usual cases, or you can pass
+a lambda. Comparisons are made against the value in the array, so the array can be modified by the output.
 
-*/
-
-Vector <HasXY*> * floodFillVector ( const int _startX, const int _startY, const bool includeDiagonals )
-{
-	const ARRAYS2_T initialValue = (*this)(_startX,_startY);
-
-	// Vector of coordinates to return.
-	Vector <HasXY*> * const vToFill = new Vector <HasXY*>;
-	vToFill->reserve(nX+nY);
+There are 2 ways to get the output:
+	floodFillBuffer() appends every filled coordinate to a Vector <HasXY> (flat buffer of values).
+	floodFillLabel() writes a label value into an ArrayS2 <int>, for example to build a landmass ID map.
 
-	/* vectors of coordinates to be checked (this can be changed to std::pair */
-	Vector <HasXY*> vToCheck;
-	vToCheck.reserve(nX+nY);
+floodFillSpans() is the core function which passes each filled span to a callable (y, xLeft, xRight) with inclusive
+coordinates. It takes the visited Bitfield by reference so it can be reused when filling from many seeds.
 
-	int currentV=-1;
-	int posX=_startX;
-	int posY=_startY;
-
-	ArrayS2 <bool> aChecked ( nX,nY,false );
-	aChecked(_startX,_startY)=true;
-	
-	// Bugfix: This algorithm seems to fill multiple coordinates twice, so for now we need this array here to quickly
-	// check for this.
-	ArrayS2 <bool> aFilled ( nX,nY,false );
+*/
 
-	/* scanline fill loop */
-	while (currentV!=vToCheck.size())
+	// COMPARISON PREDICATES
+	// Match a single value.
+struct FloodFillEqual
+{
+	ARRAYS2_T value;
+	FloodFillEqual(const ARRAYS2_T _value): value(_value) {}
+	inline bool operator() (const ARRAYS2_T& _value) const
+	{ return _value==value; }
+};
+	// Match a value plus or minus tolerance (inclusive). Requires a numeric type.
+struct FloodFillTolerance
+{
+	ARRAYS2_T value;
+	ARRAYS2_T tolerance;
+	FloodFillTolerance(const ARRAYS2_T _value, const ARRAYS2_T _tolerance): value(_value), tolerance(_tolerance) {}
+	inline bool operator() (const ARRAYS2_T& _value) const
 	{
-		const int INITIAL_X=posX;
-		/* go left to find the leftmost tile for this row which meets the criteria for water, filling along the way
-		we also check the tile directly above or below to see if there are any tiles that can be filled on those rows.
-		If we find such tiles, then we store the leftmost ones, for both the upper and lower row.
-		NOTE: y coords seems to encode upside-down, so we need to work upside-down here. */
-
-		/* Fill left */
-		while ( posX>=0 && (*this)(posX,posY)==initialValue )
-		{
-			// Fill the coordinate we are currently on.
-			if (aFilled(posX,posY)==false)
-			{
-				vToFill->push(new HasXY(posX,posY));
-				aFilled(posX,posY)=true;
-			}
-
-
-			/* check below */
-			/* If we're not on the bottom row, and the below tile is land. */
-			if(posY<nY-1 && (*this)(posX,posY+1)==initialValue && aChecked(posX,posY+1)==false )
-			{
-				/* If we are at the leftmost or rightmost column, or we have hit the end of the fill line */
-				if ( posX==0 || posX==nX-1 || (*this)(posX-1,posY+1)!=initialValue )
-				{
-					/* push tile below us if it's valid. */
-					vToCheck.push(new HasXY(posX,posY+1));
-					aChecked(posX,posY+1)=true;
-				}
-			}
-			/* check above */
-			/* If we're not on the top row, and the above tile is water. */
-			if (posY>0 && (*this)(posX,posY-1)==initialValue && aChecked(posX,posY-1)==false )
-			{
-				/* If we are at the leftmost or rightmost column of the map. */
-				if( posX==0 || posX==nX-1 || (*this)(posX-1,posY-1)!=initialValue )
-				{
-					/* push tile above us if it's valid. */
-					vToCheck.push(new HasXY(posX,posY-1));
-					aChecked(posX,posY-1)=true;
-				}
-			}
-			--posX; /* move left 1 tile */
-		}
-
+		if ( _value > value ) { return _value-value <= tolerance; }
+		return value-_value <= tolerance;
+	}
+};
+	// Match any value from min to max (inclusive).
+struct FloodFillRange
+{
+	ARRAYS2_T minValue;
+	ARRAYS2_T maxValue;
+	FloodFillRange(const ARRAYS2_T _minValue, const ARRAYS2_T _maxValue): minValue(_minValue), maxValue(_maxValue) {}
+	inline bool operator() (const ARRAYS2_T& _value) const
+	{ return _value>=minValue && _value<=maxValue; }
+};
+
+	// A span of a row which still needs to be scanned. Coordinates are inclusive.
+struct FloodFillSpan
+{
+	int x1, x2, y;
+};
 
-		/* check the last X for this scan. */
-		// NOTE: I THINK SWITCHING TO A DO WHILE MIGHT REMOVE THE NEED FOR THIS BIT.
+	// Returns the number of tiles filled. bVisited must be initialised to the same size as this array.
+	// Tiles already marked in bVisited are treated as not matching.
+template <class Predicate, class Output>
+int floodFillSpans ( const int _startX, const int _startY, Predicate inFill, const bool includeDiagonals, Bitfield& bVisited, Output output )
+{
+	if ( isSafe(_startX,_startY)==false || bVisited.get(nX*_startY+_startX) || inFill(data[nX*_startY+_startX])==false )
+	{ return 0; }
 
-		++posX;
-		/* check below */
-		/* If we're not on the bottom row, and the below tile is water, and the below tile hasn't been processed yet. */
-		if(posY<nY-1 && (*this)(posX,posY+1)==initialValue && aChecked(posX,posY+1)==false )
-		{
-			/* push coords onto vectors. */
-			vToCheck.push(new HasXY(posX,posY+1));
-			aChecked(posX,posY+1)=true;
-		}
+	int nFilled = 0;
+	const int diagonal = includeDiagonals ? 1 : 0;
 
-		/* check above */
-		/* If we're not on the top row, and the above tile is water, and the above tile hasn't been processed yet. */
-		if(posY>0 && (*this)(posX,posY-1)==initialValue && aChecked(posX,posY-1)==false)
-		{
-			/* push coords onto vectors. */
-			vToCheck.push(new HasXY(posX,posY-1));
-			aChecked(posX,posY-1)=true;
-		}
+	std::vector <FloodFillSpan> vStack;
+	vStack.reserve(64);
+	vStack.push_back({_startX,_startX,_startY});
 
-		if ( includeDiagonals )
-		{
-			// DIAGONALS: SAME BUT CHECK BELOW-LEFT
-			if(posY<nY-1 && posX>0 && (*this)(posX-1,posY+1)==initialValue && aChecked(posX-1,posY+1)==false )
-			{
-				vToCheck.push(new HasXY(posX-1,posY+1));
-				aChecked(posX-1,posY+1)=true;
-			}
-			// DIAGONALS: SAME BUT CHECK ABOVE-LEFT
-			if(posY>0 && posX>0 && (*this)(posX-1,posY-1)==initialValue && aChecked(posX-1,posY-1)==false )
-			{
-				vToCheck.push(new HasXY(posX-1,posY-1));
-				aChecked(posX-1,posY-1)=true;
-			}
-		}
-		posX=INITIAL_X+1;
+	while ( vStack.empty()==false )
+	{
+		const FloodFillSpan span = vStack.back();
+		vStack.pop_back();
 
+		const unsigned long int rowIndex = (unsigned long int)nX*span.y;
+		const ARRAYS2_T * const row = &data[rowIndex];
 
-		/* Go back to the initial x position, and now fill right */
-		while ( posX < nX && (*this)(posX,posY)==initialValue )
+		int _x = span.x1;
+		while ( _x <= span.x2 )
 		{
-			// Fill the coordinate we are currently on.
-			if (aFilled(posX,posY)==false)
+			if ( bVisited.get(rowIndex+_x) || inFill(row[_x])==false )
 			{
-				vToFill->push(new HasXY(posX,posY));
-				aFilled(posX,posY)=true;
+				++_x;
+				continue;
 			}
 
-			/* check below */
-			/* If we're not on the bottom row, and the below tile is water. */
-			if(posY<nY-1 && (*this)(posX,posY+1)==initialValue)
-			{
-				/* If we are at the leftmost or rightmost column of the map. */
-				if ( aChecked(posX,posY+1)==false && (posX==0 || posX==nX-1 || (*this)(posX-1,posY+1)!=initialValue ) )
-				{
-					/* push tile below us */
-					vToCheck.push(new HasXY(posX,posY+1));
-					aChecked(posX,posY+1)=true;
-				}
-			}
-			/* check above */
-			/* If we're not on the top row, and the above tile is water. */
-			if(posY>0 && (*this)(posX,posY-1)==initialValue )
-			{
-				/* If we are at the leftmost or rightmost column of the map. */
-				if ( aChecked(posX,posY-1)==false && ( posX==0 || posX==nX-1 || (*this)(posX-1,posY-1)!=initialValue ) )
-				{
-					/* push tile above us. */
-					vToCheck.push(new HasXY(posX,posY-1));
-					aChecked(posX,posY-1)=true;
-				}
-			}
-			/* move right 1 tile */
-			++posX;
+				// Found a run. Extend it left and right as far as it goes.
+			int left = _x;
+			while ( left > 0 && bVisited.get(rowIndex+left-1)==false && inFill(row[left-1]) )
+			{ --left; }
+			int right = _x;
+			while ( right < nX-1 && bVisited.get(rowIndex+right+1)==false && inFill(row[right+1]) )
+			{ ++right; }
+
+			for (int _x2=left;_x2<=right;++_x2)
+			{ bVisited.set(rowIndex+_x2); }
+			nFilled+=right-left+1;
+
+			output(span.y,left,right);
+
+				// Queue the rows above and below.
+			const int scanLeft = (left-diagonal < 0) ? 0 : left-diagonal;
+			const int scanRight = (right+diagonal > nX-1) ? nX-1 : right+diagonal;
+			if ( span.y > 0 )
+			{ vStack.push_back({scanLeft,scanRight,span.y-1}); }
+			if ( span.y < nY-1 )
+			{ vStack.push_back({scanLeft,scanRight,span.y+1}); }
+
+			_x = right+2; // right+1 is known not to match.
 		}
+	}
+	return nFilled;
+}
 
-		//KLUDGE. DO WHILE MAYBE IS SMARTER. MAYBE.
-		--posX;
-
-		if ( includeDiagonals )
+	// Append every filled coordinate to vFill. Returns the number of tiles filled.
+template <class Predicate>
+int floodFillBuffer ( const int _startX, const int _startY, Vector <HasXY>& vFill, Predicate inFill, const bool includeDiagonals=true )
+{
+	Bitfield bVisited;
+	bVisited.init(nX,nY);
+	return floodFillSpans(_startX,_startY,inFill,includeDiagonals,bVisited,
+		[&vFill](const int _y, const int _x1, const int _x2)
 		{
-			// DIAGONALS: CHECK BELOW-RIGHT
-			if(posY<nY-1 && posX<nX-1 && (*this)(posX+1,posY+1)==initialValue && aChecked(posX+1,posY+1) == false )
-			{
-				vToCheck.push(new HasXY(posX+1,posY+1));
-				aChecked(posX+1,posY+1) = true;
-			}
-
-			// DIAGONALS: CHECK ABOVE-RIGHT
-			if(posY>0 && posX<nX-1 && (*this)(posX+1,posY-1)==initialValue && aChecked(posX+1,posY-1) == 0 )
-			{
-				vToCheck.push(new HasXY(posX+1,posY-1));
-				aChecked(posX+1,posY-1) = true;
-			}
-		}
-
-
-		/* entire row is complete. Go to next set of coords. */
-		/* Look for some good coords on the vector. */
-		++currentV;
+			for (int _x=_x1;_x<=_x2;++_x)
+			{ vFill.push(HasXY(_x,_y)); }
+		});
+}
+	// Fill everything connected with the same value as the starting tile.
+int floodFillBuffer ( const int _startX, const int _startY, Vector <HasXY>& vFill, const bool includeDiagonals=true )
+{
+	if ( isSafe(_startX,_startY)==false ) { return 0; }
+	return floodFillBuffer(_startX,_startY,vFill,FloodFillEqual((*this)(_startX,_startY)),includeDiagonals);
+}
 
-		if ( currentV < vToCheck.size() )
+	// Write label to every filled coordinate in aLabel, which must be the same size as this array.
+	// Returns the number of tiles filled.
+template <class Predicate>
+int floodFillLabel ( const int _startX, const int _startY, ArrayS2 <int>& aLabel, const int label, Predicate inFill, const bool includeDiagonals=true )
+{
+	Bitfield bVisited;
+	bVisited.init(nX,nY);
+	return floodFillSpans(_startX,_startY,inFill,includeDiagonals,bVisited,
+		[&aLabel,label](const int _y, const int _x1, const int _x2)
 		{
-			posX=vToCheck(currentV)->x;
-			posY=vToCheck(currentV)->y;
-		}
-	}
+			int * const row = &aLabel.data[aLabel.nX*_y];
+			std::fill(row+_x1,row+_x2+1,label);
+		});
+}
+int floodFillLabel ( const int _startX, const int _startY, ArrayS2 <int>& aLabel, const int label, const bool includeDiagonals=true )
+{
+	if ( isSafe(_startX,_startY)==false ) { return 0; }
+	return floodFillLabel(_startX,_startY,aLabel,label,FloodFillEqual((*this)(_startX,_startY)),includeDiagonals);
+}
 
-	for ( int i=0; i<vToCheck.size(); ++i)
-	{
-		delete vToCheck(i);
-	}
+	// Old interface. Returns a vector of all the coordinates within the flood fill area, which the caller must delete.
+	// Prefer floodFillBuffer(), which doesn't allocate per tile.
+Vector <HasXY*> * floodFillVector ( const int _startX, const int _startY, const bool includeDiagonals )
+{
+	Vector <HasXY*> * const vToFill = new Vector <HasXY*>;
+	vToFill->reserve(nX+nY);
 
+	Bitfield bVisited;
+	bVisited.init(nX,nY);
+	floodFillSpans(_startX,_startY,FloodFillEqual((*this)(_startX,_startY)),includeDiagonals,bVisited,
+		[vToFill](const int _y, const int _x1, const int _x2)
+		{
+			for (int _x=_x1;_x<=_x2;++_x)
+			{ vToFill->push(new HasXY(_x,_y)); }
+		});
 	return vToFill;
 }
 
-// This one hasn't been updated.
-// May also have duplicate coordinates bug.
+	// Give every connected area a unique ID, starting from 0 in row order. Returns a new array which the caller must
+	// delete. This is now a wrapper for labelComponents(), which does the whole map in one pass.
 ArrayS2 <short int> * floodFillUniqueID ( const bool includeDiagonals, int* lastID )
 {
-	ArrayS2 <short int>* aID = new ArrayS2 <short int> (nX,nY,-1);
-	short int currentID=0;
-
-	for (int _y=0;_y<nY;++_y)
-	{
-		for (int _x=0;_x<nX;++_x) 
-		{
-			if ( (*aID)(_x,_y) == -1 )
-			{
-				ARRAYS2_T initialValue = (*this)(_x,_y);
-
-				// Vector of coordinates to return.
-				//Vector <HasXY*> * const vToFill = new Vector <HasXY*>;
-
-				/* vectors of coordinates to be checked (this can be changed to std::pair */
-				Vector <HasXY*> vToCheck;
-				//vToCheck.reserve(nX);
-
-				int currentV=-1;
-				int posX=_x;
-				int posY=_y;
+	ArrayS2 <int> aLabel;
+	const int nRegions = labelComponents(aLabel,0,includeDiagonals);
 
-				/* scanline fill loop */
-				while (currentV!=vToCheck.size())
-				{
-					const int INITIAL_X=posX;
-					/* go left to find the leftmost tile for this row which meets the criteria for water, filling along the way */
-					/* we also check the tile directly above or below to see if there are any tiles that can be filled on those rows. */
-					/* If we find such tiles, then we store the leftmost ones, for both the upper and lower row. */
-					/* NOTE: y coords seems to encode upside-down, so we need to work upside-down here. */
-					/* Fill left */
-					// while ( posX>=0 && aID(posX,posY)==false && (*this)(posX,posY)==initialValue )
-					while ( posX>=0 && (*this)(posX,posY)==initialValue && (*aID)(posX,posY)==-1)
-					{
-						(*aID)(posX,posY)=currentID;
-						//vToFill->push(new HasXY(posX,posY));
-						//(*aID)(posX,posY)=currentID;
-
-						/* check below */
-						/* If we're not on the bottom row, and the below tile is land. */
-						if(posY<nY-1 && (*this)(posX,posY+1)==initialValue && (*aID)(posX,posY+1)==-1 )
-						{
-							/* If we are at the leftmost or rightmost column of the map. */
-							if(posX==0 || posX==nX-1 )
-							{
-								/* push tile below us if it's valid. */
-								//if(aID(posX,posY+1)==false)
-								{
-									vToCheck.push(new HasXY(posX,posY+1));
-								}
-							}
-							/* if we aren't at the leftmost or rightmost column of the map. */
-							else
-							{
-								/* if the bottom-left tile doesn't match, and the below tile has not been processed. */
-								//if ( (*this)(posX-1,posY+1)!=initialValue && aID(posX,posY+1)==false )
-								if ( (*this)(posX-1,posY+1)!=initialValue )
-								{ 
-									vToCheck.push(new HasXY(posX,posY+1));
-								}
-							}
-						}
-						/* check above */
-						/* If we're not on the top row, and the above tile is water. */
-						if(posY>0 && (*this)(posX,posY-1)==initialValue && (*aID)(posX,posY-1)==-1 )
-						{
-							/* If we are at the leftmost or rightmost column of the map. */
-							if(posX==0 || posX==nX-1 )
-							{
-								/* push tile above us if it's valid. */
-								//if(aID(posX,posY-1)==false)
-								{
-									vToCheck.push(new HasXY(posX,posY-1));
-								}
-							}
-							/* if we aren't at the leftmost or rightmost column of the map. */
-							else
-							{
-								/* if the top-left tile is land, and the above tile has not been processed. */
-								//if ((*this)(posX-1,posY-1)!=initialValue && aID(posX,posY-1)==false)
-								if ((*this)(posX-1,posY-1)!=initialValue )
-								{
-									vToCheck.push(new HasXY(posX,posY-1));
-								}
-							}
-						}
-						--posX; /* move left 1 tile */
-					}
-
-
-					/* check the last X for this scan. */
-					// NOTE: I THINK SWITCHING TO A DO WHILE MIGHT REMOVE THE NEED FOR THIS BIT.
-
-					++posX;
-					/* check below */
-					/* If we're not on the bottom row, and the below tile is water, and the below tile hasn't been processed yet. */
-					if(posY<nY-1 && (*this)(posX,posY+1)==initialValue && (*aID)(posX,posY+1)==-1 )
-					{
-						/* push coords onto vectors. */
-						vToCheck.push(new HasXY(posX,posY+1));
-					}
-
-					/* check above */
-					/* If we're not on the top row, and the above tile is water, and the above tile hasn't been processed yet. */
-					if(posY>0 && (*this)(posX,posY-1)==initialValue && (*aID)(posX,posY-1)==-1)
-					{
-						/* push coords onto vectors. */
-						vToCheck.push(new HasXY(posX,posY-1));
-					}
-
-					if ( includeDiagonals )
-					{
-						// DIAGONALS: SAME BUT CHECK BELOW-LEFT
-						if(posY<nY-1 && posX>0 && (*this)(posX-1,posY+1)==initialValue && (*aID)(posX-1,posY+1)==-1 )
-						{
-							vToCheck.push(new HasXY(posX-1,posY+1));
-						}
-
-						// DIAGONALS: SAME BUT CHECK ABOVE-LEFT
-						if(posY>0 && posX>0 && (*this)(posX-1,posY-1)==initialValue && (*aID)(posX-1,posY-1)==-1 )
-						{
-							vToCheck.push(new HasXY(posX-1,posY-1));
-						}
-					}
-
-					posX=INITIAL_X+1;
-
-
-					/* Go back to the initial x position, and now fill right */
-					//while ( posX < nX && (*this)(posX,posY)==initialValue && aID(posX,posY)==false )
-					while ( posX < nX && (*this)(posX,posY)==initialValue )
-					{
-						(*aID)(posX,posY)=currentID;
-						//vToFill->push(new HasXY(posX,posY));
-						//++landMassSize;
-						/* check below */
-						/* If we're not on the bottom row, and the below tile is water. */
-						if(posY<nY-1 && (*this)(posX,posY+1)==initialValue)
-						{
-							/* If we are at the leftmost or rightmost column of the map. */
-							if(posX==0 || posX==nX-1 )
-							{
-								/* push tile below us if it's valid. */
-								if((*aID)(posX,posY+1)==-1)
-								{ vToCheck.push(new HasXY(posX,posY+1)); /* vX.push(posX); vY.push(posY+1); */ }
-							}
-							/* if we aren't at the leftmost or rightmost column of the map. */
-							else
-							{
-								/* if the bottom-left tile is land, and the below tile has not been processed. */
-								//if ( aIsLand(posX-1,posY+1)==false && aID(posX,posY+1)==false)
-								if ( (*this)(posX-1,posY+1)!=initialValue && (*aID)(posX,posY+1)==-1)
-								{ vToCheck.push(new HasXY(posX,posY+1)); /* vX.push(posX); vY.push(posY+1); */ }
-							}
-						}
-						/* check above */
-						/* If we're not on the top row, and the above tile is water. */
-						//if(posY>0 && aIsLand(posX,posY-1)==true )
-						if(posY>0 && (*this)(posX,posY-1)==initialValue )
-						{
-							/* If we are at the leftmost or rightmost column of the map. */
-							if(posX==0 || posX==nX-1 )
-							{
-								/* push tile above us if it's valid. */
-								if((*aID)(posX,posY-1)==-1)
-								{ vToCheck.push(new HasXY(posX,posY-1)); /* vX.push(posX); vY.push(posY-1); */ }
-							}
-							/* if we aren't at the leftmost or rightmost column of the map. */
-							else
-							{
-								/* if the top-left tile is land, and the above tile has not been processed. */
-								//if ( aIsLand(posX-1,posY-1)==false && aID(posX,posY-1)==false )
-								if ( (*this)(posX-1,posY-1)!=initialValue && (*aID)(posX,posY-1)==-1 )
-								{ vToCheck.push(new HasXY(posX,posY-1)); /* vX.push(posX); vY.push(posY-1); */ }
-							}
-						}
-						/* move right 1 tile */
-						++posX;
-					}
-
-					//KLUDGE. DO WHILE MAYBE IS SMARTER. MAYBE.
-					--posX;
-
-					if ( includeDiagonals )
-					{
-
-						// DIAGONALS: CHECK BELOW-RIGHT
-						//if(posY<nY-1 && posX<nX-1 && aIsLand(posX+1,posY+1)==true && aID(posX+1,posY+1)==false )
-						if(posY<nY-1 && posX<nX-1 && (*this)(posX+1,posY+1)==initialValue && (*aID)(posX+1,posY+1)==-1 )
-						{
-							//vX.push(posX+1); vY.push(posY+1);
-							vToCheck.push(new HasXY(posX+1,posY+1));
-						}
-
-						// DIAGONALS: CHECK ABOVE-RIGHT
-						//if(posY>0 && posX<nX-1 && aIsLand(posX+1,posY-1)==true && aID(posX+1,posY-1)==false )
-						if(posY>0 && posX<nX-1 && (*this)(posX+1,posY-1)==initialValue && (*aID)(posX+1,posY-1)==-1 )
-						{
-							//vX.push(posX+1); vY.push(posY-1);
-							vToCheck.push(new HasXY(posX+1,posY-1));
-						}
-
-					}
-
-
-					/* entire row is complete. Go to next set of coords. */
-					/* Look for some good coords on the vector. */
-					++currentV;
-
-
-					for (;currentV<vToCheck.size();++currentV)
-					{
-						if ( (*aID)(vToCheck(currentV)) == -1 )
-						{
-							posX=vToCheck(currentV)->x;
-							posY=vToCheck(currentV)->y;
-							break;
-						}
-						else
-						{
-							//std::cout<<"skipped a check\n";
-						}
-					}
-				}
-
-				for ( int i=0; i<vToCheck.size(); ++i)
-				{
-					delete vToCheck(i);
-				}
-				++currentID;
-
-			}
-		}
-	}
+	ArrayS2 <short int>* aID = new ArrayS2 <short int> (nX,nY,-1);
+	for (int i=0;i<nX*nY;++i)
+	{ (*aID)(i) = aLabel(i); }
 
-	*lastID = currentID-1;
+	*lastID = nRegions-1;
 	return aID;
-
 }
 
 
@@ -0,0 +1,217 @@
+#pragma once
+#ifndef WILDCAT_CONTAINER_ARRAYS2_ARRAYS2_LAYERSET_HPP
+#define WILDCAT_CONTAINER_ARRAYS2_ARRAYS2_LAYERSET_HPP
+
+/* Wildcat: ArrayS2_LayerSet
+	#include <Container/ArrayS2/ArrayS2_LayerSet.hpp>
+
+	A set of named 2D layers which all have the same size, stored as one allocation with one plane per layer.
+	For example a world map with a terrain layer, a height layer and a river layer.
+
+	Each layer is bound to an ArrayS2, which becomes a view of its plane. The ArrayS2 can be used as normal,
+	so existing code doesn't need to change, and a scan over one layer only touches that layer's memory.
+	Calling init() on a view with the same size just fills it (see ArrayS2::initView()).
+
+		ArrayS2_LayerSet layers;
+		ArrayS2 <enumBiome> aTerrainType;
+		ArrayS2 <unsigned char> aHeightMap;
+
+		layers.addLayer("terrain",aTerrainType,OCEAN);
+		layers.addLayer("height",aHeightMap,(unsigned char)0);
+		layers.init(mapSize,mapSize);
+
+		ArrayS2 <unsigned char>* aHeight = layers.getLayer <unsigned char> ("height");
+
+	Layers must be trivially copyable types, because the planes are raw memory. Each plane starts on a new
+	cache line.
+
+	The ArrayS2s must outlive the layer set, or at least not be used after it is gone.
+*/
+
+#include <Container/ArrayS2/ArrayS2.hpp>
+#include <Container/Vector/Vector.hpp>
+
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <typeinfo>
+#include <type_traits>
+
+class ArrayS2_LayerSet
+{
+	private:
+
+	static const size_t PLANE_ALIGNMENT = 64;
+
+	class Layer
+	{
+		public:
+		std::string name;
+		const std::type_info * type;
+		size_t elementSize;
+		size_t offset; // Offset of the plane from the start of the block.
+
+		void * array; // The ArrayS2 bound to this layer.
+		void (*bind) (void * array, unsigned char * plane, int nX, int nY); // Point the ArrayS2 at its plane.
+		void (*fillNull) (void * array); // Fill the ArrayS2 with its null value.
+	};
+
+	Vector <Layer> vLayer;
+
+	unsigned char * block; // The memory, as allocated.
+	unsigned char * alignedBlock; // The start of the first plane.
+	size_t blockSize;
+
+	public:
+
+	int nX, nY;
+
+	ArrayS2_LayerSet()
+	{
+		block=0;
+		alignedBlock=0;
+		blockSize=0;
+		nX=0;
+		nY=0;
+	}
+	~ArrayS2_LayerSet()
+	{
+		delete [] block;
+	}
+
+		// The block is owned by the layer set, and the layers point into it, so it can't be copied.
+	ArrayS2_LayerSet(const ArrayS2_LayerSet&) = delete;
+	void operator = (const ArrayS2_LayerSet&) = delete;
+
+		// Add a layer and bind an array to it. The array is set up on the next init(). If the layer set has
+		// already been initialised, it is initialised again, which fills every layer with its null value.
+	template <class T>
+	void addLayer (const std::string _name, ArrayS2 <T>& _array, const T _nullValue)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "ArrayS2_LayerSet layers must be trivially copyable.");
+
+		if ( getLayerIndex(_name) != -1 )
+		{
+			std::cout<<"WARNING: ArrayS2_LayerSet already has a layer called "<<_name<<".\n";
+			return;
+		}
+
+		Layer layer;
+		layer.name=_name;
+		layer.type=&typeid(T);
+		layer.elementSize=sizeof(T);
+		layer.offset=0;
+		layer.array=&_array;
+		layer.bind = [](void * array, unsigned char * plane, int _nX, int _nY)
+		{
+			ArrayS2 <T> * a = static_cast<ArrayS2 <T>*>(array);
+			a->initView(reinterpret_cast<T*>(plane),_nX,_nY);
+		};
+		layer.fillNull = [](void * array)
+		{
+			ArrayS2 <T> * a = static_cast<ArrayS2 <T>*>(array);
+			a->fill(a->nullValue);
+		};
+		vLayer.push(layer);
+
+		_array.name=_name;
+		_array.nullValue=_nullValue;
+
+		if ( block!=0 )
+		{ init(nX,nY); }
+	}
+
+		// Allocate every plane and fill each one with its null value. Layers keep their memory if the size
+		// hasn't changed.
+	void init (const int _nX, const int _nY)
+	{
+		size_t size = 0;
+		for (int i=0;i<vLayer.size();++i)
+		{
+			vLayer(i).offset=size;
+			size+=vLayer(i).elementSize*_nX*_nY;
+			size=(size+PLANE_ALIGNMENT-1)/PLANE_ALIGNMENT*PLANE_ALIGNMENT;
+		}
+
+		if ( size != blockSize || block==0 )
+		{
+			delete [] block;
+			block = new unsigned char [size+PLANE_ALIGNMENT];
+			blockSize=size;
+
+			const size_t misalignment = (size_t)block % PLANE_ALIGNMENT;
+			alignedBlock = block + (misalignment==0 ? 0 : PLANE_ALIGNMENT-misalignment);
+		}
+		nX=_nX;
+		nY=_nY;
+
+		for (int i=0;i<vLayer.size();++i)
+		{
+			Layer& layer = vLayer(i);
+			layer.bind(layer.array,alignedBlock+layer.offset,nX,nY);
+		}
+		fillNull();
+	}
+
+		// Reset every layer to its null value.
+	void fillNull()
+	{
+		for (int i=0;i<vLayer.size();++i)
+		{
+			vLayer(i).fillNull(vLayer(i).array);
+		}
+	}
+
+	int getLayerIndex (const std::string _name) const
+	{
+		for (int i=0;i<nLayers();++i)
+		{
+			if ( vLayer.data[i].name == _name )
+			{ return i; }
+		}
+		return -1;
+	}
+
+		// Get a layer by name. Returns 0 if there's no layer with that name and type.
+	template <class T>
+	ArrayS2 <T>* getLayer (const std::string _name)
+	{
+		const int i = getLayerIndex(_name);
+		if ( i==-1 )
+		{
+			std::cout<<"WARNING: ArrayS2_LayerSet has no layer called "<<_name<<".\n";
+			return 0;
+		}
+		if ( *vLayer(i).type != typeid(T) )
+		{
+			std::cout<<"WARNING: ArrayS2_LayerSet layer "<<_name<<" is a different type.\n";
+			return 0;
+		}
+		return static_cast<ArrayS2 <T>*>(vLayer(i).array);
+	}
+
+	inline int nLayers() const
+	{ return vLayer.data.size(); }
+
+		// Bytes used by one layer, or all of them.
+	size_t layerBytes (const int i) const
+	{ return vLayer.data[i].elementSize*nX*nY; }
+	size_t totalBytes() const
+	{ return blockSize; }
+
+		// One line per layer with the bytes per tile and the total size.
+	std::string getMemoryReport() const
+	{
+		std::ostringstream report;
+		report<<"Layers: "<<nX<<"x"<<nY<<".\n";
+		for (int i=0;i<nLayers();++i)
+		{
+			const Layer& layer = vLayer.data[i];
+			report<<"  "<<layer.name<<": "<<layer.elementSize<<" bytes per tile, "<<layerBytes(i)/1024<<" KB.\n";
+		}
+		report<<"  Total: "<<totalBytes()/1024<<" KB.\n";
+		return report.str();
+	}
+};
+
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef WILDCAT_CONTAINER_ARRAYS2_ARRAYS2_NEIGHBORLIST_HPP
+#define WILDCAT_CONTAINER_ARRAYS2_ARRAYS2_NEIGHBORLIST_HPP
+
+/* Wildcat: ArrayS2_NeighborList
+	#include <Container/ArrayS2/ArrayS2_NeighborList.hpp>
+
+	Fixed-size list of up to 9 coordinates, returned by value from ArrayS2::getNeighborList().
+	It lives on the stack, so building one doesn't touch the heap. It replaces the old pattern of
+	getting a new Vector of new HasXY and then deleting everything afterwards.
+
+	Shuffling works the same way as Vector::shuffle(), so swapping a Vector <HasXY*> for this list
+	gives the same order for the same seed.
+*/
+
+#include <Interface/HasXY.hpp>
+#include <Math/Random/GlobalRandom.hpp>
+#include <Math/Random/RandomLehmer.hpp>
+
+#include <algorithm> /* std::shuffle, std::swap */
+
+class ArrayS2_NeighborList
+{
+	public:
+
+	static const int MAX_NEIGHBORS = 9; // 8 neighbours plus self.
+
+	HasXY aCoord [MAX_NEIGHBORS];
+	int nCoords;
+
+	ArrayS2_NeighborList()
+	{
+		nCoords=0;
+	}
+
+	inline int size() const
+	{ return nCoords; }
+	inline bool empty() const
+	{ return nCoords==0; }
+	inline void clear()
+	{ nCoords=0; }
+
+	inline void push(const int _x, const int _y)
+	{
+		aCoord[nCoords].x=_x;
+		aCoord[nCoords].y=_y;
+		++nCoords;
+	}
+
+	inline HasXY& operator() (const int i)
+	{ return aCoord[i]; }
+
+	HasXY* begin()
+	{ return &aCoord[0]; }
+	HasXY* end()
+	{ return &aCoord[nCoords]; }
+
+		// Same as Vector::shuffle().
+	void shuffle()
+	{
+		std::shuffle(begin(),end(), Random::getRNG());
+	}
+		// Same as Vector::shuffle(RandomLehmer). Note the rng is passed by value.
+	void shuffle( RandomLehmer rng )
+	{
+		for (int i = nCoords-1; i > 0; --i)
+		{
+			std::swap(aCoord[i], aCoord[rng.rand32() % (i+1)]);
+		}
+	}
+};
+
+#endif
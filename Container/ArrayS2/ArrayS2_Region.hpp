@@ -0,0 +1,69 @@
+#pragma once
+#ifndef WILDCAT_CONTAINER_ARRAYS2_ARRAYS2_REGION_HPP
+#define WILDCAT_CONTAINER_ARRAYS2_ARRAYS2_REGION_HPP
+
+/* Wildcat: ArrayS2_Region
+	#include <Container/ArrayS2/ArrayS2_Region.hpp>
+
+	Summary of one connected region, as returned by ArrayS2::labelComponents().
+
+	The bounding box is in array coordinates and is inclusive. A region which wraps around the edge of the
+	map will have a bounding box which covers the whole width (or height) of the map.
+
+	The seed is the first tile of the region in row order. It can be used to flood fill or look up the value
+	of the region.
+*/
+
+class ArrayS2_Region
+{
+	public:
+	int size;
+	int x1, y1, x2, y2;
+	int seedX, seedY;
+
+	ArrayS2_Region()
+	{
+		size=0;
+		x1=0; y1=0; x2=-1; y2=-1;
+		seedX=0; seedY=0;
+	}
+
+		// Add a horizontal run of tiles to the region.
+	inline void addRun(const int _y, const int _x1, const int _x2)
+	{
+		if ( size==0 )
+		{
+			x1=_x1; x2=_x2;
+			y1=_y; y2=_y;
+			seedX=_x1; seedY=_y;
+		}
+		else
+		{
+			if ( _x1 < x1 ) { x1=_x1; }
+			if ( _x2 > x2 ) { x2=_x2; }
+			if ( _y < y1 ) { y1=_y; }
+			if ( _y > y2 ) { y2=_y; }
+		}
+		size+=_x2-_x1+1;
+	}
+
+		// Merge another part of the same region into this one. The other part must come later in row order.
+	void merge(const ArrayS2_Region& other)
+	{
+		if ( other.size==0 ) { return; }
+		if ( size==0 ) { *this=other; return; }
+
+		if ( other.x1 < x1 ) { x1=other.x1; }
+		if ( other.x2 > x2 ) { x2=other.x2; }
+		if ( other.y1 < y1 ) { y1=other.y1; }
+		if ( other.y2 > y2 ) { y2=other.y2; }
+		size+=other.size;
+	}
+
+	inline int width() const
+	{ return x2-x1+1; }
+	inline int height() const
+	{ return y2-y1+1; }
+};
+
+#endif
@@ -0,0 +1,276 @@
+#include <Container/ArrayS2/ArrayS2.hpp>
+#include <Math/Random/RandomLehmer.hpp>
+#include <System/Time/Timer.hpp>
+
+#include <iostream>
+
+// g++ ArrayS2_Benchmark.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX -D WILDCAT_THREADING -pthread
+
+// Benchmarks for ArrayS2 algorithms. Each test times the old path against the new one on a full-size map,
+// and checks that they give the same result.
+
+const int MAP_SIZE = 4097;
+
+void benchmarkNeighbors(ArrayS2 <unsigned char>& aMap)
+{
+	std::cout<<"\nNeighbour iteration on "<<MAP_SIZE<<"x"<<MAP_SIZE<<" map.\n";
+
+	Timer timer;
+
+	// OLD: Vector of new HasXY.
+	long unsigned int oldTotal = 0;
+	timer.init();
+	timer.start();
+	for (int _y=0;_y<aMap.nY;++_y)
+	{
+		for (int _x=0;_x<aMap.nX;++_x)
+		{
+			Vector <HasXY*>* vNeighbors = aMap.getNeighbors(_x,_y,false);
+			for (int i=0;i<vNeighbors->size();++i)
+			{
+				oldTotal+=aMap((*vNeighbors)(i));
+				delete (*vNeighbors)(i);
+			}
+			delete vNeighbors;
+		}
+	}
+	timer.update();
+	std::cout<<"  getNeighbors(): "<<timer.fullSeconds<<" seconds.\n";
+
+	// NEW: Visitor.
+	long unsigned int newTotal = 0;
+	timer.init();
+	timer.start();
+	for (int _y=0;_y<aMap.nY;++_y)
+	{
+		for (int _x=0;_x<aMap.nX;++_x)
+		{
+			aMap.forEachNeighbor(_x,_y,[&](const int _x2, const int _y2) { newTotal+=aMap(_x2,_y2); });
+		}
+	}
+	timer.update();
+	std::cout<<"  forEachNeighbor(): "<<timer.fullSeconds<<" seconds.\n";
+
+	// NEW: Stack list.
+	long unsigned int listTotal = 0;
+	timer.init();
+	timer.start();
+	for (int _y=0;_y<aMap.nY;++_y)
+	{
+		for (int _x=0;_x<aMap.nX;++_x)
+		{
+			ArrayS2_NeighborList vNeighbors = aMap.getNeighborList(_x,_y,false);
+			for (int i=0;i<vNeighbors.size();++i)
+			{
+				listTotal+=aMap(vNeighbors(i));
+			}
+		}
+	}
+	timer.update();
+	std::cout<<"  getNeighborList(): "<<timer.fullSeconds<<" seconds.\n";
+
+	if ( oldTotal==newTotal && oldTotal==listTotal )
+	{ std::cout<<"  Totals match.\n"; }
+	else
+	{ std::cout<<"  ERROR: Totals don't match.\n"; }
+
+	// Orthogonal and radius versions.
+	oldTotal=0;
+	newTotal=0;
+	timer.init();
+	timer.start();
+	for (int _y=0;_y<aMap.nY;++_y)
+	{
+		for (int _x=0;_x<aMap.nX;++_x)
+		{
+			Vector <HasXY*>* vNeighbors = aMap.getNeighbors2(_x,_y,2);
+			for (int i=0;i<vNeighbors->size();++i)
+			{
+				oldTotal+=aMap((*vNeighbors)(i));
+				delete (*vNeighbors)(i);
+			}
+			delete vNeighbors;
+		}
+	}
+	timer.update();
+	std::cout<<"  getNeighbors2() radius 2: "<<timer.fullSeconds<<" seconds.\n";
+
+	timer.init();
+	timer.start();
+	for (int _y=0;_y<aMap.nY;++_y)
+	{
+		for (int _x=0;_x<aMap.nX;++_x)
+		{
+			aMap.forEachNeighborRadius(_x,_y,2,[&](const int _x2, const int _y2) { newTotal+=aMap(_x2,_y2); },true);
+		}
+	}
+	timer.update();
+	std::cout<<"  forEachNeighborRadius() radius 2: "<<timer.fullSeconds<<" seconds.\n";
+
+	if ( oldTotal==newTotal )
+	{ std::cout<<"  Totals match.\n"; }
+	else
+	{ std::cout<<"  ERROR: Totals don't match.\n"; }
+}
+
+void benchmarkFloodFill(ArrayS2 <unsigned char>& aMap)
+{
+	std::cout<<"\nFlood fill on "<<MAP_SIZE<<"x"<<MAP_SIZE<<" map.\n";
+
+	// Make a land/water map. At 75% land the land is mostly one big connected area.
+	ArrayS2 <bool> aLand (aMap.nX,aMap.nY,false);
+	for (int i=0;i<aMap.nX*aMap.nY;++i)
+	{ aLand(i) = aMap(i) < 3; }
+	aLand(0,0) = true;
+
+	Timer timer;
+
+	// OLD INTERFACE: Vector of new HasXY.
+	timer.init();
+	timer.start();
+	Vector <HasXY*>* vFill = aLand.floodFillVector(0,0,true);
+	timer.update();
+	const int nOld = vFill->size();
+	for (int i=0;i<vFill->size();++i)
+	{ delete (*vFill)(i); }
+	delete vFill;
+	std::cout<<"  floodFillVector(): "<<nOld<<" tiles in "<<timer.fullSeconds<<" seconds.\n";
+
+	// Flat buffer.
+	Vector <HasXY> vBuffer;
+	timer.init();
+	timer.start();
+	const int nBuffer = aLand.floodFillBuffer(0,0,vBuffer,true);
+	timer.update();
+	std::cout<<"  floodFillBuffer(): "<<nBuffer<<" tiles in "<<timer.fullSeconds<<" seconds.\n";
+
+	// Label image.
+	ArrayS2 <int> aLabel (aMap.nX,aMap.nY,-1);
+	timer.init();
+	timer.start();
+	const int nLabel = aLand.floodFillLabel(0,0,aLabel,1,true);
+	timer.update();
+	std::cout<<"  floodFillLabel(): "<<nLabel<<" tiles in "<<timer.fullSeconds<<" seconds.\n";
+
+	// Range predicate on the original map, 4-way.
+	timer.init();
+	timer.start();
+	const int nRange = aMap.floodFillLabel(0,0,aLabel,2,ArrayS2 <unsigned char>::FloodFillRange(0,2),false);
+	timer.update();
+	std::cout<<"  floodFillLabel() range 0-2, 4-way: "<<nRange<<" tiles in "<<timer.fullSeconds<<" seconds.\n";
+
+	if ( nOld==nBuffer && nOld==nLabel )
+	{ std::cout<<"  Counts match.\n"; }
+	else
+	{ std::cout<<"  ERROR: Counts don't match.\n"; }
+}
+
+void benchmarkLabelComponents(ArrayS2 <unsigned char>& aMap)
+{
+	std::cout<<"\nConnected component labelling on "<<MAP_SIZE<<"x"<<MAP_SIZE<<" map.\n";
+
+	ArrayS2 <bool> aLand (aMap.nX,aMap.nY,false);
+	for (int i=0;i<aMap.nX*aMap.nY;++i)
+	{ aLand(i) = aMap(i) < 2; }
+
+	Timer timer;
+
+	// OLD APPROACH: Flood fill from every tile which doesn't have an ID yet.
+	ArrayS2 <int> aOldLabel (aMap.nX,aMap.nY,-1);
+	Bitfield bVisited;
+	bVisited.init(aMap.nX,aMap.nY);
+	int nOld = 0;
+	timer.init();
+	timer.start();
+	for (int _y=0;_y<aLand.nY;++_y)
+	{
+		for (int _x=0;_x<aLand.nX;++_x)
+		{
+			if ( aOldLabel(_x,_y)==-1 )
+			{
+				aLand.floodFillSpans(_x,_y,ArrayS2 <bool>::FloodFillEqual(aLand(_x,_y)),true,bVisited,
+					[&aOldLabel,nOld](const int _y2, const int _x1, const int _x2)
+					{
+						for (int _x3=_x1;_x3<=_x2;++_x3) { aOldLabel(_x3,_y2)=nOld; }
+					});
+				++nOld;
+			}
+		}
+	}
+	timer.update();
+	std::cout<<"  Flood fill from every seed: "<<nOld<<" regions in "<<timer.fullSeconds<<" seconds.\n";
+
+	// NEW: Single thread.
+	ArrayS2 <int> aLabel;
+	Vector <ArrayS2_Region> vRegion;
+	timer.init();
+	timer.start();
+	const int nSingle = aLand.labelComponents(aLabel,&vRegion,true,false,false,1);
+	timer.update();
+	std::cout<<"  labelComponents() 1 thread: "<<nSingle<<" regions in "<<timer.fullSeconds<<" seconds ("
+		<<(double)aLand.nX*aLand.nY/timer.fullSeconds/1000000<<"M tiles/s per core).\n";
+
+	bool match = (nSingle==nOld);
+	for (int i=0;i<aLand.nX*aLand.nY && match;++i)
+	{ match = aLabel(i)==aOldLabel(i); }
+
+	// NEW: 1 thread per core.
+	ArrayS2 <int> aLabel2;
+	timer.init();
+	timer.start();
+	const int nThreaded = aLand.labelComponents(aLabel2,&vRegion,true,false,false,0);
+	timer.update();
+	std::cout<<"  labelComponents() all cores: "<<nThreaded<<" regions in "<<timer.fullSeconds<<" seconds.\n";
+
+	for (int i=0;i<aLand.nX*aLand.nY && match;++i)
+	{ match = aLabel(i)==aLabel2(i); }
+
+	if ( match )
+	{ std::cout<<"  Labels match.\n"; }
+	else
+	{ std::cout<<"  ERROR: Labels don't match.\n"; }
+
+	// Large regions, where branches are predictable.
+	for (int _y=0;_y<aLand.nY;++_y)
+	{
+		for (int _x=0;_x<aLand.nX;++_x)
+		{ aLand(_x,_y) = ((_x/37)^(_y/53))&1; }
+	}
+	timer.init();
+	timer.start();
+	const int nBlocks = aLand.labelComponents(aLabel,&vRegion,true,false,false,1);
+	timer.update();
+	std::cout<<"  labelComponents() 1 thread, large regions: "<<nBlocks<<" regions in "<<timer.fullSeconds
+		<<" seconds ("<<(double)aLand.nX*aLand.nY/timer.fullSeconds/1000000<<"M tiles/s per core).\n";
+
+	// A comparison which isn't transitive: values within 1 of each other. 0 and 2 are only joined through a 1.
+	ArrayS2 <int> aSteps (3,2,0);
+	aSteps(0,0)=0; aSteps(1,0)=2; aSteps(2,0)=0;
+	aSteps(0,1)=0; aSteps(1,1)=1; aSteps(2,1)=2;
+	ArrayS2 <int> aStepLabel;
+	const int nSteps = aSteps.labelComponents(aStepLabel,0,true,false,false,1,
+		[](const int a, const int b) { return a-b<=1 && b-a<=1; });
+	if ( nSteps==1 )
+	{ std::cout<<"  Non-transitive comparison joins through every neighbour.\n"; }
+	else
+	{ std::cout<<"  ERROR: Non-transitive comparison gave "<<nSteps<<" regions.\n"; }
+}
+
+int main (int nArgs, char ** arg)
+{
+	RandomLehmer rng (123);
+
+	std::cout<<"Building "<<MAP_SIZE<<"x"<<MAP_SIZE<<" test map.\n";
+	ArrayS2 <unsigned char> aMap (MAP_SIZE,MAP_SIZE,0);
+	for (int i=0;i<MAP_SIZE*MAP_SIZE;++i)
+	{
+		aMap(i) = rng.rand8(4);
+	}
+
+	benchmarkNeighbors(aMap);
+	benchmarkFloodFill(aMap);
+	benchmarkLabelComponents(aMap);
+
+	std::cout<<"\nEnd of benchmarks.\n";
+	return 0;
+}
@@ -96,6 +96,17 @@ class Bitfield
          data[targetByte] = data[targetByte] & (~mask);
       }
    }
+   
+   // 1D versions of the above, where index is nX*y+x. Faster when scanning along a row.
+   inline bool get(const unsigned long int index) const
+   {
+      return (data[index>>3] & (1<<(index&7))) != 0;
+   }
+   inline void set(const unsigned long int index)
+   {
+      data[index>>3] |= (1<<(index&7));
+   }
+   
    // set binary representation of given value from given position, with a maximum of length bits set.
    // overflow not recommended
    // currently only up to 8 bits supported
@@ -0,0 +1,167 @@
+#pragma once
+#ifndef WILDCAT_FILE_FILE_MAPPING_HPP
+#define WILDCAT_FILE_FILE_MAPPING_HPP
+
+/* Wildcat: FileMapping
+	#include <File/FileMapping.hpp>
+
+	Maps a file into memory read-only, so it can be used as a buffer without reading it. Uses mmap with WILDCAT_LINUX
+	and CreateFileMapping with WILDCAT_WINDOWS. Otherwise the file is read into a single buffer.
+
+	The data is only valid until close() or the destructor.
+*/
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef WILDCAT_WINDOWS
+	#include <windows.h>
+#elif defined WILDCAT_LINUX
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+class FileMapping
+{
+	private:
+
+#ifdef WILDCAT_WINDOWS
+	HANDLE file;
+	HANDLE mapping;
+#elif defined WILDCAT_LINUX
+	void* mapped;
+#else
+	std::vector <char> vBuffer;
+#endif
+
+	public:
+
+	const char* data;
+	unsigned long int size;
+
+	FileMapping()
+	{
+#ifdef WILDCAT_WINDOWS
+		file=INVALID_HANDLE_VALUE;
+		mapping=0;
+#elif defined WILDCAT_LINUX
+		mapped=0;
+#endif
+		data=0;
+		size=0;
+	}
+	~FileMapping()
+	{
+		close();
+	}
+
+		// The mapping is unmapped when this is destroyed, so it can't be copied.
+	FileMapping(const FileMapping&) = delete;
+	void operator = (const FileMapping&) = delete;
+
+	// Map the file. Returns false if it can't be opened. An empty file maps successfully with no data.
+	bool open(const std::string _path)
+	{
+		close();
+
+#ifdef WILDCAT_WINDOWS
+		file = CreateFileA(_path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+		if ( file==INVALID_HANDLE_VALUE )
+		{ return false; }
+		LARGE_INTEGER fileSize;
+		if ( GetFileSizeEx(file,&fileSize)==0 )
+		{
+			close();
+			return false;
+		}
+		size = (unsigned long int) fileSize.QuadPart;
+		if ( size==0 )
+		{ return true; }
+		mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+		if ( mapping==0 )
+		{
+			close();
+			return false;
+		}
+		data = (const char*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if ( data==0 )
+		{
+			close();
+			return false;
+		}
+		return true;
+
+#elif defined WILDCAT_LINUX
+		const int fd = ::open(_path.c_str(), O_RDONLY);
+		if ( fd==-1 )
+		{ return false; }
+		struct stat fileStat;
+		if ( fstat(fd,&fileStat)!=0 )
+		{
+			::close(fd);
+			return false;
+		}
+		size = fileStat.st_size;
+		if ( size==0 )
+		{
+			::close(fd);
+			return true;
+		}
+		mapped = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd); // the mapping stays valid
+		if ( mapped==MAP_FAILED )
+		{
+			mapped=0;
+			size=0;
+			return false;
+		}
+		data = (const char*) mapped;
+		return true;
+
+#else
+		std::ifstream file(_path.c_str(), std::ios::binary | std::ios::ate);
+		if ( file.is_open()==false )
+		{ return false; }
+		size = file.tellg();
+		vBuffer.resize(size);
+		file.seekg(0);
+		if ( size>0 && file.read(vBuffer.data(),size).fail() )
+		{
+			close();
+			return false;
+		}
+		data = vBuffer.data();
+		return true;
+#endif
+	}
+
+	void close()
+	{
+#ifdef WILDCAT_WINDOWS
+		if ( data!=0 )
+		{ UnmapViewOfFile(data); }
+		if ( mapping!=0 )
+		{ CloseHandle(mapping); }
+		if ( file!=INVALID_HANDLE_VALUE )
+		{ CloseHandle(file); }
+		file=INVALID_HANDLE_VALUE;
+		mapping=0;
+#elif defined WILDCAT_LINUX
+		if ( mapped!=0 )
+		{ munmap(mapped,size); }
+		mapped=0;
+#else
+		std::vector <char>().swap(vBuffer);
+#endif
+		data=0;
+		size=0;
+	}
+
+	inline bool isOpen() const
+	{ return data!=0; }
+};
+
+#endif
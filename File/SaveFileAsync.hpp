@@ -0,0 +1,328 @@
+#pragma once
+#ifndef WILDCAT_FILE_SAVE_FILE_ASYNC_HPP
+#define WILDCAT_FILE_SAVE_FILE_ASYNC_HPP
+
+/* Wildcat: SaveFileAsync
+	#include <File/SaveFileAsync.hpp>
+
+	Autosaves in the background. Writing a big world on the game thread stalls it for the whole save, so the game
+	thread only copies what needs saving into a SaveFileSnapshot, and a worker thread compresses and writes it.
+
+	The snapshot copies arrays with a single memcpy each, and keeps its buffers between saves so they don't have to
+	be allocated again. SaveFileInterface objects are converted with getSaveData() while the snapshot is taken,
+	because they can change as soon as the game continues. Their chunk has the same layout as SaveJournal's
+	RECORDS chunk: u64 number of records, then for each record: u64 uid, i32 class ID, string data.
+
+	The worker writes a SaveFileBinary file to path.tmp, then renames it over the old save, so a crash during the
+	save leaves the previous save intact. Arrays are run-length compressed unless that wouldn't make them smaller.
+
+	The callback is called from update() on the game thread, with the progress from 0 to 1 while saving, and once
+	more when the save has finished. Only one save can run at a time. Threads are only used if WILDCAT_THREADING is
+	defined, otherwise the save is written during start().
+
+	Usage:
+
+	SaveFileAsync autosave;
+
+	SaveFileSnapshot* snapshot = autosave.beginSnapshot(); // 0 if the last save is still running
+	if ( snapshot )
+	{
+		snapshot->addVariable("SEED",seed);
+		snapshot->addArrayS2("HEIGHT",aHeight);
+		snapshot->addObjects("PEOPLE",vPerson);
+		autosave.start("world.sav",[](double progress, bool finished, bool succeeded) { ... });
+	}
+
+	autosave.update(); // every frame
+
+	The save is read back with SaveFileReader.
+*/
+
+#include <File/SaveFileBinary.hpp>
+#include <File/SaveFileManager.hpp> // SaveFileInterface
+
+#include <Container/Vector/Vector.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifdef WILDCAT_THREADING
+	#include <thread>
+#endif
+
+class SaveFileSnapshot
+{
+	private:
+	friend class SaveFileAsync;
+
+	class Block
+	{
+		public:
+		std::string tag;
+		unsigned int elementSize; // 0 for a chunk which isn't an array
+		unsigned int nDimensions;
+		unsigned int dimension[3];
+		bool compress;
+		std::vector <char> nullValue;
+		std::vector <char> data;
+	};
+
+	std::vector <Block> vBlock; // not shrunk by clear(), so the buffers are reused
+	unsigned int nBlocks;
+
+	Block& addBlock(const std::string& _tag, const unsigned int _elementSize)
+	{
+		if ( nBlocks==vBlock.size() )
+		{ vBlock.push_back(Block()); }
+		Block& block = vBlock[nBlocks++];
+		block.tag=_tag;
+		block.elementSize=_elementSize;
+		block.nDimensions=0;
+		block.compress=false;
+		block.nullValue.clear();
+		block.data.clear();
+		return block;
+	}
+
+	template <class T>
+	static void append(std::vector <char>& _out, const T& _value)
+	{
+		_out.insert(_out.end(),(const char*)&_value,(const char*)&_value+sizeof(T));
+	}
+
+	public:
+
+	SaveFileSnapshot()
+	{
+		nBlocks=0;
+	}
+
+	void clear()
+	{
+		nBlocks=0;
+	}
+
+	// Total bytes copied into the snapshot.
+	unsigned long long int size() const
+	{
+		unsigned long long int total=0;
+		for (unsigned int i=0;i<nBlocks;++i)
+		{ total+=vBlock[i].data.size(); }
+		return total;
+	}
+
+	template <class T>
+	void addVariable(const std::string& _tag, const T& _value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "SaveFileSnapshot can only copy plain values.");
+		append(addBlock(_tag,0).data,_value);
+	}
+	void addVariable(const std::string& _tag, const std::string& _value)
+	{
+		Block& block = addBlock(_tag,0);
+		block.data.assign(_value.begin(),_value.end());
+	}
+
+	template <class T>
+	void addArrayS2(const std::string& _tag, ArrayS2 <T>& _array, const bool _compress=true)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "SaveFileSnapshot can only copy arrays of plain values.");
+		Block& block = addBlock(_tag,sizeof(T));
+		block.nDimensions=2;
+		block.dimension[0]=_array.nX;
+		block.dimension[1]=_array.nY;
+		block.compress=_compress;
+		append(block.nullValue,_array.nullValue);
+		block.data.assign((const char*)_array.data,(const char*)(_array.data+(unsigned long long int)_array.nX*_array.nY));
+	}
+
+	template <class T>
+	void addArrayS3(const std::string& _tag, ArrayS3 <T>& _array, const bool _compress=true)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "SaveFileSnapshot can only copy arrays of plain values.");
+		Block& block = addBlock(_tag,sizeof(T));
+		block.nDimensions=3;
+		block.dimension[0]=_array.nX;
+		block.dimension[1]=_array.nY;
+		block.dimension[2]=_array.nZ;
+		block.compress=_compress;
+		append(block.nullValue,_array.nullValue);
+		block.data.assign((const char*)_array.data,
+			(const char*)(_array.data+(unsigned long long int)_array.nX*_array.nY*_array.nZ));
+	}
+
+	// Records of SaveFileInterface objects.
+	template <class T>
+	void addObjects(const std::string& _tag, Vector <T*>& _vObject)
+	{
+		Block& block = addBlock(_tag,0);
+		append(block.data,(unsigned long long int)_vObject.size());
+		for (int i=0;i<_vObject.size();++i)
+		{
+			SaveFileInterface* object = _vObject(i);
+			const std::string data = object->getSaveData();
+			append(block.data,(unsigned long long int)object->getUID());
+			append(block.data,(int)object->getClassID());
+			append(block.data,(unsigned int)data.size());
+			block.data.insert(block.data.end(),data.begin(),data.end());
+		}
+	}
+};
+
+class SaveFileAsync
+{
+	private:
+
+	enum { IDLE=0, SAVING=1, FINISHED=2 };
+
+	SaveFileSnapshot snapshot;
+	std::string path;
+	std::function <void(double,bool,bool)> callback;
+
+	std::atomic <int> state;
+	std::atomic <unsigned long long int> bytesDone;
+	unsigned long long int bytesTotal;
+	double lastProgress;
+	bool succeeded;
+
+#ifdef WILDCAT_THREADING
+	std::thread worker;
+#endif
+
+	// Runs on the worker thread. Only touches the snapshot, which the game thread leaves alone until the save finishes.
+	void write()
+	{
+		const std::string tempPath = path+".tmp";
+		SaveFileWriter writer;
+		bool saved = writer.open(tempPath);
+
+		for (unsigned int i=0;saved && i<snapshot.nBlocks;++i)
+		{
+			const SaveFileSnapshot::Block& block = snapshot.vBlock[i];
+			if ( block.elementSize==0 )
+			{
+				writer.beginChunk(block.tag);
+				writer.write(block.data.data(),block.data.size());
+				writer.endChunk();
+			}
+			else
+			{
+				writer.addArrayData(block.tag,block.elementSize,block.dimension,block.nDimensions,block.nullValue.data(),
+					block.data.data(),block.compress);
+			}
+			bytesDone+=block.data.size();
+		}
+
+		saved = writer.close() && saved;
+		if ( saved )
+		{ saved = SaveFileBinary::replaceFile(tempPath,path); }
+		if ( saved==false )
+		{
+			std::cout<<"ERROR: Autosave to "<<path<<" failed.\n";
+			std::remove(tempPath.c_str());
+		}
+		succeeded=saved;
+		state=FINISHED;
+	}
+
+	// Wait for the worker and report that the save is done.
+	void finish()
+	{
+#ifdef WILDCAT_THREADING
+		worker.join();
+#endif
+		state=IDLE;
+		if ( callback )
+		{ callback(1,true,succeeded); }
+	}
+
+	public:
+
+	SaveFileAsync()
+	{
+		state=IDLE;
+		bytesDone=0;
+		bytesTotal=0;
+		lastProgress=0;
+		succeeded=false;
+	}
+	~SaveFileAsync()
+	{
+		wait();
+	}
+
+	// Clear and return the snapshot to fill, or 0 if a save is still running.
+	SaveFileSnapshot* beginSnapshot()
+	{
+		if ( state!=IDLE )
+		{ return 0; }
+		snapshot.clear();
+		return &snapshot;
+	}
+
+	// Write the snapshot to _path in the background. Returns false if a save is still running.
+	bool start(const std::string _path, std::function <void(double,bool,bool)> _callback = std::function <void(double,bool,bool)>())
+	{
+		if ( state!=IDLE )
+		{ return false; }
+		path=_path;
+		callback=_callback;
+		bytesDone=0;
+		bytesTotal=snapshot.size();
+		lastProgress=-1;
+		succeeded=false;
+		state=SAVING;
+
+#ifdef WILDCAT_THREADING
+		worker = std::thread(&SaveFileAsync::write,this);
+#else
+		write();
+#endif
+		return true;
+	}
+
+	// Call from the game thread. Reports progress through the callback, and finishes the save once it's written.
+	void update()
+	{
+		if ( state==IDLE )
+		{ return; }
+		if ( state==SAVING )
+		{
+			const double currentProgress = progress();
+			if ( currentProgress!=lastProgress && callback )
+			{ callback(currentProgress,false,false); }
+			lastProgress=currentProgress;
+			return;
+		}
+		finish();
+	}
+
+	// Block until the current save finishes, for example when the game closes. Returns false if it failed.
+	bool wait()
+	{
+		if ( state==IDLE )
+		{ return true; }
+		finish();
+		return succeeded;
+	}
+
+	inline bool isBusy() const
+	{ return state!=IDLE; }
+
+	// Fraction of the snapshot which has been written.
+	double progress() const
+	{
+		if ( state==IDLE )
+		{ return 0; }
+		if ( bytesTotal==0 )
+		{ return state==FINISHED ? 1 : 0; }
+		return (double)bytesDone/bytesTotal;
+	}
+};
+
+#endif
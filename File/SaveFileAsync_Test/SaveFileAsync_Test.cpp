@@ -0,0 +1,184 @@
+#include <climits> /* Colour.hpp needs UINT_MAX. */
+#include <iostream>
+#include <string>
+#include <cstdio>
+
+#include <Container/Vector/Vector.hpp>
+#include <File/SaveFileAsync.hpp>
+#include <System/Time/Timer.hpp>
+
+#include <chrono>
+#include <thread>
+
+// g++ SaveFileAsync_Test.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX -D WILDCAT_THREADING -pthread
+
+// Test of background autosaves. Compares the time the game thread is blocked by a normal save with the time taken
+// to snapshot the world for a background save, and checks that changes made during the save don't end up in it.
+
+const std::string savePath = "SaveFileAsync_Test.sav";
+const int WORLD_SIZE = 2048;
+const int N_PEOPLE = 20000;
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+class Person final: public SaveFileInterface
+{
+	public:
+	std::string name;
+
+	int getClassID() override
+	{ return 3; }
+
+	std::string getSaveData() override
+	{ return name; }
+};
+
+ArrayS2 <int> aHeight;
+ArrayS2 <unsigned char> aBiome;
+Vector <Person*> vPerson;
+
+void takeSnapshot(SaveFileSnapshot* snapshot)
+{
+	snapshot->addVariable("SEED",(long int)42);
+	snapshot->addVariable("NAME",std::string("Async world"));
+	snapshot->addArrayS2("HEIGHT",aHeight);
+	snapshot->addArrayS2("BIOME",aBiome);
+	snapshot->addObjects("PEOPLE",vPerson);
+}
+
+int main (int nArgs, char ** arg)
+{
+	std::remove(savePath.c_str());
+
+	aHeight.init(WORLD_SIZE,WORLD_SIZE,-1);
+	aBiome.init(WORLD_SIZE,WORLD_SIZE,0);
+	for (int i=0;i<WORLD_SIZE*WORLD_SIZE;++i)
+	{
+		aHeight.data[i] = ((long int)i*7919)%1000;
+		aBiome.data[i] = (i/WORLD_SIZE/64)%5;
+	}
+	for (int i=0;i<N_PEOPLE;++i)
+	{
+		Person* person = new Person;
+		person->name="Person "+DataTools::toString(i);
+		vPerson.push(person);
+	}
+
+	// A normal save blocks the game until it's written.
+	Timer timer;
+	timer.init();
+	timer.start();
+	{
+		SaveFileAsync blockingSave;
+		takeSnapshot(blockingSave.beginSnapshot());
+		blockingSave.start(savePath);
+		blockingSave.wait();
+	}
+	timer.update();
+	const double blockingSeconds = timer.fullSeconds;
+
+	SaveFileAsync autosave;
+	int nProgressCalls = 0;
+	bool finished = false;
+	bool succeeded = false;
+	double lastProgress = 0;
+	bool progressIncreases = true;
+	auto callback = [&](double progress, bool _finished, bool _succeeded)
+	{
+		if ( _finished )
+		{
+			finished=true;
+			succeeded=_succeeded;
+			return;
+		}
+		++nProgressCalls;
+		if ( progress < lastProgress || progress > 1 ) { progressIncreases=false; }
+		lastProgress=progress;
+	};
+
+	// The first background save allocates the snapshot, so time the second one.
+	takeSnapshot(autosave.beginSnapshot());
+	autosave.start(savePath,callback);
+	check("First background save", autosave.wait() && finished && succeeded);
+	finished=false;
+
+	timer.init();
+	timer.start();
+	SaveFileSnapshot* snapshot = autosave.beginSnapshot();
+	takeSnapshot(snapshot);
+	check("Start background save", autosave.start(savePath,callback));
+	timer.update();
+	const double snapshotSeconds = timer.fullSeconds;
+
+	check("Can't snapshot during a save", autosave.isBusy() && autosave.beginSnapshot()==0
+		&& autosave.start(savePath,callback)==false);
+
+	// The game keeps changing the world while the save is written.
+	for (int i=0;i<WORLD_SIZE*WORLD_SIZE;++i)
+	{ aHeight.data[i] = -5; }
+	vPerson(0)->name="Changed";
+
+	int nFrames = 0;
+	while ( finished==false )
+	{
+		autosave.update();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		++nFrames;
+	}
+	check("Background save finished", succeeded && autosave.isBusy()==false);
+	check("Progress reported", progressIncreases);
+
+	SaveFileReader reader;
+	check("Open save", reader.open(savePath));
+	long int seed = 0;
+	std::string name;
+	check("Variables", reader.loadVariable("SEED",seed) && seed==42 && reader.loadVariable("NAME",name) && name=="Async world");
+
+	ArrayS2 <int> aLoadedHeight;
+	bool sameHeight = reader.loadArrayS2("HEIGHT",aLoadedHeight) && aLoadedHeight.nX==WORLD_SIZE && aLoadedHeight.nullValue==-1;
+	for (int i=0;sameHeight && i<WORLD_SIZE*WORLD_SIZE;++i)
+	{ sameHeight = aLoadedHeight.data[i] == ((long int)i*7919)%1000; }
+	check("Save has the world from when the snapshot was taken", sameHeight);
+
+	ArrayS2 <unsigned char> aLoadedBiome;
+	bool sameBiome = reader.loadArrayS2("BIOME",aLoadedBiome);
+	for (int i=0;sameBiome && i<WORLD_SIZE*WORLD_SIZE;++i)
+	{ sameBiome = aLoadedBiome.data[i]==aBiome.data[i]; }
+	check("Biomes are compressed", sameBiome && reader.getChunk("BIOME").size < WORLD_SIZE*WORLD_SIZE/100);
+
+	SaveFileChunk chunk = reader.getChunk("PEOPLE");
+	bool samePeople = chunk.readValue<unsigned long long int>()==N_PEOPLE;
+	for (int i=0;samePeople && i<N_PEOPLE;++i)
+	{
+		const unsigned long long int uid = chunk.readValue<unsigned long long int>();
+		const int classID = chunk.readValue<int>();
+		const std::string data = chunk.readString();
+		samePeople = uid==vPerson(i)->getUID() && classID==3 && data == "Person "+DataTools::toString(i);
+	}
+	check("Records", samePeople && chunk.remaining()==0);
+	reader.close();
+
+	// A failed save leaves the old one alone.
+	takeSnapshot(autosave.beginSnapshot());
+	finished=false;
+	std::cout<<"Expect 2 errors:\n";
+	autosave.start("missing_folder/"+savePath,callback);
+	autosave.wait();
+	check("Failed save is reported", finished && succeeded==false);
+	check("Old save is still valid", reader.open(savePath));
+	reader.close();
+
+	std::cout<<"Blocking save: "<<blockingSeconds<<"s. Background save blocked the game thread for "<<snapshotSeconds
+		<<"s and took "<<nFrames<<" frames, with "<<nProgressCalls<<" progress updates.\n";
+
+	vPerson.deleteAll();
+	std::remove(savePath.c_str());
+	std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+	return nFailed==0 ? 0 : 1;
+}
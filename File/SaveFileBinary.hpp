@@ -0,0 +1,615 @@
+#pragma once
+#ifndef WILDCAT_FILE_SAVE_FILE_BINARY_HPP
+#define WILDCAT_FILE_SAVE_FILE_BINARY_HPP
+
+/* Wildcat: SaveFileBinary
+	#include <File/SaveFileBinary.hpp>
+
+	Binary save files made of tagged chunks. SaveFileManager builds the whole save as a string, converts every value
+	to text, and searches the whole string for each tag, which is too slow for worlds with millions of tiles.
+
+	SaveFileWriter streams chunks to the file through a buffer, so the save is never held in memory. Values are
+	written as raw bytes, and ArrayS2/ArrayS3 planes are written as a single block.
+
+	SaveFileReader maps the file into memory and reads the chunk directory at the end of the file, so any chunk can
+	be found without searching. Only the pages of chunks which are read are loaded from disk.
+
+	Values are stored in native byte order, so saves aren't portable between big and little endian machines.
+
+	Layout:
+		"WSAV", u32 version
+		Chunks: u32 tag size, tag, u64 data size, data
+		Directory: u32 number of chunks, then for each chunk: u32 tag size, tag, u64 data offset, u64 data size
+		u64 directory offset, "WEND"
+
+	If two chunks have the same tag, the last one is used.
+
+	Arrays can be run-length compressed by passing true to addArrayS2()/addArrayS3(). This helps layers with large
+	areas of the same value. Compressed arrays are loaded the same way.
+
+	Usage:
+
+	SaveFileWriter writer;
+	writer.open("world.sav");
+	writer.addVariable("SEED",seed);
+	writer.addArrayS2("HEIGHT",aHeight);
+	writer.beginChunk("PEOPLE");
+	writer.writeValue(vPerson.size());
+	...
+	writer.close();
+
+	SaveFileReader reader;
+	reader.open("world.sav");
+	reader.loadVariable("SEED",seed);
+	reader.loadArrayS2("HEIGHT",aHeight);
+	SaveFileChunk chunk = reader.getChunk("PEOPLE");
+	int nPeople = chunk.readValue<int>();
+*/
+
+#include <File/FileMapping.hpp>
+
+#include <Container/ArrayS2/ArrayS2.hpp>
+#include <Container/ArrayS3/ArrayS3.hpp>
+
+#include <cstdio> // rename
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+class SaveFileBinary
+{
+	public:
+	static const unsigned int VERSION = 1;
+	static const unsigned int BUFFER_SIZE = 1<<16;
+	static const unsigned int COMPRESSED = 0x80000000; // flag on an array's element size
+
+	// FNV-1a, for detecting damaged data.
+	static unsigned long long int checksum(const char* _data, const unsigned long long int _size)
+	{
+		unsigned long long int hash = 14695981039346656037ULL;
+		for (unsigned long long int i=0;i<_size;++i)
+		{
+			hash ^= (unsigned char)_data[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	// Replace one file with another in a single step, so the destination is never missing or partly written.
+	static bool replaceFile(const std::string _from, const std::string _to)
+	{
+#ifdef WILDCAT_WINDOWS
+		return MoveFileExA(_from.c_str(), _to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+		return std::rename(_from.c_str(), _to.c_str()) == 0;
+#endif
+	}
+
+	// Run-length encode _n elements as pairs of u32 run length and element. Gives up and returns false once the
+	// output is as big as the raw data, because it isn't worth compressing.
+	static bool compressRuns(const char* _data, const unsigned long long int _n, const unsigned int _elementSize,
+		std::vector <char>& _out)
+	{
+		_out.clear();
+		const unsigned long long int rawSize = _n*_elementSize;
+		unsigned long long int i=0;
+		while ( i<_n )
+		{
+			const char* element = _data+i*_elementSize;
+			unsigned int run=1;
+			while ( i+run<_n && run<0xFFFFFFFF && std::memcmp(element,element+run*_elementSize,_elementSize)==0 )
+			{ ++run; }
+			if ( _out.size()+4+_elementSize >= rawSize )
+			{ return false; }
+			_out.insert(_out.end(),(const char*)&run,(const char*)&run+4);
+			_out.insert(_out.end(),element,element+_elementSize);
+			i+=run;
+		}
+		return true;
+	}
+
+	// Decode exactly _n elements from compressRuns(). Returns false if the data doesn't match.
+	static bool decompressRuns(const char* _in, const unsigned long long int _inSize, const unsigned int _elementSize,
+		char* _out, const unsigned long long int _n)
+	{
+		unsigned long long int i=0;
+		unsigned long long int position=0;
+		while ( position+4+_elementSize <= _inSize )
+		{
+			unsigned int run;
+			std::memcpy(&run,_in+position,4);
+			const char* element = _in+position+4;
+			position+=4+_elementSize;
+			if ( run > _n-i )
+			{ return false; }
+			if ( _elementSize==1 )
+			{ std::memset(_out+i,*element,run); }
+			else
+			{
+				for (unsigned int j=0;j<run;++j)
+				{ std::memcpy(_out+(i+j)*_elementSize,element,_elementSize); }
+			}
+			i+=run;
+		}
+		return i==_n && position==_inSize;
+	}
+};
+
+class SaveFileWriter
+{
+	private:
+
+	class DirectoryEntry
+	{
+		public:
+		std::string tag;
+		unsigned long long int offset;
+		unsigned long long int size;
+	};
+
+	std::ofstream file;
+	std::vector <char> vBuffer;
+	unsigned long long int bufferStart; // file position of vBuffer[0]
+	bool failed;
+
+	std::vector <DirectoryEntry> vDirectory;
+	std::vector <char> vCompressed; // reused between compressed arrays
+	bool inChunk;
+	unsigned long long int chunkSizePosition; // where to write the size of the current chunk
+
+	void flush()
+	{
+		if ( vBuffer.size()>0 )
+		{
+			file.write(vBuffer.data(),vBuffer.size());
+			bufferStart+=vBuffer.size();
+			vBuffer.clear();
+		}
+		if ( file.good()==false )
+		{ failed=true; }
+	}
+
+	// Overwrite bytes which have already been written.
+	void patch(const unsigned long long int _position, const void* _data, const unsigned int _size)
+	{
+		if ( _position >= bufferStart )
+		{
+			std::memcpy(&vBuffer[_position-bufferStart],_data,_size);
+			return;
+		}
+		flush();
+		file.seekp(_position);
+		file.write((const char*)_data,_size);
+		file.seekp(0,std::ios::end);
+	}
+
+	public:
+
+	SaveFileWriter()
+	{
+		bufferStart=0;
+		failed=false;
+		inChunk=false;
+		chunkSizePosition=0;
+	}
+	~SaveFileWriter()
+	{
+		close();
+	}
+
+	// Create the file, replacing it if it exists.
+	bool open(const std::string _path)
+	{
+		close();
+		file.open(_path.c_str(), std::ios::binary | std::ios::trunc);
+		if ( file.is_open()==false )
+		{
+			std::cout<<"ERROR: Unable to write save file "<<_path<<".\n";
+			return false;
+		}
+		failed=false;
+		bufferStart=0;
+		vBuffer.clear();
+		vBuffer.reserve(SaveFileBinary::BUFFER_SIZE);
+		vDirectory.clear();
+		inChunk=false;
+
+		write("WSAV",4);
+		writeValue((unsigned int)SaveFileBinary::VERSION);
+		return true;
+	}
+
+	inline bool isOpen()
+	{ return file.is_open(); }
+
+	// Current size of the file, including anything still buffered.
+	inline unsigned long long int position() const
+	{ return bufferStart+vBuffer.size(); }
+
+	void write(const void* _data, const unsigned long long int _size)
+	{
+		if ( vBuffer.size()+_size > SaveFileBinary::BUFFER_SIZE )
+		{
+			flush();
+			if ( _size > SaveFileBinary::BUFFER_SIZE )
+			{
+				// large blocks go straight to the file
+				file.write((const char*)_data,_size);
+				bufferStart+=_size;
+				return;
+			}
+		}
+		vBuffer.insert(vBuffer.end(),(const char*)_data,(const char*)_data+_size);
+	}
+
+	template <class T>
+	inline void writeValue(const T& _value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "SaveFileWriter can only write plain values.");
+		write(&_value,sizeof(T));
+	}
+
+	// Overwrite a value which was written earlier, for example a count which wasn't known yet.
+	template <class T>
+	void overwriteValue(const unsigned long long int _position, const T& _value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "SaveFileWriter can only write plain values.");
+		patch(_position,&_value,sizeof(T));
+	}
+
+	void writeString(const std::string& _str)
+	{
+		writeValue((unsigned int)_str.size());
+		write(_str.data(),_str.size());
+	}
+
+	template <class T>
+	void writeArray(const T* _data, const unsigned long long int _n)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "SaveFileWriter can only write plain values.");
+		write(_data,_n*sizeof(T));
+	}
+
+	// Start a new chunk. Anything written until endChunk() or the next beginChunk() goes in it.
+	void beginChunk(const std::string& _tag)
+	{
+		endChunk();
+		writeString(_tag);
+		chunkSizePosition=position();
+		writeValue((unsigned long long int)0); // filled in by endChunk()
+
+		DirectoryEntry entry;
+		entry.tag=_tag;
+		entry.offset=position();
+		entry.size=0;
+		vDirectory.push_back(entry);
+		inChunk=true;
+	}
+
+	void endChunk()
+	{
+		if ( inChunk==false )
+		{ return; }
+		DirectoryEntry& entry = vDirectory.back();
+		entry.size = position()-entry.offset;
+		patch(chunkSizePosition,&entry.size,sizeof(entry.size));
+		inChunk=false;
+	}
+
+	template <class T>
+	void addVariable(const std::string& _tag, const T& _value)
+	{
+		beginChunk(_tag);
+		writeValue(_value);
+		endChunk();
+	}
+	void addVariable(const std::string& _tag, const std::string& _value)
+	{
+		beginChunk(_tag);
+		write(_value.data(),_value.size());
+		endChunk();
+	}
+
+	// Chunk contents: u32 element size, u32 for each dimension, null value, data. If _compress is set and the data
+	// has enough runs, it is written with compressRuns() and the element size has the COMPRESSED flag.
+	void addArrayData(const std::string& _tag, const unsigned int _elementSize, const unsigned int* _dimension,
+		const unsigned int _nDimensions, const void* _nullValue, const void* _data, const bool _compress=false)
+	{
+		unsigned long long int n=1;
+		for (unsigned int i=0;i<_nDimensions;++i)
+		{ n*=_dimension[i]; }
+		const bool compressed = _compress && SaveFileBinary::compressRuns((const char*)_data,n,_elementSize,vCompressed);
+
+		beginChunk(_tag);
+		writeValue((unsigned int)(compressed ? _elementSize | SaveFileBinary::COMPRESSED : _elementSize));
+		writeArray(_dimension,_nDimensions);
+		write(_nullValue,_elementSize);
+		if ( compressed )
+		{ write(vCompressed.data(),vCompressed.size()); }
+		else
+		{ write(_data,n*_elementSize); }
+		endChunk();
+	}
+
+	template <class T>
+	void addArrayS2(const std::string& _tag, ArrayS2 <T>& _array, const bool _compress=false)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "SaveFileWriter can only write arrays of plain values.");
+		const unsigned int dimension[2] = { (unsigned int)_array.nX, (unsigned int)_array.nY };
+		addArrayData(_tag,sizeof(T),dimension,2,&_array.nullValue,_array.data,_compress);
+	}
+
+	template <class T>
+	void addArrayS3(const std::string& _tag, ArrayS3 <T>& _array, const bool _compress=false)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "SaveFileWriter can only write arrays of plain values.");
+		const unsigned int dimension[3] = { (unsigned int)_array.nX, (unsigned int)_array.nY, (unsigned int)_array.nZ };
+		addArrayData(_tag,sizeof(T),dimension,3,&_array.nullValue,_array.data,_compress);
+	}
+
+	// Write the directory and close the file. Returns false if anything failed to write.
+	bool close()
+	{
+		if ( file.is_open()==false )
+		{ return false; }
+		endChunk();
+
+		const unsigned long long int directoryOffset = position();
+		writeValue((unsigned int)vDirectory.size());
+		for (unsigned int i=0;i<vDirectory.size();++i)
+		{
+			writeString(vDirectory[i].tag);
+			writeValue(vDirectory[i].offset);
+			writeValue(vDirectory[i].size);
+		}
+		writeValue(directoryOffset);
+		write("WEND",4);
+		flush();
+		file.close();
+		vDirectory.clear();
+		return failed==false;
+	}
+};
+
+// Reads values from a chunk in the order they were written. Reading past the end gives 0 values and sets failed.
+class SaveFileChunk
+{
+	public:
+
+	const char* data;
+	unsigned long long int size;
+	unsigned long long int position;
+	bool failed;
+
+	SaveFileChunk(const char* _data=0, const unsigned long long int _size=0)
+	{
+		data=_data;
+		size=_size;
+		position=0;
+		failed=false;
+	}
+
+	inline bool exists() const
+	{ return data!=0; }
+
+	inline unsigned long long int remaining() const
+	{ return size-position; }
+
+	bool read(void* _out, const unsigned long long int _size)
+	{
+		if ( _size > remaining() )
+		{
+			failed=true;
+			std::memset(_out,0,_size);
+			return false;
+		}
+		std::memcpy(_out,data+position,_size);
+		position+=_size;
+		return true;
+	}
+
+	template <class T>
+	T readValue()
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "SaveFileChunk can only read plain values.");
+		T value;
+		read(&value,sizeof(T));
+		return value;
+	}
+
+	std::string readString()
+	{
+		const unsigned int length = readValue<unsigned int>();
+		if ( length > remaining() )
+		{
+			failed=true;
+			return "";
+		}
+		std::string str (data+position,length);
+		position+=length;
+		return str;
+	}
+};
+
+class SaveFileReader
+{
+	private:
+
+	class DirectoryEntry
+	{
+		public:
+		unsigned long long int offset;
+		unsigned long long int size;
+	};
+
+	FileMapping mapping;
+	std::unordered_map <std::string, DirectoryEntry> mDirectory;
+
+	public:
+
+	~SaveFileReader()
+	{
+		close();
+	}
+
+	// Map the file and read its chunk directory. Returns false if it isn't a valid save file.
+	bool open(const std::string _path)
+	{
+		close();
+		if ( mapping.open(_path)==false )
+		{
+			std::cout<<"ERROR: Unable to open save file "<<_path<<".\n";
+			return false;
+		}
+
+		SaveFileChunk file (mapping.data,mapping.size);
+		char magic [4];
+		file.read(magic,4);
+		if ( std::memcmp(magic,"WSAV",4)!=0 || file.readValue<unsigned int>()!=SaveFileBinary::VERSION || mapping.size<16 )
+		{
+			std::cout<<"ERROR: "<<_path<<" is not a valid save file.\n";
+			close();
+			return false;
+		}
+
+		file.position = mapping.size-12;
+		const unsigned long long int directoryOffset = file.readValue<unsigned long long int>();
+		file.read(magic,4);
+		if ( std::memcmp(magic,"WEND",4)!=0 || directoryOffset > mapping.size-12 )
+		{
+			std::cout<<"ERROR: Save file "<<_path<<" is incomplete.\n";
+			close();
+			return false;
+		}
+
+		file.position = directoryOffset;
+		const unsigned int nChunks = file.readValue<unsigned int>();
+		for (unsigned int i=0;i<nChunks && file.failed==false;++i)
+		{
+			const std::string tag = file.readString();
+			DirectoryEntry entry;
+			entry.offset = file.readValue<unsigned long long int>();
+			entry.size = file.readValue<unsigned long long int>();
+			if ( entry.offset > directoryOffset || entry.size > directoryOffset-entry.offset )
+			{ file.failed=true; }
+			mDirectory[tag]=entry; // the last chunk with a tag is used
+		}
+		if ( file.failed )
+		{
+			std::cout<<"ERROR: Save file "<<_path<<" has a damaged directory.\n";
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void close()
+	{
+		mapping.close();
+		mDirectory.clear();
+	}
+
+	inline unsigned int nChunks() const
+	{ return mDirectory.size(); }
+
+	inline bool hasChunk(const std::string& _tag) const
+	{ return mDirectory.find(_tag)!=mDirectory.end(); }
+
+	// Return the chunk's data. The chunk reads straight from the mapped file, so it's only valid while the reader is open.
+	SaveFileChunk getChunk(const std::string& _tag) const
+	{
+		std::unordered_map <std::string, DirectoryEntry>::const_iterator it = mDirectory.find(_tag);
+		if ( it==mDirectory.end() )
+		{ return SaveFileChunk(); }
+		return SaveFileChunk(mapping.data+it->second.offset,it->second.size);
+	}
+
+	template <class T>
+	bool loadVariable(const std::string& _tag, T& _value)
+	{
+		SaveFileChunk chunk = getChunk(_tag);
+		if ( chunk.exists()==false || chunk.size!=sizeof(T) )
+		{
+			std::cout<<"ERROR: DIDN'T FIND TAG: "<<_tag<<".\n";
+			return false;
+		}
+		return chunk.read(&_value,sizeof(T));
+	}
+	bool loadVariable(const std::string& _tag, std::string& _value)
+	{
+		SaveFileChunk chunk = getChunk(_tag);
+		if ( chunk.exists()==false )
+		{
+			std::cout<<"ERROR: DIDN'T FIND TAG: "<<_tag<<".\n";
+			return false;
+		}
+		_value.assign(chunk.data,chunk.size);
+		return true;
+	}
+
+	template <class T>
+	bool loadArrayS2(const std::string& _tag, ArrayS2 <T>& _array)
+	{
+		SaveFileChunk chunk = getChunk(_tag);
+		const unsigned int elementSize = chunk.readValue<unsigned int>();
+		const unsigned int nX = chunk.readValue<unsigned int>();
+		const unsigned int nY = chunk.readValue<unsigned int>();
+		const T nullValue = chunk.readValue<T>();
+		if ( checkArray(chunk,elementSize,sizeof(T),(unsigned long long int)nX*nY)==false )
+		{
+			std::cout<<"ERROR: Unable to load array "<<_tag<<".\n";
+			return false;
+		}
+		_array.init(nX,nY,nullValue);
+		return readArray(chunk,elementSize,(char*)_array.data,(unsigned long long int)nX*nY,_tag);
+	}
+
+	template <class T>
+	bool loadArrayS3(const std::string& _tag, ArrayS3 <T>& _array)
+	{
+		SaveFileChunk chunk = getChunk(_tag);
+		const unsigned int elementSize = chunk.readValue<unsigned int>();
+		const unsigned int nX = chunk.readValue<unsigned int>();
+		const unsigned int nY = chunk.readValue<unsigned int>();
+		const unsigned int nZ = chunk.readValue<unsigned int>();
+		const T nullValue = chunk.readValue<T>();
+		if ( checkArray(chunk,elementSize,sizeof(T),(unsigned long long int)nX*nY*nZ)==false )
+		{
+			std::cout<<"ERROR: Unable to load array "<<_tag<<".\n";
+			return false;
+		}
+		_array.init(nX,nY,nZ,nullValue);
+		return readArray(chunk,elementSize,(char*)_array.data,(unsigned long long int)nX*nY*nZ,_tag);
+	}
+
+	private:
+
+	// Compressed arrays can only be checked while decoding them.
+	static bool checkArray(const SaveFileChunk& _chunk, const unsigned int _elementSize, const unsigned int _size,
+		const unsigned long long int _n)
+	{
+		if ( _chunk.failed || (_elementSize & ~SaveFileBinary::COMPRESSED) != _size )
+		{ return false; }
+		return (_elementSize & SaveFileBinary::COMPRESSED) || _chunk.remaining() == _n*_size;
+	}
+
+	static bool readArray(SaveFileChunk& _chunk, const unsigned int _elementSize, char* _out, const unsigned long long int _n,
+		const std::string& _tag)
+	{
+		if ( (_elementSize & SaveFileBinary::COMPRESSED)==0 )
+		{ return _chunk.read(_out,_chunk.remaining()); }
+		if ( SaveFileBinary::decompressRuns(_chunk.data+_chunk.position,_chunk.remaining(),
+			_elementSize & ~SaveFileBinary::COMPRESSED,_out,_n)==false )
+		{
+			std::cout<<"ERROR: Array "<<_tag<<" has damaged data.\n";
+			return false;
+		}
+		return true;
+	}
+};
+
+#endif
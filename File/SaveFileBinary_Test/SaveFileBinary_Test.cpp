@@ -0,0 +1,154 @@
+#include <climits> /* Colour.hpp needs UINT_MAX. */
+#include <iostream>
+#include <string>
+#include <cstdio>
+
+#include <Container/Vector/Vector.hpp>
+#include <File/SaveFileBinary.hpp>
+#include <File/SaveFileManager.hpp>
+#include <File/FileManagerStatic.hpp>
+#include <System/Time/Timer.hpp>
+
+// g++ SaveFileBinary_Test.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX
+
+// Test of binary save files. Saves variables, custom chunks and arrays, loads them back, and checks that bad files
+// aren't loaded. Then times saving and loading a world of tiles against SaveFileManager.
+
+const std::string savePath = "SaveFileBinary_Test.sav";
+const std::string textSavePath = "SaveFileBinary_Test.txt";
+const int WORLD_SIZE = 1024;
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+int main (int nArgs, char ** arg)
+{
+	ArrayS2 <int> aHeight (WORLD_SIZE,WORLD_SIZE,-1);
+	for (int i=0;i<WORLD_SIZE*WORLD_SIZE;++i)
+	{ aHeight.data[i] = ((long int)i*7919)%1000; }
+	ArrayS3 <unsigned char> aColour (64,32,3,0);
+	for (unsigned int i=0;i<64*32*3;++i)
+	{ aColour.data[i] = i%251; }
+	ArrayS2 <short int> aBiome (WORLD_SIZE,WORLD_SIZE,0);
+	for (int i=0;i<WORLD_SIZE*WORLD_SIZE;++i)
+	{ aBiome.data[i] = i/1000; }
+
+	Timer timer;
+	timer.init();
+	timer.start();
+	SaveFileWriter writer;
+	check("Open writer", writer.open(savePath));
+	writer.addVariable("SEED",(long int)123456789);
+	writer.addVariable("NAME",std::string("Test world"));
+	writer.addVariable("SCALE",2.5);
+	writer.beginChunk("PEOPLE");
+	writer.writeValue(3);
+	writer.writeString("Ryan");
+	writer.writeString("Garo");
+	writer.writeString("");
+	writer.endChunk();
+	writer.addArrayS2("HEIGHT",aHeight);
+	writer.addArrayS3("COLOUR",aColour);
+	writer.addArrayS2("BIOME",aBiome,true);
+	writer.addArrayS3("COLOUR_NOT_COMPRESSIBLE",aColour,true);
+	writer.addVariable("SEED",(long int)42); // replaces the first one
+	check("Close writer", writer.close());
+	timer.update();
+	const double binarySaveSeconds = timer.fullSeconds;
+
+	timer.init();
+	timer.start();
+	SaveFileReader reader;
+	check("Open reader", reader.open(savePath));
+	ArrayS2 <int> aLoadedHeight;
+	const bool loadedHeight = reader.loadArrayS2("HEIGHT",aLoadedHeight);
+	timer.update();
+	const double binaryLoadSeconds = timer.fullSeconds;
+
+	long int seed = 0;
+	std::string name = "";
+	double scale = 0;
+	check("Variables", reader.loadVariable("SEED",seed) && seed==42 && reader.loadVariable("NAME",name) && name=="Test world"
+		&& reader.loadVariable("SCALE",scale) && scale==2.5);
+	check("Number of chunks", reader.nChunks()==8);
+
+	SaveFileChunk chunk = reader.getChunk("PEOPLE");
+	const int nPeople = chunk.readValue<int>();
+	const std::string person1 = chunk.readString();
+	const std::string person2 = chunk.readString();
+	const std::string person3 = chunk.readString();
+	check("Custom chunk", nPeople==3 && person1=="Ryan" && person2=="Garo" && person3=="" && chunk.remaining()==0 && chunk.failed==false);
+	chunk.readValue<int>();
+	check("Reading past the end of a chunk fails", chunk.failed);
+
+	bool sameHeight = loadedHeight && aLoadedHeight.nX==WORLD_SIZE && aLoadedHeight.nY==WORLD_SIZE && aLoadedHeight.nullValue==-1;
+	for (int i=0;sameHeight && i<WORLD_SIZE*WORLD_SIZE;++i)
+	{ sameHeight = aLoadedHeight.data[i]==aHeight.data[i]; }
+	check("ArrayS2", sameHeight);
+
+	ArrayS3 <unsigned char> aLoadedColour;
+	bool sameColour = reader.loadArrayS3("COLOUR",aLoadedColour) && aLoadedColour.nX==64 && aLoadedColour.nY==32 && aLoadedColour.nZ==3;
+	for (unsigned int i=0;sameColour && i<64*32*3;++i)
+	{ sameColour = aLoadedColour.data[i]==aColour.data[i]; }
+	check("ArrayS3", sameColour);
+
+	ArrayS2 <short int> aLoadedBiome;
+	bool sameBiome = reader.loadArrayS2("BIOME",aLoadedBiome) && aLoadedBiome.nX==WORLD_SIZE && aLoadedBiome.nY==WORLD_SIZE;
+	for (int i=0;sameBiome && i<WORLD_SIZE*WORLD_SIZE;++i)
+	{ sameBiome = aLoadedBiome.data[i]==aBiome.data[i]; }
+	const unsigned long long int biomeSize = reader.getChunk("BIOME").size;
+	check("Compressed ArrayS2", sameBiome && biomeSize < (unsigned long long int)WORLD_SIZE*WORLD_SIZE*sizeof(short int)/100);
+
+	bool sameColour2 = reader.loadArrayS3("COLOUR_NOT_COMPRESSIBLE",aLoadedColour);
+	for (unsigned int i=0;sameColour2 && i<64*32*3;++i)
+	{ sameColour2 = aLoadedColour.data[i]==aColour.data[i]; }
+	check("Array which doesn't compress is stored raw", sameColour2
+		&& reader.getChunk("COLOUR_NOT_COMPRESSIBLE").size==reader.getChunk("COLOUR").size);
+
+	std::cout<<"Expect 2 errors:\n";
+	ArrayS2 <short int> aWrongType;
+	check("Array with the wrong type isn't loaded", reader.loadArrayS2("HEIGHT",aWrongType)==false);
+	check("Missing tag", reader.hasChunk("MISSING")==false && reader.loadVariable("MISSING",seed)==false);
+	reader.close();
+
+	// A save which was cut off has no directory.
+	std::string saveData = FileManagerStatic::getFile(savePath);
+	FileManagerStatic::writeFreshString(saveData.substr(0,saveData.size()/2),savePath);
+	std::cout<<"Expect 1 error:\n";
+	check("Incomplete save isn't loaded", reader.open(savePath)==false);
+
+	// The same tiles through SaveFileManager.
+	timer.init();
+	timer.start();
+	SaveFileManager textSave;
+	SaveChunk textChunk ("HEIGHT");
+	for (int i=0;i<WORLD_SIZE*WORLD_SIZE;++i)
+	{ textChunk.add(DataTools::toString(aHeight.data[i])); }
+	textSave.addChunk(textChunk);
+	textSave.saveToFile(textSavePath);
+	timer.update();
+	const double textSaveSeconds = timer.fullSeconds;
+
+	timer.init();
+	timer.start();
+	SaveFileManager textLoad;
+	textLoad.loadFile(textSavePath);
+	SaveChunk* loadedChunk = textLoad.getChunk("HEIGHT");
+	timer.update();
+	const double textLoadSeconds = timer.fullSeconds;
+	check("SaveFileManager loaded the same number of tiles", loadedChunk->vData.size()==WORLD_SIZE*WORLD_SIZE);
+	delete loadedChunk;
+
+	std::cout<<WORLD_SIZE*WORLD_SIZE<<" tiles. SaveFileManager save: "<<textSaveSeconds<<"s, load: "<<textLoadSeconds
+		<<"s. Binary save: "<<binarySaveSeconds<<"s, load: "<<binaryLoadSeconds<<"s.\n";
+
+	std::remove(savePath.c_str());
+	std::remove(textSavePath.c_str());
+	std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+	return nFailed==0 ? 0 : 1;
+}
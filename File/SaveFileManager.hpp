@@ -4,6 +4,8 @@
 #include <Data/DataTools.hpp>
 #include <File/FileManager.hpp>
 
+#include <vector>
+
 /* Wildcat:SaveFileManager
 #include <File/SaveFileManager.hpp> **/
 
@@ -11,6 +13,8 @@
 Class to help turning game state into a file, and loading it back into a game. Uses FileManager for most File IO.
 
 Works by loading the save file as a string, then performing operations to extract useful information from the string.
+This is fine for small saves, but large saves such as worlds with millions of tiles should use the binary chunk format
+in File/SaveFileBinary.hpp, which streams to the file and doesn't need to search for tags.
 
 Specification: Anything outside of square brackets is ignored. Data must be enclosed in square brackets.
 The format is:
@@ -69,15 +73,41 @@ UID <long long unsigned int> SaveFileInterface_UID;
 
 class SaveFileInterface
 {
+	friend class SaveJournal;
+
 	private:
 	// uid is used to store pointers between objects.
 	long long unsigned int uid;
 
+	// true if the object has changed since it was last saved. See SaveJournal.
+	bool saveDirty;
+	// The dirty list of the SaveJournal tracking this object, or 0. markDirty() adds the object to it, so saves
+	// don't need to check every object.
+	std::vector <SaveFileInterface*> * vSaveDirty;
+
+	inline void clearDirty()
+	{ saveDirty=false; }
+
 	public:
 
 	SaveFileInterface()
 	{
 		uid = SaveFileInterface_UID.get();
+		saveDirty=true;
+		vSaveDirty=0;
+	}
+	// Copies aren't tracked by the original's journal.
+	SaveFileInterface(const SaveFileInterface& _other)
+	{
+		uid=_other.uid;
+		saveDirty=_other.saveDirty;
+		vSaveDirty=0;
+	}
+	SaveFileInterface& operator = (const SaveFileInterface& _other)
+	{
+		uid=_other.uid;
+		if ( _other.saveDirty ) { markDirty(); }
+		return *this;
 	}
 	~SaveFileInterface() {}
 
@@ -86,6 +116,24 @@ class SaveFileInterface
 		return uid;
 	}
 
+	// Restore the UID of a loaded object. New objects won't be given this UID.
+	void setUID(const long long unsigned int _uid)
+	{
+		uid=_uid;
+		if ( SaveFileInterface_UID.uid <= _uid )
+		{ SaveFileInterface_UID.uid = _uid+1; }
+	}
+
+	// Objects should call markDirty() whenever their save data changes, so incremental saves include them.
+	inline void markDirty()
+	{
+		if ( saveDirty ) { return; }
+		saveDirty=true;
+		if ( vSaveDirty!=0 ) { vSaveDirty->push_back(this); }
+	}
+	inline bool isDirty() const
+	{ return saveDirty; }
+
 
 	virtual std::string getSaveFileName()
 	{
@@ -102,6 +150,12 @@ class SaveFileInterface
 		return "";
 	}
 
+	// Restore the object from the data returned by getSaveData().
+	virtual bool loadSaveData(const std::string& /* _data */)
+	{
+		return false;
+	}
+
 	virtual void save()
 	{
 	}
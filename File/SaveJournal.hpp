@@ -0,0 +1,479 @@
+#pragma once
+#ifndef WILDCAT_FILE_SAVE_JOURNAL_HPP
+#define WILDCAT_FILE_SAVE_JOURNAL_HPP
+
+/* Wildcat: SaveJournal
+	#include <File/SaveJournal.hpp>
+
+	Incremental saves of SaveFileInterface objects, keyed by their UID. Rewriting the whole world on every autosave
+	stalls the game, so instead only objects which have called markDirty() are written, and they are appended to a
+	journal next to the save file. markDirty() adds the object to the journal's dirty list, so a save only looks at
+	the objects which changed, however many are tracked.
+
+	The save is made of 2 files:
+		path: the base snapshot. A SaveFileBinary file with every record in a RECORDS chunk, and a GENERATION chunk
+			which counts the snapshots.
+		path.journal: the generation of the snapshot it applies to, then records which changed since the snapshot,
+			and UIDs which were removed. Later entries replace earlier ones. Each entry has a checksum, so if the game
+			stops partway through writing one, it and anything after it are ignored, and the journal is compacted
+			before anything else is appended.
+
+	When the journal grows past maxJournalRatio of the base snapshot, compact() folds it into a new snapshot. The new
+	snapshot is written to a temporary file and then renamed over the old one, so a crash never leaves a broken save.
+	The new snapshot has the next generation, so if the game stops after the rename but before the journal is deleted,
+	the old journal no longer matches and is ignored.
+
+	Usage:
+
+	SaveJournal journal ("world.sav");
+	journal.track(&person); // every saveable object
+	person.markDirty(); // whenever it changes
+	journal.save(); // autosave, writes only changed objects
+	journal.untrack(&person); // before deleting it
+
+	Loading:
+
+	journal.load();
+	for (auto& record: journal.mRecord)
+	{
+		SaveFileInterface* object = makeObject(record.second.classID);
+		object->setUID(record.first);
+		object->loadSaveData(record.second.data);
+		journal.track(object,true);
+	}
+	journal.clearRecords();
+
+	Tracked objects must be untracked before they are deleted. They mustn't call markDirty() after their journal is
+	destroyed unless they have been untracked.
+*/
+
+#include <File/SaveFileManager.hpp> // SaveFileInterface
+#include <File/SaveFileBinary.hpp>
+#include <File/FileMapping.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class SaveJournal_Record
+{
+	public:
+	int classID;
+	std::string data;
+};
+
+class SaveJournal
+{
+	private:
+
+	enum { ENTRY_RECORD=0, ENTRY_REMOVE=1 };
+
+	std::string basePath;
+	std::string journalPath;
+
+	std::unordered_map <unsigned long long int, SaveFileInterface*> mTracked;
+	std::vector <unsigned long long int> vRemoved; // untracked since the last save
+	std::vector <SaveFileInterface*> vDirty; // tracked objects which called markDirty() since the last save
+
+	unsigned long long int baseSize;
+	unsigned long long int journalSize;
+	unsigned long long int generation; // of the base snapshot
+	bool journalChecked; // the journal on disk is known to be valid, so it can be appended to
+
+	static void appendEntry(std::string& _out, const unsigned char _type, const unsigned long long int _uid, const int _classID,
+		const std::string& _data)
+	{
+		const unsigned long int start = _out.size();
+		const unsigned int size = _data.size();
+		_out.append((const char*)&_type,1);
+		_out.append((const char*)&_uid,8);
+		_out.append((const char*)&_classID,4);
+		_out.append((const char*)&size,4);
+		_out.append(_data);
+		const unsigned long long int checksum = SaveFileBinary::checksum(_out.data()+start,_out.size()-start);
+		_out.append((const char*)&checksum,8);
+	}
+
+	static void writeRecord(SaveFileWriter& writer, const unsigned long long int _uid, const int _classID, const std::string& _data)
+	{
+		writer.writeValue(_uid);
+		writer.writeValue(_classID);
+		writer.writeString(_data);
+	}
+
+	// Take the object off the dirty list, and stop markDirty() adding it.
+	void forgetDirty(SaveFileInterface* _object)
+	{
+		if ( _object->vSaveDirty!=&vDirty ) { return; }
+		if ( _object->isDirty() )
+		{
+			for (unsigned int i=0;i<vDirty.size();++i)
+			{
+				if ( vDirty[i]==_object )
+				{
+					vDirty[i]=vDirty.back();
+					vDirty.pop_back();
+					break;
+				}
+			}
+		}
+		_object->vSaveDirty=0;
+	}
+
+	unsigned long long int readGeneration()
+	{
+		SaveFileReader reader;
+		if ( getFileSize(basePath)==0 || reader.open(basePath)==false )
+		{ return 0; }
+		SaveFileChunk chunk = reader.getChunk("GENERATION");
+		return chunk.readValue<unsigned long long int>();
+	}
+
+	inline std::string tempPath() const
+	{ return basePath+".tmp"; }
+
+	// Write the next snapshot to a temporary file, with a RECORDS chunk filled in by _writeRecords.
+	template <class Function>
+	bool writeTempBase(Function _writeRecords)
+	{
+		SaveFileWriter writer;
+		if ( writer.open(tempPath())==false )
+		{ return false; }
+		const bool recordsWritten = _writeRecords(writer);
+		writer.addVariable("GENERATION",generation+1);
+		if ( writer.close()==false || recordsWritten==false )
+		{
+			std::remove(tempPath().c_str());
+			return false;
+		}
+		return true;
+	}
+
+	// Rename the temporary snapshot over the old one. Nothing may have the old one open, because Windows can't
+	// replace an open file. The journal is deleted afterwards, but until then the new generation means it is ignored.
+	bool replaceBase()
+	{
+		if ( SaveFileBinary::replaceFile(tempPath(),basePath)==false )
+		{ return false; }
+		++generation;
+		std::remove(journalPath.c_str());
+		baseSize=getFileSize(basePath);
+		journalSize=0;
+		journalChecked=true;
+		return true;
+	}
+
+	// Read the base snapshot's records. Returns false if there is no valid snapshot.
+	bool readBase(std::unordered_map <unsigned long long int, SaveJournal_Record>& _mRecord)
+	{
+		SaveFileReader reader;
+		if ( reader.open(basePath)==false )
+		{ return false; }
+		SaveFileChunk chunk = reader.getChunk("RECORDS");
+		const unsigned long long int nRecords = chunk.readValue<unsigned long long int>();
+		_mRecord.reserve(_mRecord.size()+nRecords);
+		for (unsigned long long int i=0;i<nRecords && chunk.failed==false;++i)
+		{
+			const unsigned long long int uid = chunk.readValue<unsigned long long int>();
+			SaveJournal_Record& record = _mRecord[uid];
+			record.classID = chunk.readValue<int>();
+			record.data = chunk.readString();
+		}
+		if ( chunk.failed )
+		{
+			std::cout<<"ERROR: SaveJournal: Damaged snapshot "<<basePath<<".\n";
+			return false;
+		}
+		return true;
+	}
+
+	// Replay the journal onto the records. Entries in _mRemoved are UIDs which were removed.
+	// Returns false if the journal is from an older snapshot, which is ignored, or if it has a damaged entry. Replaying
+	// stops at the damaged entry.
+	bool readJournal(std::unordered_map <unsigned long long int, SaveJournal_Record>& _mRecord,
+		std::unordered_map <unsigned long long int, bool>* _mRemoved)
+	{
+		FileMapping mapping;
+		if ( mapping.open(journalPath)==false || mapping.size==0 )
+		{ return true; }
+
+		SaveFileChunk journal (mapping.data,mapping.size);
+		if ( journal.readValue<unsigned long long int>()!=generation || journal.failed )
+		{
+			std::cout<<"WARNING: SaveJournal: "<<journalPath<<" is from an older snapshot. Ignoring it.\n";
+			return false;
+		}
+		while ( journal.remaining()>0 )
+		{
+			const unsigned long long int start = journal.position;
+			const unsigned char type = journal.readValue<unsigned char>();
+			const unsigned long long int uid = journal.readValue<unsigned long long int>();
+			const int classID = journal.readValue<int>();
+			const std::string data = journal.readString();
+			const unsigned long long int end = journal.position;
+			const unsigned long long int checksum = journal.readValue<unsigned long long int>();
+			if ( journal.failed || type>ENTRY_REMOVE || checksum!=SaveFileBinary::checksum(mapping.data+start,end-start) )
+			{
+				std::cout<<"WARNING: SaveJournal: Damaged entry at byte "<<start<<" of "<<journalPath
+					<<". Ignoring it and everything after it.\n";
+				return false;
+			}
+
+			if ( type==ENTRY_REMOVE )
+			{
+				_mRecord.erase(uid);
+				if ( _mRemoved!=0 )
+				{ (*_mRemoved)[uid]=true; }
+			}
+			else
+			{
+				SaveJournal_Record& record = _mRecord[uid];
+				record.classID=classID;
+				record.data=data;
+				if ( _mRemoved!=0 )
+				{ _mRemoved->erase(uid); }
+			}
+		}
+		return true;
+	}
+
+	static unsigned long long int getFileSize(const std::string _path)
+	{
+		std::ifstream file(_path.c_str(), std::ios::binary | std::ios::ate);
+		if ( file.is_open()==false )
+		{ return 0; }
+		return file.tellg();
+	}
+
+	public:
+
+	// Records read by load(). The game rebuilds its objects from these.
+	std::unordered_map <unsigned long long int, SaveJournal_Record> mRecord;
+
+	// Compact when the journal is bigger than this fraction of the snapshot.
+	double maxJournalRatio;
+
+	// Number of records and bytes written by the last save.
+	unsigned long int nLastSaveRecords;
+	unsigned long long int lastSaveBytes;
+
+	SaveJournal(const std::string _path = "")
+	{
+		generation=0;
+		journalChecked=false;
+		maxJournalRatio=0.5;
+		nLastSaveRecords=0;
+		lastSaveBytes=0;
+		setPath(_path);
+	}
+		// Tracked objects point to the dirty list, so it can't be copied.
+	SaveJournal(const SaveJournal&) = delete;
+	void operator = (const SaveJournal&) = delete;
+
+	void setPath(const std::string _path)
+	{
+		basePath=_path;
+		journalPath=_path+".journal";
+		baseSize=getFileSize(basePath);
+		journalSize=getFileSize(journalPath);
+		generation=readGeneration();
+		journalChecked=false;
+	}
+
+	// Objects which were just loaded or saved can be tracked as clean, otherwise they are saved next time.
+	// An object can only be tracked by one journal.
+	void track(SaveFileInterface* _object, const bool _isSaved=false)
+	{
+		forgetDirty(_object);
+		mTracked[_object->getUID()]=_object;
+		_object->vSaveDirty=&vDirty;
+		_object->clearDirty();
+		if ( _isSaved==false )
+		{ _object->markDirty(); }
+	}
+
+	// Stop tracking the object, and remove it from the save next time.
+	void untrack(SaveFileInterface* _object)
+	{
+		forgetDirty(_object);
+		if ( mTracked.erase(_object->getUID()) > 0 )
+		{ vRemoved.push_back(_object->getUID()); }
+	}
+
+	inline unsigned long int nTracked() const
+	{ return mTracked.size(); }
+
+	inline unsigned long long int getJournalSize() const
+	{ return journalSize; }
+
+	// Write a new snapshot of every tracked object, and delete the journal.
+	bool saveAll()
+	{
+		const bool written = writeTempBase([this](SaveFileWriter& writer)
+		{
+			writer.beginChunk("RECORDS");
+			writer.writeValue((unsigned long long int)mTracked.size());
+			for (std::unordered_map <unsigned long long int, SaveFileInterface*>::iterator it=mTracked.begin();it!=mTracked.end();++it)
+			{ writeRecord(writer,it->first,it->second->getClassID(),it->second->getSaveData()); }
+			writer.endChunk();
+			return true;
+		});
+		if ( written==false || replaceBase()==false )
+		{
+			std::cout<<"ERROR: SaveJournal: Unable to write "<<basePath<<".\n";
+			return false;
+		}
+
+		for (unsigned int i=0;i<vDirty.size();++i)
+		{ vDirty[i]->clearDirty(); }
+		vDirty.clear();
+		vRemoved.clear();
+		nLastSaveRecords=mTracked.size();
+		lastSaveBytes=baseSize;
+		return true;
+	}
+
+	// Append changed and removed objects to the journal. If there's no snapshot yet, everything is saved.
+	bool save()
+	{
+		if ( baseSize==0 )
+		{ return saveAll(); }
+
+		std::string entries = "";
+		nLastSaveRecords=0;
+		for (unsigned int i=0;i<vRemoved.size();++i)
+		{
+			appendEntry(entries,ENTRY_REMOVE,vRemoved[i],0,"");
+			++nLastSaveRecords;
+		}
+		for (unsigned int i=0;i<vDirty.size();++i)
+		{
+			appendEntry(entries,ENTRY_RECORD,vDirty[i]->getUID(),vDirty[i]->getClassID(),vDirty[i]->getSaveData());
+			++nLastSaveRecords;
+		}
+		lastSaveBytes=entries.size();
+		if ( entries.size()==0 )
+		{ return true; }
+
+		// Entries after a damaged one would never be read, so a journal which hasn't been read yet is checked first.
+		if ( journalChecked==false && journalSize>0 )
+		{
+			std::unordered_map <unsigned long long int, SaveJournal_Record> mJournal;
+			if ( readJournal(mJournal,0)==false && compact()==false )
+			{ return false; }
+		}
+		journalChecked=true;
+
+		// A new journal starts with the generation of the snapshot.
+		if ( journalSize==0 )
+		{ entries.insert(0,(const char*)&generation,8); }
+		std::ofstream journal(journalPath.c_str(), std::ios::binary | (journalSize==0 ? std::ios::trunc : std::ios::app));
+		journal.write(entries.data(),entries.size());
+		journal.close();
+		if ( journal.fail() )
+		{
+			std::cout<<"ERROR: SaveJournal: Unable to write "<<journalPath<<".\n";
+			journalChecked=false; // part of an entry may have been written.
+			journalSize=getFileSize(journalPath);
+			return false;
+		}
+
+		for (unsigned int i=0;i<vDirty.size();++i)
+		{ vDirty[i]->clearDirty(); }
+		vDirty.clear();
+		vRemoved.clear();
+		journalSize+=entries.size();
+
+		if ( journalSize > baseSize*maxJournalRatio )
+		{ return compact(); }
+		return true;
+	}
+
+	// Fold the journal into a new snapshot. Only the journal is held in memory, the snapshot is streamed. If the
+	// journal has a damaged entry, the entries before it are kept and the rest are dropped.
+	bool compact()
+	{
+		std::unordered_map <unsigned long long int, SaveJournal_Record> mChanged;
+		std::unordered_map <unsigned long long int, bool> mRemoved;
+		readJournal(mChanged,&mRemoved);
+
+		SaveFileReader reader;
+		if ( reader.open(basePath)==false )
+		{ return false; }
+		SaveFileChunk chunk = reader.getChunk("RECORDS");
+		const unsigned long long int nBaseRecords = chunk.readValue<unsigned long long int>();
+
+		const bool written = writeTempBase([&](SaveFileWriter& writer)
+		{
+			writer.beginChunk("RECORDS");
+			const unsigned long long int countPosition = writer.position();
+			writer.writeValue((unsigned long long int)0); // number of records, filled in below.
+
+			unsigned long long int nRecords = 0;
+			for (unsigned long long int i=0;i<nBaseRecords && chunk.failed==false;++i)
+			{
+				const unsigned long long int uid = chunk.readValue<unsigned long long int>();
+				const int classID = chunk.readValue<int>();
+				const std::string data = chunk.readString();
+
+				std::unordered_map <unsigned long long int, SaveJournal_Record>::iterator changed = mChanged.find(uid);
+				if ( changed!=mChanged.end() )
+				{
+					writeRecord(writer,uid,changed->second.classID,changed->second.data);
+					mChanged.erase(changed);
+					++nRecords;
+				}
+				else if ( mRemoved.find(uid)==mRemoved.end() )
+				{
+					writeRecord(writer,uid,classID,data);
+					++nRecords;
+				}
+			}
+			// records which aren't in the snapshot yet.
+			for (std::unordered_map <unsigned long long int, SaveJournal_Record>::iterator it=mChanged.begin();it!=mChanged.end();++it)
+			{
+				writeRecord(writer,it->first,it->second.classID,it->second.data);
+				++nRecords;
+			}
+			writer.overwriteValue(countPosition,nRecords);
+			writer.endChunk();
+			return chunk.failed==false;
+		});
+		reader.close();
+
+		if ( written==false || replaceBase()==false )
+		{
+			std::cout<<"ERROR: SaveJournal: Unable to compact "<<basePath<<".\n";
+			return false;
+		}
+		return true;
+	}
+
+	// Read the snapshot and replay the journal into mRecord. A damaged journal tail, or a journal from an older
+	// snapshot, is dropped by compacting.
+	bool load()
+	{
+		mRecord.clear();
+		baseSize=getFileSize(basePath);
+		journalSize=getFileSize(journalPath);
+		generation=readGeneration();
+		journalChecked=false;
+		if ( readBase(mRecord)==false )
+		{ return false; }
+		if ( readJournal(mRecord,0) )
+		{ journalChecked=true; }
+		else
+		{ compact(); }
+		return true;
+	}
+
+	// Free the loaded records once the objects have been rebuilt.
+	void clearRecords()
+	{
+		std::unordered_map <unsigned long long int, SaveJournal_Record>().swap(mRecord);
+	}
+};
+
+#endif
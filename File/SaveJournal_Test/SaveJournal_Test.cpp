@@ -0,0 +1,225 @@
+#include <climits> /* Colour.hpp needs UINT_MAX. */
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include <Container/Vector/Vector.hpp>
+#include <File/SaveJournal.hpp>
+#include <System/Time/Timer.hpp>
+
+// g++ SaveJournal_Test.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX
+
+// Test of incremental saves. Saves a world of objects, changes a few, and checks that only those are written, that
+// loading gives the latest state, and that compaction and damaged journals work. Also times a full save against an
+// incremental one.
+
+const std::string savePath = "SaveJournal_Test.sav";
+const int N_OBJECTS = 200000;
+
+int nFailed = 0;
+unsigned long int nGetSaveData = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+class Tile final: public SaveFileInterface
+{
+	public:
+	int height;
+	std::string name;
+
+	Tile()
+	{
+		height=0;
+		name="tile";
+	}
+
+	int getClassID() override
+	{ return 7; }
+
+	std::string getSaveData() override
+	{
+		++nGetSaveData;
+		return std::string((const char*)&height,sizeof(int))+name;
+	}
+
+	bool loadSaveData(const std::string& _data) override
+	{
+		if ( _data.size()<sizeof(int) )
+		{ return false; }
+		height = *(const int*)_data.data();
+		name = _data.substr(sizeof(int));
+		return true;
+	}
+
+	void setHeight(const int _height)
+	{
+		height=_height;
+		markDirty();
+	}
+};
+
+// Check that the loaded records match the tiles.
+bool loadMatches(SaveJournal& journal, Vector <Tile*>& vTile)
+{
+	if ( journal.load()==false || journal.mRecord.size()!=(unsigned int)vTile.size() )
+	{ return false; }
+	for (int i=0;i<vTile.size();++i)
+	{
+		std::unordered_map <unsigned long long int, SaveJournal_Record>::iterator it = journal.mRecord.find(vTile(i)->getUID());
+		if ( it==journal.mRecord.end() || it->second.classID!=7 || it->second.data!=vTile(i)->getSaveData() )
+		{ return false; }
+	}
+	journal.clearRecords();
+	return true;
+}
+
+int main (int nArgs, char ** arg)
+{
+	std::remove(savePath.c_str());
+	std::remove((savePath+".journal").c_str());
+
+	Vector <Tile*> vTile;
+	SaveJournal journal (savePath);
+	for (int i=0;i<N_OBJECTS;++i)
+	{
+		Tile* tile = new Tile;
+		tile->height=i;
+		vTile.push(tile);
+		journal.track(tile);
+	}
+
+	Timer timer;
+	timer.init();
+	timer.start();
+	check("First save writes everything", journal.save() && journal.nLastSaveRecords==N_OBJECTS);
+	timer.update();
+	const double fullSeconds = timer.fullSeconds;
+	const unsigned long long int fullBytes = journal.lastSaveBytes;
+
+	check("Save with no changes writes nothing", journal.save() && journal.nLastSaveRecords==0 && journal.lastSaveBytes==0);
+
+	for (int i=0;i<100;++i)
+	{ vTile(i*1000)->setHeight(-i); }
+	vTile(5)->name="renamed";
+	vTile(5)->markDirty();
+	nGetSaveData=0;
+	timer.init();
+	timer.start();
+	check("Incremental save writes only changes", journal.save() && journal.nLastSaveRecords==101);
+	timer.update();
+	check("Incremental save only looks at changed objects", nGetSaveData==101);
+	const double incrementalSeconds = timer.fullSeconds;
+	const unsigned long long int incrementalBytes = journal.lastSaveBytes;
+	check("Journal exists", journal.getJournalSize()>0);
+
+	// Objects which are untracked, or copies of tracked ones, aren't saved.
+	Tile* untracked = new Tile;
+	journal.track(untracked);
+	untracked->setHeight(7);
+	journal.untrack(untracked);
+	delete untracked;
+	Tile copy = *vTile(0);
+	copy.setHeight(999);
+	nGetSaveData=0;
+	check("Untracked objects and copies aren't saved", journal.save() && journal.nLastSaveRecords==1 && nGetSaveData==0);
+
+	// Remove some tiles and add a new one.
+	for (int i=0;i<10;++i)
+	{
+		journal.untrack(vTile(vTile.size()-1));
+		delete vTile(vTile.size()-1);
+		vTile.eraseSlot(vTile.size()-1);
+	}
+	Tile* newTile = new Tile;
+	newTile->name="new";
+	vTile.push(newTile);
+	journal.track(newTile);
+	vTile(1)->setHeight(12345);
+	check("Save removals and new objects", journal.save() && journal.nLastSaveRecords==12);
+
+	check("Load replays the journal", loadMatches(journal,vTile));
+
+	// Rebuild objects from the save, like a game would.
+	journal.load();
+	SaveJournal loadedJournal (savePath);
+	Vector <Tile*> vLoaded;
+	for (auto& record: journal.mRecord)
+	{
+		Tile* tile = new Tile;
+		tile->setUID(record.first);
+		tile->loadSaveData(record.second.data);
+		loadedJournal.track(tile,true);
+		vLoaded.push(tile);
+	}
+	journal.clearRecords();
+	check("Rebuilt objects are clean", loadedJournal.save() && loadedJournal.nLastSaveRecords==0);
+	Tile fresh;
+	check("New objects don't reuse loaded UIDs", journal.mRecord.count(fresh.getUID())==0 && fresh.getUID()>newTile->getUID());
+	vLoaded.deleteAll();
+
+	check("Compact", journal.compact() && journal.getJournalSize()==0);
+	check("Load after compacting", loadMatches(journal,vTile));
+
+	// Simulate a crash partway through writing a journal entry.
+	vTile(2)->setHeight(222);
+	journal.save();
+	{
+		std::ofstream journalFile((savePath+".journal").c_str(), std::ios::binary | std::ios::app);
+		journalFile.write("\0\1\2\3\4\5",6);
+	}
+	std::cout<<"Expect 2 warnings:\n";
+	check("Damaged journal tail is ignored", loadMatches(journal,vTile));
+	check("Damaged journal was compacted", journal.getJournalSize()==0);
+
+	// A damaged tail found by a save, without loading first, is dropped before appending.
+	vTile(3)->setHeight(333);
+	journal.save();
+	{
+		std::ofstream journalFile((savePath+".journal").c_str(), std::ios::binary | std::ios::app);
+		journalFile.write("\0\1\2\3\4\5",6);
+	}
+	journal.setPath(savePath);
+	vTile(4)->setHeight(444);
+	std::cout<<"Expect 2 warnings:\n";
+	check("Save drops a damaged tail before appending", journal.save() && journal.nLastSaveRecords==1
+		&& loadMatches(journal,vTile));
+
+	// A crash after the new snapshot is renamed, but before the journal is deleted, leaves an old journal.
+	vTile(5)->setHeight(555);
+	journal.save();
+	std::string oldJournal;
+	{
+		std::ifstream journalFile((savePath+".journal").c_str(), std::ios::binary);
+		oldJournal.assign(std::istreambuf_iterator<char>(journalFile),std::istreambuf_iterator<char>());
+	}
+	vTile(5)->setHeight(556);
+	journal.saveAll();
+	{
+		std::ofstream journalFile((savePath+".journal").c_str(), std::ios::binary);
+		journalFile.write(oldJournal.data(),oldJournal.size());
+	}
+	journal.setPath(savePath);
+	std::cout<<"Expect 2 warnings:\n";
+	check("Journal from an older snapshot is ignored", oldJournal.size()>0 && loadMatches(journal,vTile));
+
+	// Autosaves compact once the journal gets large.
+	journal.maxJournalRatio=0.01;
+	for (int i=0;i<10000;++i)
+	{ vTile(i)->setHeight(i*2); }
+	check("Large journal is compacted", journal.save() && journal.getJournalSize()==0 && loadMatches(journal,vTile));
+
+	std::cout<<N_OBJECTS<<" objects. Full save: "<<fullSeconds<<"s, "<<fullBytes<<" bytes. Save of 101 changes: "
+		<<incrementalSeconds<<"s, "<<incrementalBytes<<" bytes.\n";
+
+	vTile.deleteAll();
+	std::remove(savePath.c_str());
+	std::remove((savePath+".journal").c_str());
+	std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+	return nFailed==0 ? 0 : 1;
+}
@@ -0,0 +1,459 @@
+#pragma once
+#ifndef WILDCAT_FILE_WTF_IMAGE_HPP
+#define WILDCAT_FILE_WTF_IMAGE_HPP
+
+/* Wildcat: WTFImage
+	#include <File/WTFImage.hpp>
+
+	Compiled binary image of parsed raws. Parsing hundreds of WTF files as text every launch is slow, so the parsed tree
+	can be saved with compile(), and later loaded with load(), which just maps the file into memory and checks it. Nothing
+	is allocated per node, and lookups read the image directly.
+
+	The image stores the md5 of the source text. load() fails if the hash doesn't match, so the image is rebuilt whenever
+	the raws change. open() does all of this: it loads the image if it's up to date, otherwise it parses the source text
+	and compiles a new image.
+
+	Nodes are referred to by index. Roots are nodes 0 to nRoots()-1, and each node's sub-nodes are stored together.
+
+	Layout, in native byte order:
+		Header
+		Path index: indexSize entries of {hash, node}. Same hash as WTFPathIndex.
+		Nodes: nNodes entries of {id, parent, firstSub, nSubs, firstValue, nValues}
+		Values: nValues entries of {offset, size} in the string table.
+		String table.
+	The header has a checksum of everything after it, so a damaged or partly written image won't load.
+*/
+
+#include <File/WTFManager.hpp>
+#include <File/FileMapping.hpp>
+
+#include <Data/Checksum/md5.cpp>
+
+#include <Container/Vector/Vector.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class WTFImage
+{
+	public:
+
+	static const unsigned int VERSION = 1;
+	static const unsigned int NONE = 0xFFFFFFFF;
+
+	private:
+
+	class Header
+	{
+		public:
+		char magic [4]; // "WTFI"
+		unsigned int version;
+		char sourceHash [32]; // md5 of the source text, in hex
+		unsigned int nNodes;
+		unsigned int nRoots;
+		unsigned int nValues;
+		unsigned int indexSize; // power of 2, or 0 if there are no nodes
+		unsigned int stringsSize;
+		unsigned int padding;
+		unsigned long long int checksum;
+	};
+
+	class IndexEntry
+	{
+		public:
+		unsigned long long int hash;
+		unsigned int node; // NONE if empty
+		unsigned int padding;
+	};
+
+	class Node
+	{
+		public:
+		unsigned int idOffset;
+		unsigned int idSize;
+		unsigned int parent; // NONE for roots
+		unsigned int firstSub;
+		unsigned int nSubs;
+		unsigned int firstValue;
+		unsigned int nValues;
+		unsigned int padding;
+	};
+
+	class Value
+	{
+		public:
+		unsigned int offset;
+		unsigned int size;
+	};
+
+	FileMapping mapping;
+
+	const Header* header;
+	const IndexEntry* aIndex;
+	const Node* aNode;
+	const Value* aValue;
+	const char* aString;
+
+	// FNV-1a, but 8 bytes at a time so checking a large image is quick.
+	static unsigned long long int checksum(const char* _data, const unsigned long int _size)
+	{
+		unsigned long long int hash = WTFPathIndex::HASH_START;
+		unsigned long int i=0;
+		for (;i+8<=_size;i+=8)
+		{
+			unsigned long long int word;
+			std::memcpy(&word,_data+i,8);
+			hash ^= word;
+			hash *= 1099511628211ULL;
+		}
+		return WTFPathIndex::hash(hash,_data+i,_size-i);
+	}
+
+	// true if the node's path is _path[0] to _path[_size-1].
+	bool hasPath(unsigned int _node, const char* _path, unsigned long int _size) const
+	{
+		while ( _node!=NONE )
+		{
+			const Node& node = aNode[_node];
+			if ( node.idSize > _size || std::memcmp(aString+node.idOffset,_path+_size-node.idSize,node.idSize)!=0 )
+			{ return false; }
+			_size-=node.idSize;
+			_node=node.parent;
+			if ( _node!=NONE )
+			{
+				if ( _size==0 || _path[_size-1]!='.' )
+				{ return false; }
+				--_size;
+			}
+		}
+		return _size==0;
+	}
+
+	// Check that every offset in the image is in bounds, so lookups don't need to.
+	bool validate(const std::string& _sourceHash)
+	{
+		if ( mapping.size < sizeof(Header) )
+		{ return false; }
+		const Header* h = (const Header*) mapping.data;
+		if ( std::memcmp(h->magic,"WTFI",4)!=0 || h->version!=VERSION )
+		{ return false; }
+		if ( _sourceHash.size()!=32 || std::memcmp(h->sourceHash,_sourceHash.data(),32)!=0 )
+		{ return false; }
+		if ( h->indexSize & (h->indexSize-1) )
+		{ return false; }
+
+		const unsigned long long int expectedSize = sizeof(Header) + (unsigned long long int)h->indexSize*sizeof(IndexEntry)
+			+ (unsigned long long int)h->nNodes*sizeof(Node) + (unsigned long long int)h->nValues*sizeof(Value) + h->stringsSize;
+		if ( expectedSize != mapping.size )
+		{ return false; }
+		if ( checksum(mapping.data+sizeof(Header),mapping.size-sizeof(Header)) != h->checksum )
+		{ return false; }
+
+		const IndexEntry* index = (const IndexEntry*) (mapping.data+sizeof(Header));
+		const Node* node = (const Node*) (index+h->indexSize);
+		const Value* value = (const Value*) (node+h->nNodes);
+
+		for (unsigned int i=0;i<h->indexSize;++i)
+		{
+			if ( index[i].node!=NONE && index[i].node>=h->nNodes )
+			{ return false; }
+		}
+		for (unsigned int i=0;i<h->nNodes;++i)
+		{
+			const Node& n = node[i];
+			if ( (unsigned long long int)n.idOffset+n.idSize > h->stringsSize
+				|| (unsigned long long int)n.firstSub+n.nSubs > h->nNodes
+				|| (unsigned long long int)n.firstValue+n.nValues > h->nValues
+				|| (n.parent==NONE) != (i<h->nRoots)
+				|| (n.parent!=NONE && n.parent>=i) ) // parents come before their sub-nodes, so there are no loops.
+			{ return false; }
+		}
+		for (unsigned int i=0;i<h->nValues;++i)
+		{
+			if ( (unsigned long long int)value[i].offset+value[i].size > h->stringsSize )
+			{ return false; }
+		}
+		return true;
+	}
+
+	// Add the string to the string table, unless it's already there. Returns its offset.
+	static unsigned int addString(const std::string& _str, std::string& strings, std::unordered_map <std::string, unsigned int>& mString)
+	{
+		std::unordered_map <std::string, unsigned int>::iterator it = mString.find(_str);
+		if ( it!=mString.end() )
+		{ return it->second; }
+		const unsigned int offset = strings.size();
+		strings+=_str;
+		mString[_str]=offset;
+		return offset;
+	}
+
+	public:
+
+	WTFImage()
+	{
+		header=0;
+		aIndex=0;
+		aNode=0;
+		aValue=0;
+		aString=0;
+	}
+
+	static std::string hashSource(const std::string& _sourceText)
+	{
+		return md5(_sourceText);
+	}
+
+	// Write the manager's raws to an image file. Returns false if the file can't be written.
+	static bool compile(WTFManager& _manager, const std::string& _sourceHash, const std::string& _path)
+	{
+		std::vector <WTFNode*> vTreeNode; // in image order: roots, then each node's subs together
+		std::vector <unsigned int> vTreeParent;
+		for (int i=0;i<_manager.vRoot.size();++i)
+		{
+			vTreeNode.push_back(_manager.vRoot(i));
+			vTreeParent.push_back((unsigned int)NONE);
+		}
+
+		std::vector <Node> vImageNode;
+		std::vector <Value> vImageValue;
+		std::vector <unsigned long long int> vPathHash;
+		std::string strings = "";
+		std::unordered_map <std::string, unsigned int> mString;
+
+		for (unsigned int i=0;i<vTreeNode.size();++i)
+		{
+			WTFNode* treeNode = vTreeNode[i];
+			Node node;
+			std::memset(&node,0,sizeof(Node));
+
+			node.idOffset=addString(treeNode->id,strings,mString);
+			node.idSize=treeNode->id.size();
+
+			node.firstValue=vImageValue.size();
+			node.nValues=treeNode->vValue.size();
+			for (int i2=0;i2<treeNode->vValue.size();++i2)
+			{
+				Value value;
+				value.offset=addString(treeNode->vValue(i2),strings,mString);
+				value.size=treeNode->vValue(i2).size();
+				vImageValue.push_back(value);
+			}
+
+			node.parent=vTreeParent[i];
+			unsigned long long int pathHash = WTFPathIndex::HASH_START;
+			if ( node.parent!=NONE )
+			{ pathHash = WTFPathIndex::hash(vPathHash[node.parent],".",1); }
+			pathHash = WTFPathIndex::hash(pathHash,treeNode->id.data(),treeNode->id.size());
+			vPathHash.push_back(pathHash);
+
+			node.firstSub=vTreeNode.size();
+			node.nSubs=treeNode->vSubRaw.size();
+			for (int i2=0;i2<treeNode->vSubRaw.size();++i2)
+			{
+				vTreeNode.push_back(treeNode->vSubRaw(i2));
+				vTreeParent.push_back(i);
+			}
+
+			vImageNode.push_back(node);
+		}
+
+		// Index the nodes the manager would return, so duplicate paths give the same node.
+		unsigned int indexSize = 0;
+		if ( vImageNode.size()>0 )
+		{
+			indexSize=64;
+			while ( indexSize < vImageNode.size()*2 )
+			{ indexSize*=2; }
+		}
+		std::vector <IndexEntry> vIndex (indexSize);
+		for (unsigned int i=0;i<vIndex.size();++i)
+		{
+			vIndex[i].hash=0;
+			vIndex[i].node=NONE;
+			vIndex[i].padding=0;
+		}
+		for (unsigned int i=0;i<vTreeNode.size();++i)
+		{
+			if ( _manager.getNode(vTreeNode[i]->getFullID()) != vTreeNode[i] )
+			{ continue; }
+			unsigned int slot = vPathHash[i] & (indexSize-1);
+			while ( vIndex[slot].node!=NONE )
+			{ slot = (slot+1) & (indexSize-1); }
+			vIndex[slot].hash=vPathHash[i];
+			vIndex[slot].node=i;
+		}
+
+		Header h;
+		std::memset(&h,0,sizeof(Header));
+		std::memcpy(h.magic,"WTFI",4);
+		h.version=VERSION;
+		std::memcpy(h.sourceHash,_sourceHash.data(),_sourceHash.size()<32 ? _sourceHash.size() : 32);
+		h.nNodes=vImageNode.size();
+		h.nRoots=_manager.vRoot.size();
+		h.nValues=vImageValue.size();
+		h.indexSize=indexSize;
+		h.stringsSize=strings.size();
+
+		std::string body = "";
+		body.append((const char*)vIndex.data(),vIndex.size()*sizeof(IndexEntry));
+		body.append((const char*)vImageNode.data(),vImageNode.size()*sizeof(Node));
+		body.append((const char*)vImageValue.data(),vImageValue.size()*sizeof(Value));
+		body.append(strings);
+		h.checksum = checksum(body.data(),body.size());
+
+		std::ofstream file(_path.c_str(), std::ios::binary | std::ios::trunc);
+		if ( file.is_open()==false )
+		{
+			std::cout<<"WARNING: WTFImage: Unable to write "<<_path<<"\n";
+			return false;
+		}
+		file.write((const char*)&h,sizeof(Header));
+		file.write(body.data(),body.size());
+		return file.good();
+	}
+
+	// Map the image, if it exists, is valid, and was compiled from source text with this hash.
+	bool load(const std::string& _path, const std::string& _sourceHash)
+	{
+		close();
+		if ( mapping.open(_path)==false )
+		{ return false; }
+		if ( validate(_sourceHash)==false )
+		{
+			close();
+			return false;
+		}
+		header = (const Header*) mapping.data;
+		aIndex = (const IndexEntry*) (mapping.data+sizeof(Header));
+		aNode = (const Node*) (aIndex+header->indexSize);
+		aValue = (const Value*) (aNode+header->nNodes);
+		aString = (const char*) (aValue+header->nValues);
+		return true;
+	}
+
+	// Load the image if it's up to date with the source text, otherwise parse the text and compile a new image.
+	// Returns false if the text can't be parsed.
+	bool open(const std::string& _path, const std::string& _sourceText)
+	{
+		const std::string sourceHash = hashSource(_sourceText);
+		if ( load(_path,sourceHash) )
+		{ return true; }
+
+		WTFManager manager;
+		if ( manager.parse(_sourceText)==false )
+		{ return false; }
+		if ( compile(manager,sourceHash,_path) && load(_path,sourceHash) )
+		{ return true; }
+
+		std::cout<<"WARNING: WTFImage: Unable to load compiled raws from "<<_path<<"\n";
+		return false;
+	}
+
+	void close()
+	{
+		mapping.close();
+		header=0;
+		aIndex=0;
+		aNode=0;
+		aValue=0;
+		aString=0;
+	}
+
+	inline bool isLoaded() const
+	{ return header!=0; }
+
+	inline unsigned int nNodes() const
+	{ return header==0 ? 0 : header->nNodes; }
+
+	inline unsigned int nRoots() const
+	{ return header==0 ? 0 : header->nRoots; }
+
+	// return the node with this full path, or NONE if there isn't one.
+	unsigned int getNode(const std::string& _path) const
+	{
+		if ( header==0 || header->indexSize==0 )
+		{ return NONE; }
+		const unsigned long long int pathHash = WTFPathIndex::hash(WTFPathIndex::HASH_START,_path.data(),_path.size());
+		const unsigned int mask = header->indexSize-1;
+		unsigned int slot = pathHash & mask;
+		while ( aIndex[slot].node!=NONE )
+		{
+			if ( aIndex[slot].hash==pathHash && hasPath(aIndex[slot].node,_path.data(),_path.size()) )
+			{ return aIndex[slot].node; }
+			slot = (slot+1) & mask;
+		}
+		return NONE;
+	}
+
+	// return true if the path through the tree exists.
+	bool hasTag(const std::string& _path) const
+	{
+		return getNode(_path)!=NONE;
+	}
+
+	// return the value attached to this path. If there are multiple it will return the first.
+	// if there are none it will return empty string.
+	std::string getValue(const std::string& _path) const
+	{
+		const unsigned int node = getNode(_path);
+		if ( node==NONE || aNode[node].nValues==0 )
+		{ return ""; }
+		return getValue(node,0);
+	}
+
+	// return a copy of the values attached to this path, or 0 if there are none.
+	Vector <std::string> * getValues(const std::string& _path) const
+	{
+		const unsigned int node = getNode(_path);
+		if ( node==NONE || aNode[node].nValues==0 )
+		{ return 0; }
+		Vector <std::string>* vRet = new Vector <std::string>;
+		for (unsigned int i=0;i<aNode[node].nValues;++i)
+		{ vRet->push(getValue(node,i)); }
+		return vRet;
+	}
+
+	// Access to individual nodes. The node must be valid.
+	inline std::string getID(const unsigned int _node) const
+	{ return std::string(aString+aNode[_node].idOffset,aNode[_node].idSize); }
+
+	inline unsigned int getParent(const unsigned int _node) const
+	{ return aNode[_node].parent; }
+
+	inline unsigned int nSubs(const unsigned int _node) const
+	{ return aNode[_node].nSubs; }
+
+	inline unsigned int getSub(const unsigned int _node, const unsigned int _i) const
+	{ return aNode[_node].firstSub+_i; }
+
+	inline unsigned int nValues(const unsigned int _node) const
+	{ return aNode[_node].nValues; }
+
+	inline std::string getValue(const unsigned int _node, const unsigned int _i) const
+	{
+		const Value& value = aValue[aNode[_node].firstValue+_i];
+		return std::string(aString+value.offset,value.size);
+	}
+
+	// return a random sub-node of the path, or NONE if there are none.
+	// Blank returns a random root.
+	unsigned int getRandom(const std::string& _path, RandomInterface& rng) const
+	{
+		if ( _path.size()==0 )
+		{
+			if ( nRoots()==0 )
+			{ return NONE; }
+			return rng.rand32(nRoots()-1);
+		}
+		const unsigned int node = getNode(_path);
+		if ( node==NONE || aNode[node].nSubs==0 )
+		{ return NONE; }
+		return aNode[node].firstSub+rng.rand32(aNode[node].nSubs-1);
+	}
+};
+
+#endif
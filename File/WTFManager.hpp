@@ -46,8 +46,10 @@ Future possibilities:
 		A simple timestamp system might be the best option.)
 	* Pointer handling - Pointers can be saved by giving objects unique IDs.
 	* Binary data - Probably best handled with the old "chunk" system.
-	
-	This tree data could be read normally but collapsed into a hashmap for much faster lookups.
+
+Parsing is done in a single pass over the input, without copying it. Nodes are stored together in an arena owned by
+the WTFManager, and every node's full path (for example CREATURE.DEER.AGE) is put in a hashmap, so lookups don't need
+to walk the tree. If a path is used more than once, lookups return the first node with that path.
 
 */
 
@@ -56,24 +58,224 @@ Future possibilities:
 #include <Container/Vector/Vector.hpp>
 #include <Data/DataTools.hpp>
 
+#include <deque>
+#include <vector>
+#include <utility> // std::pair
+
+// Hash table from full paths to nodes. The paths aren't stored, instead each entry has the hash of the path, and
+// matches are checked against the node's IDs. This means the parser only has to hash each ID once, as the hash of
+// a path can be continued from the hash of its parent's path.
+class WTFPathIndex
+{
+	private:
+	
+	class Entry
+	{
+		public:
+		unsigned long long int hash;
+		WTFNode* node; // 0 if the entry is empty
+	};
+	
+	std::vector <Entry> vEntry; // size is always a power of 2, and at most half full.
+	unsigned long int nEntries;
+	
+	// true if the node's path is _path[0] to _path[_size-1].
+	static bool hasPath(const WTFNode* node, const char* _path, unsigned long int _size)
+	{
+		while ( node!=0 )
+		{
+			const std::string& id = node->id;
+			if ( id.size() > _size || id.compare(0,id.size(),_path+_size-id.size(),id.size())!=0 )
+			{ return false; }
+			_size-=id.size();
+			node=node->parent;
+			if ( node!=0 )
+			{
+				if ( _size==0 || _path[_size-1]!='.' )
+				{ return false; }
+				--_size;
+			}
+		}
+		return _size==0;
+	}
+	
+	static bool samePath(const WTFNode* node, const WTFNode* node2)
+	{
+		while ( node!=0 && node2!=0 )
+		{
+			if ( node==node2 )
+			{ return true; }
+			if ( node->id != node2->id )
+			{ return false; }
+			node=node->parent;
+			node2=node2->parent;
+		}
+		return node==node2;
+	}
+	
+	void grow()
+	{
+		std::vector <Entry> vOld;
+		vOld.swap(vEntry);
+		vEntry.assign(vOld.size()==0 ? 64 : vOld.size()*2, Entry{0,0});
+		const unsigned long int mask = vEntry.size()-1;
+		for (unsigned long int i=0;i<vOld.size();++i)
+		{
+			if ( vOld[i].node==0 )
+			{ continue; }
+			unsigned long int slot = vOld[i].hash & mask;
+			while ( vEntry[slot].node!=0 )
+			{ slot = (slot+1) & mask; }
+			vEntry[slot]=vOld[i];
+		}
+	}
+	
+	public:
+	
+	// FNV-1a
+	static const unsigned long long int HASH_START = 14695981039346656037ULL;
+	static inline unsigned long long int hash(unsigned long long int _hash, const char* _str, const unsigned long int _size)
+	{
+		for (unsigned long int i=0;i<_size;++i)
+		{
+			_hash ^= (unsigned char)_str[i];
+			_hash *= 1099511628211ULL;
+		}
+		return _hash;
+	}
+	
+	WTFPathIndex()
+	{
+		nEntries=0;
+	}
+	
+	void clear()
+	{
+		vEntry.clear();
+		nEntries=0;
+	}
+	
+	// Add the node with the given path hash. If there's already a node with the same path, the first one is kept,
+	// and this returns false.
+	bool add(const unsigned long long int _hash, WTFNode* node)
+	{
+		if ( (nEntries+1)*2 > vEntry.size() )
+		{ grow(); }
+		
+		const unsigned long int mask = vEntry.size()-1;
+		unsigned long int slot = _hash & mask;
+		while ( vEntry[slot].node!=0 )
+		{
+			if ( vEntry[slot].hash==_hash && samePath(vEntry[slot].node,node) )
+			{ return false; }
+			slot = (slot+1) & mask;
+		}
+		vEntry[slot].hash=_hash;
+		vEntry[slot].node=node;
+		++nEntries;
+		return true;
+	}
+	
+	// Remove the entry for this node. The entries after it in the probe sequence are shifted back into the gap, so
+	// no tombstones are needed.
+	void remove(const unsigned long long int _hash, const WTFNode* node)
+	{
+		if ( nEntries==0 )
+		{ return; }
+		
+		const unsigned long int mask = vEntry.size()-1;
+		unsigned long int hole = _hash & mask;
+		while ( vEntry[hole].node!=node )
+		{
+			if ( vEntry[hole].node==0 )
+			{ return; }
+			hole = (hole+1) & mask;
+		}
+		
+		for (unsigned long int slot=(hole+1)&mask; vEntry[slot].node!=0; slot=(slot+1)&mask)
+		{
+			// An entry can fill the hole if its home slot isn't between the hole and where it is now.
+			const unsigned long int home = vEntry[slot].hash & mask;
+			if ( ((slot-home)&mask) >= ((slot-hole)&mask) )
+			{
+				vEntry[hole]=vEntry[slot];
+				hole=slot;
+			}
+		}
+		vEntry[hole].node=0;
+		--nEntries;
+	}
+	
+	inline unsigned long int size() const
+	{ return nEntries; }
+	
+	WTFNode* find(const std::string& _path) const
+	{
+		if ( nEntries==0 )
+		{ return 0; }
+		const unsigned long long int pathHash = hash(HASH_START,_path.data(),_path.size());
+		const unsigned long int mask = vEntry.size()-1;
+		unsigned long int slot = pathHash & mask;
+		while ( vEntry[slot].node!=0 )
+		{
+			if ( vEntry[slot].hash==pathHash && hasPath(vEntry[slot].node,_path.data(),_path.size()) )
+			{ return vEntry[slot].node; }
+			slot = (slot+1) & mask;
+		}
+		return 0;
+	}
+};
+
 // RawManager is necessary to parse the data and manage the root (level 0) nodes.
 class WTFManager
 {
+	friend class WTFImage; // WTFImage::compile() reads the nodes directly.
+	
 	private:
 	Vector <WTFNode*> vRoot; // vector of all root (level 0) nodes.
 	
+	std::deque <WTFNode> nodeArena; // all nodes. A deque doesn't move them when it grows.
+	WTFPathIndex pathIndex; // full path of each node, eg CREATURE.DEER.AGE
+	
+	// Make a new node under the given parent, or a root node if there isn't one.
+	WTFNode* newNode(WTFNode* _parent)
+	{
+		nodeArena.emplace_back();
+		WTFNode* node = &nodeArena.back();
+		node->parent=_parent;
+		if ( _parent==0 )
+		{ vRoot.push(node); }
+		else
+		{ _parent->vSubRaw.push(node); }
+		return node;
+	}
+	
+	// Undo a failed parse(). Its nodes are at the end of the arena, and they only hang off roots or each other, so
+	// the nodes loaded before it are untouched.
+	void rollBack(const int _nRoots, const unsigned long int _nNodes, const unsigned long int _nIndexed,
+		const std::vector <std::pair <unsigned long long int, WTFNode*> >& _vIndexed)
+	{
+		for (unsigned long int i=_vIndexed.size();i>0;--i)
+		{ pathIndex.remove(_vIndexed[i-1].first,_vIndexed[i-1].second); }
+		if ( pathIndex.size()!=_nIndexed )
+		{ std::cout<<"Error: WTFManager path index didn't roll back.\n"; }
+		
+		while ( vRoot.size()>_nRoots )
+		{ vRoot.popBack(); }
+		nodeArena.resize(_nNodes);
+	}
+	
 	public:
 	WTFManager() { }
 	
 	~WTFManager()
 	{
-		// clear the nodes vector.
-		for (int i=0;i<vRoot.size();++i)
-		{
-			delete vRoot(i);
-		}
 	}
 	
+		// The path index points into nodeArena, so a copy would point into the original's nodes.
+	WTFManager(const WTFManager&) = delete;
+	void operator = (const WTFManager&) = delete;
+	
 	// do a quick bracket count just to be sure it's not bad data
 	bool verify(const std::string input)
 	{
@@ -144,107 +346,154 @@ class WTFManager
 	
 	void clear()
 	{
-		for (int i=0;i<vRoot.size();++i)
-		{
-			delete vRoot(i);
-		}
+		vRoot.clear();
+		pathIndex.clear();
+		nodeArena.clear();
 	}
 	
-	bool parse(const std::string input)
+	bool parse(const std::string& input)
 	{
-		// step 1: Remove all non-relevant data. That is: everything outside of square brackets.
-		// and any whitespace outside of quotation marks.
+		return parse(input.data(),input.size());
+	}
+	
+	// Parse raws from a buffer, which could be a file mapped into memory. The buffer isn't needed afterwards.
+	// Nodes are added to any already loaded. If the raws are invalid, the nodes added by this call are removed and
+	// the ones already loaded are kept.
+	bool parse(const char* input, const unsigned long int size)
+	{
+		enum { SKIP, READ_ID, READ_VALUES };
+		int state = SKIP; // SKIP ignores everything except brackets.
 		
-		if (verify(input) == false )
-		{
-			std::cout<<"Verification failed, parsing aborted.\n";
-		}
-
-		// read all root raws and parse them individually.
-		Vector <std::string> vStrRoot;
+		std::vector <WTFNode*> vOpen; // the node at each level.
+		std::vector <unsigned long long int> vPathHash; // hash of the full path of each open node.
 		
-		std::string strRoot = "";
+		// What to roll back to if parsing fails.
+		const int nRootsBefore = vRoot.size();
+		const unsigned long int nNodesBefore = nodeArena.size();
+		const unsigned long int nIndexedBefore = pathIndex.size();
+		std::vector <std::pair <unsigned long long int, WTFNode*> > vIndexed; // index entries added by this call
 		
-		int currentLevel = 0;
-		bool quotes = false; // ignore anything in quotes (only applies inside brackets)
-		bool closedBracket = false; // ignore anything between a closing and opening bracket
-		for (unsigned int i=0;i<input.size();++i)
+		std::string currentValue = "";
+		bool valueStarted = false;
+		bool quotes = false;
+		
+		for (unsigned long int i=0;i<size;++i)
 		{
-			if (currentLevel>0 && closedBracket==false && input[i] == '\"'			)
-			{
-				quotes=!quotes;
-			}
+			const char c = input[i];
 			
-			if ( quotes == false && input[i] == '[' )
+			if ( state==READ_VALUES )
 			{
-				++currentLevel;
-				closedBracket=false;
+				if ( c=='\"' )
+				{
+					quotes=!quotes;
+				}
+				if ( quotes || c=='\"' )
+				{
+					currentValue+=c;
+					valueStarted=true;
+					continue;
+				}
+				if ( c==',' )
+				{ // delimit multiple values
+					vOpen.back()->vValue.push(currentValue); // note that null values may be pushed
+					currentValue="";
+					valueStarted=true;
+					continue;
+				}
+				if ( c=='[' || c==']' )
+				{ // end of values, which may be followed by sub-nodes.
+					if ( c==']' || valueStarted )
+					{ vOpen.back()->vValue.push(currentValue); }
+					currentValue="";
+					valueStarted=false;
+					state=SKIP;
+				}
+				else
+				{
+					if ( c!=' ' && c!='\n' && c!='\r' && c!='\t' )
+					{
+						currentValue+=c;
+						valueStarted=true;
+					}
+					continue;
+				}
 			}
-			
-			if (currentLevel > 0 && ( closedBracket==false || input[i]==']'))
+			else if ( state==READ_ID )
 			{
-				if ( quotes == true || ( input[i] != ' ' && input[i] != '\n' && input[i] != '\r' && input[i] != '\t') )
+				if ( c==':' || c=='[' || c==']' )
 				{
-					strRoot+=input[i];
-				}					
+					WTFNode* node = vOpen.back();
+					if ( node->id.size()==0 )
+					{
+						std::cout<<"Error: No raw ID. Aborting.\n";
+						rollBack(nRootsBefore,nNodesBefore,nIndexedBefore,vIndexed);
+						return false;
+					}
+					
+					unsigned long long int pathHash = WTFPathIndex::HASH_START;
+					if ( node->parent!=0 )
+					{ pathHash = WTFPathIndex::hash(vPathHash.back(),".",1); }
+					pathHash = WTFPathIndex::hash(pathHash,node->id.data(),node->id.size());
+					vPathHash.push_back(pathHash);
+					if ( pathIndex.add(pathHash,node) )
+					{ vIndexed.emplace_back(pathHash,node); }
+					
+					if ( c==':' )
+					{
+						state=READ_VALUES;
+						continue;
+					}
+					state=SKIP;
+				}
+				else
+				{
+					if ( c!=' ' && c!='\n' && c!='\r' && c!='\t' )
+					{ vOpen.back()->id+=c; }
+					continue;
+				}
 			}
 			
-			if (quotes == false && input[i] == ']')
+			// SKIP, or a bracket which ended an ID or values.
+			if ( c=='[' )
 			{
-				--currentLevel;
-				closedBracket=true;
-				
-				// push the raw to the vector if we are back to level 0
-				if ( currentLevel==0 && strRoot.size() > 0 )
+				vOpen.push_back(newNode(vOpen.size()==0 ? 0 : vOpen.back()));
+				state=READ_ID;
+			}
+			else if ( c==']' )
+			{
+				if ( vOpen.size()==0 )
 				{
-					vStrRoot.push(strRoot);
-					strRoot="";
+					std::cout<<"Error: Too many closing brackets. Aborting.\n";
+					rollBack(nRootsBefore,nNodesBefore,nIndexedBefore,vIndexed);
+					return false;
 				}
+				vOpen.pop_back();
+				vPathHash.pop_back();
 			}
 		}
 		
-		// we now have all the root nodes at this point. We take the data we need and then make the subnodes.
-		for (int i=0;i<vStrRoot.size();++i)
+		if ( vOpen.size()!=0 || quotes )
 		{
-			// create a Raw root node and let the node parse the string
-			WTFNode * rRoot = new WTFNode;
-			if (rRoot->parse(vStrRoot(i)))
-			{
-				vRoot.push(rRoot);
-			}
-			else
-			{
-				delete rRoot;
-				// abort
-				clear();
-				std::cout<<"ERROR: Parsing failed\n";
-				return false;
-			}
+			std::cout<<"Error: Bad bracket count. Aborting.\n";
+			rollBack(nRootsBefore,nNodesBefore,nIndexedBefore,vIndexed);
+			return false;
 		}
 		return true;
 	}
 	
-	Vector <std::string> * getValues(std::string _query)
+	// return the node with this full path, or 0 if there isn't one.
+	WTFNode* getNode(const std::string& _query)
 	{
-		if ( _query.size()==0 )
-		{ return 0; }
+		return pathIndex.find(_query);
+	}
 	
-		//break query into delimiters.
-		Vector <std::string> * vPath = DataTools::tokenize(_query,".");
-		
-		for (int i=0;i<vRoot.size();++i)
-		{
-			if ( vRoot(i)->getID() == (*vPath)(0) )
-			{
-				vPath->eraseSlot(0);
-				Vector <std::string>* vRet = vRoot(i)->getValues(vPath);
-				delete vPath;
-				return vRet;
-			}
-		}
-		
-		delete vPath;
-		return 0;
+	// return a copy of the values attached to this path, or 0 if there are none.
+	Vector <std::string> * getValues(const std::string& _query)
+	{
+		WTFNode* node = getNode(_query);
+		if ( node==0 || node->vValue.size()==0 )
+		{ return 0; }
+		return node->vValue.copy();
 	}
 	
 	Vector <std::string> * delimitPath(std::string _query)
@@ -254,55 +503,19 @@ class WTFManager
 
 	// return the value attached to this path. If there are multiple it will return the first.
 	// if there are none it will return empty string.
-	std::string getValue(std::string _query)
+	std::string getValue(const std::string& _query)
 	{
-		if ( _query.size()==0 )
-		{ return 0; }
-	
-		//break query into delimiters.
-		Vector <std::string> * vPath = delimitPath(_query);
-		
-		for (int i=0;i<vRoot.size();++i)
-		{
-			if ( vRoot(i)->getID() == (*vPath)(0) )
-			{
-				vPath->eraseSlot(0);
-				std::string strRet = vRoot(i)->getValue(vPath);
-				delete vPath;
-				return strRet;
-			}
-		}
-		
-		delete vPath;
-		// couldn't find path, return empty string.
-		return "";
+		WTFNode* node = getNode(_query);
+		if ( node==0 || node->vValue.size()==0 )
+		{ return ""; }
+		return node->vValue(0);
 	}
 	
 	
 	// return true if the path through the tree exists.
-	bool hasTag (std::string _query)
+	bool hasTag (const std::string& _query)
 	{
-		if ( _query.size()==0 )
-		{ return false; }
-	
-		//break query into delimiters.
-		Vector <std::string> * vPath = delimitPath(_query);
-		
-		for (int i=0;i<vRoot.size();++i)
-		{
-			if ( vRoot(i)->getID() == (*vPath)(0) )
-			{
-				vPath->eraseSlot(0);
-				
-				if (vRoot(i)->hasTag(vPath))
-				{
-					delete vPath;
-					return true;
-				}
-			}
-		}
-		delete vPath;
-		return false;
+		return pathIndex.find(_query)!=0;
 	}
 	
 	// print all raws, using full or relative path, with or without indenting
@@ -317,10 +530,8 @@ class WTFManager
 	}
 	
 	// return all subraws from the given namespace. Blank returns everything on layer 0.
-	Vector <WTFNode*> * getAllSub(std::string _query)
+	Vector <WTFNode*> * getAllSub(const std::string& _query)
 	{
-		//Vector <WTFNode*> vSubs = new Vector <WTFNode*> ();
-
 		// Top-level layer
 		if (_query.size() == 0)
 		{
@@ -336,31 +547,16 @@ class WTFManager
 			}
 		}
 		
-		//Namespaced layer
-		//break query into delimiters.
-		Vector <std::string> * vPath = delimitPath(_query);
-		
-		for (int i=0;i<vRoot.size();++i)
-		{
-			// we found matching root node, search into here.
-			if ( vRoot(i)->getID() == (*vPath)(0) )
-			{
-				vPath->eraseSlot(0);
-				return vRoot(i)->getAll(vPath);
-			}
-		}
-		
-		delete vPath;
-		return 0;
-
+		WTFNode* node = getNode(_query);
+		if ( node==0 )
+		{ return 0; }
+		return &node->vSubRaw;
 	}
 	
 	// return random node on the given namespace.
 	// For example if we have COLOUR.RED, COLOUR.GREEN and COLOUR.BLUE
 	// and call getRandom("COLOUR"), we should get either the RED, GREEN, or BLUE nodes.
-	// namespaces should be divided using colon, eg:
-	// COLOUR:RED
-	WTFNode* getRandom(std::string _query, RandomInterface& rng)
+	WTFNode* getRandom(const std::string& _query, RandomInterface& rng)
 	{
 		
 		// Top-level random
@@ -378,22 +574,10 @@ class WTFManager
 			}
 		}
 		
-		//Namespaced random
-		//break query into delimiters.
-		Vector <std::string> * vPath = delimitPath(_query);
-		
-		for (int i=0;i<vRoot.size();++i)
-		{
-			// we found matching root node, search into here.
-			if ( vRoot(i)->getID() == (*vPath)(0) )
-			{
-				vPath->eraseSlot(0);
-				return vRoot(i)->getRandom(vPath,rng);
-			}
-		}
-		
-		delete vPath;
-		return 0;
+		WTFNode* node = getNode(_query);
+		if ( node==0 )
+		{ return 0; }
+		return node->getRandomSub(rng);
 	}
 	
 };
@@ -16,6 +16,10 @@
 
 class WTFNode
 {
+	friend class WTFManager; // WTFManager::parse() builds the nodes directly.
+	friend class WTFPathIndex;
+	friend class WTFImage;
+	
 	private:
 	WTFNode* parent;
 	
@@ -44,7 +48,8 @@ class WTFNode
 	
 	//parse the top layer and then recurse down to sub-raws.
 	// return false if the data is invalid.
-	// the raw data should be stripped by this point by the rawmanager.
+	// the raw data should be stripped by this point.
+	// WTFManager doesn't use this, it parses all nodes in a single pass.
 	bool parse(std::string input, WTFNode* _parent=0)
 	{
 		parent = _parent;
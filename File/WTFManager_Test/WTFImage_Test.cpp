@@ -0,0 +1,142 @@
+#include <File/WTFImage.hpp>
+#include <File/FileManagerStatic.hpp>
+
+#include <Math/Random/RandomLehmer.hpp>
+#include <System/Time/Timer.hpp>
+
+#include <string>
+#include <iostream>
+#include <cstdio>
+
+// g++ WTFImage_Test.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX
+
+// Test of compiled raws. Compiles generated raws to an image, checks that every path gives the same result from the
+// image as from WTFManager, and that stale or damaged images aren't loaded. Then times parsing against loading.
+
+const int N_CREATURES = 20000;
+const std::string imagePath = "WTFImage_Test.wtfi";
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+std::string generateRaws(const int nCreatures)
+{
+	std::string raws = "Generated raws for WTFImage_Test.\n\n[CREATURE\n";
+	for (int i=0;i<nCreatures;++i)
+	{
+		raws+="\t[C"+std::to_string(i)+":\n";
+		raws+="\t\t[NAME:\"Creature number "+std::to_string(i)+"\",\"Creatures\"]\n";
+		raws+="\t\t[AGE:"+std::to_string(i%100)+"]\n";
+		raws+="\t\t[RGB:"+std::to_string(i%256)+","+std::to_string((i*3)%256)+","+std::to_string((i*7)%256)+"]\n";
+		raws+="\t\t[MAMMAL]\n";
+		raws+="\t\t[BODY\n\t\t\t[HEAD:1]\n\t\t\t[LEGS:4]\n\t\t\t[TAIL]\n\t\t]\n";
+		raws+="\t]\n";
+	}
+	raws+="]\n[COLOUR\n\t[RED:255,0,0]\n\t[GREEN:0,255,0]\n]\n[COLOUR\n\t[BLUE:0,0,255]\n]\n";
+	return raws;
+}
+
+// Compare the node and everything under it.
+bool matches(WTFManager& manager, WTFImage& image, WTFNode* node, const std::string path, int& nCompared)
+{
+	++nCompared;
+	const unsigned int imageNode = image.getNode(path);
+	if ( imageNode==WTFImage::NONE || image.getID(imageNode)!=node->getID() )
+	{ return false; }
+	if ( manager.getValue(path)!=image.getValue(path) )
+	{ return false; }
+	Vector <std::string>* vManager = manager.getValues(path);
+	Vector <std::string>* vImage = image.getValues(path);
+	bool same = (vManager==0)==(vImage==0);
+	if ( same && vManager!=0 )
+	{
+		same = vManager->size()==vImage->size();
+		for (int i=0;same && i<vManager->size();++i)
+		{ same = (*vManager)(i)==(*vImage)(i); }
+	}
+	delete vManager;
+	delete vImage;
+	if ( same==false )
+	{ return false; }
+
+	Vector <WTFNode*>* vSub = manager.getAllSub(path);
+	if ( vSub==0 || (unsigned int)vSub->size()!=image.nSubs(imageNode) )
+	{ return false; }
+	for (int i=0;i<vSub->size();++i)
+	{
+		// duplicate paths only compare the first node.
+		const std::string subPath = path+"."+(*vSub)(i)->getID();
+		if ( manager.getNode(subPath)==(*vSub)(i) && matches(manager,image,(*vSub)(i),subPath,nCompared)==false )
+		{ return false; }
+	}
+	return true;
+}
+
+int main (int nArgs, char ** arg)
+{
+	std::remove(imagePath.c_str());
+	const std::string raws = generateRaws(N_CREATURES);
+	Timer timer;
+
+	WTFManager manager;
+	timer.init();
+	timer.start();
+	manager.parse(raws);
+	timer.update();
+	const double parseSeconds = timer.fullSeconds;
+
+	WTFImage image;
+	check("No image to load yet", image.load(imagePath,WTFImage::hashSource(raws))==false);
+	check("Open compiles the image", image.open(imagePath,raws) && image.isLoaded());
+
+	image.close();
+	timer.init();
+	timer.start();
+	const std::string sourceHash = WTFImage::hashSource(raws);
+	timer.update();
+	const double hashSeconds = timer.fullSeconds;
+	timer.init();
+	timer.start();
+	const bool loaded = image.load(imagePath,sourceHash);
+	timer.update();
+	const double loadSeconds = timer.fullSeconds;
+	check("Load the compiled image", loaded);
+
+	int nCompared = 0;
+	bool allMatch = image.nRoots()==3;
+	Vector <WTFNode*>* vRoot = manager.getAllSub("");
+	for (int i=0;allMatch && i<vRoot->size();++i)
+	{
+		if ( manager.getNode((*vRoot)(i)->getID())==(*vRoot)(i) )
+		{ allMatch = matches(manager,image,(*vRoot)(i),(*vRoot)(i)->getID(),nCompared); }
+	}
+	check("All "+std::to_string(nCompared)+" paths match WTFManager", allMatch);
+	check("Missing paths", image.hasTag("CREATURE.C20000")==false && image.getValue("CREATURE.C1.WINGS")=="" && image.getValues("X")==0);
+	check("Duplicate roots are merged", image.hasTag("COLOUR.RED") && image.getValue("COLOUR.BLUE")=="0" && manager.hasTag("COLOUR.BLUE"));
+
+	RandomLehmer rng;
+	rng.seed(0);
+	const unsigned int randomNode = image.getRandom("CREATURE",rng);
+	check("Random sub-node", randomNode!=WTFImage::NONE && image.getParent(randomNode)==image.getNode("CREATURE"));
+
+	const std::string changedRaws = raws+"[NEW:1]";
+	check("Changed source doesn't load the old image", image.load(imagePath,WTFImage::hashSource(changedRaws))==false);
+	check("Open recompiles changed source", image.open(imagePath,changedRaws) && image.getValue("NEW")=="1");
+	image.close();
+
+	std::string imageData = FileManagerStatic::getFile(imagePath);
+	imageData[imageData.size()/2]^=1;
+	FileManagerStatic::writeFreshString(imageData,imagePath);
+	check("Damaged image doesn't load", image.load(imagePath,WTFImage::hashSource(changedRaws))==false);
+
+	std::cout<<raws.size()/1024<<" KB of raws. Parse: "<<parseSeconds<<"s. md5: "<<hashSeconds<<"s. Load image: "<<loadSeconds<<"s.\n";
+
+	std::remove(imagePath.c_str());
+	std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+	return nFailed==0 ? 0 : 1;
+}
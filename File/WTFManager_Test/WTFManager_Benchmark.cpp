@@ -0,0 +1,110 @@
+#include "../WTFManager.hpp"
+
+#include <Math/Random/RandomLehmer.hpp>
+#include <System/Time/Timer.hpp>
+
+#include <string>
+#include <iostream>
+
+// g++ WTFManager_Benchmark.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX
+
+// Benchmark for WTFManager. Generates a few megabytes of raws, then times parsing them and looking up paths.
+
+const int N_CREATURES = 20000;
+const int N_LOOKUPS = 1000000;
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+std::string generateRaws()
+{
+	std::string raws = "Generated raws for WTFManager_Benchmark.\n\n[CREATURE\n";
+	for (int i=0;i<N_CREATURES;++i)
+	{
+		const std::string id = "C"+std::to_string(i);
+		raws+="\t["+id+":\n";
+		raws+="\t\t[NAME:\"Creature number "+std::to_string(i)+"\",\"Creatures\"] comment\n";
+		raws+="\t\t[DESCRIPTION:\"A generated creature, with [brackets] and, commas in quotes.\"]\n";
+		raws+="\t\t[AGE:"+std::to_string(i%100)+"]\n";
+		raws+="\t\t[RGB:"+std::to_string(i%256)+","+std::to_string((i*3)%256)+","+std::to_string((i*7)%256)+"]\n";
+		raws+="\t\t[MAMMAL]\n";
+		raws+="\t\t[BODY\n";
+		raws+="\t\t\t[HEAD:1]\n\t\t\t[LEGS:4]\n\t\t\t[TAIL]\n";
+		raws+="\t\t]\n";
+		raws+="\t]\n";
+	}
+	raws+="]\n";
+	return raws;
+}
+
+int main (int nArgs, char ** arg)
+{
+	const std::string raws = generateRaws();
+	std::cout<<"Generated "<<raws.size()/1024<<" KB of raws with "<<N_CREATURES<<" creatures.\n";
+	
+	Timer timer;
+	WTFManager wtfManager;
+	
+	timer.init();
+	timer.start();
+	const bool parsed = wtfManager.parse(raws);
+	timer.update();
+	std::cout<<"Parse: "<<timer.fullSeconds<<" seconds.\n";
+	
+	check("Parsed", parsed);
+	check("getValue", wtfManager.getValue("CREATURE.C1234.AGE")=="34"
+		&& wtfManager.getValue("CREATURE.C5.NAME")=="\"Creature number 5\"");
+	check("Missing getValue is blank", wtfManager.getValue("CREATURE.C1234.WINGS")=="");
+	Vector <std::string>* vValue = wtfManager.getValues("CREATURE.C10.RGB");
+	check("getValues", vValue!=0 && vValue->size()==3 && (*vValue)(0)=="10" && (*vValue)(2)=="70");
+	delete vValue;
+	check("hasTag", wtfManager.hasTag("CREATURE.C19999.BODY.TAIL") && wtfManager.hasTag("CREATURE.C20000")==false);
+	Vector <WTFNode*>* vSub = wtfManager.getAllSub("CREATURE");
+	check("getAllSub", vSub!=0 && vSub->size()==N_CREATURES);
+	
+	RandomLehmer rng;
+	rng.seed(0);
+	Vector <std::string> vQuery;
+	for (int i=0;i<1000;++i)
+	{ vQuery.push("CREATURE.C"+std::to_string(rng.rand32(N_CREATURES-1))+".BODY.LEGS"); }
+	
+	timer.init();
+	timer.start();
+	long int total = 0;
+	for (int i=0;i<N_LOOKUPS;++i)
+	{ total+=wtfManager.getValue(vQuery(i%1000)).size(); }
+	timer.update();
+	std::cout<<N_LOOKUPS<<" getValue: "<<timer.fullSeconds<<" seconds.\n";
+	check("Lookups found values", total==N_LOOKUPS);
+	
+	timer.init();
+	timer.start();
+	int nFound = 0;
+	for (int i=0;i<N_LOOKUPS;++i)
+	{ nFound+=wtfManager.hasTag(vQuery(i%1000)); }
+	timer.update();
+	std::cout<<N_LOOKUPS<<" hasTag: "<<timer.fullSeconds<<" seconds.\n";
+	check("Tags found", nFound==N_LOOKUPS);
+	
+	// A failed parse only removes its own nodes.
+	const std::string before = wtfManager.getAll();
+	std::cout<<"Expect 4 errors:\n";
+	check("Too many closing brackets", wtfManager.parse("[EXTRA[A:1]][B]]")==false);
+	check("No ID", wtfManager.parse("[NEW[X][]]")==false);
+	check("Bad bracket count", wtfManager.parse("[NEW[X:\"1\"]")==false);
+	check("Failure under an existing path", wtfManager.parse("[CREATURE[C5[WINGS:2]]]]")==false);
+	check("Failed parses leave the old raws", wtfManager.getAll()==before
+		&& wtfManager.getValue("CREATURE.C1234.AGE")=="34" && wtfManager.hasTag("CREATURE.C19999.BODY.TAIL"));
+	check("Failed parses leave no paths", wtfManager.hasTag("EXTRA")==false && wtfManager.hasTag("EXTRA.A")==false
+		&& wtfManager.hasTag("B")==false && wtfManager.hasTag("NEW.X")==false && wtfManager.hasTag("CREATURE.C5.WINGS")==false);
+	check("Parsing after a failure", wtfManager.parse("[LATE:1]") && wtfManager.getValue("LATE")=="1"
+		&& wtfManager.getValue("CREATURE.C5.AGE")=="5");
+	
+	std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+	return nFailed==0 ? 0 : 1;
+}
@@ -47,6 +47,14 @@ class BoardObject: public HasXY
 };
 
 
+	// SOMETHING THAT NEEDS TO KNOW WHEN A TILE CHANGES, FOR EXAMPLE BOARDVIEWER'S CACHED CHUNKS.
+class BoardObserver
+{
+	public:
+	virtual ~BoardObserver() {}
+	virtual void tileChanged(const int _x, const int _y) =0;
+};
+
 class Board
 {
 	public:
@@ -54,6 +62,8 @@ class Board
 	
 	ArrayS2 <char> aTravelRule;
 	
+	Vector <BoardObserver*> vObserver;
+	
 	Board()
 	{
 	}
@@ -65,11 +75,23 @@ class Board
 		
 		//for ( int 
 	}
+	void addObserver(BoardObserver* _observer)
+	{
+		vObserver.push(_observer);
+	}
 	void teleportObject(BoardObject* _boardObject, const int _teleportX, const int _teleportY)
 	{
+		const int oldX = _boardObject->x;
+		const int oldY = _boardObject->y;
 		
 		_boardObject->setCoordinates(_teleportX,_teleportY);
 		//aBoardObject->push(_boardObject);
+		
+		for (int i=0;i<vObserver.size();++i)
+		{
+			vObserver(i)->tileChanged(oldX,oldY);
+			vObserver(i)->tileChanged(_teleportX,_teleportY);
+		}
 	}
 	void removeObject( BoardObject* _boardObject )
 	{
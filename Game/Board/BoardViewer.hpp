@@ -7,6 +7,11 @@
 #include <Device/Mouse/MouseInterface.hpp>
 #include <Render/Renderer.hpp>
 #include <Interface/HasTexture.hpp>
+#include <Game/Board/Board.hpp>
+#include <Game/Board/BoardViewer_LOD.hpp>
+#include <Game/Board/BoardViewer_ChunkCache.hpp>
+
+#include <vector>
 
 /*
 	#include <BoardViewer/BoardViewer.hpp>
@@ -15,6 +20,10 @@
 
 	This class is useful because many of my games use this 'board' approach to rendering the world. However, there are performance issues in some cases, such as rendering a million tiles when the player is zoomed out very far. I am thinking about a solution for this.
 
+	UPDATE: When tileSize is below lodTileSize, which is 0 (off) by default, the board is drawn from BoardViewer_LOD instead, which is one texel per tile, so the cost depends on the screen size rather than the number of tiles. Call markTile() whenever something on a tile changes, so the LOD image stays up to date. Overlays and grid mode aren't drawn in this mode.
+
+	UPDATE: Above lodTileSize, the board is drawn from BoardViewer_ChunkCache if chunkCaching is on. It is off by default. Chunks of the board are pre-rendered into textures, and only the tiles passed to markTile() are drawn again, so panning and zooming just composite the chunks. Fog of war and the grid are drawn as single layers over the whole board. Board::teleportObject() marks tiles automatically if the viewer is added with Board::addObserver(), but adding and removing objects, fog of war changes and animated textures don't, so only turn chunkCaching on if the game marks those tiles itself.
+
 	GridMode also suffers here. Instead of manually drawing a grid texture over each tile, we need to overlay a single grid texture over the while board. This will require dynamic texture creation at runtime, which I feel is the next step to improving performance. A tile based game will not update fluidly, but over discrete turns, so when a turn takes place, the board can be pre-rendered and then only that texture needs to be displayed for the next 30 frames or so. The only issue is zooming and panning over this pre-rendered texture.
 
 	Okay... So I'm going to use the following principle...
@@ -108,9 +117,9 @@ class RenderLast
 	
 	int x1,y1,x2,y2;
 
-	int tex;
+	Texture* tex;
 
-	RenderLast ( const int _x1, const int _y1, const int _x2, const int _y2, const int _tex )
+	RenderLast ( const int _x1, const int _y1, const int _x2, const int _y2, Texture* _tex )
 	{
 		x1=_x1;
 		y1=_y1;
@@ -121,17 +130,7 @@ class RenderLast
 
 	void render()
 	{
-		glBindTexture( GL_TEXTURE_2D, tex);
-		glBegin(GL_QUADS);
-			glTexCoord2s(0,1);
-			glVertex2s(x1,y1);
-			glTexCoord2s(1,1);
-			glVertex2s(x2,y1);
-			glTexCoord2s(1,0);
-			glVertex2s(x2,y2);
-			glTexCoord2s(0,0);
-			glVertex2s(x1,y2);
-		glEnd();
+		Renderer::placeTexture4(x1,y1,x2,y2,tex,false);
 	}
 };
 
@@ -157,7 +156,7 @@ class RenderLast
 
 /* Made it a GUI class, since it now functions in GUIs. */
 template <class T>
-class BoardViewer: public DisplayInterface, public MouseInterface
+class BoardViewer: public DisplayInterface, public MouseInterface, public BoardObserver
 {
 	public:
 
@@ -225,6 +224,18 @@ class BoardViewer: public DisplayInterface, public MouseInterface
 
 	int MIN_ZOOM, MAX_ZOOM;
 
+		// LEVEL OF DETAIL. BELOW THIS TILE SIZE THE BOARD IS DRAWN FROM THE LOD IMAGES. 0 TURNS IT OFF.
+	int lodTileSize;
+	BoardViewer_LOD <T> lod;
+
+		// PRE-RENDERED CHUNKS OF THE BOARD. CHUNKTILES IS THE NUMBER OF TILES ACROSS A CHUNK.
+	bool chunkCaching;
+	int chunkTiles;
+	BoardViewer_ChunkCache <T> chunkCache;
+
+		// OVERSIZED TEXTURES TO DRAW AFTER THE TILES. KEPT TO AVOID ALLOCATING EVERY FRAME.
+	std::vector <RenderLast> vRenderLast;
+
 	BoardViewer()
 	{
 		active=false;
@@ -270,6 +281,30 @@ class BoardViewer: public DisplayInterface, public MouseInterface
 		MAX_ZOOM = 16;
 		normaliseZoom();
 
+		lodTileSize = 0;
+
+		chunkCaching = false;
+		chunkTiles = 32;
+
+	}
+
+		/* Tell the LOD images that something on the tile has changed. */
+	inline void markTile(const int _x, const int _y)
+	{
+		lod.markTile(_x,_y);
+		chunkCache.markTile(_x,_y);
+	}
+	void tileChanged(const int _x, const int _y) override
+	{
+		markTile(_x,_y);
+	}
+		/* Redo the LOD images for the whole board, for example after loading. */
+	void markAllTiles()
+	{
+		if ( aBoard==0 ) { return; }
+		// Caches which aren't for this board yet are built in full the first time they're drawn.
+		if ( lod.isFor(aBoard,aFogOfWar) ) { lod.markAll(); }
+		if ( chunkCache.isFor(aBoard,aFogOfWar) ) { chunkCache.markAll(); }
 	}
 
 	void toggleGrid()
@@ -551,9 +586,28 @@ class BoardViewer: public DisplayInterface, public MouseInterface
 			/* Pixel coords for leftmost tile. */
 		Renderer::setTextureMode();
 
+		vRenderLast.clear();
+
+		if ( tileSize < lodTileSize )
+		{
+			renderLOD(tileX,tileY,pixelOffsetX,pixelOffsetY);
+			Renderer::restoreViewPort();
+			normaliseCoordinates();
+			return;
+		}
+		if ( chunkCaching )
+		{
+			renderChunks(tileX,tileY,pixelOffsetX,pixelOffsetY);
+			Renderer::restoreViewPort();
+			normaliseCoordinates();
+			return;
+		}
+
 		const short unsigned int aBoardNZ = aBoard->nZ;
 
-		Vector <RenderLast*> vLast;
+			// Tiles don't overlap, so quads can be grouped by texture as long as each tile draws its quads in
+			// order. The nth quad on each tile goes in layer n.
+		Renderer::beginBatch(true);
 
 		//for (short int currentY = -pixelOffsetY; currentY<mainViewNY; currentY+=tileSize)
 		for (short int currentY = pixelOffsetY; currentY <= mainViewY2; currentY+=tileSize)
@@ -561,6 +615,7 @@ class BoardViewer: public DisplayInterface, public MouseInterface
 			//for (short int currentX = pixelOffsetX; currentX<mainViewNX+tileSize; currentX+=tileSize)
 			for (short int currentX = pixelOffsetX; currentX <= mainViewX2; currentX+=tileSize)
 			{
+					int layer = 0;
 					//std::cout<<"\n";
 						// OUT OF BOUNDS/NULL RENDER
 					if ( aBoard->isSafe(tileX,tileY,0)==false || (*aBoard)(tileX,tileY,0)==0 )
@@ -580,6 +635,7 @@ class BoardViewer: public DisplayInterface, public MouseInterface
 						//std::cout<<"2\n";
 						// FOG OF WAR
 						Renderer::setColourMode();
+						Renderer::setBatchLayer(layer++);
 						Renderer::placeColour4a(0,0,0,0,currentX,currentY,currentX+tileSize,currentY+tileSize);
 						Renderer::setTextureMode();
 
@@ -601,39 +657,17 @@ class BoardViewer: public DisplayInterface, public MouseInterface
 									// ONLY RENDER SOMETHING IF IT HAS A TEXTURE.
 									if ( (*(*aBoard)(tileX,tileY,_z))(i)->currentTexture()!=0 )
 									{
-										//Renderer::placeTexture4(currentX,currentY,currentX+tileSize,currentY+tileSize, (*(*aBoard)(tileX,tileY,_z))(i),false);
-
-										//INLINED CODE FOR PERFORMANCE
-										glBindTexture( GL_TEXTURE_2D, (*(*aBoard)(tileX,tileY,_z))(i)->currentTexture()->textureID);
+										Texture* texture = (*(*aBoard)(tileX,tileY,_z))(i)->currentTexture();
 
 										if ( (*(*aBoard)(tileX,tileY,_z))(i)->getMinSize() > tileSize )
 										{
 											const int offset = (*(*aBoard)(tileX,tileY,_z))(i)->getMinSize() / 2;
-											vLast.push(new RenderLast(currentX-offset,currentY-offset,currentX+offset,currentY+offset,(*(*aBoard)(tileX,tileY,_z))(i)->currentTexture()->textureID));
-											
-											// glBegin(GL_QUADS);
-												// glTexCoord2s(0,1);
-												// glVertex2s(currentX-offset,currentY-offset);
-												// glTexCoord2s(1,1);
-												// glVertex2s(currentX+offset,currentY-offset);
-												// glTexCoord2s(1,0);
-												// glVertex2s(currentX+offset,currentY+offset);
-												// glTexCoord2s(0,0);
-												// glVertex2s(currentX-offset,currentY+offset);
-											// glEnd();
+											vRenderLast.push_back(RenderLast(currentX-offset,currentY-offset,currentX+offset,currentY+offset,texture));
 										}
 										else
 										{
-											glBegin(GL_QUADS);
-												glTexCoord2s(0,1);
-												glVertex2s(currentX,currentY);
-												glTexCoord2s(1,1);
-												glVertex2s(currentX+tileSize,currentY);
-												glTexCoord2s(1,0);
-												glVertex2s(currentX+tileSize,currentY+tileSize);
-												glTexCoord2s(0,0);
-												glVertex2s(currentX,currentY+tileSize);
-											glEnd();
+											Renderer::setBatchLayer(layer++);
+											Renderer::placeTexture4(currentX,currentY,currentX+tileSize,currentY+tileSize,texture,false);
 										}
 									}
 								}
@@ -644,6 +678,7 @@ class BoardViewer: public DisplayInterface, public MouseInterface
 						{
 							// PARTIAL FOG
 							Renderer::setColourMode();
+							Renderer::setBatchLayer(layer++);
 							Renderer::placeColour4a(0,0,0,120,currentX,currentY,currentX+tileSize,currentY+tileSize);
 							Renderer::setTextureMode();
 
@@ -651,54 +686,7 @@ class BoardViewer: public DisplayInterface, public MouseInterface
 
 						}
 
-							// STATIC OVERLAY RENDERING.
-
-						if ( overlayActive==true && aOverlay != 0 )
-						{
-							if ( (*aOverlay)(tileX,tileY)!=0 )
-							{
-								Renderer::placeTexture4(currentX,currentY,currentX+tileSize,currentY+tileSize, (*aOverlay)(tileX,tileY));
-							}
-						}
-
-							// DYNAMIC OVERLAY RENDERING.
-
-						if (squareOverlay==true && squareOverlayTexture != 0 && squareOverlayRange!=0)
-						{
-							const int borderX1 = hoveredXTile-squareOverlayRange;
-							const int borderX2 = hoveredXTile+squareOverlayRange;
-
-							const int borderY1 = hoveredYTile-squareOverlayRange;
-							const int borderY2 = hoveredYTile+squareOverlayRange;
-
-
-								// SQUARE BORDER OVERLAY.
-							if ( tileX<=borderX2 && tileX >=borderX1 && tileY <=borderY2 && tileY >=borderY1 )
-							{
-									// BORDER
-								if ( tileX==borderX1 || tileX==borderX2 || tileY==borderY1 ||tileY==borderY2 )
-								{
-									Renderer::setColourMode();
-									Renderer::placeColour4a(0,0,0,100,currentX,currentY,currentX+tileSize,currentY+tileSize);
-									Renderer::setTextureMode();
-								}
-									// INNER BIT
-								else
-								{
-									Renderer::setColourMode();
-									Renderer::placeColour4a(0,0,0,60,currentX,currentY,currentX+tileSize,currentY+tileSize);
-									Renderer::setTextureMode();
-								}
-							}
-							// if (
-								// (tileX<=hoveredXTile+squareOverlayRange)&&(tileX>=hoveredXTile-squareOverlayRange)
-							// &&(tileY<=hoveredYTile+squareOverlayRange)&&(tileY>=hoveredYTile-squareOverlayRange)
-								// )
-							// {
-								// if ( tileX==hovered
-
-							// }
-						}
+						renderOverlays(tileX,tileY,currentX,currentY,layer);
 
 	//bool squareOverlay;
 	//	Texture * squareOverlayTexture;
@@ -709,6 +697,7 @@ class BoardViewer: public DisplayInterface, public MouseInterface
 					{
 							//Renderer::placeColour4a(255,0,0,100,currentX,currentY,currentX+tileSize,currentY+tileSize);
 
+							Renderer::setBatchLayer(layer++);
 							Renderer::placeTexture4(currentX,currentY,currentX+tileSize,currentY+tileSize,&TEX_OVERLAY_GRID,false);
 					}
 
@@ -719,10 +708,11 @@ class BoardViewer: public DisplayInterface, public MouseInterface
 			++tileY;
 		}
 		
-		for (int i=0;i<vLast.size();++i)
-		{
-			vLast(i)->render();
-		}
+		Renderer::endBatch();
+
+			// Oversized textures can overlap each other, so they are drawn in order.
+		for (unsigned int i=0;i<vRenderLast.size();++i)
+		{ vRenderLast[i].render(); }
 
 		// DRAW A REFERENCE CENTER POINT.
 		//const int centerX = mainViewNX/2;
@@ -745,6 +735,200 @@ class BoardViewer: public DisplayInterface, public MouseInterface
 		normaliseCoordinates();
 	}
 
+		/* Zoomed out rendering. The whole board is one LOD image, with important objects drawn over it. */
+	void renderLOD(const int _tileX, const int _tileY, const int _pixelOffsetX, const int _pixelOffsetY)
+	{
+		if ( lod.isFor(aBoard,aFogOfWar)==false )
+		{ lod.init(aBoard,aFogOfWar); }
+		if ( lod.nLevels()==0 ) { return; }
+
+		lod.update();
+		const int level = lod.chooseLevel();
+		lod.upload(level);
+		Texture* image = lod.getLevel(level);
+
+			// PIXEL COORDS OF THE BOTTOM LEFT OF TILE (0,0). EACH TEXEL OF THE LEVEL COVERS 2^LEVEL TILES.
+		const int boardX1 = _pixelOffsetX - _tileX*tileSize;
+		const int boardY1 = _pixelOffsetY - _tileY*tileSize;
+		const int texelSize = tileSize<<level;
+		Renderer::placeTexture4(boardX1,boardY1,boardX1+image->nX*texelSize,boardY1+image->nY*texelSize,image,false);
+
+		renderImportant(lod.getImportant(),boardX1,boardY1);
+	}
+
+		/* Objects with a min size above 1 are drawn over everything else, at their min size if the tiles are smaller. */
+	void renderImportant(const std::set <int>& sImportant, const int boardX1, const int boardY1)
+	{
+		for (std::set<int>::const_iterator it=sImportant.begin();it!=sImportant.end();++it)
+		{
+			const int tileX = *it % aBoard->nX;
+			const int tileY = *it / aBoard->nX;
+			const int currentX = boardX1 + tileX*tileSize;
+			const int currentY = boardY1 + tileY*tileSize;
+
+			for ( unsigned short int _z=0;_z<aBoard->nZ;++_z)
+			{
+				Vector <T> * vObject = (*aBoard)(tileX,tileY,_z);
+				if ( vObject==0 ) { continue; }
+				for ( int i=0;i<vObject->size();++i )
+				{
+					Texture* texture = (*vObject)(i)->currentTexture();
+					const int minSize = (*vObject)(i)->getMinSize();
+					if ( texture==0 || minSize <= 1 ) { continue; }
+					if ( minSize <= tileSize )
+					{
+						vRenderLast.push_back(RenderLast(currentX,currentY,currentX+tileSize,currentY+tileSize,texture));
+						continue;
+					}
+					const int offset = minSize / 2;
+					if ( currentX+offset < 0 || currentY+offset < 0 || currentX-offset > mainViewX2 || currentY-offset > mainViewY2 )
+					{ continue; }
+					vRenderLast.push_back(RenderLast(currentX-offset,currentY-offset,currentX+offset,currentY+offset,texture));
+				}
+			}
+		}
+		for (unsigned int i=0;i<vRenderLast.size();++i)
+		{ vRenderLast[i].render(); }
+	}
+
+		/* Cached rendering. Visible chunks are drawn as one quad each, then fog of war, overlays and the grid. */
+	void renderChunks(const int _tileX, const int _tileY, const int _pixelOffsetX, const int _pixelOffsetY)
+	{
+		if ( chunkCache.isFor(aBoard,aFogOfWar)==false )
+		{ chunkCache.init(aBoard,aFogOfWar,chunkTiles); }
+
+		const int boardX1 = _pixelOffsetX - _tileX*tileSize;
+		const int boardY1 = _pixelOffsetY - _tileY*tileSize;
+		const int boardX2 = boardX1 + aBoard->nX*tileSize;
+		const int boardY2 = boardY1 + aBoard->nY*tileSize;
+
+			// CHUNKS
+		const int pixelsPerTile = chunkCache.pixelsPerTileFor(tileSize);
+		const int chunkSize = chunkCache.getChunkTiles()*tileSize;
+		const int chunkX1 = std::max(0,-boardX1/chunkSize);
+		const int chunkY1 = std::max(0,-boardY1/chunkSize);
+		const int chunkX2 = std::min(chunkCache.getNChunksX()-1,(mainViewX2-boardX1)/chunkSize);
+		const int chunkY2 = std::min(chunkCache.getNChunksY()-1,(mainViewY2-boardY1)/chunkSize);
+
+		Renderer::beginBatch(true);
+		for (int chunkY=chunkY1;chunkY<=chunkY2;++chunkY)
+		{
+			for (int chunkX=chunkX1;chunkX<=chunkX2;++chunkX)
+			{
+				Texture* image = chunkCache.getChunk(chunkX,chunkY,pixelsPerTile);
+				if ( image==0 ) { continue; }
+				const int x1 = boardX1 + chunkX*chunkSize;
+				const int y1 = boardY1 + chunkY*chunkSize;
+				Renderer::placeTexture4(x1,y1,x1+image->nX/pixelsPerTile*tileSize,y1+image->nY/pixelsPerTile*tileSize,image,false);
+			}
+		}
+		Renderer::endBatch();
+		chunkCache.nextFrame();
+
+			// FOG OF WAR
+		Texture* fogLayer = chunkCache.getFogLayer();
+		if ( fogLayer!=0 )
+		{ Renderer::placeTexture4(boardX1,boardY1,boardX2,boardY2,fogLayer,false); }
+
+			// OVERLAYS ARE STILL DONE PER TILE, BUT ONLY IF THEY'RE ON. THE GRID TEXTURE CAN ONLY REPEAT IF IT'S NOT IN AN ATLAS.
+		const bool gridLayer = TEX_OVERLAY_GRID.u1==0 && TEX_OVERLAY_GRID.v1==0 && TEX_OVERLAY_GRID.u2==1 && TEX_OVERLAY_GRID.v2==1;
+		const bool drawOverlays = (overlayActive==true && aOverlay!=0) || (squareOverlay==true && squareOverlayTexture!=0 && squareOverlayRange!=0);
+		if ( drawOverlays || (gridMode==true && gridLayer==false) )
+		{
+			Renderer::beginBatch(true);
+			int tileY = _tileY;
+			for (int currentY = _pixelOffsetY; currentY <= mainViewY2; currentY+=tileSize)
+			{
+				int tileX = _tileX;
+				for (int currentX = _pixelOffsetX; currentX <= mainViewX2; currentX+=tileSize)
+				{
+					int layer = 0;
+					if ( aBoard->isSafe(tileX,tileY,0) && (*aBoard)(tileX,tileY,0)!=0
+						&& (aFogOfWar==0 || aFogOfWar->isSafe(tileX,tileY)==false || (*aFogOfWar)(tileX,tileY)!=0) )
+					{ renderOverlays(tileX,tileY,currentX,currentY,layer); }
+					if ( gridMode==true && gridLayer==false )
+					{
+						Renderer::setBatchLayer(layer++);
+						Renderer::placeTexture4(currentX,currentY,currentX+tileSize,currentY+tileSize,&TEX_OVERLAY_GRID,false);
+					}
+					++tileX;
+				}
+				++tileY;
+			}
+			Renderer::endBatch();
+		}
+
+			// GRID, AS ONE QUAD WITH THE TEXTURE REPEATED ONCE PER TILE.
+		if ( gridMode==true && gridLayer==true )
+		{
+			Texture grid;
+			grid.textureID = TEX_OVERLAY_GRID.textureID;
+			grid.nX = TEX_OVERLAY_GRID.nX;
+			grid.nY = TEX_OVERLAY_GRID.nY;
+			grid.u2 = aBoard->nX;
+			grid.v2 = aBoard->nY;
+			Renderer::placeTexture4(boardX1,boardY1,boardX2,boardY2,&grid,false);
+		}
+
+		renderImportant(chunkCache.getImportant(),boardX1,boardY1);
+	}
+
+		/* Overlays which are drawn over a tile. */
+	void renderOverlays(const int tileX, const int tileY, const int currentX, const int currentY, int& layer)
+	{
+			// STATIC OVERLAY RENDERING.
+
+		if ( overlayActive==true && aOverlay != 0 )
+		{
+			if ( (*aOverlay)(tileX,tileY)!=0 )
+			{
+				Renderer::setBatchLayer(layer++);
+				Renderer::placeTexture4(currentX,currentY,currentX+tileSize,currentY+tileSize, (*aOverlay)(tileX,tileY));
+			}
+		}
+
+			// DYNAMIC OVERLAY RENDERING.
+
+		if (squareOverlay==true && squareOverlayTexture != 0 && squareOverlayRange!=0)
+		{
+			const int borderX1 = hoveredXTile-squareOverlayRange;
+			const int borderX2 = hoveredXTile+squareOverlayRange;
+
+			const int borderY1 = hoveredYTile-squareOverlayRange;
+			const int borderY2 = hoveredYTile+squareOverlayRange;
+
+
+				// SQUARE BORDER OVERLAY.
+			if ( tileX<=borderX2 && tileX >=borderX1 && tileY <=borderY2 && tileY >=borderY1 )
+			{
+					// BORDER
+				if ( tileX==borderX1 || tileX==borderX2 || tileY==borderY1 ||tileY==borderY2 )
+				{
+					Renderer::setColourMode();
+					Renderer::setBatchLayer(layer++);
+					Renderer::placeColour4a(0,0,0,100,currentX,currentY,currentX+tileSize,currentY+tileSize);
+					Renderer::setTextureMode();
+				}
+					// INNER BIT
+				else
+				{
+					Renderer::setColourMode();
+					Renderer::setBatchLayer(layer++);
+					Renderer::placeColour4a(0,0,0,60,currentX,currentY,currentX+tileSize,currentY+tileSize);
+					Renderer::setTextureMode();
+				}
+			}
+			// if (
+				// (tileX<=hoveredXTile+squareOverlayRange)&&(tileX>=hoveredXTile-squareOverlayRange)
+			// &&(tileY<=hoveredYTile+squareOverlayRange)&&(tileY>=hoveredYTile-squareOverlayRange)
+				// )
+			// {
+				// if ( tileX==hovered
+
+			// }
+		}
+	}
+
 	void keyboardEvent(Keyboard* _keyboard)
 	{
 		//std::cout<<"KB EVENT()\n";
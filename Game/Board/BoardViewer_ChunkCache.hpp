@@ -0,0 +1,419 @@
+#pragma once
+#ifndef WILDCAT_BOARD_VIEWER_BOARD_VIEWER_CHUNK_CACHE_HPP
+#define WILDCAT_BOARD_VIEWER_BOARD_VIEWER_CHUNK_CACHE_HPP
+
+#include <Container/ArrayS2/ArrayS2.hpp>
+#include <Container/ArrayS3/ArrayS3.hpp>
+#include <Container/Vector/Vector.hpp>
+#include <Graphics/Texture/Texture.hpp>
+#include <Graphics/PixelScreen/PixelScreen_DirtyTexture.hpp>
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+/*
+	#include <Game/Board/BoardViewer_ChunkCache.hpp>
+
+	Pre-rendered chunks of the board for BoardViewer. The board is split into chunks of chunkTiles x chunkTiles tiles.
+	Each chunk is drawn once into an RGBA texture, so a frame only needs one quad per visible chunk instead of a quad
+	per object on every tile. Tile based games change the board over discrete turns, so most frames just composite
+	the cached chunks, and panning and zooming cost nothing extra.
+
+	markTile() queues a tile to be drawn again the next time its chunk is used. Only the changed tiles are drawn, and
+	only their blocks are uploaded through PixelScreen_DirtyTexture. Animated textures only change when their tile is
+	marked.
+
+	Chunks are drawn at pixelsPerTile, which is the tile size rounded up to a power of 2 and capped at
+	maxPixelsPerTile. Zooming in past the cached size draws the chunk again at the higher size. Objects are drawn
+	from their texture data in RAM, and textures without data are drawn as their average colour. Objects with a
+	min size above 1 are left out, because BoardViewer draws them over everything at every zoom level. Their tiles
+	are kept in a list, which markTile() keeps up to date.
+
+	Chunks are made when they are first drawn. If there are more than maxChunks, the ones used least recently are
+	deleted.
+
+	Fog of war is a separate layer with one texel per tile, drawn over the whole board as one quad. Hidden tiles are
+	black, and partly fogged tiles are black with alpha 120.
+
+	Image rows go from the top of the chunk to the bottom, so each image can be drawn with Renderer::placeTexture4().
+*/
+
+class BoardViewer_Chunk
+{
+	public:
+
+	Texture image;
+	PixelScreen_DirtyTexture upload;
+
+	int tileX, tileY; // bottom left tile
+	int nTilesX, nTilesY;
+	int pixelsPerTile; // 0 if it needs to be drawn in full
+
+	std::vector <int> vDirtyTile; // x+y*nTilesX, relative to the chunk
+	std::vector <unsigned char> vTileQueued;
+
+	unsigned long int lastUsed;
+
+	BoardViewer_Chunk(const int _tileX, const int _tileY, const int _nTilesX, const int _nTilesY)
+	{
+		tileX=_tileX;
+		tileY=_tileY;
+		nTilesX=_nTilesX;
+		nTilesY=_nTilesY;
+		pixelsPerTile=0;
+		vTileQueued.assign(nTilesX*nTilesY,0);
+		lastUsed=0;
+	}
+	~BoardViewer_Chunk()
+	{
+		upload.release();
+		delete [] image.data;
+	}
+};
+
+template <class T>
+class BoardViewer_ChunkCache
+{
+	private:
+
+	ArrayS3 < Vector < T > * > * aBoard;
+	ArrayS2 <char> * aFogOfWar;
+	int nX, nY;
+	int chunkTiles;
+	int nChunksX, nChunksY;
+
+	std::vector <BoardViewer_Chunk*> vChunk; // 0 if the chunk hasn't been made
+	std::vector <int> vLoaded; // chunks which have been made
+
+	unsigned long int frame;
+
+	Texture fogLayer;
+	PixelScreen_DirtyTexture fogUpload;
+
+	std::set <int> sImportant; // tiles with objects which have a min size above 1
+
+	void clear()
+	{
+		for (unsigned int i=0;i<vLoaded.size();++i)
+		{ delete vChunk[vLoaded[i]]; }
+		vChunk.clear();
+		vLoaded.clear();
+		fogUpload.release();
+		delete [] fogLayer.data;
+		fogLayer.data=0;
+		sImportant.clear();
+	}
+
+	// Draw _texture over a square of the image. _x and _y are the top left pixel.
+	static void drawTexture(Texture& _image, const int _x, const int _y, const int _size, Texture* _texture)
+	{
+		for (int y=0;y<_size;++y)
+		{
+			unsigned char* pixel = &_image.data[((_y+y)*_image.nX+_x)*4];
+			const unsigned char* sourceRow = 0;
+			if ( _texture->data!=0 && _texture->nX>0 && _texture->nY>0 )
+			{ sourceRow = &_texture->data[(y*_texture->nY/_size)*_texture->nX*4]; }
+
+			for (int x=0;x<_size;++x, pixel+=4)
+			{
+				unsigned char source[4] = {_texture->averageRed,_texture->averageGreen,_texture->averageBlue,255};
+				if ( sourceRow!=0 )
+				{
+					const unsigned char* texel = &sourceRow[(x*_texture->nX/_size)*4];
+					source[0]=texel[0];
+					source[1]=texel[1];
+					source[2]=texel[2];
+					source[3]=texel[3];
+				}
+
+				const unsigned int alpha = source[3];
+				if ( alpha==255 )
+				{
+					pixel[0]=source[0];
+					pixel[1]=source[1];
+					pixel[2]=source[2];
+					pixel[3]=255;
+				}
+				else if ( alpha>0 )
+				{
+					pixel[0]=(source[0]*alpha+pixel[0]*(255-alpha))/255;
+					pixel[1]=(source[1]*alpha+pixel[1]*(255-alpha))/255;
+					pixel[2]=(source[2]*alpha+pixel[2]*(255-alpha))/255;
+					pixel[3]=alpha+pixel[3]*(255-alpha)/255;
+				}
+			}
+		}
+	}
+
+	// Clear a tile of the chunk and draw its objects in order.
+	void renderTile(BoardViewer_Chunk* _chunk, const int _localX, const int _localY)
+	{
+		Texture& image = _chunk->image;
+		const int size = _chunk->pixelsPerTile;
+		const int x1 = _localX*size;
+		const int y1 = (_chunk->nTilesY-1-_localY)*size;
+
+		for (int y=y1;y<y1+size;++y)
+		{
+			unsigned char* row = &image.data[(y*image.nX+x1)*4];
+			for (int i=0;i<size*4;++i) { row[i]=0; }
+		}
+
+		const int tileX = _chunk->tileX+_localX;
+		const int tileY = _chunk->tileY+_localY;
+		for (int _z=0;_z<(int)aBoard->nZ;++_z)
+		{
+			Vector <T> * vObject = (*aBoard)(tileX,tileY,_z);
+			if ( vObject==0 ) { continue; }
+			for (int i=0;i<vObject->size();++i)
+			{
+				Texture* texture = (*vObject)(i)->currentTexture();
+				if ( texture==0 || (*vObject)(i)->getMinSize() > 1 ) { continue; }
+				drawTexture(image,x1,y1,size,texture);
+			}
+		}
+		_chunk->upload.markRect(x1,y1,x1+size-1,y1+size-1);
+		++tilesRendered;
+	}
+
+	void renderChunk(BoardViewer_Chunk* _chunk, const int _pixelsPerTile)
+	{
+		if ( _chunk->pixelsPerTile!=_pixelsPerTile )
+		{
+			// Draw the whole chunk at the new size.
+			const int imageX = _chunk->nTilesX*_pixelsPerTile;
+			const int imageY = _chunk->nTilesY*_pixelsPerTile;
+			if ( _chunk->image.data==0 || _chunk->image.nX!=imageX || _chunk->image.nY!=imageY )
+			{
+				delete [] _chunk->image.data;
+				_chunk->image.create(imageX,imageY,1,true);
+				_chunk->upload.init(&_chunk->image);
+			}
+			_chunk->pixelsPerTile=_pixelsPerTile;
+			for (int _y=0;_y<_chunk->nTilesY;++_y)
+			{
+				for (int _x=0;_x<_chunk->nTilesX;++_x)
+				{ renderTile(_chunk,_x,_y); }
+			}
+			for (unsigned int i=0;i<_chunk->vDirtyTile.size();++i)
+			{ _chunk->vTileQueued[_chunk->vDirtyTile[i]]=0; }
+			_chunk->vDirtyTile.clear();
+			++chunksRendered;
+			return;
+		}
+
+		for (unsigned int i=0;i<_chunk->vDirtyTile.size();++i)
+		{
+			const int index = _chunk->vDirtyTile[i];
+			renderTile(_chunk,index%_chunk->nTilesX,index/_chunk->nTilesX);
+			_chunk->vTileQueued[index]=0;
+		}
+		_chunk->vDirtyTile.clear();
+	}
+
+	// Delete the chunks used least recently, but never ones used this frame.
+	void evict()
+	{
+		while ( (int)vLoaded.size()>maxChunks )
+		{
+			int oldest=-1;
+			for (unsigned int i=0;i<vLoaded.size();++i)
+			{
+				const BoardViewer_Chunk* chunk = vChunk[vLoaded[i]];
+				if ( chunk->lastUsed<frame && (oldest==-1 || chunk->lastUsed<vChunk[vLoaded[oldest]]->lastUsed) )
+				{ oldest=i; }
+			}
+			if ( oldest==-1 ) { return; }
+			delete vChunk[vLoaded[oldest]];
+			vChunk[vLoaded[oldest]]=0;
+			vLoaded[oldest]=vLoaded.back();
+			vLoaded.pop_back();
+		}
+	}
+
+	inline void updateFog(const int _x, const int _y)
+	{
+		if ( aFogOfWar==0 || fogLayer.data==0 || aFogOfWar->isSafe(_x,_y)==false ) { return; }
+		const int row = nY-1-_y;
+		unsigned char* pixel = &fogLayer.data[(row*nX+_x)*4];
+		pixel[0]=0;
+		pixel[1]=0;
+		pixel[2]=0;
+		const char fog = (*aFogOfWar)(_x,_y);
+		pixel[3] = fog==0 ? 255 : fog==1 ? 120 : 0;
+		fogUpload.markPixel(_x,row);
+	}
+
+	void updateImportant(const int _x, const int _y)
+	{
+		for (int _z=0;_z<(int)aBoard->nZ;++_z)
+		{
+			Vector <T> * vObject = (*aBoard)(_x,_y,_z);
+			if ( vObject==0 ) { continue; }
+			for (int i=0;i<vObject->size();++i)
+			{
+				if ( (*vObject)(i)->currentTexture()!=0 && (*vObject)(i)->getMinSize() > 1 )
+				{
+					sImportant.insert(_x+_y*nX);
+					return;
+				}
+			}
+		}
+		sImportant.erase(_x+_y*nX);
+	}
+
+	public:
+
+	int maxPixelsPerTile;
+	int maxChunks;
+
+	unsigned long int chunksRendered; // chunks drawn in full
+	unsigned long int tilesRendered;
+
+	BoardViewer_ChunkCache()
+	{
+		aBoard=0;
+		aFogOfWar=0;
+		nX=0; nY=0;
+		chunkTiles=32;
+		nChunksX=0; nChunksY=0;
+		frame=1;
+		maxPixelsPerTile=16;
+		maxChunks=256;
+		chunksRendered=0;
+		tilesRendered=0;
+	}
+	~BoardViewer_ChunkCache()
+	{
+		clear();
+	}
+
+	void init(ArrayS3 < Vector < T > * > * _aBoard, ArrayS2 <char> * _aFogOfWar=0, const int _chunkTiles=32)
+	{
+		clear();
+		aBoard=_aBoard;
+		aFogOfWar=_aFogOfWar;
+		chunkTiles = _chunkTiles>0 ? _chunkTiles : 32;
+		nX = aBoard==0 ? 0 : aBoard->nX;
+		nY = aBoard==0 ? 0 : aBoard->nY;
+		nChunksX=(nX+chunkTiles-1)/chunkTiles;
+		nChunksY=(nY+chunkTiles-1)/chunkTiles;
+		vChunk.assign(nChunksX*nChunksY,0);
+
+		if ( aFogOfWar!=0 && nX>0 && nY>0 )
+		{
+			fogLayer.create(nX,nY,1,true);
+			fogUpload.init(&fogLayer);
+		}
+		markAll();
+	}
+
+	// Whether init() needs to be called again for this board.
+	inline bool isFor(ArrayS3 < Vector < T > * > * _aBoard, ArrayS2 <char> * _aFogOfWar) const
+	{
+		return aBoard==_aBoard && aFogOfWar==_aFogOfWar && _aBoard!=0 && nX==(int)_aBoard->nX && nY==(int)_aBoard->nY;
+	}
+
+	inline int getChunkTiles() const
+	{ return chunkTiles; }
+	inline int getNChunksX() const
+	{ return nChunksX; }
+	inline int getNChunksY() const
+	{ return nChunksY; }
+	inline int nLoaded() const
+	{ return vLoaded.size(); }
+
+	// The tile size to draw chunks at, for a tile size on the screen.
+	inline int pixelsPerTileFor(const int _tileSize) const
+	{
+		int size=1;
+		while ( size<_tileSize && size<maxPixelsPerTile ) { size*=2; }
+		return size;
+	}
+
+	// Something on the tile has changed, or its fog of war.
+	void markTile(const int _x, const int _y)
+	{
+		if ( _x<0 || _y<0 || _x>=nX || _y>=nY ) { return; }
+		updateFog(_x,_y);
+		updateImportant(_x,_y);
+
+		BoardViewer_Chunk* chunk = vChunk[(_y/chunkTiles)*nChunksX+_x/chunkTiles];
+		if ( chunk==0 || chunk->pixelsPerTile==0 ) { return; }
+		const int index = (_x-chunk->tileX)+(_y-chunk->tileY)*chunk->nTilesX;
+		if ( chunk->vTileQueued[index]==0 )
+		{
+			chunk->vTileQueued[index]=1;
+			chunk->vDirtyTile.push_back(index);
+		}
+	}
+
+	// Draw everything again, for example after loading.
+	void markAll()
+	{
+		for (unsigned int i=0;i<vLoaded.size();++i)
+		{ vChunk[vLoaded[i]]->pixelsPerTile=0; }
+		for (int _y=0;_y<nY;++_y)
+		{
+			for (int _x=0;_x<nX;++_x)
+			{
+				updateFog(_x,_y);
+				updateImportant(_x,_y);
+			}
+		}
+	}
+
+	// Start a new frame. Chunks which weren't used last frame may be deleted.
+	void nextFrame()
+	{
+		evict();
+		++frame;
+	}
+
+	// The image for a chunk, drawn and uploaded if it has changed. Returns 0 if the chunk is off the board.
+	Texture* getChunk(const int _chunkX, const int _chunkY, const int _pixelsPerTile)
+	{
+		if ( _chunkX<0 || _chunkY<0 || _chunkX>=nChunksX || _chunkY>=nChunksY ) { return 0; }
+
+		const int index = _chunkY*nChunksX+_chunkX;
+		BoardViewer_Chunk* chunk = vChunk[index];
+		if ( chunk==0 )
+		{
+			const int tileX = _chunkX*chunkTiles;
+			const int tileY = _chunkY*chunkTiles;
+			chunk = new BoardViewer_Chunk(tileX,tileY,std::min(chunkTiles,nX-tileX),std::min(chunkTiles,nY-tileY));
+			vChunk[index]=chunk;
+			vLoaded.push_back(index);
+		}
+		chunk->lastUsed=frame;
+		renderChunk(chunk,_pixelsPerTile);
+		chunk->upload.upload();
+		return &chunk->image;
+	}
+
+	// Bytes sent by the last upload of a chunk.
+	unsigned long int chunkBytesUploaded(const int _chunkX, const int _chunkY)
+	{
+		if ( _chunkX<0 || _chunkY<0 || _chunkX>=nChunksX || _chunkY>=nChunksY ) { return 0; }
+		BoardViewer_Chunk* chunk = vChunk[_chunkY*nChunksX+_chunkX];
+		return chunk==0 ? 0 : chunk->upload.bytesUploaded;
+	}
+
+	// The fog of war layer, with one texel per tile. Returns 0 if there is no fog of war.
+	Texture* getFogLayer()
+	{
+		if ( fogLayer.data==0 ) { return 0; }
+		fogUpload.upload();
+		return &fogLayer;
+	}
+
+	inline unsigned long int fogBytesUploaded() const
+	{ return fogUpload.bytesUploaded; }
+
+	// Tiles with objects which have a min size above 1, as x+y*nX.
+	inline const std::set <int>& getImportant() const
+	{ return sImportant; }
+};
+
+#endif
@@ -0,0 +1,306 @@
+#pragma once
+#ifndef WILDCAT_BOARD_VIEWER_BOARD_VIEWER_LOD_HPP
+#define WILDCAT_BOARD_VIEWER_BOARD_VIEWER_LOD_HPP
+
+#include <Container/ArrayS2/ArrayS2.hpp>
+#include <Container/ArrayS3/ArrayS3.hpp>
+#include <Container/Vector/Vector.hpp>
+#include <Graphics/Texture/Texture.hpp>
+#include <Graphics/PixelScreen/PixelScreen_DirtyTexture.hpp>
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+/*
+	#include <Game/Board/BoardViewer_LOD.hpp>
+
+	Level of detail images for BoardViewer. When the player is zoomed far out, drawing every object on every tile
+	costs the same as drawing a zoomed in board with a million tiles. Instead the board is drawn as one texture with
+	a texel per tile, so the cost depends on the screen size.
+
+	Level 0 has one texel per tile, which is the average colour of the top textured object on the tile. Each level
+	above halves the size, averaging each 2x2 block like Texture::createMipMap(). The average is weighted by alpha,
+	so empty and fogged tiles don't darken their neighbours. Higher levels are used if level 0 is bigger than
+	maxTextureSize.
+
+	The images are kept up to date incrementally. markTile() must be called when anything on a tile changes, or its
+	fog of war changes, and update() then only redoes those tiles and their parents in each level. Each level is
+	uploaded through a PixelScreen_DirtyTexture, so only the changed blocks are sent to the GPU. Animated textures
+	aren't shown, because the image only changes when a tile is marked.
+
+	Objects with getMinSize() above 1 must be visible at every zoom level, so their tiles are kept in a list which
+	is drawn over the image.
+
+	Image rows go from the top of the board to the bottom, so the image can be drawn with Renderer::placeTexture4()
+	over the whole board.
+*/
+
+template <class T>
+class BoardViewer_LOD
+{
+	private:
+
+	ArrayS3 < Vector < T > * > * aBoard;
+	ArrayS2 <char> * aFogOfWar;
+	int nX, nY;
+
+	Vector <Texture*> vLevel;
+	Vector <PixelScreen_DirtyTexture*> vUpload;
+
+	std::vector <int> vDirtyTile; // x+y*nX
+	std::vector <unsigned char> vTileQueued;
+
+	std::set <int> sImportant; // tiles with objects which have a min size above 1
+
+	void clear()
+	{
+		for (int i=0;i<vLevel.size();++i)
+		{
+			delete vUpload(i);
+			delete [] vLevel(i)->data;
+			delete vLevel(i);
+		}
+		vLevel.clear();
+		vUpload.clear();
+		vDirtyTile.clear();
+		vTileQueued.clear();
+		sImportant.clear();
+	}
+
+	// One RGBA texel, with rows flipped so the top of the board is the top of the image.
+	inline unsigned char* texel(const int _level, const int _x, const int _y)
+	{
+		Texture* image = vLevel(_level);
+		return &image->data[((image->nY-1-_y)*image->nX+_x)*4];
+	}
+
+	inline void setTexel(const int _level, const int _x, const int _y, const unsigned char _red,
+		const unsigned char _green, const unsigned char _blue, const unsigned char _alpha)
+	{
+		unsigned char* pixel = texel(_level,_x,_y);
+		pixel[0]=_red;
+		pixel[1]=_green;
+		pixel[2]=_blue;
+		pixel[3]=_alpha;
+		vUpload(_level)->markPixel(_x,vLevel(_level)->nY-1-_y);
+	}
+
+	// The colour of a texture: the average from loading, or the centre pixel if it doesn't have one.
+	static void textureColour(Texture* _texture, unsigned char* _rgb)
+	{
+		if ( (_texture->averageRed!=0 || _texture->averageGreen!=0 || _texture->averageBlue!=0)
+			|| _texture->data==0 || _texture->nX<=0 || _texture->nY<=0 )
+		{
+			_rgb[0]=_texture->averageRed;
+			_rgb[1]=_texture->averageGreen;
+			_rgb[2]=_texture->averageBlue;
+			return;
+		}
+		_rgb[0]=_texture->getPixel(_texture->nX/2,_texture->nY/2,0);
+		_rgb[1]=_texture->getPixel(_texture->nX/2,_texture->nY/2,1);
+		_rgb[2]=_texture->getPixel(_texture->nX/2,_texture->nY/2,2);
+	}
+
+	// Work out a tile's level 0 texel, and whether it has important objects.
+	void updateTile(const int _x, const int _y)
+	{
+		bool important = false;
+		bool found = false;
+		unsigned char rgb[3] = {0,0,0};
+
+		const bool hidden = aFogOfWar!=0 && aFogOfWar->isSafe(_x,_y) && (*aFogOfWar)(_x,_y)==0;
+		for (int _z=0;hidden==false && _z<(int)aBoard->nZ;++_z)
+		{
+			Vector <T> * vObject = (*aBoard)(_x,_y,_z);
+			if ( vObject==0 ) { continue; }
+			for (int i=0;i<vObject->size();++i)
+			{
+				Texture* texture = (*vObject)(i)->currentTexture();
+				if ( texture==0 ) { continue; }
+				// Objects are drawn in order, so the last one is on top.
+				textureColour(texture,rgb);
+				found=true;
+				if ( (*vObject)(i)->getMinSize() > 1 )
+				{ important=true; }
+			}
+		}
+
+		if ( found==false )
+		{ setTexel(0,_x,_y,0,0,0,0); }
+		else if ( aFogOfWar!=0 && aFogOfWar->isSafe(_x,_y) && (*aFogOfWar)(_x,_y)==1 )
+		{
+			// Partial fog is drawn as black with alpha 120.
+			setTexel(0,_x,_y,rgb[0]*135/255,rgb[1]*135/255,rgb[2]*135/255,255);
+		}
+		else
+		{ setTexel(0,_x,_y,rgb[0],rgb[1],rgb[2],255); }
+
+		if ( important ) { sImportant.insert(_x+_y*nX); }
+		else { sImportant.erase(_x+_y*nX); }
+	}
+
+	// Work out a texel from the 2x2 block below it.
+	void updateParent(const int _level, const int _x, const int _y)
+	{
+		const Texture* below = vLevel(_level-1);
+		unsigned int red=0, green=0, blue=0, alpha=0;
+		int nChildren=0;
+		for (int y=_y*2;y<_y*2+2 && y<below->nY;++y)
+		{
+			for (int x=_x*2;x<_x*2+2 && x<below->nX;++x)
+			{
+				const unsigned char* child = texel(_level-1,x,y);
+				red+=child[0]*child[3];
+				green+=child[1]*child[3];
+				blue+=child[2]*child[3];
+				alpha+=child[3];
+				++nChildren;
+			}
+		}
+		if ( alpha==0 )
+		{
+			setTexel(_level,_x,_y,0,0,0,0);
+			return;
+		}
+		setTexel(_level,_x,_y,red/alpha,green/alpha,blue/alpha,alpha/nChildren);
+	}
+
+	public:
+
+	int maxTextureSize;
+
+	unsigned long int tilesUpdated; // tiles redone by the last update()
+
+	BoardViewer_LOD()
+	{
+		aBoard=0;
+		aFogOfWar=0;
+		nX=0;
+		nY=0;
+		maxTextureSize=8192;
+		tilesUpdated=0;
+	}
+	~BoardViewer_LOD()
+	{
+		clear();
+	}
+
+	// Build every level for the board. The first update() draws all of them.
+	void init(ArrayS3 < Vector < T > * > * _aBoard, ArrayS2 <char> * _aFogOfWar=0)
+	{
+		clear();
+		aBoard=_aBoard;
+		aFogOfWar=_aFogOfWar;
+		nX = aBoard==0 ? 0 : aBoard->nX;
+		nY = aBoard==0 ? 0 : aBoard->nY;
+		if ( nX<=0 || nY<=0 ) { return; }
+
+		int levelX=nX, levelY=nY;
+		while ( true )
+		{
+			Texture* image = new Texture;
+			image->create(levelX,levelY,1,true);
+			vLevel.push(image);
+			PixelScreen_DirtyTexture* upload = new PixelScreen_DirtyTexture;
+			upload->init(image);
+			vUpload.push(upload);
+
+			if ( levelX==1 && levelY==1 ) { break; }
+			levelX=(levelX+1)/2;
+			levelY=(levelY+1)/2;
+		}
+		vTileQueued.assign(nX*nY,0);
+		markAll();
+	}
+
+	// Whether init() needs to be called again for this board.
+	inline bool isFor(ArrayS3 < Vector < T > * > * _aBoard, ArrayS2 <char> * _aFogOfWar) const
+	{
+		return aBoard==_aBoard && aFogOfWar==_aFogOfWar && _aBoard!=0 && nX==(int)_aBoard->nX && nY==(int)_aBoard->nY;
+	}
+
+	inline void markTile(const int _x, const int _y)
+	{
+		if ( _x<0 || _y<0 || _x>=nX || _y>=nY ) { return; }
+		const int index = _x+_y*nX;
+		if ( vTileQueued[index]==0 )
+		{
+			vTileQueued[index]=1;
+			vDirtyTile.push_back(index);
+		}
+	}
+
+	void markAll()
+	{
+		vDirtyTile.clear();
+		for (int i=0;i<nX*nY;++i)
+		{
+			vTileQueued[i]=1;
+			vDirtyTile.push_back(i);
+		}
+	}
+
+	// Redo the marked tiles, and the texels above them in each level.
+	void update()
+	{
+		tilesUpdated=vDirtyTile.size();
+		if ( vDirtyTile.empty() ) { return; }
+
+		for (unsigned int i=0;i<vDirtyTile.size();++i)
+		{
+			updateTile(vDirtyTile[i]%nX,vDirtyTile[i]/nX);
+			vTileQueued[vDirtyTile[i]]=0;
+		}
+
+		// Texels of the level being updated, as x+y*levelX.
+		std::vector <int> vTexel;
+		vTexel.swap(vDirtyTile);
+		int levelX=nX;
+		for (int level=1;level<vLevel.size();++level)
+		{
+			const int parentX = vLevel(level)->nX;
+			for (unsigned int i=0;i<vTexel.size();++i)
+			{
+				const int x = vTexel[i]%levelX;
+				const int y = vTexel[i]/levelX;
+				vTexel[i] = x/2+(y/2)*parentX;
+			}
+			std::sort(vTexel.begin(),vTexel.end());
+			vTexel.erase(std::unique(vTexel.begin(),vTexel.end()),vTexel.end());
+			for (unsigned int i=0;i<vTexel.size();++i)
+			{ updateParent(level,vTexel[i]%parentX,vTexel[i]/parentX); }
+			levelX=parentX;
+		}
+		vTexel.clear();
+		vDirtyTile.swap(vTexel); // keep the memory
+	}
+
+	inline int nLevels()
+	{ return vLevel.size(); }
+
+	inline Texture* getLevel(const int _level)
+	{ return vLevel(_level); }
+
+	// The level to draw with: the most detailed one which fits in maxTextureSize.
+	int chooseLevel()
+	{
+		int level=0;
+		while ( level+1<vLevel.size() && ( vLevel(level)->nX>maxTextureSize || vLevel(level)->nY>maxTextureSize ) )
+		{ ++level; }
+		return level;
+	}
+
+	// Send the changed parts of a level to the GPU. Levels are only uploaded when they are drawn.
+	unsigned long int upload(const int _level)
+	{
+		vUpload(_level)->upload();
+		return vUpload(_level)->bytesUploaded;
+	}
+
+	// Tiles with objects which should be drawn over the image, as x+y*nX.
+	inline const std::set <int>& getImportant() const
+	{ return sImportant; }
+};
+
+#endif
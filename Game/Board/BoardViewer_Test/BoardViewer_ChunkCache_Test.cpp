@@ -0,0 +1,242 @@
+#include <Game/Board/Board.hpp>
+#include <Game/Board/BoardViewer_ChunkCache.hpp>
+#include <Interface/HasTexture.hpp>
+#include <System/Time/Timer.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// g++ BoardViewer_ChunkCache_Test.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX
+
+// Headless test of BoardViewer_ChunkCache. Checks the pixels of drawn chunks, that marked tiles are the only ones
+// drawn again and uploaded, that Board::teleportObject() tells observers, and the fog of war layer. Then compares
+// a frame of cached chunks with drawing every chunk again, and counts the quads each way.
+
+const int BOARD_SIZE = 500;
+const int N_FRAMES = 100;
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+class TestObject: public HasTexture
+{
+	public:
+	Texture* texture;
+	int minSize;
+
+	TestObject(Texture* _texture, const int _minSize=1)
+	{
+		texture=_texture;
+		minSize=_minSize;
+	}
+	Texture* currentTexture() override { return texture; }
+	int getMinSize() override { return minSize; }
+};
+
+	// Tells the cache about tiles changed by a Board.
+class CacheObserver: public BoardObserver
+{
+	public:
+	BoardViewer_ChunkCache <TestObject*>* cache;
+	int nCalls;
+
+	CacheObserver(BoardViewer_ChunkCache <TestObject*>* _cache)
+	{
+		cache=_cache;
+		nCalls=0;
+	}
+	void tileChanged(const int _x, const int _y) override
+	{
+		cache->markTile(_x,_y);
+		++nCalls;
+	}
+};
+
+void makeTexture(Texture& _texture, const unsigned char _red, const unsigned char _green, const unsigned char _blue,
+	const unsigned char _alpha=255)
+{
+	_texture.create(4,4,1,true);
+	for (int i=0;i<16;++i)
+	{
+		_texture.data[i*4]=_red;
+		_texture.data[i*4+1]=_green;
+		_texture.data[i*4+2]=_blue;
+		_texture.data[i*4+3]=_alpha;
+	}
+}
+
+	// The top left pixel of a tile in a chunk image.
+const unsigned char* tilePixel(Texture* _image, const int _localX, const int _localY, const int _pixelsPerTile)
+{
+	const int nTilesY = _image->nY/_pixelsPerTile;
+	return &_image->data[(((nTilesY-1-_localY)*_pixelsPerTile)*_image->nX+_localX*_pixelsPerTile)*4];
+}
+
+bool isColour(const unsigned char* _pixel, const int _red, const int _green, const int _blue, const int _alpha)
+{
+	return _pixel[0]==_red && _pixel[1]==_green && _pixel[2]==_blue && _pixel[3]==_alpha;
+}
+
+int main (int nArgs, char ** arg)
+{
+	Texture grass, water, unit, ghost, city, noData;
+	makeTexture(grass,0,200,0);
+	makeTexture(water,0,0,200);
+	makeTexture(unit,200,0,0);
+	makeTexture(ghost,255,255,255,51);
+	makeTexture(city,255,255,0);
+	noData.nX=4;
+	noData.nY=4;
+	noData.averageRed=1;
+	noData.averageGreen=2;
+	noData.averageBlue=3;
+	unit.setPixel(0,0,3,0); // transparent corner
+
+	ArrayS3 < Vector <TestObject*> * > aBoard;
+	aBoard.init(BOARD_SIZE,BOARD_SIZE,2,0);
+	for (int _y=0;_y<BOARD_SIZE;++_y)
+	{
+		for (int _x=0;_x<BOARD_SIZE;++_x)
+		{
+			aBoard(_x,_y,0) = new Vector <TestObject*>;
+			aBoard(_x,_y,0)->push(new TestObject((_x+_y)%3==0 ? &water : &grass));
+			aBoard(_x,_y,1) = new Vector <TestObject*>;
+		}
+	}
+	aBoard(1,1,1)->push(new TestObject(&unit));
+	aBoard(2,1,1)->push(new TestObject(&ghost));
+	aBoard(3,1,1)->push(new TestObject(&city,16));
+	aBoard(4,1,0)->clear();
+	aBoard(4,1,0)->push(new TestObject(&noData));
+	aBoard(5,1,0)->clear();
+
+	ArrayS2 <char> aFogOfWar (BOARD_SIZE,BOARD_SIZE,2);
+	aFogOfWar(10,10)=0;
+	aFogOfWar(11,10)=1;
+
+	BoardViewer_ChunkCache <TestObject*> cache;
+	cache.init(&aBoard,&aFogOfWar,32);
+	check("Chunk grid", cache.getNChunksX()==16 && cache.getNChunksY()==16);
+	check("Pixels per tile", cache.pixelsPerTileFor(1)==1 && cache.pixelsPerTileFor(5)==8
+		&& cache.pixelsPerTileFor(16)==16 && cache.pixelsPerTileFor(64)==16);
+
+	Texture* image = cache.getChunk(0,0,16);
+	check("Chunk size", image!=0 && image->nX==32*16 && image->nY==32*16 && cache.nLoaded()==1);
+	check("Terrain", isColour(tilePixel(image,0,0,16),0,0,200,255) && isColour(tilePixel(image,1,0,16),0,200,0,255));
+	const unsigned char* unitPixel = tilePixel(image,1,1,16);
+	check("Unit drawn over terrain, keeping transparent pixels", isColour(unitPixel,0,200,0,255)
+		&& isColour(unitPixel+8*4,200,0,0,255));
+	check("Alpha blending", isColour(tilePixel(image,2,1,16),51,51,(255*51+200*204)/255,255));
+	check("Objects with a min size are left out", isColour(tilePixel(image,3,1,16),0,200,0,255));
+	check("Their tiles are listed", cache.getImportant().size()==1 && cache.getImportant().count(3+1*BOARD_SIZE)==1);
+	check("Textures without data use their average", isColour(tilePixel(image,4,1,16),1,2,3,255));
+	check("Empty tiles are transparent", tilePixel(image,5,1,16)[3]==0);
+	check("Tiles are scaled", std::memcmp(tilePixel(image,0,0,16),tilePixel(image,0,0,16)+15*4,4)==0);
+
+	Texture* edge = cache.getChunk(15,15,16);
+	check("Edge chunks are cut to the board", edge->nX==(BOARD_SIZE-15*32)*16 && edge->nY==(BOARD_SIZE-15*32)*16);
+	check("Chunks off the board", cache.getChunk(16,0,16)==0 && cache.getChunk(-1,0,16)==0);
+
+	// Nothing changed, so nothing is drawn or uploaded.
+	const unsigned long int chunksBefore = cache.chunksRendered;
+	const unsigned long int tilesBefore = cache.tilesRendered;
+	cache.getChunk(0,0,16);
+	check("Unchanged chunk is cached", cache.chunksRendered==chunksBefore && cache.tilesRendered==tilesBefore
+		&& cache.chunkBytesUploaded(0,0)==0);
+
+	// Moving an object on the board tells the cache about both tiles.
+	Board board;
+	CacheObserver observer (&cache);
+	board.addObserver(&observer);
+	BoardObject piece;
+	piece.setCoordinates(1,1);
+	aBoard(1,1,1)->clear();
+	aBoard(6,2,1)->push(new TestObject(&unit));
+	board.teleportObject(&piece,6,2);
+	check("teleportObject tells observers", observer.nCalls==2 && piece.x==6 && piece.y==2);
+
+	image = cache.getChunk(0,0,16);
+	check("Only marked tiles are drawn", cache.tilesRendered==tilesBefore+2 && cache.chunksRendered==chunksBefore);
+	check("Only marked tiles are uploaded", cache.chunkBytesUploaded(0,0)==2*16*16*4);
+	check("Moved unit", isColour(tilePixel(image,1,1,16),0,200,0,255) && isColour(tilePixel(image,6,2,16)+8*4,200,0,0,255));
+
+	aBoard(7,2,1)->push((*aBoard(3,1,1))(0));
+	aBoard(3,1,1)->clear();
+	cache.markTile(3,1);
+	cache.markTile(7,2);
+	check("Marked tiles update the list", cache.getImportant().size()==1 && cache.getImportant().count(7+2*BOARD_SIZE)==1);
+
+	BoardViewer_ChunkCache <TestObject*> fresh;
+	fresh.init(&aBoard,&aFogOfWar,32);
+	Texture* freshImage = fresh.getChunk(0,0,16);
+	check("Updated chunk matches a fresh one", std::memcmp(image->data,freshImage->data,image->nX*image->nY*4)==0);
+
+	image = cache.getChunk(0,0,4);
+	check("Zooming out draws the chunk smaller", image->nX==32*4 && cache.chunksRendered==chunksBefore+1
+		&& isColour(tilePixel(image,0,0,4),0,0,200,255));
+
+	// Fog of war layer.
+	Texture* fog = cache.getFogLayer();
+	check("Fog layer has a texel per tile", fog!=0 && fog->nX==BOARD_SIZE && fog->nY==BOARD_SIZE
+		&& cache.fogBytesUploaded()==(unsigned long int)BOARD_SIZE*BOARD_SIZE*4);
+	const unsigned char* hidden = &fog->data[((BOARD_SIZE-1-10)*BOARD_SIZE+10)*4];
+	check("Fog alpha", hidden[3]==255 && hidden[4+3]==120 && hidden[8+3]==0);
+	aFogOfWar(10,10)=2;
+	cache.markTile(10,10);
+	cache.getFogLayer();
+	check("Fog change uploads one block", hidden[3]==0 && cache.fogBytesUploaded()==16*16*4);
+
+	// Old chunks are deleted, but not ones used this frame.
+	cache.maxChunks=4;
+	cache.nextFrame();
+	for (int i=0;i<6;++i) { cache.getChunk(i,3,4); }
+	cache.nextFrame();
+	check("Chunks used in the frame are kept", cache.nLoaded()==6);
+	cache.getChunk(0,3,4);
+	cache.nextFrame();
+	check("Least recently used chunks are deleted", cache.nLoaded()==4);
+
+	// A 1920x1080 screen at 16 pixels per tile shows 5x3 chunks. Compare a frame from the cache with drawing them all
+	// again, which is what the CPU would do without the cache.
+	cache.maxChunks=256;
+	const int pixelsPerTile = 16;
+	Timer timer;
+	timer.init();
+	timer.start();
+	for (int frame=0;frame<N_FRAMES;++frame)
+	{
+		for (int _y=0;_y<3;++_y)
+		{
+			for (int _x=0;_x<5;++_x)
+			{ cache.getChunk(_x,_y,pixelsPerTile); }
+		}
+		cache.nextFrame();
+	}
+	timer.update();
+	const double cachedSeconds = timer.fullSeconds;
+
+	BoardViewer_ChunkCache <TestObject*> uncached;
+	uncached.init(&aBoard,0,32);
+	timer.init();
+	timer.start();
+	for (int _y=0;_y<3;++_y)
+	{
+		for (int _x=0;_x<5;++_x)
+		{ uncached.getChunk(_x,_y,pixelsPerTile); }
+	}
+	timer.update();
+	const double redrawSeconds = timer.fullSeconds;
+	check("Cached frames are faster", cachedSeconds/N_FRAMES < redrawSeconds);
+
+	std::cout<<"5x3 chunks of 32x32 tiles. Cached frame: "<<cachedSeconds/N_FRAMES<<"s. Drawing the chunks again: "
+		<<redrawSeconds<<"s. Quads per frame: "<<15<<" cached, "<<15*32*32<<"+ drawing each tile.\n";
+
+	std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+	return nFailed==0 ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+#include <Game/Board/BoardViewer_LOD.hpp>
+#include <Interface/HasTexture.hpp>
+#include <Math/Random/RandomLehmer.hpp>
+#include <System/Time/Timer.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// g++ BoardViewer_LOD_Test.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX
+
+// Headless test of BoardViewer_LOD. Builds a board of terrain with some units on it, checks the colours in each
+// level, checks that updating a few marked tiles gives the same images as rebuilding them, and compares the cost
+// and upload size of an incremental update with a full rebuild.
+
+const int BOARD_SIZE = 1024;
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+class TestObject: public HasTexture
+{
+	public:
+	Texture* texture;
+	int minSize;
+
+	TestObject(Texture* _texture, const int _minSize=1)
+	{
+		texture=_texture;
+		minSize=_minSize;
+	}
+	Texture* currentTexture() override { return texture; }
+	int getMinSize() override { return minSize; }
+};
+
+void makeTexture(Texture& _texture, const unsigned char _red, const unsigned char _green, const unsigned char _blue)
+{
+	_texture.create(4,4,1,true);
+	_texture.averageRed=_red;
+	_texture.averageGreen=_green;
+	_texture.averageBlue=_blue;
+}
+
+	// Texel of a level, by tile coordinates.
+const unsigned char* texel(BoardViewer_LOD <TestObject*>& lod, const int _level, const int _x, const int _y)
+{
+	Texture* image = lod.getLevel(_level);
+	return &image->data[((image->nY-1-_y)*image->nX+_x)*4];
+}
+
+bool isColour(const unsigned char* _texel, const int _red, const int _green, const int _blue, const int _alpha)
+{
+	return _texel[0]==_red && _texel[1]==_green && _texel[2]==_blue && _texel[3]==_alpha;
+}
+
+bool sameLevels(BoardViewer_LOD <TestObject*>& a, BoardViewer_LOD <TestObject*>& b)
+{
+	if ( a.nLevels()!=b.nLevels() ) { return false; }
+	for (int i=0;i<a.nLevels();++i)
+	{
+		const int nBytes = a.getLevel(i)->nX*a.getLevel(i)->nY*4;
+		if ( std::memcmp(a.getLevel(i)->data,b.getLevel(i)->data,nBytes)!=0 ) { return false; }
+	}
+	return true;
+}
+
+int main (int nArgs, char ** arg)
+{
+	Texture grass, water, unit, city;
+	makeTexture(grass,0,200,0);
+	makeTexture(water,0,0,200);
+	makeTexture(unit,200,0,0);
+	makeTexture(city,255,255,255);
+
+	Texture centre; // no average, so the centre pixel is used
+	centre.create(4,4,1,true);
+	centre.setPixel(2,2,0,10);
+	centre.setPixel(2,2,1,20);
+	centre.setPixel(2,2,2,30);
+	centre.setPixel(2,2,3,255);
+
+	RandomLehmer rng (7);
+
+	ArrayS3 < Vector <TestObject*> * > aBoard;
+	aBoard.init(BOARD_SIZE,BOARD_SIZE,2,0);
+	for (int _y=0;_y<BOARD_SIZE;++_y)
+	{
+		for (int _x=0;_x<BOARD_SIZE;++_x)
+		{
+			aBoard(_x,_y,0) = new Vector <TestObject*>;
+			aBoard(_x,_y,0)->push(new TestObject(rng.flip() ? &grass : &water));
+			aBoard(_x,_y,1) = new Vector <TestObject*>;
+		}
+	}
+	aBoard(3,4,1)->push(new TestObject(&unit));
+	aBoard(5,5,1)->push(new TestObject(&city,16));
+	aBoard(6,6,0)->clear();
+	aBoard(6,6,0)->push(new TestObject(&centre));
+	aBoard(7,7,0)->clear();
+
+	ArrayS2 <char> aFogOfWar (BOARD_SIZE,BOARD_SIZE,2);
+	aFogOfWar(8,8)=0;
+	aFogOfWar(9,9)=1;
+
+	BoardViewer_LOD <TestObject*> lod;
+	lod.init(&aBoard,&aFogOfWar);
+	lod.update();
+
+	check("Levels go down to 1x1", lod.nLevels()==11 && lod.getLevel(10)->nX==1 && lod.getLevel(10)->nY==1);
+	check("Level 0 is the top object's colour", isColour(texel(lod,0,3,4),200,0,0,255));
+	check("Texture without an average uses its centre", isColour(texel(lod,0,6,6),10,20,30,255));
+	check("Empty tile is transparent", texel(lod,0,7,7)[3]==0);
+	check("Fogged tile is transparent", texel(lod,0,8,8)[3]==0);
+	check("Partly fogged tile is darker", texel(lod,0,9,9)[3]==255 && texel(lod,0,9,9)[0]<=texel(lod,0,9,9)[1]+texel(lod,0,9,9)[2]
+		&& (texel(lod,0,9,9)[1]==200*135/255 || texel(lod,0,9,9)[2]==200*135/255));
+	check("Important objects are listed", lod.getImportant().size()==1 && *lod.getImportant().begin()==5+5*BOARD_SIZE);
+
+	// Tiles (6,6),(7,6),(6,7),(7,7): centre colour, two random terrain, and one empty tile.
+	const unsigned char* a = texel(lod,0,6,6);
+	const unsigned char* b = texel(lod,0,7,6);
+	const unsigned char* c = texel(lod,0,6,7);
+	const unsigned char* parent = texel(lod,1,3,3);
+	check("Level 1 ignores empty tiles", parent[0]==(a[0]+b[0]+c[0])/3 && parent[1]==(a[1]+b[1]+c[1])/3
+		&& parent[2]==(a[2]+b[2]+c[2])/3 && parent[3]==255*3/4);
+
+	BoardViewer_LOD <TestObject*> odd;
+	ArrayS3 < Vector <TestObject*> * > aOdd (5,3,1,0);
+	for (int i=0;i<5*3;++i) { aOdd.data[i] = aBoard.data[i*2]; }
+	odd.init(&aOdd);
+	odd.update();
+	check("Odd sizes round up", odd.nLevels()==4 && odd.getLevel(1)->nX==3 && odd.getLevel(1)->nY==2
+		&& odd.getLevel(2)->nX==2 && odd.getLevel(2)->nY==1);
+	check("Odd edge averages one column", std::memcmp(texel(odd,1,2,1),texel(odd,0,4,2),4)==0);
+
+	check("Level 0 is used when it fits", lod.chooseLevel()==0);
+	lod.maxTextureSize=256;
+	check("Levels bigger than the max texture size are skipped", lod.chooseLevel()==2);
+	lod.maxTextureSize=8192;
+
+	const unsigned long int fullBytes = lod.upload(0);
+	check("First upload is the whole level", fullBytes==(unsigned long int)BOARD_SIZE*BOARD_SIZE*4);
+
+	// Move the unit. Only the blocks around the 2 tiles are uploaded.
+	aBoard(3,4,1)->clear();
+	aBoard(100,200,1)->push(new TestObject(&unit));
+	lod.markTile(3,4);
+	lod.markTile(100,200);
+	lod.update();
+	const unsigned long int moveBytes = lod.upload(0);
+	check("Moving a unit uploads a small part of the level", moveBytes>0 && moveBytes*100<fullBytes);
+
+	// Change terrain all over the board, marking only those tiles.
+	Timer timer;
+	timer.init();
+	timer.start();
+	const int N_CHANGES = 100;
+	for (int i=0;i<N_CHANGES;++i)
+	{
+		const int _x = rng.rand32(BOARD_SIZE);
+		const int _y = rng.rand32(BOARD_SIZE);
+		(*aBoard(_x,_y,0))(0)->texture = &city;
+		lod.markTile(_x,_y);
+	}
+	aFogOfWar(9,9)=2;
+	lod.markTile(9,9);
+	lod.markTile(-1,0); // ignored
+	lod.update();
+	timer.update();
+	const double incrementalSeconds = timer.fullSeconds;
+	check("Only marked tiles are redone", lod.tilesUpdated<=N_CHANGES+1);
+
+	BoardViewer_LOD <TestObject*> rebuilt;
+	timer.init();
+	timer.start();
+	rebuilt.init(&aBoard,&aFogOfWar);
+	rebuilt.update();
+	timer.update();
+	const double rebuildSeconds = timer.fullSeconds;
+	check("Incremental update matches a rebuild", sameLevels(lod,rebuilt));
+	check("Moved unit shows up", isColour(texel(lod,0,100,200),200,0,0,255) && texel(lod,0,3,4)[0]!=200);
+
+	lod.upload(0);
+	lod.update();
+	check("Update with nothing marked does nothing", lod.tilesUpdated==0 && lod.upload(0)==0);
+
+	std::cout<<BOARD_SIZE<<"x"<<BOARD_SIZE<<" board. Full rebuild: "<<rebuildSeconds<<"s, "<<fullBytes
+		<<" bytes uploaded. "<<N_CHANGES+1<<" changed tiles: "<<incrementalSeconds<<"s. Moving a unit: "<<moveBytes<<" bytes uploaded.\n";
+
+	std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+	return nFailed==0 ? 0 : 1;
+}
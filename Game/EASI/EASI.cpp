@@ -11,7 +11,7 @@
 
 #include <Game/EASI/EASI.hpp>
 
-#include <queue> // shunting algorithm
+#include <cmath> // pow
 
 EASI::EASI()
 {
@@ -20,13 +20,15 @@ EASI::EASI()
    isWaitingInput=0;
    input = "";
    vLine=0;
+   pc=0;
+   lastInput=-1;
+   instructionsPerTick=100;
+   nInstructions=0;
    
    vInput.clear();
-   vInputVar.clear();
+   vStack.reserve(64);
 }
 
-#define EASI_LOAD_VERBOSE
-
 std::string EASI::load(std::string _code)
 {
    //EASI CODE MUST ALWAYS BE IN  U P P E R C A S E
@@ -43,6 +45,15 @@ std::string EASI::load(std::string _code)
 	#endif
    
    terminated=false;
+   isWaitingInput=0;
+   vInput.clear();
+   pc=0;
+   currentLine=0;
+   nInstructions=0;
+   program.clear();
+   vStack.clear();
+   vStringStack.clear();
+   printLine="";
    
    if ( vLine != 0 )
    {
@@ -66,7 +77,9 @@ std::string EASI::load(std::string _code)
       return "";
    }
 	
+	#ifdef EASI_LOAD_VERBOSE
 	std::cout<<"Stripped input:\n\n";
+	#endif
 
    // Load up each line.
    for (int i=0;i<vLine->size();++i)
@@ -74,16 +87,14 @@ std::string EASI::load(std::string _code)
 		if ( (*vLine)(i) != "\n" && (*vLine)(i) != "\r" )
 		{
 			vCodeLine.push(new CodeLine((*vLine)(i)));
+			#ifdef EASI_LOAD_VERBOSE
 			std::cout<<"\t"<<(*vLine)(i)<<"\n";
-		}
-		else
-		{
-			std::cout<<"REJECT\n";
+			#endif
 		}
    }
    
    // Debug output of each CodeLine
-   #define EASI_OUTPUT_CODE
+   //#define EASI_OUTPUT_CODE
    #ifdef EASI_OUTPUT_CODE
    for (int i=0;i<vCodeLine.size();++i)
    {
@@ -113,752 +124,264 @@ std::string EASI::load(std::string _code)
       
    }
    #endif
+   
+   // Compile into bytecode. Every variable gets a slot in the VarTable.
+   varTable.clear();
+   EASI_Compiler compiler;
+   compiler.compile(vCodeLine,program,varTable);
+   
+   #ifdef EASI_OUTPUT_CODE
+   std::cout<<"\nBytecode:\n"<<program.toString(varTable)<<"\n";
+   #endif
    return "";
 }
 
-std::string EASI::cycle()
+std::string EASI::receiveInput()
 {
-   if (terminated) { return ""; }
-   // Waiting for input, continue waiting
-   if (isWaitingInput > 0) { return ""; }
+   if (isWaitingInput > 0 || vInput.size() == 0) { return ""; }
    
-   // Inputs have been recieved. Process and clear.
-   if (isWaitingInput == 0 && vInput.size() > 0 )
+   // load each input into corresponding variable
+   for(int i=0;i<vInput.size();++i)
    {
-      // load each input into corresponding variable
-      for(int i=0;i<vInput.size();++i)
+      if ( program.vInput.isSafe(lastInput) && program.vInput(lastInput).vSlot.isSafe(i) )
       {
-         if ( vCodeLine.isSafe(currentLine-1) && vCodeLine(currentLine-1)->vExpressionToken.isSafe(i+1) )
+         EASI_Input& in = program.vInput(lastInput);
+         if ( in.vIsString(i) )
          {
-            varTable.set(vCodeLine(currentLine-1)->vExpressionToken(i+1),vInput(i));
+            varTable.vValue(in.vSlot(i)).setString(vInput(i));
+         }
+         else if ( DataTools::isNumeric(vInput(i)) )
+         {
+            varTable.vValue(in.vSlot(i)).setInteger(strtol(vInput(i).c_str(),0,10));
          }
          else
          {
-            std::cout<<"Error loading var table.\n";
+            // convert invalid values to 0.
+            varTable.vValue(in.vSlot(i)).setInteger(0);
          }
-         
-
       }
-
-      std::string rString = "Inputs recieved:\n";
-      for(int i=0;i<vInput.size();++i)
+      else
       {
-         rString+=vInput(i)+"\n";
+         std::cout<<"Error loading var table.\n";
       }
-      vInput.clear();
-      return rString;
    }
    
-   // Run the current line of code
-   if (vCodeLine.isSafe(currentLine)==false)
+   std::string rString = "Inputs recieved:\n";
+   for(int i=0;i<vInput.size();++i)
    {
-      std::cout<<"EASI: End of program\n";
-      terminated=true;
-      currentLine=0;
-      return "END OF PROGRAM\n";
+      rString+=vInput(i)+"\n";
    }
-   
-   int oldLine = currentLine;
-   
-   std::string strEval = evaluate (vCodeLine(currentLine));
-   
-   if ( currentLine == oldLine )
-   { // only increment linenumber if it hasn't been modified by the code
-      ++currentLine;
-   }
-
-   return strEval;
+   vInput.clear();
+   return rString;
 }
 
-std::string EASI::evaluate(CodeLine* _codeLine)
-{   
-   if ( _codeLine == 0 )
+std::string EASI::cycle()
+{
+   if (terminated) { return ""; }
+   // Waiting for input, continue waiting
+   if (isWaitingInput > 0) { return ""; }
+   
+   // Inputs have been recieved. Process and clear.
+   if (vInput.size() > 0 )
    {
-      return "ERROR: Null CodeLine ptr\n";
+      return receiveInput();
    }
+   
+   std::string strOutput = "";
+   execute(1,true,strOutput);
+   return strOutput;
+}
 
-   std::cout<<"Evaluating line: "<<_codeLine->strLineStripped<<"\n";
-
-   // 1: Sub all variables into expressions, replace uninitialized vars with 0 or null string.
-   // 2: Evaluate expression, assign if necessary.
-   //    There's no need to worry about combining strings and expressions except with PRINT,
-   //    as mixing of var types is forbidden.
-   //    todo: Account for positive/negative prefixes, which can be found either at the
-   //    start of an expression, or following other operators.
-   // 3: Evaluate and execute keywords.
+std::string EASI::run(const unsigned int _maxInstructions)
+{
+   if (terminated || isWaitingInput > 0) { return ""; }
+   
+   std::string strOutput = receiveInput();
+   execute(_maxInstructions,false,strOutput);
+   return strOutput;
+}
 
-   // sub all variables using token vector
-   //  should be moved into a function
+unsigned int EASI::execute(const unsigned int _maxInstructions, const bool _singleLine, std::string& _output)
+{
+   unsigned int nRun = 0;
+   const int nCode = program.vCode.size();
    
-   // only sub existing vars
-   // note that BASIC assumes any non-system keyword is a var,
-   // so maybe we will change this later.
-   Vector <std::string> vSubbedToken = _codeLine->vExpressionToken;
-   for (int i=0;i<vSubbedToken.size();++i)
+   while (nRun < _maxInstructions || _singleLine)
    {
-		std::cout<<"Checking sub: "<<vSubbedToken(i)<<"\n";
-      if ( varTable.hasVar(vSubbedToken(i)) )
-      {
-         if ( varTable.isRealVar(vSubbedToken(i)) ) // get variable as-is
-         {
-            vSubbedToken(i) = varTable.get(vSubbedToken(i));
-         }
-         else if ( varTable.isStringVar(vSubbedToken(i)) ) // add quotes to sub so we know it's a string
-         {
-            vSubbedToken(i) = "\"" + varTable.get(vSubbedToken(i)) + "\"";
-         }
-      }
-   }
-   
-   // Assignment expression
-   // Checking for "FOR" is not good. In future we should insert "LET"
-   // into raw expressions.
-   if ( _codeLine->assignmentVar != "" && _codeLine->keyword != "FOR")
-   {
-      if ( _codeLine->vAssignmentIndices.size() > 0 )
-      {
-         // this is an array assignment
-         // each dim must be evaluated
-         Vector <unsigned short int> vArrayIndex;
-         
-         // evaluate each index and push result to index vector
-         for (int i=0;i<_codeLine->vAssignmentIndices.size();++i)
-         {
-            shunt.shunt(_codeLine->vAssignmentIndices(i));
-            long int index = shunt.evaluate();
-            if ( index > 256 )
-            {
-               std::cout<<"ARRAY OUT OF BOUNDS\n";
-               return "";
-            }
-            vArrayIndex.push(index);
-         }
-         
-         varTable.set(_codeLine->assignmentVar,vArrayIndex,"TEST");
-         
-         return "";
-         
-         std::string strEvalExpression = "";
-         for (int i=1;i<vSubbedToken.size();++i)
-         {
-            if (vSubbedToken(i)==",")
-            {
-               //evaluate index and keep going
-               shunt.shunt(strEvalExpression);
-               strEvalExpression="";
-               long int index = shunt.evaluate();
-               if ( index > 256 )
-               {
-                  std::cout<<"ARRAY OUT OF BOUNDS\n";
-                  return "";
-               }
-               vArrayIndex.push(index);
-               continue;
-            }
-            if ( vSubbedToken(i) == "=" )
-            {
-            }
-            strEvalExpression += vSubbedToken(i);
-         }
-         
-         //evaluate final index
-         shunt.shunt(strEvalExpression);
-         strEvalExpression="";
-         long int index = shunt.evaluate();
-         if ( index > 256 )
-         {
-            std::cout<<"ARRAY OUT OF BOUNDS\n";
-            return "";
-         }
-         vArrayIndex.push(index);
-         
-         // assign array value
-         std::cout<<"Assigning array var\n";
-         varTable.set(_codeLine->assignmentVar,"1");
-         
-         
-         return "";
-      }
-      else
+      if ( pc >= nCode )
       {
+         _output+="END OF PROGRAM\n";
+         terminated=true;
+         pc=0;
+         break;
       }
       
-      // rebuild subbed expression into string
-      std::string strEvalExpression = "";
-      for (int i=0;i<vSubbedToken.size();++i)
-      {
-         strEvalExpression += vSubbedToken(i);
-      }
+      const EASI_Instruction& in = program.vCode(pc++);
+      ++nRun;
       
-      // real variable evaluation
-      if ( varTable.isRealVar(_codeLine->assignmentVar) )
-      {
-         shunt.shunt(strEvalExpression);
-         std::string strResult = DataTools::toString(shunt.evaluate());
-         varTable.set(_codeLine->assignmentVar,DataTools::toString(strResult));
-      }
-      // string variable evaluation
-      else if (varTable.isStringVar(_codeLine->assignmentVar) )
+      switch (in.op)
       {
-         // assigning string vars is simpler because there's only the + operator
-         bool isString = false;
-         std::string strVarAssignment = "";
-         
-         for (unsigned int i=0;i<strEvalExpression.size();++i)
-         {
-            if ( strEvalExpression[i] == '"' )
-            {
-               isString = !isString;
-               continue;
-            }
+         case EASI_NOP:
+            break;
+         case EASI_PUSH_NUM:
+            vStack.push_back(program.vNumber(in.arg));
+            break;
+         case EASI_PUSH_STR:
+            vStringStack.push_back(program.vString(in.arg));
+            break;
+         case EASI_LOAD_NUM:
+            vStack.push_back(varTable.vValue(in.arg).integer);
+            break;
+         case EASI_LOAD_STR:
+            vStringStack.push_back(varTable.vValue(in.arg).string);
+            break;
+         case EASI_STORE_NUM:
+            varTable.vValue(in.arg).setInteger(vStack.back());
+            vStack.pop_back();
+            break;
+         case EASI_STORE_STR:
+            varTable.vValue(in.arg).string.swap(vStringStack.back());
+            vStringStack.pop_back();
+            break;
             
-            if ( isString )
+         // Binary operators leave their result in the left value.
+         case EASI_ADD: vStack[vStack.size()-2] += vStack.back(); vStack.pop_back(); break;
+         case EASI_SUB: vStack[vStack.size()-2] -= vStack.back(); vStack.pop_back(); break;
+         case EASI_MUL: vStack[vStack.size()-2] *= vStack.back(); vStack.pop_back(); break;
+         case EASI_DIV:
+            if ( vStack.back()==0 )
             {
-               strVarAssignment += strEvalExpression[i];
+               std::cout<<"ERROR: Divide by 0.\n";
+               vStack[vStack.size()-2] = 0;
             }
-         }
+            else { vStack[vStack.size()-2] /= vStack.back(); }
+            vStack.pop_back();
+            break;
+         case EASI_POW:
+            vStack[vStack.size()-2] = pow(vStack[vStack.size()-2],vStack.back());
+            vStack.pop_back();
+            break;
+         case EASI_EQ: vStack[vStack.size()-2] = vStack[vStack.size()-2] == vStack.back() ? -1 : 0; vStack.pop_back(); break;
+         case EASI_NE: vStack[vStack.size()-2] = vStack[vStack.size()-2] != vStack.back() ? -1 : 0; vStack.pop_back(); break;
+         case EASI_LT: vStack[vStack.size()-2] = vStack[vStack.size()-2] < vStack.back() ? -1 : 0; vStack.pop_back(); break;
+         case EASI_LE: vStack[vStack.size()-2] = vStack[vStack.size()-2] <= vStack.back() ? -1 : 0; vStack.pop_back(); break;
+         case EASI_GT: vStack[vStack.size()-2] = vStack[vStack.size()-2] > vStack.back() ? -1 : 0; vStack.pop_back(); break;
+         case EASI_GE: vStack[vStack.size()-2] = vStack[vStack.size()-2] >= vStack.back() ? -1 : 0; vStack.pop_back(); break;
          
-         varTable.set(_codeLine->assignmentVar,strVarAssignment);
-      }
-
-   //std::cout<<varTable.toString();
-   }
-   // IF <expression> THEN <linenumber>
-   // or:
-   // IF <expression> THEN <command>
-   else if ( _codeLine->keyword == "IF" )
-   {
-      // evaluate everything between IF and THEN.
-      std::cout<<"EVALUATING IF\n";
-      
-      // sub in vars
-      // sub all variables using token vector
-      // vSubbedToken.clear();
-      // vSubbedToken = _codeLine->vExpressionToken;
-      // for (int i=0;i<vSubbedToken.size();++i)
-      // {
-         // if ( varTable.isRealVar(vSubbedToken(i)) ) // get variable as-is
-         // {
-            // vSubbedToken(i) = varTable.get(vSubbedToken(i));
-         // }
-         // else if ( varTable.isStringVar(vSubbedToken(i)) ) // add quotes to sub so we know it's a string
-         // {
-            // vSubbedToken(i) = "\"" + varTable.get(vSubbedToken(i)) + "\"";
-         // }
-      // }
-      // rebuild subbed expression into string
-      std::string strEvalExpression = "";
-      for (int i=0;i<vSubbedToken.size();++i)
-      {
-         strEvalExpression += vSubbedToken(i);
-      }
-      
-      shunt.shunt(strEvalExpression);
-      std::string strResult = DataTools::toString(shunt.evaluate());
-      //varTable.set(_codeLine->assignmentVar,DataTools::toString(strResult));
-      
-      std::cout<<"RESULT: "<<strResult<<"\n";
-      
-      // -1 is true, execute arg.
-      if (strResult == "-1")
-      {
-         std::cout<<"TRUE, EXECUTING ARG: "<<_codeLine->arg<<"\n";
-         // if arg is a number, jump to that label
+         case EASI_NEG: vStack.back() = -vStack.back(); break;
+         case EASI_ABS: vStack.back() = labs(vStack.back()); break;
+         case EASI_RND: vStack.back() = Random::randomInt(vStack.back()); break;
          
-         if (DataTools::isNumeric(_codeLine->arg))
+         case EASI_CONCAT:
+            vStringStack[vStringStack.size()-2] += vStringStack.back();
+            vStringStack.pop_back();
+            break;
+         case EASI_STR_EQ:
+         case EASI_STR_NE:
          {
-            std::cout<<"JUMP TO LINE : "<<_codeLine->arg<<"\n";
-            jumpToLabel(_codeLine->arg);
+            const bool equal = vStringStack[vStringStack.size()-2] == vStringStack.back();
+            vStack.push_back( equal == (in.op==EASI_STR_EQ) ? -1 : 0 );
+            vStringStack.pop_back();
+            vStringStack.pop_back();
+            break;
          }
          
-         // if arg is not a number, execute the line like a normal code line.
-      }
-      else
-      {
-         std::cout<<"FALSE, CONTINUING\n";
-      }
-
-      // 0 is false, continue next line.
-      
-   }
-   else if ( _codeLine->keyword == "DIM" )
-   {
-      // token 2 must be a var.
-      // token 3 must be an opening paren
-      // remaining tokens are array dimension expressions, comma delimited
-      // final token is closing paren
-      
-      std::string strEvalExpression = "";
-      for (int i=0;i<vSubbedToken.size();++i)
-      {
-         strEvalExpression += vSubbedToken(i);
-      }
-      //std::cout<<"EVAL: "<<strEvalExpression<<"\n";
-      
-      if ( vSubbedToken.size()>2)
-      {
-         if ( vSubbedToken(1) == "(" )
-         {
-            if (varTable.isValid(vSubbedToken(0)))
-            {
-            }
-            else
-            {
-               std::cout<<"Error: Invalid var name.\n";
-               return "";
-            }
-            //std::cout<<"Valid DIM\n";
-            
-            // build sub-expressions and push results to array dim vector
-            Vector <unsigned short int> vArrayDim;
-            std::string currentExpression = "";
-            for (int i=2;i<vSubbedToken.size();++i)
-            {
-               if ( vSubbedToken(i) == "," )
-               {
-                  // evaluate expr and continue
-                  if (currentExpression.size() == 0 )
-                  { // something went wrong
-                     std::cout<<"Error building array\n";
-                     return "";
-                  }
-                  
-                  //std::cout<<"evaluating sub expressoin: "<<currentExpression<<"\n";
-                  Shunting sh;
-                  sh.shunt(currentExpression);
-                  vArrayDim.push(sh.evaluate());
-                  currentExpression="";
-                  
-                  
-               }
-               else if (vSubbedToken(i) == ")")
-               {
-                  // evaluate final expressoin and finished.
-                  // evaluate expr and continue
-                  if (currentExpression.size() == 0 )
-                  { // something went wrong
-                     std::cout<<"Error building array\n";
-                     return "";
-                  }
-                  
-                  //std::cout<<"evaluating sub expressoin: "<<currentExpression<<"\n";
-                  Shunting sh;
-                  sh.shunt(currentExpression);
-                  vArrayDim.push(sh.evaluate());
-                  currentExpression="";
-                  
-                  varTable.addArray(vSubbedToken(0),vArrayDim);
-                  
-                  //std::cout<<"finished building array\n";
-                  
-                  //std::cout<<"Vartable:\n"<<varTable.toString()<<"\n";
-               }
-               else
-               {
-                  currentExpression+=vSubbedToken(i);
-               }
-            }
-            // std::cout<<"DIMs are: ";
-            // for (int i=0;i<vArrayDim.size();++i)
-            // { std::cout<<vArrayDim(i)<<", ";
-            // } std::cout<<"\n";
-            
-            
+         case EASI_PRINT_NUM:
+            printLine+=std::to_string(vStack.back());
+            vStack.pop_back();
+            break;
+         case EASI_PRINT_STR:
+            printLine+=vStringStack.back();
+            vStringStack.pop_back();
+            break;
+         case EASI_PRINT_END:
+            _output+=printLine;
+            if ( _singleLine==false ) { _output+="\n"; }
+            printLine.clear();
+            break;
             
-            return "";
-         }
-         else
+         case EASI_JUMP:
+            pc=in.arg;
+            break;
+         case EASI_JUMP_FALSE:
+            if ( vStack.back()==0 ) { pc=in.arg; }
+            vStack.pop_back();
+            break;
+         case EASI_NEXT:
          {
-            std::cout<<"INVALID DIM\n";
-            return "";
-         }
-      }
-      else
-      {
-         std::cout<<"INVALID DIM\n";
-         return "";
-      }
-   }
-   else if ( _codeLine->keyword == "GOTO" )
-   {
-      jumpToLabel(_codeLine->expression);
-   }
-   else if ( _codeLine->keyword == "INPUT" )
-   {
-      //Execution freezes until user presses enter.
-      // INPUT can contain string output, followed by ;.
-      // Multiple vars can be listed, separated by commas.
-      // Example: INPUT "PLEASE ENTER 2 NUMBERS"; A
-      // program will repeat input if a string is entered into a number var
-      // numbers can be entered as strings.
-      isWaitingInput=_codeLine->vExpressionToken.size()-1;
-      if ( isWaitingInput < 1)
-      {
-         std::cout<<"Error with INPUT command\n";
-         isWaitingInput=0;
-      }
-      else
-      {
-         std::cout<<"Waiting for input\n";
-      }
-      
-      return _codeLine->vExpressionToken(0);
-   }
-   else if ( _codeLine->keyword == "NEXT" )
-   {
-      //scan up until we find a FOR keyword.
-      forCycle();
-      return "";
-   }
-   else if ( _codeLine->keyword == "PRINT" )
-   {
-      // PRINT can return strings, evaluate an expression, or a combination of both.
-      // Strings can be string var or text enclosed in quotes.
-      // adjacent strings are automatically appended, even without a + operator
-      // Any operations between strings and non-strings are invalid.
-      // PRINT will also evaluate normal expressions.
-      
-      // rebuild subbed expression into string
-      std::string strEvalExpression = "";
-      
-      std::string expressionToEvaluate="";
-      
-      //bool lastWasString = false;
-      bool appendingString = false;
-      
-      for (int i=0;i<vSubbedToken.size();++i)
-      {
-         // replace all instances of "\\n" with '\n'.
-         size_t index = 0;
-         while (true) //https://stackoverflow.com/questions/4643512/replace-substring-with-another-substring-c
-         {
-              /* Locate the substring to replace. */
-              index = vSubbedToken(i).find("\\N", index);
-              if (index == std::string::npos) break;
-
-              /* Make the replacement. */
-              vSubbedToken(i).replace(index, 2, "\n");
-
-              /* Advance index forward so the next iteration doesn't pick it up as well. */
-              index += 2;
-         }
-         
-         //number variable
-         if (DataTools::isNumeric(vSubbedToken(i)))
-         {
-            //if last was string, then invalid operation.
-            if (appendingString) //invalid
+            EASI_Loop& loop = program.vLoop(in.arg);
+            for (int i=0;i<loop.vExtraSlot.size();++i)
             {
-               return "ERROR\n";
+               EASI_Value& value = varTable.vValue(loop.vExtraSlot(i));
+               value.setInteger(value.integer+loop.step);
             }
-            else
-            {
-               //strEvalExpression+=vSubbedToken(i);
-               expressionToEvaluate+=vSubbedToken(i);
-            }
-         }
-         else if (vSubbedToken(i).size()>1 && vSubbedToken(i)[0] == '"' && vSubbedToken(i).back()=='"')
-         { // is a string
-            //this is a string, only appending is possible.
             
-            
-            //EVALUATE EXPRESSION
-            if (expressionToEvaluate.size() > 0)
-            {
-               //EVALUATE
-               shunt.shunt(expressionToEvaluate);
-               std::string strResult = DataTools::toString(shunt.evaluate());
-               strEvalExpression+=strResult;
-               expressionToEvaluate="";
-            }
-            
-            // remove first and last char
-            strEvalExpression+=vSubbedToken(i).substr(1, vSubbedToken(i).size() - 2);
-            
-            //Strings can only be followed by + and another string, another string, or a number.
-            //lastWasString=true;
-            appendingString=false;
+            // Note that loops use inclusive ranges.
+            EASI_Value& counter = varTable.vValue(loop.slot);
+            counter.setInteger(counter.integer+loop.step);
+            const long int value = counter.integer;
+            if ( loop.step < 0 ? value >= loop.to : value <= loop.to )
+            { pc=loop.start; }
+            break;
          }
-         else // operator or invalid.
+         case EASI_LOAD_ARRAY:
          {
-            expressionToEvaluate+=vSubbedToken(i);
+            // the indexes are the top nDims values on the stack.
+            const EASI_Array& array = program.vArray(in.arg);
+            const int first = vStack.size()-array.nDims;
+            long int* element = varTable.getArrayElement(array.slot,&vStack[first],array.nDims);
+            vStack[first] = element==0 ? 0 : *element;
+            vStack.resize(first+1);
+            break;
          }
-      }
-      
-      //FINAL CASE EVALUATE EXPRESSION
-      if (expressionToEvaluate.size() > 0)
-      {
-            //EVALUATE
-            shunt.shunt(expressionToEvaluate);
-            std::string strResult = DataTools::toString(shunt.evaluate());
-            strEvalExpression+=strResult;
-            expressionToEvaluate="";
-      }
-      return strEvalExpression;
-   }
-   else if ( _codeLine->keyword == "END" )
-   { // Get off Mr Bones' Wild Ride
-      terminated=true;
-      currentLine=0;
-   }
-   
-   
-   return "";
-
-   
-   
-
-   std::string _str = "";
-   std::string _strSubExpression = "";
-   
-   Vector <std::string> _vString;
-   Vector <std::string> _vSubExpression;
-   
-   bool isString=false;
-   // we need to sub all variables here to prevent confusion with string variables in expressions.
-   // variables are alphabetical, so we just scan for any alphabetical chars.
-   // in future we must make sure we aren't reading in keywords or functions
-   // BASIC and EASI set unknown variables to 0, this includes throwing /0 errors.
-   std::string _strSubbedCode = "";
-   std::string _strVar = "";
-   
-         // need to account for assignment expressions here.
-         // assignment can have a single lvalue, but multiple rvalues.
-   std::string _strAssignment = ""; // Variable to assign if required.
-   //bool isLvalue=true; // only true for first element.
-   
-   std::string _strExpression = _codeLine->expression;
-   
-   
-   // step 1: determine if this is an assignment expression.
-   // This can only happen if there is no keyword, or the keyword is LET
-   
-   Vector <std::string> expressionTokens; // vector of tokens in expression
-   
-
-
-   
-   
-   //Step 0: figure out if this is an assignment expression, for example:
-   // A = B or
-   // VAR = 123+456*2
-   // Assignment expressions may only use a single =.
-   // Invalid assignments still run in BASIC. Assignment appears to become a comparator,
-   // with true returning -1 (11111111 11111111) TRUE
-   // and false returning 0 (0000000 00000000) FALSE
-   // TRUE appears to be a special case which converts to value -1. (10000000 00000001).
-   // however this is unlikely to appear in normal code.
-
-   
-   // Step 1: Sub in all variable values (except strings and assignment variable).
-   for (unsigned int i=0;i<_strExpression.size();++i)
-   {
-      if ( _strExpression[i] == '\"' ) // flip between expression and string
-      {
-         isString = !isString;
-         _strSubbedCode += '\"';
-         continue;
-      }
-         
-      if ( isString ) // ignore
-      {
-         _strSubbedCode += _strExpression[i];
-      }
-      else // scan for variables
-      {
-         // check is alpha
-         //check is dollarsign
-         
-         if ( DataTools::isAlpha(_strExpression[i]) )
-         {
-            _strVar+=_strExpression[i];
-         }
-         else if (_strExpression[i] == '$')
+         case EASI_STORE_ARRAY:
          {
-            //STRING VAR
-            // pull from vartable
-            //std::cout<<"Stringvar\n";
-            _strVar+='$';
-            _strSubbedCode += varTable.get(_strVar);
-            _strVar="";
-         }
-         else
-         {
-            // variable terminates.
-            if (_strVar != "")
-            {
-               // pull from vartable.
-               _strSubbedCode += varTable.get(_strVar);
-               _strVar="";
-            }
-            _strSubbedCode += _strExpression[i];
+            const long int value = vStack.back();
+            vStack.pop_back();
+            const EASI_Array& array = program.vArray(in.arg);
+            const int first = vStack.size()-array.nDims;
+            long int* element = varTable.getArrayElement(array.slot,&vStack[first],array.nDims);
+            if ( element!=0 ) { *element=value; }
+            vStack.resize(first);
+            break;
          }
-
-      }
-
-   }
-   //end case: final var
-   if ( _strVar.size() > 0 )
-   {
-      _strSubbedCode += varTable.get(_strVar);
-   }
-   
-   //create sub expression and string vector.
-   
-   isString=false;
-   for (unsigned int i=0;i<_strExpression.size();++i)
-   {
-      if ( _strExpression[i] == '\"' ) // flip between expression and string
-      {
-         isString = !isString;
-         
-         if ( isString ) // push the expression
+         case EASI_DIM:
          {
-            _vSubExpression.push(_strSubExpression);
-            _strSubExpression="";
+            const EASI_Array& array = program.vArray(in.arg);
+            const int first = vStack.size()-array.nDims;
+            varTable.dimArray(array.slot,&vStack[first],array.nDims);
+            vStack.resize(first);
+            break;
          }
-         else // push the string
+         case EASI_INPUT:
          {
-            _vString.push(_str);
-            _str="";
+            //Execution freezes until user presses enter.
+            EASI_Input& inputLine = program.vInput(in.arg);
+            lastInput=in.arg;
+            isWaitingInput=inputLine.vSlot.size();
+            _output+=inputLine.prompt;
+            break;
          }
+         case EASI_END:
+            // Get off Mr Bones' Wild Ride
+            terminated=true;
+            pc=0;
+            break;
       }
-      else if (isString)
-      {
-         _str += _strExpression[i];
-      }
-      else
-      {
-         _strSubExpression += _strExpression[i];
-      }
-   }
-   _vSubExpression.push(_strSubExpression);
-   
-   std::cout<<"Sub expressions\n";
-   for (int i=0;i<_vSubExpression.size();++i)
-   {
-      std::cout<<_vSubExpression(i)<<"\n";
-      //convert each sub expression with shunting
-      
-      std::stack <std::string> stkValue;
-      std::stack <std::string> stkOperator;
-      
-      std::queue <std::string> qVal;
-      
       
+      if ( terminated || isWaitingInput > 0 ) { break; }
+      if ( _singleLine && ( pc >= nCode || program.isLineStart(pc) ) ) { break; }
    }
    
-   std::cout<<"Sub strings\n";
-   for (int i=0;i<_vString.size();++i)
-   {
-      std::cout<<_vString(i)<<"\n";
-   }
-
-   // EVALUATE SUBEXPRESSIONS
-
-   // std::cout<<"Sub expressions\n";
-   // for (int i=0;i<_vSubExpression.size();++i)
-   // {
-      // std::cout<<_vSubExpression(i)<<"\n";
-      // std::string shunted = shunt(_vSubExpression(i));
-      // std::cout<<"Shunted to: "<<shunted<<"\n";
-   // }
-   
-
-   return _strExpression+"\n"+_strSubbedCode+"\n";
-
+   nInstructions+=nRun;
+   currentLine = pc < nCode ? program.vSourceLine(pc) : vCodeLine.size();
+   if ( terminated ) { currentLine=0; }
+   return nRun;
 }
 
-
-void EASI::jumpToLabel(std::string _label)
+std::string EASI::getVar(const std::string _name)
 {
-   for (int i=0;i<vCodeLine.size();++i)
-   {
-      if ( vCodeLine(i)->label == _label || vCodeLine(i)->lineLabel == _label )
-      {
-         currentLine = i;
-      }
-   }
+   return varTable.get(_name);
 }
 
-void EASI::forCycle()
-{ // move up until we find a FOR loop. Set the current line to that for loop
-   // we should also increment the variable
-   // Also we need the vars from the NEXT line
-
-   // save the NEXT line in case we need to exit the loop.
-   long int nextLine = currentLine;
-   
-   if ( vCodeLine(currentLine)->hasKeyword("NEXT") )
-   {
-      // get all the vars to STEP
-      Vector <std::string> vStep;
-      for (int i=1;i<vCodeLine(currentLine)->vArg.size();++i)
-      {
-         vStep.push(vCodeLine(currentLine)->vArg(i));
-      }
-      
-      while (currentLine >= 0 )
-      {
-         if ( vCodeLine(currentLine)->vArg.size() > 3 && vCodeLine(currentLine)->vArg(0) == "FOR" )
-         { // Found matching FOR
-            // Get target var name
-            std::string targetVarName = vCodeLine(currentLine)->vArg(1);
-            // Push the target var to the vector if it isn't already.
-            vStep.pushUnique(targetVarName);
-            
-            long int targetVarValue = DataTools::toInt(vCodeLine(currentLine)->vArg(3));
-
-            // step the variables.
-            long int stepAmount = DataTools::toInt(vCodeLine(currentLine)->vArg(4));
-
-            for (int i=0;i<vStep.size();++i)
-            {
-               long int var = DataTools::toInt(varTable.get(vStep(i)));
-               var+=stepAmount;
-               varTable.set(vStep(i),DataTools::toString(var));
-            }
-            // check if the target var has incremented to or past its target.
-            long int var = DataTools::toInt(varTable.get(targetVarName));
-            if ( var > targetVarValue ) // Note that loops use inclusive ranges.
-            {
-               currentLine=nextLine;
-               return;
-            }
-
-            return;
-         }
-         --currentLine;
-      }
-      if (currentLine<0)
-      {
-         std::cout<<"Error: Couldn't find matching FOR for NEXT\n";
-      }
-      return;
-   }
-   else
-   {
-      std::cout<<"ERROR: No NEXT here.\n";
-      std::cout<<"Line: "<<vCodeLine(currentLine)->strLine<<"\n";
-      return;
-   }
-   
-
-}
-
-#include <list> 
-#include <iterator> 
-
-//#include <Algorithm/Shunting.cpp>
-
-// std::string EASI::shunt(std::string _input)
-// {
-   // //Shunting shunt;
-   // shunt.shunt(_input);
-   
-   // std::cout<<"EASI: shunted: "<<shunt.toString()<<".\n";
-   // return shunt.toString();
-
-// }
-
 #endif
@@ -12,81 +12,153 @@
    have expanded functionality. The purpose of EASI is for use in programming and hacking games, but
    it could potentially also be used for scripting.
    
-   Todo: Shift from named strings to predictable token Vector.
+   load() parses the code into CodeLines, and then compiles them into bytecode (see
+   EASI_Bytecode.hpp). Variables become VarTable slots and expressions are converted to postfix
+   once, so running a line doesn't touch any strings unless the line uses them.
+   
+   cycle() runs one line of code. tick() runs up to instructionsPerTick instructions, so many
+   programs (for example every terminal in the game) can be run each frame at a fixed cost.
    
 */
 
-#include <stack> // for shunting-yard algorithm
+#include <unordered_map>
+#include <cstdlib> // strtol, strtod
+
+// Print each line as it is parsed and compiled.
+//#define EASI_LOAD_VERBOSE
+
+// A typed EASI value. Number variables hold integers, which is all the VM uses, but reals can
+// be set and read through VarTable, and are truncated when the VM reads them.
+class EASI_Value
+{
+   public:
+   enum enumType { INTEGER, REAL, STRING };
+   
+   unsigned char type;
+   long int integer;
+   double real;
+   std::string string;
+   
+   EASI_Value()
+   {
+      type=INTEGER;
+      integer=0;
+      real=0;
+   }
+   
+   void setInteger(const long int _value)
+   {
+      type=INTEGER;
+      integer=_value;
+   }
+   void setReal(const double _value)
+   {
+      type=REAL;
+      real=_value;
+      integer=_value;
+   }
+   void setString(const std::string _value)
+   {
+      type=STRING;
+      string=_value;
+   }
+   
+   double getReal() const
+   {
+      return type==REAL ? real : integer;
+   }
+   
+   std::string toString() const
+   {
+      if ( type==STRING ) { return string; }
+      if ( type==REAL ) { return DataTools::toString(real); }
+      return std::to_string(integer); // much faster than an ostringstream
+   }
+};
 
-// Simple table to lookup variable names and values
+// Table of variables and arrays. Names are resolved to slots once, and the slots can then be
+// used directly, which is what the EASI compiler does.
 // VarTable is held by EASI.
 class VarTable
 {
-   private:
+   public:
+   
+   // Array of integers, stored flat in row-major order. Each index is bounds-checked.
    class VarTableArray
    {
       public:
       std::string name; // Name of the array
-      Vector <unsigned short int> vDim; // list of dimensions
-      Vector <int> vValue; // vector of array values, initialised to 0.
+      Vector <long int> vDim; // size of each dimension
+      Vector <long int> vStride; // elements between consecutive indexes of each dimension
+      Vector <long int> vValue; // vector of array values, initialised to 0.
       
       VarTableArray()
       {
          name="";
       }
-      void init(std::string _name, Vector <unsigned short int> _vDim)
+      
+      bool isDimensioned()
+      {
+         return vDim.size() > 0;
+      }
+      
+      bool init(const long int* _aDim, const int _nDims)
       {
-         if (_vDim.size()==0)
+         if (_nDims==0)
          {
             std::cout<<"Error: Constructing null array dims\n";
-            return;
+            return false;
          }
          
-         name=_name;
-         vDim=_vDim;
+         long int totalIndex=1;
+         for (int i=0;i<_nDims;++i)
+         {
+            if ( _aDim[i] < 1 || _aDim[i] > 65535 || totalIndex*_aDim[i] > 16777216 )
+            {
+               std::cout<<"Error: invalid array size\n";
+               return false;
+            }
+            totalIndex*=_aDim[i];
+         }
          
-         unsigned long int totalIndex=vDim(0);
-         for (int i=1;i<vDim.size();++i)
+         vDim.clear();
+         vStride.clear();
+         for (int i=0;i<_nDims;++i)
          {
-            totalIndex*=vDim(i);
+            vDim.push(_aDim[i]);
+            vStride.push(0);
          }
-         for (unsigned int i=0;i<totalIndex;++i)
+         long int stride=1;
+         for (int i=_nDims-1;i>=0;--i)
          {
-            vValue.push(0);
+            vStride(i)=stride;
+            stride*=vDim(i);
          }
+         vValue.data.assign(totalIndex,0);
+         return true;
       }
-      void set(Vector<unsigned short int> vAddress, std::string _value)
+      
+      // Return the element, or 0 if the index is invalid.
+      long int* get(const long int* _aIndex, const int _nIndexes)
       {
-         if (vAddress.size() != vDim.size())
+         if ( _nIndexes != vDim.size() )
          {
             std::cout<<"Incorrect array index\n";
-            return;
+            return 0;
          }
-         for (int i=0;i<vDim.size();++i)
+         long int index=0;
+         for (int i=0;i<_nIndexes;++i)
          {
-            if (vAddress(i) >= vDim(i))
+            if ( _aIndex[i] < 0 || _aIndex[i] >= vDim(i) )
             {
                std::cout<<"Error: array index out of bounds\n";
-               return;
-            }
-         }
-         // we can safely set this value.
-         // Set the value using the following algorithm:
-         //    [ index(1)*( S2* S3* S4 * ... * Sn) + index(2)*( S3* S4* S5 * ... * Sn)
-         //    + ... + index(n-1)*Sn + index(n) ] 
-         unsigned long int index=0;
-         for (int i=0;i<vDim.size()-1;++i)
-         {
-            long int totalMult = vAddress(i);
-            for (int i2=i+1;i2<vDim.size();++i2)
-            {
-               totalMult*=vDim(i2);
+               return 0;
             }
-            index+=totalMult;
+            index+=_aIndex[i]*vStride(i);
          }
-         index+=vAddress(vAddress.size()-1);
-         vValue(index)=1;
+         return &vValue(index);
       }
+      
       std::string toString()
       {
          std::string strRet = "";
@@ -98,48 +170,29 @@ class VarTable
       }
    };
    
-   public:
-   Vector <std::string> vVarName;
-   Vector <std::string> vVarValue;
+   Vector <std::string> vVarName; // name of each slot
+   Vector <EASI_Value> vValue; // value of each slot
+   std::unordered_map <std::string,int> mSlot;
    
    Vector <VarTableArray*> vArray;
+   std::unordered_map <std::string,int> mArraySlot;
    
    VarTable()
    {
    }
-   
-   void addArray(std::string strArrayName, Vector <unsigned short int> vDim)
+   ~VarTable()
    {
-      //std::cout<<"Vartable: Building array: "<<strArrayName<<"\n";
-      VarTableArray* vta = new VarTableArray;
-      vta->init(strArrayName,vDim);
-      vArray.push(vta);
+      clear();
    }
    
    // return true if var is a valid numeric or string variable name
-   bool isValid(std::string _varName)
+   static bool isValid(const std::string& _varName)
    {
-      if (_varName.size() == 0 )
-      { return false; }
-      
-      for (unsigned int i=0;i<_varName.size()-1;++i)
-      {
-         if ( _varName[i] < 65 || _varName[i] > 90 )
-         {
-            return false;
-         }
-      }
-      
-      if ( _varName.back() == '$'
-        || (_varName.back() > 64 && _varName.back() < 91) )
-      { return true; }
- 
-      
-      return false;
+      return isRealVar(_varName) || isStringVar(_varName);
    }
    
    // real vars must be uppercase alpha characters only
-   bool isRealVar ( std::string _varName )
+   static bool isRealVar (const std::string& _varName)
    {
       if ( _varName.size() == 0 )
       { return false; }
@@ -156,9 +209,9 @@ class VarTable
    }
 
    // string vars must be uppercase alpha and end with a $
-   bool isStringVar (std::string _varName)
+   static bool isStringVar (const std::string& _varName)
    {
-      if (_varName.size() == 0 )
+      if (_varName.size() < 2 || _varName.back() != '$' )
       { return false; }
       
       for (unsigned int i=0;i<_varName.size()-1;++i)
@@ -169,79 +222,131 @@ class VarTable
          }
       }
       
-      if ( _varName.back() != '$' )
-      { return false; }
- 
-      
       return true;
    }
    
+   // Slot of the variable, or -1 if it doesn't exist.
+   int findSlot(const std::string& _varName) const
+   {
+      auto it = mSlot.find(_varName);
+      return it==mSlot.end() ? -1 : it->second;
+   }
+   
+   // Slot of the variable, adding it if necessary. New variables are 0 or a null string.
+   int getSlot(const std::string& _varName)
+   {
+      auto it = mSlot.find(_varName);
+      if ( it!=mSlot.end() ) { return it->second; }
+      
+      EASI_Value value;
+      if ( isStringVar(_varName) ) { value.setString(""); }
+      
+      vVarName.push(_varName);
+      vValue.push(value);
+      mSlot[_varName]=vValue.size()-1;
+      return vValue.size()-1;
+   }
    
-   // Automatically adds the variable or updates it as required.
-   void set(std::string _varName, std::string _varValue)
+   // Slot of the array, adding it if necessary. Arrays aren't dimensioned until DIM or their
+   // first use.
+   int getArraySlot(const std::string& _arrayName)
    {
-      //std::cout<<"Set "<<_varName<<" -> "<<_varValue<<".\n";
+      auto it = mArraySlot.find(_arrayName);
+      if ( it!=mArraySlot.end() ) { return it->second; }
       
-      for (int i=0;i<vVarName.size();++i)
+      VarTableArray* vta = new VarTableArray;
+      vta->name=_arrayName;
+      vArray.push(vta);
+      mArraySlot[_arrayName]=vArray.size()-1;
+      return vArray.size()-1;
+   }
+   
+   // DIM allocates an array. Once an array is dimensioned, it cannot be redimensioned.
+   bool dimArray(const int _slot, const long int* _aDim, const int _nDims)
+   {
+      if ( vArray(_slot)->isDimensioned() )
       {
-         if ( vVarName(i) == _varName )
-         {
-            if ( DataTools::isNumeric(_varValue)==false && isRealVar(_varName) )
-            {
-               // convert invalid values to 0.
-               vVarValue(i) = "0";
-            }
-            else
-            { vVarValue(i) = _varValue;
-            }
-            
-            return;
-         }
+         std::cout<<"Error: Array "<<vArray(_slot)->name<<" is already dimensioned\n";
+         return false;
       }
-      vVarName.push(_varName);
-      vVarValue.push(_varValue);
+      return vArray(_slot)->init(_aDim,_nDims);
    }
-   // Same but for array
-   // If array doesn't exist, it will be automatically initialised with 11 indexes on each dimension.
-   void set(std::string _varName, Vector <unsigned short int> vDim, std::string _varValue)
+   
+   // Element of the array, or 0 if the index is invalid. If the array hasn't been dimensioned,
+   // it will be automatically initialised with 11 indexes on each dimension.
+   long int* getArrayElement(const int _slot, const long int* _aIndex, const int _nIndexes)
    {
-      //std::cout<<"Set array "<<_varName<<" -> "<<_varValue<<".\n";
-      
-      for (int i=0;i<vArray.size();++i)
+      VarTableArray* vta = vArray(_slot);
+      if ( vta->isDimensioned()==false )
       {
-         if ( vArray(i)->name == _varName )
-         {
-            vArray(i)->set(vDim,_varValue);
-            return;
-         }
+         std::vector <long int> vDim (_nIndexes,11);
+         if ( vta->init(vDim.data(),_nIndexes)==false ) { return 0; }
       }
-      // initialise here
-      std::cout<<"Array not found, initialise here\n";
-      // vVarName.push(_varName);
-      // vVarValue.push(_varValue);
+      return vta->get(_aIndex,_nIndexes);
    }
    
+   void addArray(std::string strArrayName, Vector <unsigned short int> vDim)
+   {
+      std::vector <long int> vSize (vDim.data.begin(),vDim.data.end());
+      dimArray(getArraySlot(strArrayName),vSize.data(),vSize.size());
+   }
+   
+   // Automatically adds the variable or updates it as required.
+   void set(std::string _varName, std::string _varValue)
+   {
+      EASI_Value& value = vValue(getSlot(_varName));
+      if ( isStringVar(_varName) )
+      {
+         value.setString(_varValue);
+         return;
+      }
+      
+      const char* str = _varValue.c_str();
+      char* end = 0;
+      const long int integer = strtol(str,&end,10);
+      if ( _varValue.size() > 0 && *end==0 )
+      {
+         value.setInteger(integer);
+         return;
+      }
+      const double real = strtod(str,&end);
+      if ( _varValue.size() > 0 && *end==0 )
+      {
+         value.setReal(real);
+         return;
+      }
+      // convert invalid values to 0.
+      value.setInteger(0);
+   }
+   // Same but for array
+   void set(std::string _varName, Vector <unsigned short int> vDim, const int _varValue)
+   {
+      std::vector <long int> vIndex (vDim.data.begin(),vDim.data.end());
+      long int* element = getArrayElement(getArraySlot(_varName),vIndex.data(),vIndex.size());
+      if ( element!=0 ) { *element=_varValue; }
+   }
    
    std::string get(std::string _varName)
    {
-      for (int i=0;i<vVarName.size();++i)
+      const int slot = findSlot(_varName);
+      if ( slot!=-1 )
       {
-         if (vVarName(i) == _varName)
-         {
-            return vVarValue(i);
-         }
+         return vValue(slot).toString();
       }
       // BASIC and EASI assume unknown variables are 0.
-      return "0";
+      return isStringVar(_varName) ? "" : "0";
    }
    bool hasVar(std::string _varName)
    {
-      return vVarName.contains(_varName);
+      return findSlot(_varName)!=-1;
    }
    void clear()
    {
       vVarName.clear();
-      vVarValue.clear();
+      vValue.clear();
+      mSlot.clear();
+      vArray.deleteAll();
+      mArraySlot.clear();
    }
    
    std::string toString()
@@ -249,23 +354,22 @@ class VarTable
       std::string strRet = "";
       for (int i=0;i<vVarName.size();++i)
       {
-         strRet+=" "+vVarName(i)+": "+vVarValue(i)+"\n";
+         strRet+=" "+vVarName(i)+": "+vValue(i).toString()+"\n";
       }
       
-      std::cout<<"Arrays:\n";
+      strRet+="Arrays:\n";
       
       for (int i=0;i<vArray.size();++i)
       {
-         std::cout<<"  "<<vArray(i)->name<<"(";
+         strRet+="  "+vArray(i)->name+"(";
          for (int i2=0;i2<vArray(i)->vDim.size();++i2)
          {
-            std::cout<<vArray(i)->vDim(i2)<<",";
-         }std::cout<<")\n";
-         
-         std::cout<<"Array content: "<<vArray(i)->toString()<<"\n";
+            strRet+=DataTools::toString(vArray(i)->vDim(i2))+",";
+         }
+         strRet+=")\n";
+         strRet+="Array content: "+vArray(i)->toString()+"\n";
       }
       
-      
       return strRet;
    }
 };
@@ -396,11 +500,15 @@ class CodeLine
                   // which executes if true, and does not execute if false.
                   if ( found != std::string::npos )
                   {
+                     #ifdef EASI_LOAD_VERBOSE
                      std::cout<<" IF CONTAINS A THEN\n";
+                     #endif
                      keyword = "IF";
                      i+=2;
                      expression = _strLine.substr(i,found-i);
+                     #ifdef EASI_LOAD_VERBOSE
                      std::cout<<"EXPRESSOIN: "<<expression<<"\n";
+                     #endif
                      i=found+4;
                      
                      arg = _strLine.substr(i);
@@ -409,7 +517,9 @@ class CodeLine
                   }
                   else
                   {
+                     #ifdef EASI_LOAD_VERBOSE
                      std::cout<<" IF BUT NO THEN\n";
+                     #endif
                   }
                   
                   
@@ -440,7 +550,9 @@ class CodeLine
                   std::size_t found = _strLine.find("TO",i2);
                   if (found==std::string::npos)
                   {
+                     #ifdef EASI_LOAD_VERBOSE
                      std::cout<<"Syntax error\n";
+                     #endif
                      return;
                   }
                   expression = _strLine.substr(i2,found-i2);
@@ -503,7 +615,9 @@ class CodeLine
                else if (_strLine.rfind("POKE",i,4) == i)
                {
                   // POKE is 2 expressions separated by commas.
+                  #ifdef EASI_LOAD_VERBOSE
                   std::cout<<"FOUND POKE\n";
+                  #endif
                   
                   keyword = "POKE";
                   vArg.push("POKE");
@@ -593,7 +707,9 @@ class CodeLine
                }
                else if (_strLine.rfind("INPUT",i,5) == i)
                {
+                  #ifdef EASI_LOAD_VERBOSE
                   std::cout<<"Found INPUT\n";
+                  #endif
                   keyword = "INPUT";
                   i+=5;
                   
@@ -608,7 +724,9 @@ class CodeLine
                   {
                      if ( _strLine[5] == '\"' )
                      {
+                        #ifdef EASI_LOAD_VERBOSE
                         std::cout<<"INPUT contains a string\n";
+                        #endif
                         bool validOutput = false;
                         //build the output string until we find terminating quote
                         for (i=6;i<_strLine.size();++i)
@@ -635,18 +753,24 @@ class CodeLine
                         }
                      }
                   }
+                  #ifdef EASI_LOAD_VERBOSE
                   std::cout<<"INPUT string built\n";
+                  #endif
                   
                   //check for terminating semicolon
                   if (i < _strLine.size() && _strLine[i] == ';')
                   {
+                     #ifdef EASI_LOAD_VERBOSE
                      std::cout<<"Advancing past semicolon\n";
+                     #endif
                      ++i;
                   }
                   
                   // push output string, even if it's a null string.
                   // so EASI can always print index 0.
+                  #ifdef EASI_LOAD_VERBOSE
                   std::cout<<"Pushing output string: "<<strOutput<<"\n";
+                  #endif
                   vExpressionToken.push(strOutput);
                   
                   // build all vars, which should be separated by commas.
@@ -657,13 +781,17 @@ class CodeLine
                   std::string currentVarName = "";
                   for (;i<_strLine.size();++i)
                   {
+                     #ifdef EASI_LOAD_VERBOSE
                      std::cout<<"current i: "<<i<<"\n";
+                     #endif
                      if ( _strLine[i] == ',' )
                      {
                         // add var
                         if ( currentVarName.size() > 0 )
                         {
+                           #ifdef EASI_LOAD_VERBOSE
                            std::cout<<"Pushing var: "<<currentVarName<<"\n";
+                           #endif
                            vExpressionToken.push(currentVarName);
                            currentVarName="";
                         }
@@ -683,7 +811,9 @@ class CodeLine
                   // add var
                   if ( currentVarName.size() > 0 )
                   {
+                     #ifdef EASI_LOAD_VERBOSE
                      std::cout<<"Pushing var final: "<<currentVarName<<"\n";
+                     #endif
                      vExpressionToken.push(currentVarName);
                      currentVarName="";
                   }
@@ -698,7 +828,7 @@ class CodeLine
          }
          if (isExpression) //expression is evaluated externally
          {
-            const std::string allowedInputs = " ,!@#$%^&*()\"\'\\=+-/";
+            const std::string allowedInputs = " ,!@#$%^&*()\"\'\\=+-/<>";
             if (DataTools::isAlphaNumeric(_strLine[i]) || allowedInputs.find(_strLine[i]) != std::string::npos)
             {
                expression+=_strLine[i];
@@ -742,7 +872,7 @@ class CodeLine
             
             // push operators or comma
             else if ( expression[i] == '+' || expression[i] == '-' || expression[i] == '*'
-               || expression[i] == '/' || expression[i] == '>' || expression[i] == '<'
+               || expression[i] == '/' || expression[i] == '^' || expression[i] == '>' || expression[i] == '<'
                || expression[i] == '=' || expression[i] == '(' || expression[i] == ')')
             {
                
@@ -903,41 +1033,55 @@ class CodeLine
    
 };
 
-#include <Math/Shunting/Shunting.cpp>
+#include <Game/EASI/EASI_Bytecode.hpp>
 
-// Maintains VarTable, CodeLines, and executes the lines.
+// Maintains VarTable, CodeLines, and runs the compiled program.
 class EASI
 {
-   public:
+   private:
+   
+   std::vector <long int> vStack; // number stack
+   std::vector <std::string> vStringStack;
+   std::string printLine; // output of the current PRINT
+   int lastInput; // the INPUT which is waiting for input
    
-   Shunting shunt; // Constructs with default operators
+   std::string receiveInput(); // Load received input into the INPUT variables.
    
-   long int currentLine;
+   // Run up to _maxInstructions, or to the end of the current line. Returns the number run.
+   unsigned int execute(const unsigned int _maxInstructions, const bool _singleLine, std::string& _output);
+   
+   public:
+   
+   long int currentLine; // CodeLine of the next instruction
    
    Vector <CodeLine*> vCodeLine;
    Vector <std::string> * vLine; // String for every line of the program, valid or not.
    
+   EASI_Program program; // compiled from vCodeLine
+   int pc; // next instruction
+   
+   unsigned int instructionsPerTick; // budget for tick()
+   unsigned long int nInstructions; // instructions run since load()
+   
    bool terminated;
    short int isWaitingInput; // 0 = not waiting for input. other values are the number of inputs to get.
-   Vector <std::string> vInputVar; // variables to put input into
    Vector <std::string> vInput; // user input from INPUT command. Can hold multiple inputs.
    std::string input; // holds current input.
    
-   VarTable varTable;
+   VarTable varTable; // variables and arrays
    
    EASI();
    
-   std::string load(std::string _code); // Load code into the CodeLine Vector
-   
-   std::string cycle(); // Execute one cycle of the code, return any output.
+   std::string load(std::string _code); // Load code into the CodeLine Vector and compile it
    
-   std::string evaluate(CodeLine* _codeLine); // Run code line in current state
+   std::string cycle(); // Execute one line of the code, return any output.
    
-   void jumpToLabel(std::string _label);
-   void forCycle(); // Move currentLine up to a FOR loop
+   // Execute up to _maxInstructions, and return any output. Each PRINT ends with a newline.
+   // Stops early if the program ends or waits for input.
+   std::string run(const unsigned int _maxInstructions);
+   std::string tick() { return run(instructionsPerTick); }
    
-   //std::string shunt(std::string input); // convert expression to postfix notation
-
+   std::string getVar(const std::string _name); // Value of a variable as a string
 };
 
 
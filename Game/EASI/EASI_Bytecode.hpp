@@ -0,0 +1,853 @@
+#pragma once
+#ifndef WILDCAT_GAME_EASI_BYTECODE_HPP
+#define WILDCAT_GAME_EASI_BYTECODE_HPP
+
+/* Wildcat: EASI_Bytecode.hpp
+   #include <Game/EASI/EASI_Bytecode.hpp>
+
+   Compiles parsed EASI CodeLines into bytecode for the EASI virtual machine.
+
+   The compiler runs once when the program is loaded. Variables are resolved to VarTable slots,
+   expressions are converted to postfix with the shunting-yard algorithm, and GOTO, IF THEN and
+   NEXT targets are resolved to instruction indexes. The VM in EASI.cpp then only has to walk
+   the instruction Vector with a value stack.
+
+   Example: A=B*2+1 becomes:
+
+      LOAD_NUM   0 (B)
+      PUSH_NUM   0 (2)
+      MUL
+      PUSH_NUM   1 (1)
+      ADD
+      STORE_NUM  1 (A)
+
+   Numbers and strings are kept on separate stacks, and the compiler checks types, so the VM
+   never needs to check whether a value is a number or a string.
+
+   Included by EASI.hpp, after CodeLine and VarTable.
+*/
+
+#include <cstdlib> // strtol
+
+enum enumEASI_Op : unsigned char
+{
+   EASI_NOP=0,
+   EASI_PUSH_NUM,    // push vNumber(arg)
+   EASI_PUSH_STR,    // push vString(arg)
+   EASI_LOAD_NUM,    // push number variable in VarTable slot arg
+   EASI_LOAD_STR,    // push string variable in VarTable slot arg
+   EASI_STORE_NUM,   // pop into number variable in VarTable slot arg
+   EASI_STORE_STR,   // pop into string variable in VarTable slot arg
+   EASI_LOAD_ARRAY,  // pop the indexes of vArray(arg) and push the element
+
+   EASI_ADD, EASI_SUB, EASI_MUL, EASI_DIV, EASI_POW,
+   EASI_EQ, EASI_NE, EASI_LT, EASI_LE, EASI_GT, EASI_GE, // true is -1, false is 0
+   EASI_NEG, EASI_ABS, EASI_RND,
+   EASI_CONCAT, EASI_STR_EQ, EASI_STR_NE,
+
+   EASI_PRINT_NUM,   // pop number and add it to the PRINT line
+   EASI_PRINT_STR,   // pop string and add it to the PRINT line
+   EASI_PRINT_END,   // output the PRINT line
+   EASI_JUMP,        // jump to instruction arg
+   EASI_JUMP_FALSE,  // pop number, jump to instruction arg if it is 0
+   EASI_NEXT,        // step vLoop(arg), and jump back to the start of the loop unless it's finished
+   EASI_DIM,         // pop the dimensions of vArray(arg) and build it
+   EASI_STORE_ARRAY, // pop value, then pop the indexes of vArray(arg) and set it
+   EASI_INPUT,       // output the prompt of vInput(arg) and wait for input
+   EASI_END
+};
+
+class EASI_Instruction
+{
+   public:
+   unsigned char op;
+   int arg;
+};
+
+// A FOR loop as seen from its NEXT.
+class EASI_Loop
+{
+   public:
+   int slot; // loop variable
+   long int to;
+   long int step;
+   int start; // first instruction after the FOR line
+   Vector <int> vExtraSlot; // other variables listed after NEXT, which are stepped too
+};
+
+class EASI_Input
+{
+   public:
+   std::string prompt;
+   Vector <int> vSlot;
+   Vector <unsigned char> vIsString; // 1 if the slot is a string variable
+};
+
+// An array reference with a given number of indexes.
+class EASI_Array
+{
+   public:
+   int slot; // VarTable array slot
+   int nDims;
+};
+
+// Compiled EASI program.
+class EASI_Program
+{
+   public:
+   Vector <EASI_Instruction> vCode;
+   Vector <int> vSourceLine; // CodeLine of each instruction
+   Vector <int> vLineStart; // first instruction of each CodeLine, plus one past the end
+
+   Vector <long int> vNumber; // constants
+   Vector <std::string> vString;
+
+   Vector <EASI_Loop> vLoop;
+   Vector <EASI_Input> vInput;
+   Vector <EASI_Array> vArray;
+
+   void clear()
+   {
+      vCode.clear();
+      vSourceLine.clear();
+      vLineStart.clear();
+      vNumber.clear();
+      vString.clear();
+      vLoop.clear();
+      vInput.clear();
+      vArray.clear();
+   }
+
+   // true if the instruction is the first one of its CodeLine.
+   inline bool isLineStart(const int _pc)
+   {
+      return _pc==0 || vSourceLine(_pc) != vSourceLine(_pc-1);
+   }
+
+   static std::string opName(const unsigned char _op)
+   {
+      static const char* aName [] = { "NOP","PUSH_NUM","PUSH_STR","LOAD_NUM","LOAD_STR","STORE_NUM",
+         "STORE_STR","LOAD_ARRAY","ADD","SUB","MUL","DIV","POW","EQ","NE","LT","LE","GT","GE","NEG","ABS","RND",
+         "CONCAT","STR_EQ","STR_NE","PRINT_NUM","PRINT_STR","PRINT_END","JUMP","JUMP_FALSE","NEXT",
+         "DIM","STORE_ARRAY","INPUT","END" };
+      if ( _op > EASI_END ) { return "?"; }
+      return aName[_op];
+   }
+
+   // Disassembly, one instruction per line. Names are looked up in the VarTable the program was
+   // compiled with.
+   std::string toString(VarTable& _varTable)
+   {
+      std::string strRet = "";
+      for (int i=0;i<vCode.size();++i)
+      {
+         const EASI_Instruction& in = vCode(i);
+         strRet+=DataTools::toString(i)+" (line "+DataTools::toString(vSourceLine(i))+"): "+opName(in.op);
+
+         switch (in.op)
+         {
+            case EASI_PUSH_NUM: strRet+=" "+DataTools::toString(vNumber(in.arg)); break;
+            case EASI_PUSH_STR: strRet+=" \""+vString(in.arg)+"\""; break;
+            case EASI_LOAD_NUM: case EASI_STORE_NUM: case EASI_LOAD_STR: case EASI_STORE_STR:
+               strRet+=" "+_varTable.vVarName(in.arg); break;
+            case EASI_JUMP: case EASI_JUMP_FALSE: case EASI_NEXT: strRet+=" "+DataTools::toString(in.arg); break;
+            case EASI_LOAD_ARRAY: case EASI_DIM: case EASI_STORE_ARRAY:
+               strRet+=" "+_varTable.vArray(vArray(in.arg).slot)->name; break;
+         }
+         strRet+="\n";
+      }
+      return strRet;
+   }
+};
+
+// Builds an EASI_Program from CodeLines. Errors are reported with std::cout, and the line
+// is compiled up to the error.
+class EASI_Compiler
+{
+   private:
+
+   enum enumType { TYPE_NONE, TYPE_NUMBER, TYPE_STRING };
+
+   // An operator waiting on the shunting-yard stack.
+   class Operator
+   {
+      public:
+      unsigned char op; // EASI_NOP for left parenthesis
+      unsigned short int precedence; // higher = higher precedence
+      bool rightAssociative;
+      bool isUnary;
+   };
+
+   EASI_Program* program;
+   Vector <CodeLine*>* vCodeLine;
+   VarTable* varTable;
+
+   int currentLine;
+   int nErrors;
+
+   Vector <int> vJumpFixup; // JUMP instructions which need a label resolved
+   Vector <std::string> vJumpLabel;
+
+   void error(const std::string _message)
+   {
+      std::cout<<"EASI: Error on line "<<currentLine<<": "<<_message<<"\n";
+      ++nErrors;
+   }
+
+   inline void emit(const unsigned char _op, const int _arg=0)
+   {
+      EASI_Instruction in;
+      in.op=_op;
+      in.arg=_arg;
+      program->vCode.push(in);
+      program->vSourceLine.push(currentLine);
+   }
+
+   int addNumber(const long int _value)
+   {
+      for (int i=0;i<program->vNumber.size();++i)
+      {
+         if ( program->vNumber(i)==_value ) { return i; }
+      }
+      program->vNumber.push(_value);
+      return program->vNumber.size()-1;
+   }
+   int addString(const std::string _value)
+   {
+      for (int i=0;i<program->vString.size();++i)
+      {
+         if ( program->vString(i)==_value ) { return i; }
+      }
+      program->vString.push(_value);
+      return program->vString.size()-1;
+   }
+
+   int getSlot(const std::string _name)
+   { return varTable->getSlot(_name); }
+
+   static bool isStringLiteral(const std::string& _token)
+   {
+      return _token.size()>1 && _token[0]=='"' && _token.back()=='"';
+   }
+   static bool isNumberLiteral(const std::string& _token)
+   {
+      if ( _token.size()==0 ) { return false; }
+      for (unsigned int i=0;i<_token.size();++i)
+      {
+         if ( std::isdigit(_token[i])==false ) { return false; }
+      }
+      return true;
+   }
+   static long int toNumber(const std::string& _str)
+   {
+      return strtol(_str.c_str(),0,10);
+   }
+
+   // Split expression text into tokens the same way CodeLine does.
+   static Vector <std::string> tokenize(const std::string _expression)
+   {
+      Vector <std::string> vToken;
+      std::string current = "";
+      bool isString = false;
+
+      for (unsigned int i=0;i<_expression.size();++i)
+      {
+         const char c = _expression[i];
+         if ( c=='"' )
+         {
+            if ( isString ) { vToken.push(current+c); current=""; }
+            else if ( current.size()>0 ) { vToken.push(current); current=c; }
+            else { current=c; }
+            isString = !isString;
+         }
+         else if ( isString )
+         {
+            current+=c;
+         }
+         else if ( c=='+' || c=='-' || c=='*' || c=='/' || c=='^' || c=='>' || c=='<' || c=='='
+            || c=='(' || c==')' || c==',' )
+         {
+            if ( current.size()>0 ) { vToken.push(current); current=""; }
+            vToken.push(std::string(1,c));
+         }
+         else if ( c!=' ' )
+         {
+            current+=c;
+         }
+      }
+      if ( current.size()>0 ) { vToken.push(current); }
+      return vToken;
+   }
+
+   // Join the 2 character comparison operators, which are tokenised separately.
+   static Vector <std::string> joinOperators(Vector <std::string>& _vToken)
+   {
+      Vector <std::string> vToken;
+      for (int i=0;i<_vToken.size();++i)
+      {
+         if ( i+1 < _vToken.size() && ( _vToken(i)=="<" || _vToken(i)==">" ) )
+         {
+            const std::string joined = _vToken(i)+_vToken(i+1);
+            if ( joined=="<=" || joined==">=" || joined=="<>" )
+            {
+               vToken.push(joined);
+               ++i;
+               continue;
+            }
+         }
+         vToken.push(_vToken(i));
+      }
+      return vToken;
+   }
+
+   // Binary operators, using the precedence of Shunting's default set.
+   static bool getBinaryOperator(const std::string& _token, Operator& _operator)
+   {
+      _operator.isUnary=false;
+      _operator.rightAssociative=false;
+
+      if ( _token=="=" ) { _operator.op=EASI_EQ; _operator.precedence=1; }
+      else if ( _token=="<>" ) { _operator.op=EASI_NE; _operator.precedence=1; }
+      else if ( _token=="<" ) { _operator.op=EASI_LT; _operator.precedence=1; }
+      else if ( _token=="<=" ) { _operator.op=EASI_LE; _operator.precedence=1; }
+      else if ( _token==">" ) { _operator.op=EASI_GT; _operator.precedence=1; }
+      else if ( _token==">=" ) { _operator.op=EASI_GE; _operator.precedence=1; }
+      else if ( _token=="+" ) { _operator.op=EASI_ADD; _operator.precedence=2; }
+      else if ( _token=="-" ) { _operator.op=EASI_SUB; _operator.precedence=2; }
+      else if ( _token=="*" ) { _operator.op=EASI_MUL; _operator.precedence=3; }
+      else if ( _token=="/" ) { _operator.op=EASI_DIV; _operator.precedence=3; }
+      else if ( _token=="^" ) { _operator.op=EASI_POW; _operator.precedence=5; _operator.rightAssociative=true; }
+      else { return false; }
+      return true;
+   }
+
+   // Prefix operators. Negation binds tighter than * but looser than ^, so -2^2 is -4.
+   static bool getUnaryOperator(const std::string& _token, Operator& _operator)
+   {
+      _operator.isUnary=true;
+      _operator.rightAssociative=true;
+
+      if ( _token=="-" ) { _operator.op=EASI_NEG; _operator.precedence=4; }
+      else if ( _token=="ABS" ) { _operator.op=EASI_ABS; _operator.precedence=6; }
+      else if ( _token=="RND" ) { _operator.op=EASI_RND; _operator.precedence=6; }
+      else { return false; }
+      return true;
+   }
+
+   // Emit an operator, checking the types of its operands.
+   bool emitOperator(const Operator& _operator, Vector <unsigned char>& _vType)
+   {
+      if ( _operator.isUnary )
+      {
+         if ( _vType.size()<1 ) { error("Missing operand"); return false; }
+         if ( _vType.back()!=TYPE_NUMBER ) { error("Type mismatch"); return false; }
+         emit(_operator.op);
+         return true;
+      }
+
+      if ( _vType.size()<2 ) { error("Missing operand"); return false; }
+      const unsigned char right = _vType.back(); _vType.popBack();
+      const unsigned char left = _vType.back(); _vType.popBack();
+
+      if ( left==TYPE_STRING && right==TYPE_STRING )
+      {
+         if ( _operator.op==EASI_ADD ) { emit(EASI_CONCAT); _vType.push(TYPE_STRING); return true; }
+         if ( _operator.op==EASI_EQ ) { emit(EASI_STR_EQ); _vType.push(TYPE_NUMBER); return true; }
+         if ( _operator.op==EASI_NE ) { emit(EASI_STR_NE); _vType.push(TYPE_NUMBER); return true; }
+         error("Invalid string operator");
+         return false;
+      }
+      if ( left!=TYPE_NUMBER || right!=TYPE_NUMBER )
+      {
+         error("Type mismatch");
+         return false;
+      }
+      emit(_operator.op);
+      _vType.push(TYPE_NUMBER);
+      return true;
+   }
+
+   // Shunting-yard over tokens [_begin,_end), emitting postfix instructions. Returns the type of
+   // the result, or TYPE_NONE if there was an error.
+   unsigned char compileExpression(Vector <std::string>& _vToken, const int _begin, const int _end)
+   {
+      std::vector <Operator> vStack;
+      Vector <unsigned char> vType; // types on the stack at runtime
+      bool expectOperand = true;
+
+      for (int i=_begin;i<_end;++i)
+      {
+         const std::string& token = _vToken(i);
+         Operator oper;
+
+         if ( expectOperand )
+         {
+            if ( token=="+" ) { continue; } // unary plus does nothing
+
+            if ( token=="(" )
+            {
+               oper.op=EASI_NOP;
+               oper.precedence=0;
+               vStack.push_back(oper);
+               continue;
+            }
+            if ( getUnaryOperator(token,oper) )
+            {
+               vStack.push_back(oper);
+               continue;
+            }
+
+            if ( isNumberLiteral(token) )
+            {
+               emit(EASI_PUSH_NUM,addNumber(toNumber(token)));
+               vType.push(TYPE_NUMBER);
+            }
+            else if ( isStringLiteral(token) )
+            {
+               emit(EASI_PUSH_STR,addString(token.substr(1,token.size()-2)));
+               vType.push(TYPE_STRING);
+            }
+            else if ( VarTable::isStringVar(token) )
+            {
+               emit(EASI_LOAD_STR,getSlot(token));
+               vType.push(TYPE_STRING);
+            }
+            else if ( VarTable::isRealVar(token) )
+            {
+               if ( i+1<_end && _vToken(i+1)=="(" )
+               {
+                  // Array element. The indexes are compiled as separate expressions.
+                  int end=0;
+                  const int nDims = compileIndexList(_vToken,i+2,_end,end);
+                  if ( nDims<1 ) { return TYPE_NONE; }
+                  emit(EASI_LOAD_ARRAY,getArray(token,nDims));
+                  i=end-1;
+               }
+               else
+               {
+                  emit(EASI_LOAD_NUM,getSlot(token));
+               }
+               vType.push(TYPE_NUMBER);
+            }
+            else
+            {
+               error("Unexpected "+token);
+               return TYPE_NONE;
+            }
+            expectOperand=false;
+            continue;
+         }
+
+         if ( token==")" )
+         {
+            while ( vStack.empty()==false && vStack.back().op!=EASI_NOP )
+            {
+               if ( emitOperator(vStack.back(),vType)==false ) { return TYPE_NONE; }
+               vStack.pop_back();
+            }
+            if ( vStack.empty() )
+            {
+               error("Too many right parentheses");
+               return TYPE_NONE;
+            }
+            vStack.pop_back();
+            continue;
+         }
+
+         if ( getBinaryOperator(token,oper)==false )
+         {
+            error("Expected operator, got "+token);
+            return TYPE_NONE;
+         }
+         while ( vStack.empty()==false && vStack.back().op!=EASI_NOP )
+         {
+            const Operator& top = vStack.back();
+            if ( top.precedence > oper.precedence || (top.precedence==oper.precedence && oper.rightAssociative==false) )
+            {
+               if ( emitOperator(top,vType)==false ) { return TYPE_NONE; }
+               vStack.pop_back();
+            }
+            else { break; }
+         }
+         vStack.push_back(oper);
+         expectOperand=true;
+      }
+
+      if ( expectOperand )
+      {
+         error("Missing operand");
+         return TYPE_NONE;
+      }
+      while ( vStack.empty()==false )
+      {
+         if ( vStack.back().op==EASI_NOP )
+         {
+            error("Too many left parentheses");
+            return TYPE_NONE;
+         }
+         if ( emitOperator(vStack.back(),vType)==false ) { return TYPE_NONE; }
+         vStack.pop_back();
+      }
+      if ( vType.size()!=1 )
+      {
+         error("Invalid expression");
+         return TYPE_NONE;
+      }
+      return vType(0);
+   }
+
+   bool compileNumber(Vector <std::string>& _vToken, const int _begin, const int _end)
+   {
+      const unsigned char type = compileExpression(_vToken,_begin,_end);
+      if ( type==TYPE_STRING ) { error("Expected a number"); }
+      return type==TYPE_NUMBER;
+   }
+
+   // Compile comma separated number expressions between parentheses, starting with the token
+   // after the left parenthesis and stopping before _limit. Returns the number of expressions,
+   // and sets _end to the token after the right parenthesis.
+   int compileIndexList(Vector <std::string>& _vToken, const int _begin, const int _limit, int& _end)
+   {
+      int nIndexes=0;
+      int depth=0;
+      int start=_begin;
+      for (int i=_begin;i<_limit;++i)
+      {
+         if ( _vToken(i)=="(" ) { ++depth; }
+         else if ( _vToken(i)==")" && depth>0 ) { --depth; }
+         else if ( depth==0 && ( _vToken(i)=="," || _vToken(i)==")" ) )
+         {
+            if ( compileNumber(_vToken,start,i)==false ) { return -1; }
+            ++nIndexes;
+            start=i+1;
+            if ( _vToken(i)==")" )
+            {
+               _end=i+1;
+               return nIndexes;
+            }
+         }
+      }
+      error("Missing right parenthesis");
+      return -1;
+   }
+
+   void compileAssignment(const std::string& _var, Vector <std::string>& _vToken, const int _begin)
+   {
+      if ( VarTable::isStringVar(_var) )
+      {
+         // Old behaviour: every string in the expression is appended, with or without a +.
+         int nStrings=0;
+         for (int i=_begin;i<_vToken.size();++i)
+         {
+            const std::string& token = _vToken(i);
+            if ( token=="+" ) { continue; }
+            if ( isStringLiteral(token) ) { emit(EASI_PUSH_STR,addString(token.substr(1,token.size()-2))); }
+            else if ( VarTable::isStringVar(token) ) { emit(EASI_LOAD_STR,getSlot(token)); }
+            else
+            {
+               error("Type mismatch");
+               return;
+            }
+            if ( ++nStrings > 1 ) { emit(EASI_CONCAT); }
+         }
+         if ( nStrings==0 ) { emit(EASI_PUSH_STR,addString("")); }
+         emit(EASI_STORE_STR,getSlot(_var));
+      }
+      else if ( VarTable::isRealVar(_var) )
+      {
+         if ( compileNumber(_vToken,_begin,_vToken.size()) )
+         { emit(EASI_STORE_NUM,getSlot(_var)); }
+      }
+      else
+      {
+         error("Invalid variable name "+_var);
+      }
+   }
+
+   int getArray(const std::string _name, const int _nDims)
+   {
+      const int slot = varTable->getArraySlot(_name);
+      for (int i=0;i<program->vArray.size();++i)
+      {
+         if ( program->vArray(i).slot==slot && program->vArray(i).nDims==_nDims ) { return i; }
+      }
+      EASI_Array array;
+      array.slot=slot;
+      array.nDims=_nDims;
+      program->vArray.push(array);
+      return program->vArray.size()-1;
+   }
+
+   void compilePrint(Vector <std::string>& _vToken)
+   {
+      // Strings and number expressions can be placed next to each other, for example:
+      // PRINT "A IS "A*2" AND B IS "B
+      // Each number expression is the run of tokens between strings.
+      int runStart=0;
+      for (int i=0;i<=_vToken.size();++i)
+      {
+         const bool isString = i<_vToken.size() && ( isStringLiteral(_vToken(i)) || VarTable::isStringVar(_vToken(i)) );
+         if ( isString==false && i<_vToken.size() ) { continue; }
+
+         // the run may just be a + joining 2 strings.
+         bool onlyPlus = true;
+         for (int i2=runStart;i2<i;++i2)
+         {
+            if ( _vToken(i2)!="+" ) { onlyPlus=false; }
+         }
+         if ( onlyPlus==false )
+         {
+            if ( compileNumber(_vToken,runStart,i)==false ) { return; }
+            emit(EASI_PRINT_NUM);
+         }
+
+         if ( isString )
+         {
+            std::string token = _vToken(i);
+            if ( isStringLiteral(token) )
+            {
+               token = token.substr(1,token.size()-2);
+               DataTools::findAndReplace(&token,"\\N","\n");
+               emit(EASI_PUSH_STR,addString(token));
+            }
+            else
+            {
+               emit(EASI_LOAD_STR,getSlot(token));
+            }
+            emit(EASI_PRINT_STR);
+         }
+         runStart=i+1;
+      }
+      emit(EASI_PRINT_END);
+   }
+
+   void compileStatement(CodeLine* _codeLine)
+   {
+      Vector <std::string> vToken = joinOperators(_codeLine->vExpressionToken);
+      const std::string& keyword = _codeLine->keyword;
+
+      if ( keyword=="" && _codeLine->assignmentVar!="" )
+      {
+         if ( _codeLine->vAssignmentIndices.size()>0 )
+         {
+            if ( VarTable::isRealVar(_codeLine->assignmentVar)==false )
+            {
+               error("Invalid array name "+_codeLine->assignmentVar);
+               return;
+            }
+            for (int i=0;i<_codeLine->vAssignmentIndices.size();++i)
+            {
+               Vector <std::string> vIndexToken = tokenize(_codeLine->vAssignmentIndices(i));
+               vIndexToken = joinOperators(vIndexToken);
+               if ( compileNumber(vIndexToken,0,vIndexToken.size())==false ) { return; }
+            }
+            // the tokens are "=" and the value.
+            if ( vToken.size()<2 || vToken(0)!="=" )
+            {
+               error("Invalid array assignment");
+               return;
+            }
+            if ( compileNumber(vToken,1,vToken.size())==false ) { return; }
+            emit(EASI_STORE_ARRAY,getArray(_codeLine->assignmentVar,_codeLine->vAssignmentIndices.size()));
+         }
+         else
+         {
+            compileAssignment(_codeLine->assignmentVar,vToken,0);
+         }
+      }
+      else if ( keyword=="LET" )
+      {
+         if ( vToken.size()<2 || vToken(1)!="=" )
+         {
+            error("Invalid LET");
+            return;
+         }
+         compileAssignment(vToken(0),vToken,2);
+      }
+      else if ( keyword=="PRINT" )
+      {
+         compilePrint(vToken);
+      }
+      else if ( keyword=="IF" )
+      {
+         if ( compileNumber(vToken,0,vToken.size())==false ) { return; }
+         const int jumpIndex = program->vCode.size();
+         emit(EASI_JUMP_FALSE);
+
+         // THEN can be followed by a line label, or a statement.
+         if ( isNumberLiteral(_codeLine->arg) )
+         {
+            vJumpFixup.push(program->vCode.size());
+            vJumpLabel.push(_codeLine->arg);
+            emit(EASI_JUMP);
+         }
+         else if ( _codeLine->arg.size()>0 )
+         {
+            CodeLine subLine (_codeLine->arg);
+            compileStatement(&subLine);
+         }
+         program->vCode(jumpIndex).arg = program->vCode.size();
+      }
+      else if ( keyword=="GOTO" )
+      {
+         vJumpFixup.push(program->vCode.size());
+         vJumpLabel.push(_codeLine->expression);
+         emit(EASI_JUMP);
+      }
+      else if ( keyword=="FOR" )
+      {
+         // vArg is: FOR, variable, start expression, end value, step value
+         if ( _codeLine->vArg.size()<5 || VarTable::isRealVar(_codeLine->vArg(1))==false )
+         {
+            error("Invalid FOR");
+            return;
+         }
+         Vector <std::string> vStartToken = tokenize(_codeLine->vArg(2));
+         vStartToken = joinOperators(vStartToken);
+         if ( compileNumber(vStartToken,0,vStartToken.size()) )
+         { emit(EASI_STORE_NUM,getSlot(_codeLine->vArg(1))); }
+      }
+      else if ( keyword=="NEXT" )
+      {
+         compileNext(_codeLine);
+      }
+      else if ( keyword=="DIM" )
+      {
+         if ( vToken.size()<4 || vToken(1)!="(" || VarTable::isRealVar(vToken(0))==false )
+         {
+            error("Invalid DIM");
+            return;
+         }
+         int end=0;
+         const int nDims = compileIndexList(vToken,2,vToken.size(),end);
+         if ( nDims<1 ) { return; }
+         emit(EASI_DIM,getArray(vToken(0),nDims));
+      }
+      else if ( keyword=="INPUT" )
+      {
+         if ( vToken.size()<2 )
+         {
+            error("INPUT needs a variable");
+            return;
+         }
+         EASI_Input input;
+         input.prompt=vToken(0);
+         for (int i=1;i<vToken.size();++i)
+         {
+            const bool isString = VarTable::isStringVar(vToken(i));
+            if ( isString==false && VarTable::isRealVar(vToken(i))==false )
+            {
+               error("Invalid INPUT variable "+vToken(i));
+               return;
+            }
+            input.vSlot.push(getSlot(vToken(i)));
+            input.vIsString.push(isString);
+         }
+         program->vInput.push(input);
+         emit(EASI_INPUT,program->vInput.size()-1);
+      }
+      else if ( keyword=="END" )
+      {
+         emit(EASI_END);
+      }
+      // REM, LABEL and POKE have no code.
+   }
+
+   void compileNext(CodeLine* _codeLine)
+   {
+      // The matching FOR is the closest one above.
+      int forLine = currentLine-1;
+      for (;forLine>=0;--forLine)
+      {
+         CodeLine* codeLine = (*vCodeLine)(forLine);
+         if ( codeLine->vArg.size()>4 && codeLine->vArg(0)=="FOR" ) { break; }
+      }
+      if ( forLine<0 )
+      {
+         error("NEXT without FOR");
+         return;
+      }
+
+      CodeLine* forCodeLine = (*vCodeLine)(forLine);
+      EASI_Loop loop;
+      loop.slot = getSlot(forCodeLine->vArg(1));
+      loop.to = toNumber(forCodeLine->vArg(3));
+      loop.step = toNumber(forCodeLine->vArg(4));
+      loop.start = program->vLineStart(forLine+1);
+
+      // NEXT may list other variables to step.
+      for (int i=1;i<_codeLine->vArg.size();++i)
+      {
+         Vector <std::string> vName = tokenize(_codeLine->vArg(i));
+         for (int i2=0;i2<vName.size();++i2)
+         {
+            if ( vName(i2)=="," ) { continue; }
+            if ( VarTable::isRealVar(vName(i2))==false )
+            {
+               error("Invalid NEXT variable "+vName(i2));
+               return;
+            }
+            const int slot = getSlot(vName(i2));
+            if ( slot!=loop.slot ) { loop.vExtraSlot.pushUnique(slot); }
+         }
+      }
+      program->vLoop.push(loop);
+      emit(EASI_NEXT,program->vLoop.size()-1);
+   }
+
+   public:
+
+   EASI_Compiler()
+   {
+      program=0;
+      varTable=0;
+      vCodeLine=0;
+      currentLine=0;
+      nErrors=0;
+   }
+
+   // Compile the lines into the program, adding their variables to the VarTable. Returns the
+   // number of errors.
+   int compile(Vector <CodeLine*>& _vCodeLine, EASI_Program& _program, VarTable& _varTable)
+   {
+      program=&_program;
+      varTable=&_varTable;
+      vCodeLine=&_vCodeLine;
+      program->clear();
+      vJumpFixup.clear();
+      vJumpLabel.clear();
+      nErrors=0;
+
+      for (currentLine=0;currentLine<_vCodeLine.size();++currentLine)
+      {
+         program->vLineStart.push(program->vCode.size());
+         compileStatement(_vCodeLine(currentLine));
+      }
+      program->vLineStart.push(program->vCode.size());
+
+      // Resolve jumps. If more than one line has the label, the last one is used.
+      for (int i=0;i<vJumpFixup.size();++i)
+      {
+         EASI_Instruction& in = program->vCode(vJumpFixup(i));
+         int target=-1;
+         for (int i2=0;i2<_vCodeLine.size();++i2)
+         {
+            if ( _vCodeLine(i2)->label==vJumpLabel(i) || _vCodeLine(i2)->lineLabel==vJumpLabel(i) )
+            { target=i2; }
+         }
+         if ( target==-1 )
+         {
+            currentLine=program->vSourceLine(vJumpFixup(i));
+            error("Unknown label "+vJumpLabel(i));
+            in.op=EASI_NOP;
+         }
+         else
+         {
+            in.arg=program->vLineStart(target);
+         }
+      }
+      return nErrors;
+   }
+};
+
+#endif
@@ -0,0 +1,193 @@
+#include <climits> /* Colour.hpp needs UINT_MAX. */
+#include <iostream>
+#include <string>
+#include <deque>
+#include <stack>
+
+#include <Container/Vector/Vector.hpp>
+#include <Data/DataTools.hpp>
+#include <Data/Tokenize.hpp>
+#include <Math/Random/GlobalRandom.hpp>
+#include <System/Time/Timer.hpp>
+
+#include <Game/EASI/EASI.cpp>
+#include <Math/Shunting/Shunting.cpp>
+
+// g++ EASI_Benchmark.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX
+
+// Benchmarks for EASI variable storage. Times variable access by name against access by slot, and then
+// runs a tight FOR loop the way the old interpreter did and through the VM.
+
+const long int N_LOOPS = 1000000;
+// Shunting reads numbers as ints, so the old interpreter's total overflows after about 65000 iterations.
+const long int N_OLD_LOOPS = 50000;
+
+void benchmarkVarTable()
+{
+   std::cout<<"\nVarTable: "<<N_LOOPS<<" iterations of I=I+1 and X=X+I.\n";
+
+   const char* aName [] = { "A","B","C","D","E","F","G","H","X","Y","Z","I" };
+
+   Timer timer;
+
+   // OLD: Lookup by name, with the values converted to and from strings.
+   VarTable byName;
+   for (auto name: aName) { byName.set(name,"0"); }
+   timer.init();
+   timer.start();
+   for (long int i=0;i<N_LOOPS;++i)
+   {
+      byName.set("I",DataTools::toString(std::stol(byName.get("I"))+1));
+      byName.set("X",DataTools::toString(std::stol(byName.get("X"))+std::stol(byName.get("I"))));
+   }
+   timer.update();
+   std::cout<<"  By name: "<<timer.fullSeconds<<" seconds.\n";
+
+   // NEW: Slots resolved once, typed values.
+   VarTable bySlot;
+   for (auto name: aName) { bySlot.getSlot(name); }
+   const int slotI = bySlot.getSlot("I");
+   const int slotX = bySlot.getSlot("X");
+   timer.init();
+   timer.start();
+   for (long int i=0;i<N_LOOPS;++i)
+   {
+      EASI_Value& valueI = bySlot.vValue(slotI);
+      EASI_Value& valueX = bySlot.vValue(slotX);
+      valueI.setInteger(valueI.integer+1);
+      valueX.setInteger(valueX.integer+valueI.integer);
+   }
+   timer.update();
+   std::cout<<"  By slot: "<<timer.fullSeconds<<" seconds.\n";
+
+   if ( byName.get("X")==bySlot.get("X") )
+   { std::cout<<"  Totals match.\n"; }
+   else
+   { std::cout<<"  ERROR: Totals don't match.\n"; }
+}
+
+// The variable table used by the old interpreter: names and values as strings, searched in order.
+class StringVarTable
+{
+   public:
+   Vector <std::string> vVarName;
+   Vector <std::string> vVarValue;
+
+   void set(const std::string& _varName, const std::string& _varValue)
+   {
+      for (int i=0;i<vVarName.size();++i)
+      {
+         if ( vVarName(i)==_varName )
+         {
+            vVarValue(i)=_varValue;
+            return;
+         }
+      }
+      vVarName.push(_varName);
+      vVarValue.push(_varValue);
+   }
+   bool hasVar(const std::string& _varName)
+   {
+      for (int i=0;i<vVarName.size();++i)
+      {
+         if ( vVarName(i)==_varName ) { return true; }
+      }
+      return false;
+   }
+   std::string get(const std::string& _varName)
+   {
+      for (int i=0;i<vVarName.size();++i)
+      {
+         if ( vVarName(i)==_varName ) { return vVarValue(i); }
+      }
+      return "";
+   }
+};
+
+void benchmarkForLoop()
+{
+   std::cout<<"\nEASI: FOR I=1 TO "<<N_OLD_LOOPS<<" interpreted, and FOR I=1 TO "<<N_LOOPS<<" compiled.\n";
+
+   Timer timer;
+
+   // OLD: What EASI::evaluate() did for each line before programs were compiled. Each pass copies the line's
+   // tokens, substitutes the variables as strings, rebuilds the expression and shunts it again. NEXT steps the
+   // counter as a string and searches back for its FOR. The debug output it printed for every line isn't included,
+   // so the real interpreter was slower than this.
+   CodeLine forLine ("FOR I=1 TO "+DataTools::toString(N_OLD_LOOPS));
+   CodeLine bodyLine ("X=X+I");
+   CodeLine nextLine ("NEXT");
+   Vector <CodeLine*> vCodeLine;
+   vCodeLine.push(&forLine);
+   vCodeLine.push(&bodyLine);
+   vCodeLine.push(&nextLine);
+
+   StringVarTable varTable;
+   Shunting shunt;
+   varTable.set("I","1");
+   varTable.set("X","0");
+
+   timer.init();
+   timer.start();
+   int currentLine = 1;
+   while ( true )
+   {
+      if ( currentLine==1 )
+      {
+         Vector <std::string> vSubbedToken = bodyLine.vExpressionToken;
+         for (int i=0;i<vSubbedToken.size();++i)
+         {
+            if ( varTable.hasVar(vSubbedToken(i)) ) { vSubbedToken(i) = varTable.get(vSubbedToken(i)); }
+         }
+         std::string strEvalExpression = "";
+         for (int i=0;i<vSubbedToken.size();++i)
+         { strEvalExpression += vSubbedToken(i); }
+         shunt.shunt(strEvalExpression);
+         varTable.set(bodyLine.assignmentVar,DataTools::toString(shunt.evaluate()));
+         currentLine=2;
+      }
+      else if ( currentLine==2 )
+      {
+         int forIndex = currentLine;
+         while ( forIndex>=0 && (vCodeLine(forIndex)->vArg.size()<4 || vCodeLine(forIndex)->vArg(0)!="FOR") )
+         { --forIndex; }
+         const std::string targetVarName = vCodeLine(forIndex)->vArg(1);
+         const long int targetVarValue = DataTools::toInt(vCodeLine(forIndex)->vArg(3));
+         const long int var = DataTools::toInt(varTable.get(targetVarName))+1;
+         varTable.set(targetVarName,DataTools::toString(var));
+         if ( var>targetVarValue ) { break; }
+         currentLine=forIndex+1;
+      }
+   }
+   timer.update();
+   const double oldRate = N_OLD_LOOPS/timer.fullSeconds/1000000;
+   std::cout<<"  Interpreting strings: "<<timer.fullSeconds<<" seconds, "<<oldRate<<" million iterations per second.\n";
+   if ( varTable.get("X")!=DataTools::toString(N_OLD_LOOPS*(N_OLD_LOOPS+1)/2) )
+   { std::cout<<"  ERROR: Total is "<<varTable.get("X")<<".\n"; }
+
+   // NEW: Compiled once, then run on the VM.
+   EASI easi;
+   easi.load("FOR I=1 TO "+DataTools::toString(N_LOOPS)+"\nX=X+I\nNEXT\n");
+
+   timer.init();
+   timer.start();
+   while ( easi.terminated==false )
+   { easi.run(1000000); }
+   timer.update();
+
+   std::cout<<"  Bytecode VM: "<<timer.fullSeconds<<" seconds, "<<easi.nInstructions<<" instructions, "
+      <<N_LOOPS/timer.fullSeconds/1000000<<" million iterations per second, "
+      <<N_LOOPS/timer.fullSeconds/1000000/oldRate<<" times faster.\n";
+
+   if ( easi.getVar("X")==DataTools::toString(N_LOOPS*(N_LOOPS+1)/2) )
+   { std::cout<<"  Total is correct.\n"; }
+   else
+   { std::cout<<"  ERROR: Total is "<<easi.getVar("X")<<".\n"; }
+}
+
+int main (int nArgs, char ** arg)
+{
+   benchmarkVarTable();
+   benchmarkForLoop();
+   return 0;
+}
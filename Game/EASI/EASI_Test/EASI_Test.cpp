@@ -0,0 +1,119 @@
+#include <climits> /* Colour.hpp needs UINT_MAX. */
+#include <iostream>
+#include <string>
+#include <deque>
+
+#include <Container/Vector/Vector.hpp>
+#include <Data/DataTools.hpp>
+#include <Data/Tokenize.hpp>
+#include <Math/Random/GlobalRandom.hpp>
+
+#include <Game/EASI/EASI.cpp>
+
+#include <chrono>
+
+// g++ EASI_Test.cpp -I %WILDCAT%/
+
+// Headless test of the EASI bytecode compiler and VM. Runs some small programs and checks their output
+// and variables, then checks that tick() never runs more than its budget.
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+   std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+   if ( passed==false ) { ++nFailed; }
+}
+
+   // Run the whole program and return its output.
+std::string runAll(EASI& easi, const std::string code)
+{
+   easi.load(code);
+   std::string output = "";
+   for (int i=0;i<100000 && easi.terminated==false && easi.isWaitingInput==0;++i)
+   { output+=easi.run(1000); }
+   return output;
+}
+
+int main (int nArgs, char ** arg)
+{
+   EASI easi;
+
+   runAll(easi,"A=2+3*4\nB=(2+3)*4\nC=-2^2\nD=10-2-3\nE=2^3^2\nF=7/2\nG=ABS(-5)+1\nH=3>=3\nI=1<>1\n");
+   check("Precedence", easi.getVar("A")=="14" && easi.getVar("B")=="20" && easi.getVar("C")=="-4");
+   check("Left and right associativity", easi.getVar("D")=="5" && easi.getVar("E")=="512");
+   check("Division and functions", easi.getVar("F")=="3" && easi.getVar("G")=="6");
+   check("Comparisons", easi.getVar("H")=="-1" && easi.getVar("I")=="0");
+
+   std::string output = runAll(easi,"A=5\nPRINT \"A IS \"A*2\" OK\"\nLET B$=\"X\"+\"Y\"\nPRINT B$+\"Z\"\n");
+   check("PRINT strings and numbers", output=="A IS 10 OK\nXYZ\nEND OF PROGRAM\n");
+
+   output = runAll(easi,"T=0\nFOR I=1 TO 10\nT=T+I\nNEXT\nPRINT T\nFOR J=5 TO 1 STEP -2\nPRINT J\nNEXT\n");
+   check("FOR loops", output=="55\n5\n3\n1\nEND OF PROGRAM\n");
+
+   output = runAll(easi,"10 N=0\n20 N=N+1\n30 IF N<3 THEN 20\nIF N=3 THEN PRINT \"THREE\"\nIF N=4 THEN PRINT \"FOUR\"\nGOTO SKIP\nPRINT \"NO\"\nLABEL SKIP\nEND\nPRINT \"NO\"\n");
+   check("IF, GOTO and labels", output=="THREE\n" && easi.getVar("N")=="3");
+
+   output = runAll(easi,"A$=\"YES\"\nIF A$=\"YES\" THEN PRINT \"Y\"\nIF A$=\"NO\" THEN PRINT \"N\"\n");
+   check("String comparison", output=="Y\nEND OF PROGRAM\n");
+
+   runAll(easi,"DIM Q(3,3)\nQ(1,2)=7\n");
+   check("Array assignment", easi.varTable.vArray.size()==1 && easi.varTable.vArray(0)->vValue(5)==7);
+
+   runAll(easi,"DIM Q(3,4)\nFOR I=0 TO 2\nQ(I,3)=I*10+1\nNEXT\nA=Q(2,3)+Q(1,1+2)\nB=Q(3,0)\nR(2)=5\nC=R(2)*2+R(10)\n");
+   check("Array reads", easi.getVar("A")=="32" && easi.getVar("C")=="10");
+   check("Array bounds", easi.getVar("B")=="0");
+
+   VarTable varTable;
+   varTable.set("X","2.5");
+   varTable.set("Y$","HELLO");
+   varTable.set("Z","12");
+   varTable.set("Z","A");
+   check("Typed values", varTable.get("X")=="2.5" && varTable.vValue(varTable.findSlot("X")).integer==2
+      && varTable.get("Y$")=="HELLO" && varTable.get("Z")=="0" && varTable.get("W")=="0");
+   check("Slots are interned", varTable.getSlot("X")==0 && varTable.getSlot("Z")==2 && varTable.vVarName.size()==3);
+
+   output = runAll(easi,"INPUT \"NUMBER\";X\nPRINT X*2\n");
+   check("INPUT waits", output=="NUMBER" && easi.isWaitingInput==1);
+   easi.vInput.push("21");
+   easi.isWaitingInput=0;
+   output = easi.run(100);
+   check("INPUT receives", output=="Inputs recieved:\n21\n42\nEND OF PROGRAM\n");
+
+      // cycle() runs a line at a time, as before.
+   easi.load("A=1\nB=A+1\nPRINT B\n");
+   std::string strCycle = "";
+   int nCycles=0;
+   while ( easi.terminated==false && nCycles<10 ) { strCycle+=easi.cycle()+"|"; ++nCycles; }
+   check("cycle() runs one line", strCycle=="||2|END OF PROGRAM\n|" && nCycles==4);
+
+      // An endless loop only runs its budget.
+   easi.load("10 A=A+1\n20 GOTO 10\n");
+   easi.instructionsPerTick=50;
+   for (int i=0;i<10;++i) { easi.tick(); }
+   check("tick() keeps to its budget", easi.nInstructions==500 && easi.getVar("A")=="100");
+
+      // Lots of terminals each running a script.
+   const int N_TERMINALS = 200;
+   const int N_FRAMES = 100;
+   EASI* aTerminal = new EASI [N_TERMINALS];
+   for (int i=0;i<N_TERMINALS;++i)
+   { aTerminal[i].load("10 FOR I=1 TO 100\n20 X=X+I*2-1\n30 NEXT\n40 GOTO 10\n"); }
+
+   auto start = std::chrono::steady_clock::now();
+   for (int frame=0;frame<N_FRAMES;++frame)
+   {
+      for (int i=0;i<N_TERMINALS;++i) { aTerminal[i].tick(); }
+   }
+   const double ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+
+   unsigned long int nTotal = 0;
+   for (int i=0;i<N_TERMINALS;++i) { nTotal+=aTerminal[i].nInstructions; }
+   check("Every terminal ran its budget", nTotal==(unsigned long int)N_TERMINALS*N_FRAMES*100);
+   std::cout<<"  "<<N_TERMINALS<<" terminals x "<<N_FRAMES<<" frames: "<<ms/N_FRAMES<<" ms per frame, "
+      <<nTotal/(ms*1000)<<" million instructions per second.\n";
+   delete [] aTerminal;
+
+   std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+   return nFailed;
+}
@@ -28,12 +28,21 @@
    Make sure the seed values are properly making reproducible maps. Biomes, landmass, etc should
    get their own subseeds too.
 
-	Multithreading support.
 	Bring back smoothness-breaking.
 	Seperate natural features to their own layer.
 	Potential feature: Flip the map so that the most land is at the north. Just a psychological thing.
 	We could find the longitude line with the least land tiles over it and set that as the wrapping point.
 
+   BIOMES
+   Biomes are listed in vBiome. Each biome gets its own fractal from its own subseed, and only reads the
+   land/ocean layer, so all the fractals can be generated at the same time. Set biomeThreads to choose how many
+   threads to use (0 is 1 per core, 1 is serial). Threads are only used if WILDCAT_THREADING is defined.
+
+   Biomes overlap, so the order they are merged in matters. Each biome has a priority, and higher priority
+   biomes are merged on top of lower ones. Biomes with the same priority are merged in the order they were
+   added. The result is the same as generating and merging each biome in that order in serial, no matter how
+   many threads are used.
+
 */
 
 // These are hardcoded globals for now.
@@ -45,46 +54,19 @@
 #include <Math/Random/RandomLehmer.hpp> // Faster RNG
 #include <Graphics/Png/Png.hpp> // FOR PNG EXPORT.
 #include <Container/ArrayS2/ArrayS2.hpp>
+#include <Container/ArrayS2/ArrayS2_LayerSet.hpp> // World layers.
 #include <Container/Vector/Vector.hpp>
 #include <Math/BasicMath/BasicMath.hpp> // TO CHECK IF MAPSIZE IS POW2+1.
 #include <File/FileManagerStatic.hpp> /* For saving the world data to file. */
 #include <System/Time/Timer.hpp>
 
+#ifdef WILDCAT_THREADING
 #include <thread>
+#include <atomic>
+#endif
+#include <algorithm> /* std::stable_sort */
 #include <limits.h> /* For INT_MAX */
 
-/*
-New approach: Each tile has more than a single piece of data for it, therefore we should use an object for each tile.
-*/
-class WorldGenerator2_Tile
-{
-   public:
-      int localSeed; //Seed used to generate local terrain.
-      int terrainType;
-      int evilLevel; //Evil places are more difficult. 0=peaceful, 255=Evil.
-      int height; //Its average height.
-      int nCaves; //The number of caves to spawn on this tile.
-
-   WorldGenerator2_Tile()
-   {
-      localSeed=0;
-      terrainType=0;
-      evilLevel=0;
-      height=0;
-      nCaves=0;
-   }
-   ~WorldGenerator2_Tile()
-   {
-   }
-
-   //Returns a string which contains all the tile data.
-   std::string getFullSeed()
-   {
-      return "";
-   }
-
-};
-
 // IMPLEMENTING SUPPORT FOR BIOMES SPECIFIED AT RUNTIME.
 // DESIGN TO RUN MULTIPLE IN PARALLEL.
 class WorldGenerator2_Biome
@@ -92,17 +74,21 @@ class WorldGenerator2_Biome
    public:
       // THE NAME OF THE BIOME, EG: DESERT.
       std::string name;
-      int seed;
+      enumBiome type;
+      int seed; // 0 means use a subseed of the world seed.
       double percentLand;
       int freeSteps;
       double smoothing;
+      int priority; // Higher priority biomes are merged over lower priority biomes.
 
-   WorldGenerator2_Biome ( const std::string _name, const double _percentLand, const int _freeSteps, const double _smoothing, const int _seed = 0 )
+   WorldGenerator2_Biome ( const enumBiome _type, const std::string _name, const double _percentLand, const int _freeSteps, const double _smoothing, const int _priority = 0, const int _seed = 0 )
    {
+      type = _type;
       name = _name;
       percentLand = _percentLand;
       freeSteps = _freeSteps;
       smoothing = _smoothing;
+      priority = _priority;
       seed = _seed;
    }
 
@@ -152,22 +138,26 @@ class WorldGenerator2
 	//std::string WorldGenerator2::biomeName [15] = { "nothing", "ocean", "grassland", "forest", "desert", "mountain", "snow", "hilly", "jungle", "wetland", "steppes", "cave", "ruin", "ice", "river" };
 	//enum enumFeature { NOTHING=0, CAVE=1, PRECURSOR_RUIN=2 };
 	
-	ArrayS2 <WorldGenerator2_Tile> aTile;
+		// The world layers are stored together, one plane per layer. Each of these arrays is a view of its
+		// plane, so they can be used like any other ArrayS2. Land/ocean isn't stored separately, it's
+		// aHeightMap > seaLevel.
+	ArrayS2_LayerSet layers;
 
 	ArrayS2 <enumBiome> aTerrainType;
 	ArrayS3 <unsigned char> aTopoMap;
 	ArrayS2 <unsigned char> aHeightMap; /* This one is for landmasses. It should really be called aLandMassMap */
-	ArrayS2 <unsigned char> aHeightMap2; /* This one is for elevations */
   
   ArrayS2 <int> aRiverMap; /* Contains the river ID */
-	
-	ArrayS2 <unsigned char> aTectonicMap;
-	
-	ArrayS2 <unsigned char> aCaveMap;
 
 	ArrayS2 <int> aGoodEvilMap; // 0 = neutral, 1 = good, 2 = evil.
 
-	//Vector <WorldGenerator2_Biome*> vBiome;
+		// These aren't generated yet, so they aren't layers and don't take up any memory.
+	ArrayS2 <unsigned char> aHeightMap2; /* This one is for elevations */
+	ArrayS2 <unsigned char> aTectonicMap;
+	ArrayS2 <unsigned char> aCaveMap;
+
+	Vector <WorldGenerator2_Biome> vBiome;
+	int biomeThreads; // Threads used to generate biomes. 0 is 1 per core, 1 is serial.
 
 	//ArrayS2 <bool> aLand; // TRUE IF LAND, FALSE IS WATER.
 
@@ -224,6 +214,14 @@ WorldGenerator2()
    wrapY=false;
 
    seaLevel=0;
+
+   biomeThreads=0;
+   setDefaultBiomes();
+
+   layers.addLayer("terrain",aTerrainType,OCEAN);
+   layers.addLayer("landmass",aHeightMap,(unsigned char)0);
+   layers.addLayer("river",aRiverMap,-1);
+   layers.addLayer("goodEvil",aGoodEvilMap,0);
 }
 
 void createLand(int _seed = 0)
@@ -249,6 +247,7 @@ void createLand(int _seed = 0)
    dsa.seed = _seed;
    dsa.wrapX = wrapX;
    dsa.wrapY = wrapY;
+   dsa.nThreads = 0; // 1 per core. Output is the same as serial.
 
    dsa.generate(&aHeightMap, heightTable, freeSteps, landSmoothing, variance, 0);
    //exit(1);
@@ -273,14 +272,12 @@ void createLand(int _seed = 0)
          if ( aHeightMap(_x,_y) > seaLevel )
          {
             aTerrainType(_x,_y) = GRASSLAND;
-            aTile(_x,_y).terrainType=GRASSLAND;
             //Count the land tiles for later use.
             ++totalLandTiles;
          }
          else
          {
             aTerrainType(_x,_y) = OCEAN;
-            aTile(_x,_y).terrainType = OCEAN;
             ++totalOceanTiles;
          }
       }
@@ -304,6 +301,7 @@ void generateHeightmap()
    dsa.seed = landformSeed+1; /* Temporary */
    dsa.wrapX = wrapX;
    dsa.wrapY = wrapY;
+   dsa.nThreads = 0; // 1 per core. Output is the same as serial.
 
    dsa.generate(&aHeightMap, 0, freeSteps, landSmoothing, variance, 0);
 
@@ -316,14 +314,12 @@ void generateHeightmap()
          if ( aHeightMap(_x,_y) > 250 )
          {
             //aTerrainType(_x,_y) = MOUNTAIN;
-            //aTile(_x,_y).terrainType=MOUNTAIN;
             //Count the land tiles for later use.
             //++totalLandTiles;
          }
          else
          {
             // aTerrainType(_x,_y) = OCEAN;
-            // aTile(_x,_y).terrainType = OCEAN;
             // ++totalOceanTiles;
          }
       }
@@ -378,18 +374,18 @@ void createRivers(int nRivers=1, int _seed=0)
       while (maxRiverLength-- > 0)
       {
          // Spread to lowest neighbor which isn't river. Abort when next to ocean.
-         Vector <HasXY*>* vNeighbors = aTerrainType.getNeighborsOrthogonal(currentX,currentY,false);
+         ArrayS2_NeighborList vNeighbors = aTerrainType.getNeighborListOrthogonal(currentX,currentY,false);
 
-         if ( vNeighbors == 0 ) { break; }
+         if ( vNeighbors.empty() ) { break; }
 
          //Shuffle vectors to randomly resolve equal height neighbors.
          if ( _seed==0)
          {
-            vNeighbors->shuffle();
+            vNeighbors.shuffle();
          }
          else
          {
-            vNeighbors->shuffle(rng);
+            vNeighbors.shuffle(rng);
          }
 
          //int i2=0;
@@ -398,16 +394,16 @@ void createRivers(int nRivers=1, int _seed=0)
 
          bool abortRiver = false;
 
-         for (int i2=0;i2<vNeighbors->size();++i2)
+         for (int i2=0;i2<vNeighbors.size();++i2)
          {
             // Abort when the river is touching an ocean.
-            if (aTerrainType((*vNeighbors)(i2)) == OCEAN )
+            if (aTerrainType(vNeighbors(i2)) == OCEAN )
             {
                abortRiver=true;
                break;
             }
             // Abort if touching another river. (River will flow into this one)
-            if ( aRiverMap((*vNeighbors)(i2)) != i && aRiverMap((*vNeighbors)(i2)) != -1)
+            if ( aRiverMap(vNeighbors(i2)) != i && aRiverMap(vNeighbors(i2)) != -1)
             {
                abortRiver=true;
                break;
@@ -418,12 +414,12 @@ void createRivers(int nRivers=1, int _seed=0)
             break;
          }
 
-         for (int i2=0;i2<vNeighbors->size();++i2)
+         for (int i2=0;i2<vNeighbors.size();++i2)
          {
-            if ( aRiverMap((*vNeighbors)(i2)) == -1 && aHeightMap((*vNeighbors)(i2)) < lowestHeight )
+            if ( aRiverMap(vNeighbors(i2)) == -1 && aHeightMap(vNeighbors(i2)) < lowestHeight )
             {
-               lowestTile = (*vNeighbors)(i2);
-               lowestHeight = aHeightMap((*vNeighbors)(i2));
+               lowestTile = &vNeighbors(i2);
+               lowestHeight = aHeightMap(vNeighbors(i2));
             }
          }
          if ( lowestTile != 0 )
@@ -437,14 +433,6 @@ void createRivers(int nRivers=1, int _seed=0)
          {
             break;
          }
-
-
-         for (int i3=0;i3<vNeighbors->size();++i3)
-         {
-            delete (*vNeighbors)(i3);
-         }
-         vNeighbors->clear();
-         delete vNeighbors;
       }
 
    }
@@ -460,10 +448,24 @@ void createRivers(int nRivers=1, int _seed=0)
 // Possible biome configuration options:
 // Pass it a map to share with other biomes.
 // Specify it to use the highest, lowest, or middle values.
-void addBiome(const std::string _name, const double _percentLand, const int _freeSteps, const int _smoothing, const int _seed=0)
+void addBiome(const enumBiome _type, const std::string _name, const double _percentLand, const int _freeSteps, const double _smoothing, const int _priority, const int _seed=0)
 {
    //std::cout<<"Biome added: "<<_name<<".\n";
-   //vBiome.push(new WorldGenerator2_Biome(_name, _percentLand, _freeSteps, _smoothing, _seed));
+   vBiome.push(WorldGenerator2_Biome(_type, _name, _percentLand, _freeSteps, _smoothing, _priority, _seed));
+}
+
+// The standard biomes. Each one is merged over the ones before it.
+void setDefaultBiomes()
+{
+   vBiome.clear();
+   addBiome(JUNGLE, "Jungle", 0.33, 4, 0.78, 1);
+   addBiome(FOREST, "Forest", 0.5, 8, 0.8, 2);
+   addBiome(WETLAND, "Wetland", 0.05, 11, 0.79, 3);
+   addBiome(STEPPES, "Steppes", 0.05, 2, 0.77, 4);
+   addBiome(SNOW, "Tundra", 0.25, 2, 0.76, 5);
+   addBiome(DESERT, "Desert", 0.11, 1, 0.8, 6);
+   addBiome(HILLY, "Hills", 0.05, 8, 0.8, 7);
+   addBiome(MOUNTAIN, "Mountains", 0.07, 13, 0.78, 8);
 }
 
 void randomiseBiomes()
@@ -528,12 +530,7 @@ void randomiseBiomes()
 		//std::cout<<"Landform seed: "<<landformSeed<<".\n";
 
 		// MAKE DEFAULT TILE OCEAN.
-		aTerrainType.init(mapSize,mapSize,OCEAN);
-		aRiverMap.init(mapSize,mapSize,-1);
-		
-		WorldGenerator2_Tile nullTile;
-    delete [] aTile.data;
-		aTile.init(mapSize,mapSize,nullTile);
+		layers.init(mapSize,mapSize);
 		
 
 		
@@ -558,100 +555,11 @@ void randomiseBiomes()
 		erodeCoast(2);
 		
 		
-		//std::thread * t[8];
-		// GENERATE BIOMES HERE IN PARALLEL
-			// GENERATE HEIGHTMAP
-		//DiamondSquareAlgorithm dsa [8];
-		
-		// for (int i=0;i<8;++i)
-		// {
-			// //dsa[i].wrapX = wrapX;
-			// //dsa[i].wrapY = wrapY;
-			// //dsa[i].seed = subSeed[i+1];
-			
-			// //td::thread t (&WorldGenerator2::test, this);
-			
-			// //t[i] (&WorldGenerator2::test, &this);
-			// //t[i] (&WorldGenerator2::test, &this->test, 1);
-			// //t[i] (&ArrayS2 <unsigned char>::init, &this->aHeightMap, x,y,0);
-		// }
-		// //ArrayS2 <unsigned char> aBiomeMap;
-		// //aBiomeMap.init(mapSize,mapSize,0);
-		
-		// //unsigned char biomeTable [256] = {0};
-		// //int * const valueTableNull = 0;
-		// //std::thread t1 (&DiamondSquareAlgorithm::generate, &dsa[0],&aBiomeMap,valueTableNull,0,0,200,0.01,false);
-		// //std::thread t2 (&DiamondSquareAlgorithm::generate, &dsa[0],&aBiomeMap,valueTableNull,0,0,200,0.01,false);
-		// //std::thread t3 (&DiamondSquareAlgorithm::generate, &dsa[0],&aBiomeMap,valueTableNull,0,0,200,0.01,false);
-		
-		
-		
-		// //std::thread t1 (&DiamondSquareAlgorithm::generate, &dsa[0]);
-		// //std::thread t1 (&DiamondSquareAlgorithm::test, &dsa[0]);
-		// //std::thread t1 (&DiamondSquareAlgorithm::test2, &dsa[0], &aBiomeMap, valueTableNull);
-		
-		// for (int i=0;i<8;++i)
-		// {
-		// //	t[i].join();
-		// }
-		
-		//int biomeTable [256] = {0};
-		
-		
-		//std::thread t1 (&ArrayS2 <unsigned char>::init, &this->aHeightMap, x,y,0);
-		
-		//std::thread t1 (&ArrayS2 <unsigned char>::init, &this->aHeightMap, x,y,0);
-
-		
-		//void createBiome (const enumBiome BIOME_TYPE, const double biomePercent, const int _freeSteps=0, const double _smoothing=0.85, const std::string _biomeName="?", ArrayS2 <unsigned char> * biomeMap=0, int _seed=0)
-		
-		
-		//void createBiome (const enumBiome BIOME_TYPE, const double biomePercent, const int _freeSteps=0, const double _smoothing=0.85, const std::string _biomeName="?", ArrayS2 <unsigned char> * biomeMap=0, int _seed=0)
-		
 		Timer timerBiome;
 		timerBiome.init();
 		timerBiome.start();
 		
-		// This section benefits greatly from multithreading.
-		//Biome creation time reduced from 3.2 seconds to 0.8 on my quad core.
-    // Unfortunately the biomes are not merging in the correct order,
-    // so that will need to be fixed. We will probably want to define a heirarchy of
-    // biomes which can overwrite other biomes.
-		
-
-   //#define THREADED_WORLDGEN
-   #if defined THREADED_WORLDGEN
-
-    std::thread t1( [this, subSeed] { createBiome(JUNGLE, 0.33, 4, 0.78, "Jungle", 0 ,subSeed[1]); });
-    std::thread t2( [this, subSeed] { createBiome(FOREST, 0.5, 8, 0.8, "Forest", 0 ,subSeed[2]); });
-    std::thread t3( [this, subSeed] { createBiome(WETLAND, 0.05, 11, 0.79, "Wetland", 0 ,subSeed[3]); });
-    std::thread t4( [this, subSeed] { createBiome(STEPPES, 0.05, 2, 0.77, "Steppes", 0 ,subSeed[4]); });
-    std::thread t5( [this, subSeed] { createBiome(SNOW, 0.25, 2, 0.76, "Tundra", 0 ,subSeed[5]); });
-    std::thread t6( [this, subSeed] { createBiome(DESERT, 0.11, 1, 0.8, "Desert", 0 ,subSeed[6]); });
-    std::thread t7( [this, subSeed] { createBiome(HILLY, 0.05, 8, 0.8, "Hills", 0 ,subSeed[7]); });
-    std::thread t8( [this, subSeed] { createBiome(MOUNTAIN, 0.07, 13, 0.78, "Mountains", 0 ,subSeed[8]); });
-
-    t1.join();
-    t2.join();
-    t3.join();
-    t4.join();
-    t5.join();
-    t6.join();
-    t7.join();
-    t8.join();
-		
-  #else
-    
-    createBiome (JUNGLE, 0.33, 4, 0.78, "Jungle", 0, subSeed[1]);
-    createBiome (FOREST, 0.5, 8, 0.8, "Forest", 0, subSeed[2]);
-    createBiome (WETLAND, 0.05, 11, 0.79, "Wetland", 0, subSeed[3]);
-    createBiome (STEPPES, 0.05, 2, 0.77, "Steppes", 0, subSeed[4]);
-    createBiome (SNOW, 0.25, 2, 0.76, "Tundra", 0, subSeed[5]);
-    createBiome (DESERT, 0.11, 1, 0.8, "Desert", 0, subSeed[6]);
-    createBiome (HILLY, 0.05, 8, 0.8, "Hills", 0, subSeed[7]);
-    createBiome (MOUNTAIN, 0.07, 13, 0.78, "Mountains", 0, subSeed[8]);
-			
-  #endif
+		createBiomes(subSeed);
 
 		timerBiome.update();
 		std::cout<<"Biomes created in "<<timerBiome.fullSeconds<<" seconds.\n";
@@ -1194,17 +1102,33 @@ void randomiseBiomes()
 		/* 0272144293 NEW FEATURE: Can pass a pre-existing map for the biome generator to use. */
 	void createBiome (const enumBiome BIOME_TYPE, const double biomePercent, const int _freeSteps=0, const double _smoothing=0.85, const std::string _biomeName="?", ArrayS2 <unsigned char> * const biomeMap=0, const int _seed=0)
 	{
-		//std::lock_guard<std::mutex> guard(mutexArrayAccess);
-		//std::lock_guard<std::mutex> guard2(render_mutex);
-		
 		std::cout<<"Creating biome: "<<_biomeName<<".\n";
-		//int biomeTable [256] = {0};
+
+		ArrayS2 <unsigned char> aBiomeMap;
+		const unsigned char biomeThreshold = createBiomeLayer(biomePercent, _freeSteps, _smoothing, _biomeName, aBiomeMap, _seed);
+
+			// MERGE DOWN THE BIOME LAYER
+			// THIS MUST BE DONE IN ORDER.
+		for (int _y=0;_y<mapSize;++_y)
+		{
+			for (int _x=0;_x<mapSize;++_x)
+			{
+				if ( aBiomeMap(_x,_y) <= biomeThreshold && aTerrainType(_x,_y) != OCEAN )
+				{
+					aTerrainType(_x,_y) = BIOME_TYPE;
+				}
+			}
+		}
+		std::cout<<"END creating biome: "<<_biomeName<<".\n";
+	}
+
+		// Generate the fractal for a biome, and return the threshold. Tiles with a value <= the threshold are
+		// part of the biome. This only reads aTerrainType, so different biomes can be done at the same time.
+	unsigned char createBiomeLayer (const double biomePercent, const int _freeSteps, const double _smoothing, const std::string _biomeName, ArrayS2 <unsigned char>& aBiomeMap, const int _seed)
+	{
 		int biomeTable [256] = {0};
-		//for ( int i=0;i<256;++i)
-		//{ biomeTable[i] = 0; }
 
-		ArrayS2 <unsigned char> aBiomeMap (mapSize,mapSize,0);
-		//aBiomeMap.init(mapSize,mapSize,0);
+		aBiomeMap.init(mapSize,mapSize,0);
 		
 
 		
@@ -1322,53 +1246,117 @@ void randomiseBiomes()
 		//std::cout<<"Total land tiles: "<<countedLandTiles<<"\n";
 		//std::cout<<"Total biome tiles: "<<total<<"\n";
 		//std::cout<<"Biome threshold: "<<(int)biomeThreshold<<"\n";
-		int nnn=0;
+		return biomeThreshold;
+	}
 
-		
-		//std::lock_guard<std::mutex> guard(mutexArrayAccess);
-		
-		//cvDesertFinished
-		
-		// std::thread t1 (WorldGenerator2::createBiome, this, WorldGenerator2::JUNGLE, 0.33, 4, 0.78, "Jungle", biomeMap2, subSeed[1]);
-		// std::thread t2 (WorldGenerator2::createBiome, this, WorldGenerator2::FOREST, 0.5, 8, 0.8, "Forest", biomeMap2, subSeed[2]);
-		// std::thread t3 (&WorldGenerator2::createBiome, this, WorldGenerator2::WETLAND, 0.05, 11, 0.79, "Wetland", biomeMap2, subSeed[3]);
-		// std::thread t4 (&WorldGenerator2::createBiome, this, WorldGenerator2::STEPPES, 0.05, 2, 0.77, "Steppes", biomeMap2, subSeed[4]);
-		// std::thread t5 (&WorldGenerator2::createBiome, this, WorldGenerator2::SNOW, 0.25, 2, 0.76, "Tundra", biomeMap2, subSeed[5]);
-		// std::thread t6 (&WorldGenerator2::createBiome, this, WorldGenerator2::DESERT, 0.11, 1, 0.8, "Desert", biomeMap2, subSeed[6]);
-		// std::thread t7 (&WorldGenerator2::createBiome, this, WorldGenerator2::HILLY, 0.05, 8, 0.8, "Hills", biomeMap2, subSeed[7]);
-		// std::thread t8 (&WorldGenerator2::createBiome, this, WorldGenerator2::MOUNTAIN, 0.07, 13, 0.78, "Mountains", biomeMap2, subSeed[8]);
-		
-			// MERGE DOWN THE BIOME LAYER
-			// THIS MUST BE DONE IN ORDER.
+		// Generate every biome in vBiome and merge them in order of priority.
+		// Biome i uses subSeed[i+1] unless it has its own seed.
+	void createBiomes (const int * const subSeed)
+	{
+		const int nBiomes = vBiome.size();
+		if ( nBiomes == 0 ) { return; }
 
-			
-		for (int _y=0;_y<mapSize;++_y)
+			// Merge order. Equal priorities stay in the order they were added.
+		Vector <int> vOrder;
+		for (int i=0;i<nBiomes;++i) { vOrder.push(i); }
+		std::stable_sort(vOrder.data.begin(), vOrder.data.end(), [this](const int a, const int b)
+		{ return vBiome(a).priority < vBiome(b).priority; });
+
+		auto biomeSeed = [&](const int i)
 		{
-			for (int _x=0;_x<mapSize;++_x)
+			if ( vBiome(i).seed != 0 ) { return vBiome(i).seed; }
+			if ( i+1 < 100 ) { return subSeed[i+1]; }
+			return subSeed[99]+i;
+		};
+
+		int nThreads = 1;
+#ifdef WILDCAT_THREADING
+		nThreads = biomeThreads;
+		if ( nThreads <= 0 ) { nThreads = std::thread::hardware_concurrency(); }
+		if ( nThreads > nBiomes ) { nThreads = nBiomes; }
+#endif
+
+		if ( nThreads <= 1 )
+		{
+				// SERIAL. Generate and merge each biome in order.
+			for (int i=0;i<nBiomes;++i)
 			{
-				if ( aBiomeMap(_x,_y) <= biomeThreshold && aTerrainType(_x,_y) != OCEAN )
+				const WorldGenerator2_Biome& biome = vBiome(vOrder(i));
+
+				Timer timerLayer;
+				timerLayer.init();
+				timerLayer.start();
+				createBiome(biome.type, biome.percentLand, biome.freeSteps, biome.smoothing, biome.name, 0, biomeSeed(vOrder(i)));
+				timerLayer.update();
+				std::cout<<"  "<<biome.name<<": "<<timerLayer.fullSeconds<<" seconds.\n";
+			}
+			return;
+		}
+
+#ifdef WILDCAT_THREADING
+			// PARALLEL. Generate every layer, then merge them all in one pass.
+		ArrayS2 <unsigned char> * aLayer = new ArrayS2 <unsigned char> [nBiomes];
+		Vector <int> vThreshold (nBiomes);
+		Vector <double> vLayerSeconds (nBiomes);
+
+		for (int i=0;i<nBiomes;++i)
+		{ std::cout<<"Creating biome: "<<vBiome(i).name<<".\n"; }
+
+		Timer timerLayers;
+		timerLayers.init();
+		timerLayers.start();
+
+		std::atomic <int> nextBiome (0);
+		auto worker = [&]()
+		{
+			for (int i=nextBiome++; i<nBiomes; i=nextBiome++)
+			{
+				const WorldGenerator2_Biome& biome = vBiome(i);
+
+				Timer timerLayer;
+				timerLayer.init();
+				timerLayer.start();
+				vThreshold(i) = createBiomeLayer(biome.percentLand, biome.freeSteps, biome.smoothing, biome.name, aLayer[i], biomeSeed(i));
+				timerLayer.update();
+				vLayerSeconds(i) = timerLayer.fullSeconds;
+			}
+		};
+		std::vector <std::thread> vThread;
+		for (int t=1;t<nThreads;++t)
+		{ vThread.emplace_back(worker); }
+		worker();
+		for (auto& t: vThread) { t.join(); }
+
+		timerLayers.update();
+		for (int i=0;i<nBiomes;++i)
+		{ std::cout<<"  "<<vBiome(i).name<<": "<<vLayerSeconds(i)<<" seconds.\n"; }
+		std::cout<<"Biome layers generated in "<<timerLayers.fullSeconds<<" seconds using "<<nThreads<<" threads.\n";
+
+			// MERGE. Each tile takes the highest priority biome which covers it, which is the same as merging
+			// every layer in order.
+		Timer timerMerge;
+		timerMerge.init();
+		timerMerge.start();
+
+		for (int i=0;i<mapArea;++i)
+		{
+			if ( aTerrainType(i) == OCEAN ) { continue; }
+			for (int j=nBiomes-1;j>=0;--j)
+			{
+				const int iBiome = vOrder(j);
+				if ( aLayer[iBiome](i) <= vThreshold(iBiome) )
 				{
-					nnn++;
-					aTerrainType(_x,_y) = BIOME_TYPE;
+					aTerrainType(i) = vBiome(iBiome).type;
+					break;
 				}
 			}
 		}
-		
-		// if ( BIOME_TYPE == JUNGLE)
-		// {
-			// cvDesertFinished.notify_all();
-		// }
-		
-		//std::cout<<"Final biome tiles: "<<nnn<<"\n";
-		
-		//std::cout<<"Debug biome table:\n";
-		
-		//for ( int i=0;i<256;++i)
-		//{
-		//std::cout<<"["<<i<<"] : "<<biomeTable[i]<<".\n";
-		//}
-		std::cout<<"END creating biome: "<<_biomeName<<".\n";
-		//std::cout<<"finished\n";
+
+		timerMerge.update();
+		std::cout<<"Biomes merged in "<<timerMerge.fullSeconds<<" seconds.\n";
+
+		delete [] aLayer;
+#endif
 	}
 
 		// DO NOT INCLUDE .PNG IN THE FILENAME, IT WILL BE INCLUDED AUTOMATICALLY.
@@ -1410,7 +1398,7 @@ void randomiseBiomes()
 			for (int _x=0;_x<mapSize;++_x)
 			{
 				// LANDFORM TILE DATA
-				if (aTile(_x,_y).terrainType == OCEAN)
+				if (aHeightMap(_x,_y) <= seaLevel)
 				{
 					aTopoMap(_x,_y,vOceanRGB);
 					landFormSaveData+="O";
@@ -0,0 +1,36 @@
+#include <string>
+#include <cstdint>
+#include <iostream>
+
+#include <Container/ArrayS3/ArrayS3.hpp>
+#include <Game/WorldGenerator/WorldGenerator2.hpp>
+#include <System/Time/Timer.hpp>
+
+// g++ WorldGenerator2_Benchmark.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX -D WILDCAT_THREADING -pthread
+
+// Times a full WorldGenerator2::generate() and prints the memory used by each world layer.
+
+void benchmarkGenerate(const int mapSize)
+{
+	std::cout<<"\ngenerate() on "<<mapSize<<"x"<<mapSize<<" map.\n";
+
+	WorldGenerator2 worldGenerator;
+	worldGenerator.mapSize=mapSize;
+	worldGenerator.seed=1234;
+
+	Timer timer;
+	timer.init();
+	timer.start();
+	worldGenerator.generate();
+	timer.update();
+
+	std::cout<<"\n"<<worldGenerator.layers.getMemoryReport();
+	std::cout<<"generate() took "<<timer.fullSeconds<<" seconds.\n";
+}
+
+int main()
+{
+	benchmarkGenerate(2049);
+	benchmarkGenerate(8193);
+	return 0;
+}
@@ -21,6 +21,12 @@
 	ANSI ESCAPE CODES
 	
 	I'm currently adding support for colours using the ANSI escape codes.
+	
+	TEXTURE ATLAS
+	
+	Glyphs are drawn through the Renderer, so they can be batched. Each glyph is
+	its own texture by default. addToAtlas() adds the glyphs to a TextureAtlas,
+	so that once the atlas is bound all text is drawn from one page.
 */
 
 #include <Container/ArrayS3/ArrayS3.hpp> // Storing PNG pixel data
@@ -31,6 +37,7 @@
 
 #include <Graphics/Png/Png.hpp>
 #include <Graphics/Texture/Texture.hpp>
+#include <Graphics/Texture/TextureAtlas.hpp>
 
 // Font conflicts with an X11 class, so we need to namespace this.
 namespace Wildcat
@@ -121,6 +128,7 @@ class Font
          // also build a texture object so we can do per-pixel stuff.
          aTexFont[i] = new Texture;
          aTexFont[i]->create(_nX,_nY,1,true);
+         aTexFont[i]->textureID = character[i];
          //aTexFont[i]->data=sub.data;
          
          std::copy(sub.data, sub.data+_nX*_nY*4, aTexFont[i]->data);
@@ -144,6 +152,24 @@ class Font
       return true;
 	}
 	
+		// Add every glyph to the atlas, named prefix:0 to prefix:255. The glyphs will be drawn from the atlas
+		// once it is packed and bound.
+	void addToAtlas(TextureAtlas& atlas, const std::string prefix="font")
+	{
+		if ( loadSuccess==false ) { return; }
+		
+		for (int i=0;i<256;++i)
+		{
+			atlas.add(prefix+":"+DataTools::toString(i),aTexFont[i]);
+		}
+	}
+	
+		// Draw a glyph with its top left corner at _x, _y.
+	inline void drawGlyph(const unsigned char _char, const int _x, const int _y)
+	{
+		Renderer::placeTexture4(_x,_y-nY,_x+nX,_y,aTexFont[_char]);
+	}
+	
 
 	/*
 		The text will only draw within the specified coordinates.
@@ -272,17 +298,7 @@ class Font
 
 				if ( text[i]!='\n' )
 				{
-					glBindTexture(GL_TEXTURE_2D, character[(int)text[i]]);
-					glBegin(GL_QUADS);
-					glTexCoord2f(0,1);
-					glVertex2f(currentX,currentY-nY);
-					glTexCoord2f(1,1);
-					glVertex2f(currentX+nX,currentY-nY);
-					glTexCoord2f(1,0);
-					glVertex2f(currentX+nX,currentY);
-					glTexCoord2f(0,0);
-					glVertex2f(currentX,currentY);
-					glEnd();
+					drawGlyph(text[i],currentX,currentY);
 				}
 		
 				currentX+=nX;
@@ -373,25 +389,15 @@ class Font
 			return;
 		}
 		
-    glColor3ub(0,0,0);
+    Renderer::setTextureMode();
+    Renderer::setColour(ColourRGBA <unsigned char> (0,0,0));
 		for(unsigned int i=0;i<text.size();++i)
 		{
-				Renderer::setTextureMode();
-				glBindTexture(GL_TEXTURE_2D, character[(int)text[i]]);
-				glBegin(GL_QUADS);
-				glTexCoord2f(0,1);
-				glVertex2f(x1,y1-nY);
-				glTexCoord2f(1,1);
-				glVertex2f(x1+nX,y1-nY);
-				glTexCoord2f(1,0);
-				glVertex2f(x1+nX,y1);
-				glTexCoord2f(0,0);
-				glVertex2f(x1,y1);
-				glEnd();
+				drawGlyph(text[i],x1,y1);
 				
 				x1+=nX;		
 		}
-    glColor3ub(255,255,255);
+    Renderer::resetColour();
 	}
 	
 	// Draw a single character from this top-left point. Useful for drawing text in grids (eg Terminals)
@@ -399,19 +405,10 @@ class Font
 	{
 		if ( _char == '\n' || _char == '\r' ) { return; }
 		
+      Renderer::setTextureMode();
       Renderer::setColour(_colour);
 
-		glBindTexture(GL_TEXTURE_2D, character[(int)_char]);
-		glBegin(GL_QUADS);
-		glTexCoord2f(0,1);
-		glVertex2f(_x,_y-nY);
-		glTexCoord2f(1,1);
-		glVertex2f(_x+nX,_y-nY);
-		glTexCoord2f(1,0);
-		glVertex2f(_x+nX,_y);
-		glTexCoord2f(0,0);
-		glVertex2f(_x,_y);
-		glEnd();
+		drawGlyph(_char,_x,_y);
 		
 		// Reset to default colour.
 		Renderer::resetColour();
@@ -12,9 +12,12 @@ monitor, however some other uses for it could come up, you could even make pixel
 PixelScreen is mostly to deal with rendering. Advanced functionality like scrolling should be handled by an external
 class.
 
-Currently it creates and binds a new texture at runtime, which is not optimal but works well enough. The performance of
-binding a 320x200 texture at runtime is acceptable, achieving about 70FPS on my dev builds. Binding larger textures
-however becomes significantly more costly.
+The screen and text overlay each have one persistent texture. Writes to the pixels are tracked in 16x16 blocks, and
+only the changed parts are uploaded when rendering (see PixelScreen_DirtyTexture). This used to create and bind a new
+texture every frame, which was okay at 320x200 but got much more costly for larger screens. Anything which writes
+to texScreen or texOverlay directly needs to mark what it changed, or call markAllDirty().
+
+Set usePBO to upload through pixel buffer objects. getBytesUploaded() returns the bytes sent by the last render().
 
 PixelScreen also has some effects it can do like basic glare effects
 and whatnot.
@@ -31,13 +34,13 @@ PixelScreen_TextMode class but that is outside of the project scope.
 Todo:
 
 * State updates should be decoupled from render calls.
-* Pixel Buffer Object support
 
 */
 
 #include <Container/ArrayS3/ArrayS3.hpp>
 #include <Math/Random/RandomLehmer.hpp>
 #include <Interface/HasTexture.hpp>
+#include <Graphics/PixelScreen/PixelScreen_DirtyTexture.hpp>
 
 // Sprites are not currently blitted, but rather directly rendered at the full resolution. Therefore you should
 // manually ensure that the pixels line up if making pixelshit unless you are trolling.
@@ -103,6 +106,7 @@ private:
 	
 	// Text mode array.
 	ArrayS2 <unsigned char> aCharMode; // Grid for drawing fonts onto screen.
+	ArrayS2 <bool> aCharDirty; // Cells which need to be drawn onto the overlay again.
 	
 	
 	// The current colour layer system. Probably could be better.
@@ -129,6 +133,12 @@ public:
 	Texture texScreen; // dynamically generated texture
 	Texture texOverlay; // dynamically generated texture. Text/hud overlay
 
+	// Upload only the changed parts of the textures. These must be declared after the textures.
+	PixelScreen_DirtyTexture dirtyScreen;
+	PixelScreen_DirtyTexture dirtyOverlay;
+
+	bool usePBO; // Upload through pixel buffer objects if available.
+
 	double scalingFactor; // how many times the standard resolution to scale up. Currently seems to affect only some
 	// aspects of the render. We should probably support decimal values although it would not look perfect.
 
@@ -166,6 +176,7 @@ public:
 		//aScreenDataReal.init(nX,nY,4,0); // RGBA
 		
 		aCharMode.init(0,0,' '); // aCharMode is initialised when the font is set.
+		aCharDirty.init(0,0,false);
 		textRed.init(nX,nY,255);
 		textGreen.init(nX,nY,255);
 		textBlue.init(nX,nY,255);
@@ -176,6 +187,10 @@ public:
 		texOverlay.create(nX,nY,1,true); // we might instead use this as render
 		texOverlay.fill(0);
 
+		dirtyScreen.init(&texScreen);
+		dirtyOverlay.init(&texOverlay);
+		usePBO=false;
+
 		updateTimer.init();
 		updateTimer.start();
 
@@ -213,6 +228,10 @@ public:
 		nCharX = nX / _font->nX;
 		nCharY = nY / _font->nY;
 		aCharMode.init(nCharX,nCharY,' ');
+		aCharDirty.init(nCharX,nCharY,false);
+
+		texOverlay.fill(0);
+		dirtyOverlay.markAll();
 	}
 
 	void clear()
@@ -224,8 +243,10 @@ public:
 		textGreen.fill(255);
 		textBlue.fill(255);
 		aCharMode.fill(' ');
+		aCharDirty.fill(false);
 		
 		texOverlay.fill(0);
+		dirtyOverlay.markAll();
 	}
 
 	void fill (unsigned char _r, unsigned char _g, unsigned char _b, unsigned char _a)
@@ -239,19 +260,31 @@ public:
 		texScreen.fillChannel(1,_g);
 		texScreen.fillChannel(2,_b);
 		texScreen.fillChannel(3,_a);
+		dirtyScreen.markAll();
+	}
+
+		// Call this after writing to texScreen or texOverlay directly.
+	void markAllDirty()
+	{
+		dirtyScreen.markAll();
+		dirtyOverlay.markAll();
 	}
 
 	// write a character to the given row and column with the specified colour.
 	void putChar (const unsigned short int _x, const unsigned short int _y, const unsigned char _char)
 	{
-		aCharMode(_x,_y)=_char;
-		textRed(_x,_y)=255;
-		textGreen(_x,_y)=0;
-		textBlue(_x,_y)=0;
+		putChar(_x,_y,_char,ColourRGBA <unsigned char> (255,0,0));
 	}
 	
 	void putChar (const unsigned short int _x, const unsigned short int _y, const unsigned char _char, ColourRGBA <unsigned char> foregroundColour)
 	{
+		if ( aCharMode.isSafe(_x,_y)==false ) { return; }
+		
+		if ( aCharMode(_x,_y)!=_char || textRed(_x,_y)!=foregroundColour.red || textGreen(_x,_y)!=foregroundColour.green
+			|| textBlue(_x,_y)!=foregroundColour.blue )
+		{
+			aCharDirty(_x,_y)=true;
+		}
 		aCharMode(_x,_y)=_char;
 		textRed(_x,_y)=foregroundColour.red;
 		textGreen(_x,_y)=foregroundColour.green;
@@ -264,10 +297,7 @@ public:
 		{
 			if ( aCharMode.isSafe(_x,_y))
 			{
-				aCharMode(_x,_y)=_str[i];
-				textRed(_x,_y)=255;
-				textGreen(_x,_y)=255;
-				textBlue(_x,_y)=255;
+				putChar(_x,_y,_str[i],ColourRGBA <unsigned char> (255,255,255));
 				++_x;
 			}
 		}
@@ -340,6 +370,29 @@ public:
 		texScreen.setPixel(_x,nY-1-_y,1,_g);
 		texScreen.setPixel(_x,nY-1-_y,2,_b);
 		texScreen.setPixel(_x,nY-1-_y,3,255);
+		dirtyScreen.markPixel(_x,nY-1-_y);
+	}
+
+		// Copy a texture onto the screen with its bottom left corner at _x, _y. Transparent pixels are skipped.
+	void blit(Texture* _texture, const short int _x, const short int _y)
+	{
+		if ( _texture==0 || _texture->data==0 ) { return; }
+
+			// Screen coords go up, texture rows go down.
+		const int top = nY-_y-_texture->nY;
+		for (int _y2=0;_y2<_texture->nY;++_y2)
+		{
+			const int screenY = top+_y2;
+			if ( screenY<0 || screenY>=nY ) { continue; }
+			for (int _x2=0;_x2<_texture->nX;++_x2)
+			{
+				const int screenX = _x+_x2;
+				if ( screenX<0 || screenX>=nX || _texture->getPixel(_x2,_y2,3)==0 ) { continue; }
+				for (int channel=0;channel<4;++channel)
+				{ texScreen.setPixel(screenX,screenY,channel,_texture->getPixel(_x2,_y2,channel)); }
+			}
+		}
+		dirtyScreen.markRect(_x,top,_x+_texture->nX-1,top+_texture->nY-1);
 	}
 
 	unsigned char getPixel(const short int _x, const short int _y, const short int _channel)
@@ -385,9 +438,9 @@ public:
 		
 		//texOverlay.fill(0);
 
-		bindNearestNeighbour(&texScreen);
+		dirtyScreen.usePBO=usePBO;
+		dirtyScreen.upload();
 		Renderer::placeTexture4(panelX1,panelY1,panelX2,panelY2,&texScreen,false);
-		unbind(&texScreen);
 		
 		for (int i=0;i<vSprite.size();++i)
 		{
@@ -414,6 +467,19 @@ public:
 			{
 				for (int _x=0;_x<nCharX;++_x)
 				{
+					if ( aCharDirty(_x,_y)==false )
+					{ continue; }
+					aCharDirty(_x,_y)=false;
+
+						// Wipe the old character before drawing the new one.
+					const int cellX = (font->nX)*_x;
+					const int cellY = (font->nY)*_y;
+					for (int _y2=cellY;_y2<cellY+font->nY;++_y2)
+					{
+						std::fill(&texOverlay.data[(_y2*nX+cellX)*4],&texOverlay.data[(_y2*nX+cellX+font->nX)*4],0);
+					}
+					dirtyOverlay.markRect(cellX,cellY,cellX+font->nX-1,cellY+font->nY-1);
+
 					if ( aCharMode(_x,_y) != ' ' )
 					{
 						// For now I'll just overlay the font with the normal render call.
@@ -437,9 +503,9 @@ public:
 		}
 
 		
-		bindNearestNeighbour(&texOverlay);
+		dirtyOverlay.usePBO=usePBO;
+		dirtyOverlay.upload();
 		Renderer::placeTexture4(panelX1,panelY1,panelX2,panelY2,&texOverlay,false);
-		unbind(&texOverlay);
 		
 
 		
@@ -483,6 +549,13 @@ public:
 			++i2;
 			if ( i2>=1000) { i2 = rngLehmer.rand8(); }
 		}
+		dirtyScreen.markAll();
+	}
+
+		// Bytes sent to the GPU by the last render().
+	unsigned long int getBytesUploaded() const
+	{
+		return dirtyScreen.bytesUploaded+dirtyOverlay.bytesUploaded;
 	}
 
 	void addSprite(Sprite *sprite)
@@ -0,0 +1,311 @@
+#pragma once
+#ifndef WILDCAT_GRAPHICS_PIXELSCREEN_DIRTYTEXTURE_HPP
+#define WILDCAT_GRAPHICS_PIXELSCREEN_DIRTYTEXTURE_HPP
+
+/* Wildcat: PixelScreen_DirtyTexture
+#include <Graphics/PixelScreen/PixelScreen_DirtyTexture.hpp>
+
+Keeps a Texture uploaded to one persistent OpenGL texture, and only uploads the parts which have changed. Every
+write to the texture's pixels must be marked, for example with markPixel() or markRect(). upload() then sends
+the marked areas.
+
+The texture is split into 16x16 blocks. Marking a pixel just flags its block, so it's cheap enough to do on
+every setPixel(). When uploading, runs of dirty blocks on each row of blocks are joined into rectangles, and
+rectangles with the same span on the rows below are joined too. If there are too many rectangles, the bounding
+box is uploaded instead.
+
+If usePBO is set and OpenGL 2.1 is available, the rectangles are copied into one of 2 pixel buffer objects and
+uploaded from there. The buffers are used in turn, so the driver can copy from one while we fill the other.
+
+bytesUploaded counts the bytes sent by the last upload(), even without OpenGL, so the savings can be checked
+headless.
+*/
+
+#include <Graphics/Texture/Texture.hpp>
+#include <Container/Vector/Vector.hpp>
+
+#include <vector>
+#include <algorithm>
+
+	// Pixel coordinates from the top left of the texture.
+class PixelScreen_DirtyRect
+{
+	public:
+	int x, y, nX, nY;
+};
+
+class PixelScreen_DirtyTexture
+{
+	private:
+
+	static const int BLOCK_BITS = 4;
+	static const int BLOCK_SIZE = 1<<BLOCK_BITS;
+	static const int MAX_RECTS = 32; // Upload the bounding box if there would be more rectangles than this.
+
+	Texture* texture;
+	int nX, nY; // Size of the texture when it was last created.
+	int nBlocksX, nBlocksY;
+	std::vector <unsigned char> vBlockDirty;
+	bool anyDirty;
+	bool created; // Whether the OpenGL texture exists.
+
+#ifdef WILDCAT_USE_OPENGL
+	GLuint aPBO [2];
+	int pboIndex;
+#endif
+
+		// Work out the rectangles to upload from the dirty blocks.
+	void buildRects()
+	{
+		vRect.clear();
+
+			// Rectangles which ended on the previous row of blocks, and can still be extended down.
+		std::vector <int> vOpen;
+		std::vector <int> vStillOpen;
+
+		for (int by=0;by<nBlocksY;++by)
+		{
+			vStillOpen.clear();
+			const unsigned char* row = &vBlockDirty[by*nBlocksX];
+
+			for (int bx=0;bx<nBlocksX;)
+			{
+				if ( row[bx]==0 ) { ++bx; continue; }
+
+				const int bx1 = bx;
+				while ( bx<nBlocksX && row[bx]!=0 ) { ++bx; }
+
+				const int x1 = bx1*BLOCK_SIZE;
+				const int x2 = std::min(bx*BLOCK_SIZE,nX);
+				const int y2 = std::min((by+1)*BLOCK_SIZE,nY);
+
+				int extended = -1;
+				for (unsigned int i=0;i<vOpen.size();++i)
+				{
+					PixelScreen_DirtyRect& rect = vRect(vOpen[i]);
+					if ( rect.x==x1 && rect.nX==x2-x1 )
+					{
+						rect.nY = y2-rect.y;
+						extended = vOpen[i];
+						break;
+					}
+				}
+				if ( extended==-1 )
+				{
+					PixelScreen_DirtyRect rect;
+					rect.x=x1;
+					rect.y=by*BLOCK_SIZE;
+					rect.nX=x2-x1;
+					rect.nY=y2-rect.y;
+					vRect.push(rect);
+					extended = vRect.size()-1;
+				}
+				vStillOpen.push_back(extended);
+			}
+			vOpen.swap(vStillOpen);
+		}
+
+		if ( vRect.size() > MAX_RECTS )
+		{
+			int x1=nX, y1=nY, x2=0, y2=0;
+			for (int i=0;i<vRect.size();++i)
+			{
+				x1 = std::min(x1,vRect(i).x);
+				y1 = std::min(y1,vRect(i).y);
+				x2 = std::max(x2,vRect(i).x+vRect(i).nX);
+				y2 = std::max(y2,vRect(i).y+vRect(i).nY);
+			}
+			vRect.clear();
+			PixelScreen_DirtyRect rect;
+			rect.x=x1; rect.y=y1; rect.nX=x2-x1; rect.nY=y2-y1;
+			vRect.push(rect);
+		}
+	}
+
+	public:
+
+	bool usePBO;
+
+	Vector <PixelScreen_DirtyRect> vRect; // The rectangles sent by the last upload().
+	unsigned long int bytesUploaded; // Bytes sent by the last upload().
+	unsigned long int totalBytesUploaded;
+
+	PixelScreen_DirtyTexture()
+	{
+		texture=0;
+		nX=0; nY=0;
+		nBlocksX=0; nBlocksY=0;
+		anyDirty=false;
+		created=false;
+		usePBO=false;
+		bytesUploaded=0;
+		totalBytesUploaded=0;
+	#ifdef WILDCAT_USE_OPENGL
+		aPBO[0]=0; aPBO[1]=0;
+		pboIndex=0;
+	#endif
+	}
+	~PixelScreen_DirtyTexture()
+	{
+		release();
+	}
+
+		// Link to the texture. Everything is marked dirty, so the first upload sends the whole texture.
+	void init(Texture* _texture)
+	{
+		release();
+		texture=_texture;
+		nX = texture==0 ? 0 : texture->nX;
+		nY = texture==0 ? 0 : texture->nY;
+		nBlocksX = (nX+BLOCK_SIZE-1)>>BLOCK_BITS;
+		nBlocksY = (nY+BLOCK_SIZE-1)>>BLOCK_BITS;
+		vBlockDirty.assign(nBlocksX*nBlocksY,0);
+		markAll();
+	}
+
+		// Delete the OpenGL texture and buffers.
+	void release()
+	{
+	#ifdef WILDCAT_USE_OPENGL
+		if ( created && texture!=0 )
+		{
+			glDeleteTextures(1,&texture->textureID);
+			texture->textureID=0;
+		}
+		if ( aPBO[0]!=0 )
+		{
+			glDeleteBuffers(2,aPBO);
+			aPBO[0]=0; aPBO[1]=0;
+		}
+	#endif
+		created=false;
+	}
+
+	inline void markPixel(const int _x, const int _y)
+	{
+		if ( _x<0 || _y<0 || _x>=nX || _y>=nY ) { return; }
+		vBlockDirty[(_y>>BLOCK_BITS)*nBlocksX + (_x>>BLOCK_BITS)]=1;
+		anyDirty=true;
+	}
+
+		// Mark pixels x1 to x2 and y1 to y2 inclusive. The rectangle is clipped to the texture.
+	void markRect(int _x1, int _y1, int _x2, int _y2)
+	{
+		if ( _x1>_x2 ) { std::swap(_x1,_x2); }
+		if ( _y1>_y2 ) { std::swap(_y1,_y2); }
+		_x1=std::max(_x1,0);
+		_y1=std::max(_y1,0);
+		_x2=std::min(_x2,nX-1);
+		_y2=std::min(_y2,nY-1);
+		if ( _x1>_x2 || _y1>_y2 ) { return; }
+
+		for (int by=_y1>>BLOCK_BITS;by<=_y2>>BLOCK_BITS;++by)
+		{
+			for (int bx=_x1>>BLOCK_BITS;bx<=_x2>>BLOCK_BITS;++bx)
+			{ vBlockDirty[by*nBlocksX+bx]=1; }
+		}
+		anyDirty=true;
+	}
+
+	void markAll()
+	{
+		std::fill(vBlockDirty.begin(),vBlockDirty.end(),1);
+		anyDirty = vBlockDirty.size() > 0;
+	}
+
+	inline bool isDirty() const
+	{ return anyDirty; }
+
+		// Send the dirty parts of the texture, and clear the marks.
+	void upload()
+	{
+		bytesUploaded=0;
+		vRect.clear();
+		if ( texture==0 || texture->data==0 ) { return; }
+
+		if ( texture->nX!=nX || texture->nY!=nY )
+		{ init(texture); }
+
+		if ( anyDirty==false && created ) { return; }
+
+		const bool newTexture = created==false;
+		if ( newTexture )
+		{
+		#ifdef WILDCAT_USE_OPENGL
+			glGenTextures(1,&texture->textureID);
+			glBindTexture(GL_TEXTURE_2D, texture->textureID);
+			glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, nX, nY, 0, GL_RGBA, GL_UNSIGNED_BYTE, texture->data);
+		#endif
+			created=true;
+
+			PixelScreen_DirtyRect rect;
+			rect.x=0; rect.y=0; rect.nX=nX; rect.nY=nY;
+			vRect.push(rect);
+		}
+		else
+		{ buildRects(); }
+
+		for (int i=0;i<vRect.size();++i)
+		{ bytesUploaded += (unsigned long int)vRect(i).nX*vRect(i).nY*4; }
+		totalBytesUploaded+=bytesUploaded;
+
+	#ifdef WILDCAT_USE_OPENGL
+			// A new texture has already been sent in full by glTexImage2D().
+		if ( newTexture==false && usePBO && GLEW_VERSION_2_1 )
+		{
+			glBindTexture(GL_TEXTURE_2D, texture->textureID);
+			if ( aPBO[0]==0 ) { glGenBuffers(2,aPBO); }
+			pboIndex = 1-pboIndex;
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER,aPBO[pboIndex]);
+				// Orphan the old storage so we don't wait for the GPU to finish with it.
+			glBufferData(GL_PIXEL_UNPACK_BUFFER,bytesUploaded,0,GL_STREAM_DRAW);
+
+			unsigned char* buffer = (unsigned char*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER,GL_WRITE_ONLY);
+			if ( buffer!=0 )
+			{
+				Vector <unsigned long int> vOffset;
+				unsigned long int offset = 0;
+				for (int i=0;i<vRect.size();++i)
+				{
+					const PixelScreen_DirtyRect& rect = vRect(i);
+					vOffset.push(offset);
+					for (int _y=rect.y;_y<rect.y+rect.nY;++_y)
+					{
+						const unsigned char* source = &texture->data[(_y*nX+rect.x)*4];
+						std::copy(source,source+rect.nX*4,buffer+offset);
+						offset+=rect.nX*4;
+					}
+				}
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+				for (int i=0;i<vRect.size();++i)
+				{
+					const PixelScreen_DirtyRect& rect = vRect(i);
+					glTexSubImage2D(GL_TEXTURE_2D,0,rect.x,rect.y,rect.nX,rect.nY,GL_RGBA,GL_UNSIGNED_BYTE,(const GLvoid*)vOffset(i));
+				}
+			}
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER,0);
+		}
+		else if ( newTexture==false )
+		{
+			glBindTexture(GL_TEXTURE_2D, texture->textureID);
+
+				// Upload straight from the texture, skipping to each rectangle.
+			glPixelStorei(GL_UNPACK_ROW_LENGTH,nX);
+			for (int i=0;i<vRect.size();++i)
+			{
+				const PixelScreen_DirtyRect& rect = vRect(i);
+				glTexSubImage2D(GL_TEXTURE_2D,0,rect.x,rect.y,rect.nX,rect.nY,GL_RGBA,GL_UNSIGNED_BYTE,&texture->data[(rect.y*nX+rect.x)*4]);
+			}
+			glPixelStorei(GL_UNPACK_ROW_LENGTH,0);
+		}
+	#endif
+
+		std::fill(vBlockDirty.begin(),vBlockDirty.end(),0);
+		anyDirty=false;
+	}
+};
+
+#endif
@@ -0,0 +1,120 @@
+#include <Graphics/PixelScreen/PixelScreen_DirtyTexture.hpp>
+#include <Math/Random/RandomLehmer.hpp>
+
+#include <iostream>
+
+// g++ PixelScreen_DirtyTexture_Test.cpp -I %WILDCAT%/
+
+// Headless test of PixelScreen_DirtyTexture. Nothing is sent to a GPU, but the bytes which would have been uploaded
+// are counted, so we can check how much each kind of update costs compared to uploading the whole screen.
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+	// Whether a pixel is inside any of the uploaded rectangles.
+bool isUploaded(PixelScreen_DirtyTexture& dirty, const int _x, const int _y)
+{
+	for (int i=0;i<dirty.vRect.size();++i)
+	{
+		const PixelScreen_DirtyRect& rect = dirty.vRect(i);
+		if ( _x>=rect.x && _x<rect.x+rect.nX && _y>=rect.y && _y<rect.y+rect.nY )
+		{ return true; }
+	}
+	return false;
+}
+
+int main (int nArgs, char ** arg)
+{
+	const int nX = 320;
+	const int nY = 200;
+	const unsigned long int fullBytes = nX*nY*4;
+
+	Texture texture;
+	texture.create(nX,nY,1,true);
+
+	PixelScreen_DirtyTexture dirty;
+	dirty.init(&texture);
+
+	dirty.upload();
+	std::cout<<"  First upload: "<<dirty.bytesUploaded<<" bytes.\n";
+	check("First upload sends everything",dirty.bytesUploaded==fullBytes);
+
+	dirty.upload();
+	check("Nothing changed sends nothing",dirty.bytesUploaded==0);
+
+	// A blinking cursor: one 8x8 character cell.
+	dirty.markRect(8,8,15,15);
+	dirty.upload();
+	std::cout<<"  Cursor blink: "<<dirty.bytesUploaded<<" bytes.\n";
+	check("Cursor blink sends one block",dirty.bytesUploaded==16*16*4 && dirty.vRect.size()==1);
+
+	// A line of text across the screen.
+	dirty.markRect(0,40,nX-1,47);
+	dirty.upload();
+	std::cout<<"  Line of text: "<<dirty.bytesUploaded<<" bytes.\n";
+	check("Line of text sends one row of blocks",dirty.bytesUploaded==(unsigned long int)nX*16*4 && dirty.vRect.size()==1);
+
+	// A sprite moving across a 2x2 block area is joined into one rectangle.
+	dirty.markRect(100,100,131,131);
+	dirty.upload();
+	check("Blocks with the same span are joined",dirty.vRect.size()==1 && dirty.vRect(0).nY==48);
+
+	// Scattered pixels must all be inside the uploaded rectangles, and the rectangles must not overlap.
+	RandomLehmer rng;
+	rng.seed(5);
+	Vector <int> vX, vY;
+	for (int i=0;i<200;++i)
+	{
+		vX.push(rng.rand32()%nX);
+		vY.push(rng.rand32()%nY);
+		dirty.markPixel(vX(i),vY(i));
+	}
+	dirty.upload();
+	bool allCovered = true;
+	for (int i=0;i<vX.size();++i)
+	{
+		if ( isUploaded(dirty,vX(i),vY(i))==false ) { allCovered=false; }
+	}
+	bool noOverlap = true;
+	for (int i=0;i<dirty.vRect.size();++i)
+	{
+		for (int j=i+1;j<dirty.vRect.size();++j)
+		{
+			const PixelScreen_DirtyRect& a = dirty.vRect(i);
+			const PixelScreen_DirtyRect& b = dirty.vRect(j);
+			if ( a.x < b.x+b.nX && b.x < a.x+a.nX && a.y < b.y+b.nY && b.y < a.y+a.nY ) { noOverlap=false; }
+		}
+	}
+	std::cout<<"  200 scattered pixels: "<<dirty.bytesUploaded<<" bytes in "<<dirty.vRect.size()<<" rectangles.\n";
+	check("Scattered pixels are covered",allCovered);
+	check("Rectangles don't overlap",noOverlap);
+	check("Scattered pixels stay under the rectangle limit",dirty.vRect.size()<=32);
+
+	// Marking outside the texture is ignored, and the edge blocks are clipped to the texture.
+	dirty.markPixel(-1,5);
+	dirty.markPixel(nX,5);
+	dirty.markRect(nX-1,nY-1,nX+50,nY+50);
+	dirty.upload();
+	check("Edges are clipped",dirty.vRect.size()==1 && dirty.vRect(0).x+dirty.vRect(0).nX==nX && dirty.vRect(0).y+dirty.vRect(0).nY==nY);
+
+	dirty.markAll();
+	dirty.upload();
+	check("Full screen update",dirty.bytesUploaded==fullBytes);
+
+	// Resizing the texture starts again with a full upload.
+	delete [] texture.data;
+	texture.create(640,400,1,true);
+	dirty.upload();
+	check("Resize sends everything",dirty.bytesUploaded==640*400*4);
+
+	if ( nFailed==0 )
+	{ std::cout<<"All tests passed.\n"; }
+	else
+	{ std::cout<<nFailed<<" tests failed.\n"; }
+	return nFailed;
+}
@@ -9,6 +9,8 @@
 #include "Renderer.hpp"
 
 /* STL libs */
+#include <algorithm> /* For sorting batches by layer. */
+#include <iostream>
 /* Internal libs */
 #include <Graphics/Texture/Texture.hpp> /* For texture rendering. */
 #include <Math/Geometry/Geometry.hpp> /* For rotations and coordinates. */
@@ -23,6 +25,18 @@
 	/* Put Direct3D code here... */
 #endif
 
+unsigned char Renderer::currentColour[4]={255,255,255,255};
+
+bool Renderer::batching=false;
+bool Renderer::groupByTexture=false;
+int Renderer::batchLayer=0;
+std::vector <Renderer::Batch> Renderer::vBatch;
+int Renderer::nBatches=0;
+std::map < std::tuple <int,int,unsigned int>, int > Renderer::mBatchIndex;
+int Renderer::lastBatchIndex=-1;
+unsigned int Renderer::nBatchesSubmitted=0;
+unsigned int Renderer::nPrimitivesBatched=0;
+
 
 /* Save the current viewport so it can be quickly restored later. */
 void Renderer::saveViewPort()
@@ -37,6 +51,8 @@ void Renderer::saveViewPort()
 /* Restore the viewport to the previously saved coordinates. I'm not sure if this code is correct, but it seems to work okay. I'll leave the mess here for now. */
 void Renderer::restoreViewPort()
 {
+	/* The batch must be drawn using the viewport it was made for. */
+	flushBatch();
 	#ifdef WILDCAT_USE_OPENGL
 		/* Update projection matrix */
 		glMatrixMode(GL_PROJECTION);
@@ -54,6 +70,7 @@ void Renderer::restoreViewPort()
 	My viewport functions take 2 coordinates, which is different to the usual way viewports are handled in OpenGL. This is just due to the way my engine works. */
 void Renderer::resizeViewPort(const int _x1, const int _y1, const int _x2, const int _y2)
 {
+	flushBatch();
 	#ifdef WILDCAT_USE_OPENGL
 		/* Note that the glViewport wants the bottom-left point and then the width and height, whereas gluOrtho2D wants x1,x2,y1,y2. */
 		const int _nX = _x2-_x1;
@@ -68,26 +85,33 @@ void Renderer::resizeViewPort(const int _x1, const int _y1, const int _x2, const
 		glMatrixMode(GL_MODELVIEW);
 	#elif defined WILDCAT_USE_DIRECT3D
 		/* Put Direct3D code here... */
+	#else
+		/* Headless builds have no viewport. */
+		(void)_x1; (void)_y1; (void)_x2; (void)_y2;
 	#endif
 }
 
-void Renderer::resetColour()
+void Renderer::setCurrentColour(const unsigned char r, const unsigned char g, const unsigned char b, const unsigned char a)
 {
+	currentColour[0]=r;
+	currentColour[1]=g;
+	currentColour[2]=b;
+	currentColour[3]=a;
 	#ifdef WILDCAT_USE_OPENGL
-		glColor4ub(255,255,255,255);
+		glColor4ub(r,g,b,a);
 	#elif defined WILDCAT_USE_DIRECT3D
 		/* Put Direct3D code here... */
 	#endif
 }
 
-void Renderer::setColour(ColourRGBA <unsigned char> colour)
+void Renderer::resetColour()
 {
-	#ifdef WILDCAT_USE_OPENGL
-		glColor4ub(colour.red,colour.green,colour.blue,colour.alpha);
-	#elif defined WILDCAT_USE_DIRECT3D
-		/* Put Direct3D code here... */
-	#endif
+	setCurrentColour(255,255,255,255);
+}
 
+void Renderer::setColour(ColourRGBA <unsigned char> colour)
+{
+	setCurrentColour(colour.red,colour.green,colour.blue,colour.alpha);
 }
 
 void Renderer::setTextureMode()
@@ -124,23 +148,8 @@ void Renderer::setColourMode()
 /* There was also a function like this which took 'const GLuint _texture' instead of 'const Texture* _texture'. I think I'll try to stick with using the Texture object from now on. */
 void Renderer::placeTexture8(const int _x1, const int _y1, const int _x2, const int _y2, const int _x3, const int _y3, const int _x4, const int _y4, const Texture* _texture)
 {
-	#ifdef WILDCAT_USE_OPENGL
 	setTextureMode();
-	
-	glBindTexture( GL_TEXTURE_2D, _texture->textureID);
-	glBegin(GL_QUADS);
-		glTexCoord2f(0,1);
-		glVertex2f(_x1,_y1);
-		glTexCoord2f(1,1);
-		glVertex2f(_x2,_y2);
-		glTexCoord2f(1,0);
-		glVertex2f(_x3,_y3);
-		glTexCoord2f(0,0);
-		glVertex2f(_x4,_y4);
-	glEnd();
-	#elif defined WILDCAT_USE_DIRECT3D
-		/* Put Direct3D code here... */
-	#endif
+	submitTexturedQuad(_texture,_x1,_y1,_x2,_y2,_x3,_y3,_x4,_y4);
 }
 
 #include <math.h>
@@ -148,29 +157,18 @@ void Renderer::placeTexture8(const int _x1, const int _y1, const int _x2, const
 /* Render a square texture rotated about its center by a certain number of degrees. */
 void Renderer::placeTexture4RotatedDegrees(const int _x1, const int _y1, const int _x2, const int _y2, const Texture* _texture, const int rotationDegrees)
 {
-	#ifdef WILDCAT_USE_OPENGL
-		setTextureMode();
-	
-		/* Turn the 2 points into a square object. */
-		Square <double> square (_x1,_y1,_x2,_y2);
-		/* Rotate the square object. */
-		square.rotateAboutCenterDegrees(rotationDegrees);
+	setTextureMode();
 
-		glBindTexture( GL_TEXTURE_2D, _texture->textureID);
-		glBegin(GL_QUADS);
-		
-			glTexCoord2f(0,1);
-			glVertex2f(round(square.p1.x),round(square.p1.y));
-			glTexCoord2f(1,1);
-			glVertex2f(round(square.p2.x),round(square.p2.y));
-			glTexCoord2f(1,0);
-			glVertex2f(round(square.p3.x),round(square.p3.y));
-			glTexCoord2f(0,0);
-			glVertex2f(round(square.p4.x),round(square.p4.y));
-		glEnd();
-	#elif defined WILDCAT_USE_DIRECT3D
-		/* Put Direct3D code here... */
-	#endif
+	/* Turn the 2 points into a square object. */
+	Square <double> square (_x1,_y1,_x2,_y2);
+	/* Rotate the square object. */
+	square.rotateAboutCenterDegrees(rotationDegrees);
+
+	submitTexturedQuad(_texture,
+		round(square.p1.x),round(square.p1.y),
+		round(square.p2.x),round(square.p2.y),
+		round(square.p3.x),round(square.p3.y),
+		round(square.p4.x),round(square.p4.y));
 }
 
 /*
@@ -183,93 +181,50 @@ void Renderer::placeTexture4(const int _x1, const int _y1, const int _x2, const
 {
 	if (_texture == 0)
 	{ return; }
-	#ifdef WILDCAT_USE_OPENGL
-		setTextureMode();
-	
-		if(preserveAspectRatio==false)
+
+	setTextureMode();
+
+	if(preserveAspectRatio==false)
+	{
+		submitTexturedQuad(_texture,_x1,_y1,_x2,_y1,_x2,_y2,_x1,_y2);
+	}
+	else
+	{
+		/* Stretch the image to fit, but preserve aspect ratio. */
+
+		const double textureAspectRatio = (double)_texture->nX/_texture->nY;
+		const int selectionNX = _x2-_x1;
+		const int selectionNY = _y2-_y1;
+		const double selectionAspectRatio = (double) selectionNX/selectionNY;
+
+		/* higher number == wider. */
+		if(selectionAspectRatio==textureAspectRatio)
+		{
+			submitTexturedQuad(_texture,_x1,_y1,_x2,_y1,_x2,_y2,_x1,_y2);
+		}
+		/* Coords are too wide. */
+		else if(selectionAspectRatio>textureAspectRatio)
 		{
-			glBindTexture( GL_TEXTURE_2D, _texture->textureID);
-			glBegin(GL_QUADS);
-				glTexCoord2f(0,1);
-				glVertex2f(_x1,_y1);
-				glTexCoord2f(1,1);
-				glVertex2f(_x2,_y1);
-				glTexCoord2f(1,0);
-				glVertex2f(_x2,_y2);
-				glTexCoord2f(0,0);
-				glVertex2f(_x1,_y2);
-			glEnd();
+			/* Find height that matches aspect ratio. */
+			const int requiredHeight = selectionNX*(1/textureAspectRatio);
+			/* Needs to be centered vertically. */
+			const int centerY = ((_y2-_y1) / 2) + _y1;
+
+			const int newY1 = centerY - (requiredHeight/2);
+			const int newY2 = centerY + (requiredHeight/2);
+			submitTexturedQuad(_texture,_x1,newY1,_x2,newY1,_x2,newY2,_x1,newY2);
 		}
 		else
 		{
-			/* Stretch the image to fit, but preserve aspect ratio. */
-			
-			const double textureAspectRatio = (double)_texture->nX/_texture->nY;
-			const int selectionNX = _x2-_x1;
-			const int selectionNY = _y2-_y1;
-			const double selectionAspectRatio = (double) selectionNX/selectionNY;
-
-			/* higher number == wider. */
-			if(selectionAspectRatio==textureAspectRatio)
-			{
-				glBindTexture( GL_TEXTURE_2D, _texture->textureID);
-				glBegin(GL_QUADS);
-					glTexCoord2f(0,1);
-					glVertex2f(_x1,_y1);
-					glTexCoord2f(1,1);
-					glVertex2f(_x2,_y1);
-					glTexCoord2f(1,0);
-					glVertex2f(_x2,_y2);
-					glTexCoord2f(0,0);
-					glVertex2f(_x1,_y2);
-				glEnd();
-			}
-			/* Coords are too wide. */
-			else if(selectionAspectRatio>textureAspectRatio)
-			{
-				/* Find required width. */
-				const int requiredWidth = selectionNX;
-				/* Find height that matches aspect ratio. */
-				const int requiredHeight = selectionNX*(1/textureAspectRatio);
-				/* Needs to be centered vertically. */
-				const int centerY = ((_y2-_y1) / 2) + _y1;
-				
-				glBindTexture( GL_TEXTURE_2D, _texture->textureID);
-				glBegin(GL_QUADS);
-					glTexCoord2f(0,1);
-					glVertex2f(_x1,centerY - (requiredHeight/2));
-					glTexCoord2f(1,1);
-					glVertex2f(_x2,centerY - (requiredHeight/2));
-					glTexCoord2f(1,0);
-					glVertex2f(_x2,centerY + (requiredHeight/2));
-					glTexCoord2f(0,0);
-					glVertex2f(_x1,centerY + (requiredHeight/2));
-				glEnd();
-				
-				
-			}
-			else
-			{
-				/* Find required width. */
-				const int requiredWidth = selectionNY*textureAspectRatio;
-				const int centerX = ((_x2-_x1) / 2) + _x1;
-				
-				glBindTexture( GL_TEXTURE_2D, _texture->textureID);
-				glBegin(GL_QUADS);
-					glTexCoord2f(0,1);
-					glVertex2f(centerX - (requiredWidth/2),_y1);
-					glTexCoord2f(1,1);
-					glVertex2f(centerX + (requiredWidth/2),_y1);
-					glTexCoord2f(1,0);
-					glVertex2f(centerX + (requiredWidth/2),_y2);
-					glTexCoord2f(0,0);
-					glVertex2f(centerX - (requiredWidth/2),_y2);
-				glEnd();
-			}
+			/* Find required width. */
+			const int requiredWidth = selectionNY*textureAspectRatio;
+			const int centerX = ((_x2-_x1) / 2) + _x1;
+
+			const int newX1 = centerX - (requiredWidth/2);
+			const int newX2 = centerX + (requiredWidth/2);
+			submitTexturedQuad(_texture,newX1,_y1,newX2,_y1,newX2,_y2,newX1,_y2);
 		}
-	#elif defined WILDCAT_USE_DIRECT3D
-		/* Put Direct3D code here... */
-	#endif
+	}
 }
 void Renderer::placeTexture4(const int _x1, const int _y1, const int _x2, const int _y2, HasTexture* _texture, const bool preserveAspectRatio /* Default false. */)
 {
@@ -289,111 +244,287 @@ void Renderer::placeTextureCentered (const int _centerX, const int _centerY, Has
 
 void Renderer::placeColour4 (const unsigned char r, const unsigned char g, const unsigned char b, const int _x1, const int _y1, const int _x2, const int _y2)
 {
+	setColourMode();
+	/* Set the colour of the shape. */
+	setCurrentColour(r,g,b,255);
+	/* Draw the shape. */
+	submitColourQuad(_x1,_y1,_x2,_y2);
+}
+
+void Renderer::placeColour4a (const unsigned char r, const unsigned char g, const unsigned char b, const unsigned char a, const int _x1, const int _y1, const int _x2, const int _y2)
+{
+	setColourMode();
+	/* Set the colour of the shape. */
+	setCurrentColour(r,g,b,a);
+	/* Draw the shape. */
+	submitColourQuad(_x1,_y1,_x2,_y2);
+
+		// Reset alpha.
+	setCurrentColour(r,g,b,255);
+}
+
+void Renderer::placeColour4 (ColourRGB <unsigned char>& colour, const int _x1, const int _y1, const int _x2, const int _y2)
+{
+	Renderer::placeColour4 (colour.red,colour.green,colour.blue,_x1,_y1,_x2,_y2);
+}
+
+//Stolen from https://stackoverflow.com/questions/13462209/opengl-draw-rectangle-outline
+void Renderer::placeBorder4(const unsigned char r, const unsigned char g, const unsigned char b, const int _x1, const int _y1, const int _x2, const int _y2)
+{
+	setColourMode();
+	/* Set the colour of the shape. */
+	setCurrentColour(r,g,b,255);
+	/* Draw the shape. This used to be a line loop, but separate lines can be batched. */
+	submitLine(_x1,_y1,_x1,_y2);
+	submitLine(_x1,_y2,_x2,_y2);
+	submitLine(_x2,_y2,_x2,_y1);
+	submitLine(_x2,_y1,_x1,_y1);
+}
+
+void Renderer::placeLine(const unsigned char r, const unsigned char g, const unsigned char b, const int _x1, const int _y1, const int _x2, const int _y2)
+{
+	setColourMode();
+	/* Set the colour of the shape. */
+	setCurrentColour(r,g,b,255);
+	/* Draw the shape. */
+	submitLine(_x1,_y1,_x2,_y2);
+}
+
+void Renderer::placeLineAlpha(const unsigned char r, const unsigned char g, const unsigned char b, const unsigned char a, const float _x1, const float _y1, const float _x2, const float _y2, const float lineThickness)
+{
+	/* Batches are drawn with the default line width, so thick lines are drawn straight away. */
+	const bool wasBatching = batching;
+	if ( lineThickness != 1 && batching )
+	{
+		flushBatch();
+		batching=false;
+	}
+
 	#ifdef WILDCAT_USE_OPENGL
-		setColourMode();
-		/* Set the colour of the shape. */
-		glColor3ub(r,g,b);
-		/* Draw the shape. */
-		glBegin(GL_TRIANGLE_STRIP);
-			glVertex2f(_x1,_y2);
+		glLineWidth(lineThickness);
+	#endif
+
+	setColourMode();
+	/* Set the colour of the shape. */
+	setCurrentColour(r,g,b,a);
+	/* Draw the shape. */
+	submitLine(_x1,_y1,_x2,_y2);
+
+	#ifdef WILDCAT_USE_OPENGL
+		// reset line width to default
+		glLineWidth(1);
+	#endif
+
+	batching=wasBatching;
+}
+
+Renderer::Batch* Renderer::getBatch(const enumBatchPrimitive _primitive, const bool _textured, const unsigned int _textureID)
+{
+	const int layer = groupByTexture ? batchLayer : 0;
+
+	/* Most of the time we're adding to the same batch as last time. */
+	if ( lastBatchIndex != -1 && vBatch[lastBatchIndex].sameKey(layer,_primitive,_textured,_textureID) )
+	{ return &vBatch[lastBatchIndex]; }
+
+	if ( groupByTexture )
+	{
+		auto found = mBatchIndex.find(std::make_tuple(layer,(int)_primitive*2+_textured,_textureID));
+		if ( found != mBatchIndex.end() )
+		{
+			lastBatchIndex=found->second;
+			return &vBatch[lastBatchIndex];
+		}
+	}
+
+	/* Start a new batch, reusing an old one if there is one. */
+	if ( nBatches == (int)vBatch.size() )
+	{ vBatch.push_back(Batch()); }
+
+	Batch* batch = &vBatch[nBatches];
+	batch->layer=layer;
+	batch->primitive=_primitive;
+	batch->textured=_textured;
+	batch->textureID=_textureID;
+	batch->vVertex.clear();
+
+	if ( groupByTexture )
+	{ mBatchIndex[std::make_tuple(layer,(int)_primitive*2+_textured,_textureID)]=nBatches; }
+
+	lastBatchIndex=nBatches;
+	++nBatches;
+	return batch;
+}
+
+void Renderer::submitTexturedQuad(const Texture* _texture, const float _x1, const float _y1, const float _x2, const float _y2, const float _x3, const float _y3, const float _x4, const float _y4)
+{
+	const float u1 = _texture->u1;
+	const float v1 = _texture->v1;
+	const float u2 = _texture->u2;
+	const float v2 = _texture->v2;
+
+	if ( batching )
+	{
+		std::vector <BatchVertex>& vVertex = getBatch(BATCH_QUADS,true,_texture->textureID)->vVertex;
+		const unsigned char* c = currentColour;
+		vVertex.push_back({_x1,_y1,u1,v2,{c[0],c[1],c[2],c[3]}});
+		vVertex.push_back({_x2,_y2,u2,v2,{c[0],c[1],c[2],c[3]}});
+		vVertex.push_back({_x3,_y3,u2,v1,{c[0],c[1],c[2],c[3]}});
+		vVertex.push_back({_x4,_y4,u1,v1,{c[0],c[1],c[2],c[3]}});
+		return;
+	}
+
+	#ifdef WILDCAT_USE_OPENGL
+		glBindTexture( GL_TEXTURE_2D, _texture->textureID);
+		glBegin(GL_QUADS);
+			glTexCoord2f(u1,v2);
 			glVertex2f(_x1,_y1);
+			glTexCoord2f(u2,v2);
 			glVertex2f(_x2,_y2);
-			glVertex2f(_x2,_y1);
+			glTexCoord2f(u2,v1);
+			glVertex2f(_x3,_y3);
+			glTexCoord2f(u1,v1);
+			glVertex2f(_x4,_y4);
 		glEnd();
 	#elif defined WILDCAT_USE_DIRECT3D
 		/* Put Direct3D code here... */
 	#endif
 }
 
-void Renderer::placeColour4a (const unsigned char r, const unsigned char g, const unsigned char b, const unsigned char a, const int _x1, const int _y1, const int _x2, const int _y2)
+void Renderer::submitColourQuad(const float _x1, const float _y1, const float _x2, const float _y2)
 {
+	if ( batching )
+	{
+		std::vector <BatchVertex>& vVertex = getBatch(BATCH_QUADS,false,0)->vVertex;
+		const unsigned char* c = currentColour;
+		vVertex.push_back({_x1,_y1,0,0,{c[0],c[1],c[2],c[3]}});
+		vVertex.push_back({_x2,_y1,0,0,{c[0],c[1],c[2],c[3]}});
+		vVertex.push_back({_x2,_y2,0,0,{c[0],c[1],c[2],c[3]}});
+		vVertex.push_back({_x1,_y2,0,0,{c[0],c[1],c[2],c[3]}});
+		return;
+	}
+
 	#ifdef WILDCAT_USE_OPENGL
-		setColourMode();
-		/* Set the colour of the shape. */
-		glColor4ub(r,g,b,a);
-		/* Draw the shape. */
 		glBegin(GL_TRIANGLE_STRIP);
 			glVertex2f(_x1,_y2);
 			glVertex2f(_x1,_y1);
 			glVertex2f(_x2,_y2);
 			glVertex2f(_x2,_y1);
 		glEnd();
-		
-			// Reset alpha.
-		glColor4ub(r,g,b,255);
 	#elif defined WILDCAT_USE_DIRECT3D
 		/* Put Direct3D code here... */
 	#endif
 }
 
-void Renderer::placeColour4 (ColourRGB <unsigned char>& colour, const int _x1, const int _y1, const int _x2, const int _y2)
+void Renderer::submitLine(const float _x1, const float _y1, const float _x2, const float _y2)
 {
+	if ( batching )
+	{
+		std::vector <BatchVertex>& vVertex = getBatch(BATCH_LINES,false,0)->vVertex;
+		const unsigned char* c = currentColour;
+		vVertex.push_back({_x1,_y1,0,0,{c[0],c[1],c[2],c[3]}});
+		vVertex.push_back({_x2,_y2,0,0,{c[0],c[1],c[2],c[3]}});
+		return;
+	}
+
 	#ifdef WILDCAT_USE_OPENGL
-		setColourMode();
-		Renderer::placeColour4 (colour.red,colour.green,colour.blue,_x1,_y1,_x2,_y2);
+		glBegin(GL_LINES);
+			glVertex2f(_x1,_y1);
+			glVertex2f(_x2,_y2);
+		glEnd();
 	#elif defined WILDCAT_USE_DIRECT3D
 		/* Put Direct3D code here... */
 	#endif
 }
 
-//Stolen from https://stackoverflow.com/questions/13462209/opengl-draw-rectangle-outline
-void Renderer::placeBorder4(const unsigned char r, const unsigned char g, const unsigned char b, const int _x1, const int _y1, const int _x2, const int _y2)
+void Renderer::beginBatch(const bool _groupByTexture /* Default false. */)
 {
-	#ifdef WILDCAT_USE_OPENGL
-		setColourMode();
-		/* Set the colour of the shape. */
-		glColor3ub(r,g,b);
-		/* Draw the shape. */
-		 glBegin(GL_LINE_LOOP);
-      glVertex2f(_x1,_y1);
-      glVertex2f(_x1,_y2);
-      glVertex2f(_x2,_y2);
-      glVertex2f(_x2,_y1);
-      //glVertex2f(_x1,_y1);
-      
-
-		 glEnd();
-    
-	#elif defined WILDCAT_USE_DIRECT3D
-		/* Put Direct3D code here... */
-	#endif
+	if ( batching )
+	{
+		std::cout<<"WARNING: Renderer::beginBatch() called while already batching.\n";
+		flushBatch();
+	}
+	batching=true;
+	groupByTexture=_groupByTexture;
+	batchLayer=0;
 }
 
-void Renderer::placeLine(const unsigned char r, const unsigned char g, const unsigned char b, const int _x1, const int _y1, const int _x2, const int _y2)
+void Renderer::endBatch()
 {
-	#ifdef WILDCAT_USE_OPENGL
-		setColourMode();
-		/* Set the colour of the shape. */
-		glColor3ub(r,g,b);
-		/* Draw the shape. */
-		 glBegin(GL_LINES);
-      glVertex2f(_x1,_y1);
-      glVertex2f(_x2,_y2);
-		 glEnd();
-    
-	#elif defined WILDCAT_USE_DIRECT3D
-		/* Put Direct3D code here... */
-	#endif
+	if ( batching==false )
+	{
+		std::cout<<"WARNING: Renderer::endBatch() called without beginBatch().\n";
+		return;
+	}
+	flushBatch();
+	batching=false;
+	groupByTexture=false;
+	batchLayer=0;
 }
 
-void Renderer::placeLineAlpha(const unsigned char r, const unsigned char g, const unsigned char b, const unsigned char a, const float _x1, const float _y1, const float _x2, const float _y2, const float lineThickness)
+void Renderer::flushBatch()
 {
+	if ( nBatches==0 )
+	{ return; }
+
+	/* Batches are in order of their first quad, so a stable sort keeps that order within each layer. */
+	if ( groupByTexture )
+	{
+		std::stable_sort(vBatch.begin(),vBatch.begin()+nBatches, [](const Batch& a, const Batch& b)
+		{ return a.layer < b.layer; });
+	}
+
 	#ifdef WILDCAT_USE_OPENGL
-      glLineWidth(lineThickness);
-   
-		setColourMode();
-		/* Set the colour of the shape. */
-		glColor4ub(r,g,b,a);
-		/* Draw the shape. */
-		 glBegin(GL_LINES);
-      glVertex2f(_x1,_y1);
-      glVertex2f(_x2,_y2);
-		 glEnd();
-    
-      // reset line width to default
-      glLineWidth(1);
+		const GLsizei stride = sizeof(BatchVertex);
+
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_COLOR_ARRAY);
+
+		for (int i=0;i<nBatches;++i)
+		{
+			const Batch* batch = &vBatch[i];
+			const BatchVertex* vertex = batch->vVertex.data();
+
+			if ( batch->textured )
+			{
+				glEnable(GL_TEXTURE_2D);
+				glBindTexture(GL_TEXTURE_2D, batch->textureID);
+				glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+				glTexCoordPointer(2,GL_FLOAT,stride,&vertex->u);
+			}
+			else
+			{
+				glDisable(GL_TEXTURE_2D);
+				glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+			}
+			glVertexPointer(2,GL_FLOAT,stride,&vertex->x);
+			glColorPointer(4,GL_UNSIGNED_BYTE,stride,vertex->colour);
+
+			glDrawArrays(batch->primitive==BATCH_QUADS ? GL_QUADS : GL_LINES, 0, batch->vVertex.size());
+		}
+
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		glDisableClientState(GL_COLOR_ARRAY);
+		glDisableClientState(GL_VERTEX_ARRAY);
+
+		/* Put the state back the way the caller left it. The colour array leaves the current colour undefined. */
+		if ( textureMode )
+		{ glEnable(GL_TEXTURE_2D); }
+		else
+		{ glDisable(GL_TEXTURE_2D); }
+		glColor4ub(currentColour[0],currentColour[1],currentColour[2],currentColour[3]);
 	#elif defined WILDCAT_USE_DIRECT3D
 		/* Put Direct3D code here... */
 	#endif
+
+	for (int i=0;i<nBatches;++i)
+	{
+		const Batch* batch = &vBatch[i];
+		++nBatchesSubmitted;
+		nPrimitivesBatched += batch->vVertex.size() / (batch->primitive==BATCH_QUADS ? 4 : 2);
+	}
+
+	nBatches=0;
+	lastBatchIndex=-1;
+	mBatchIndex.clear();
 }
 #endif
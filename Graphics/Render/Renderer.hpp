@@ -5,8 +5,30 @@
 /* #include <Render/Renderer.hpp>
 	Static class to link generic rendering calls to either OpenGL or Direct3D API at compile time or runtime. Currently only OpenGL is supported.
 	Replaces <Device/Display/OpenGLTools.hpp>.
+
+	BATCHING
+	Normally every place call binds its texture and draws straight away. Between beginBatch() and endBatch() the
+	quads and lines are instead added to a vertex stream on the CPU, and drawn with one draw call per texture when
+	the batch is flushed. The place calls don't need to change.
+
+		Renderer::beginBatch();
+		for (...) { Renderer::placeTexture4(x1,y1,x2,y2,texture); }
+		Renderer::endBatch();
+
+	By default the draw order is kept, so only quads in a row with the same texture share a draw call. With
+	beginBatch(true) quads are grouped by texture, which is much faster but can change the draw order. Call
+	setBatchLayer() to keep things in order: lower layers are always drawn first. For example a tile map can give
+	the nth quad on each tile layer n, because tiles don't overlap.
+
+	Direct OpenGL calls inside a batch will be drawn before the batched geometry, so call flushBatch() first.
+
+	The batch stats are counted even without OpenGL, so batching can be tested headless.
 */
 
+#include <vector>
+#include <map>
+#include <tuple>
+
 class Texture;
 //class Colour;
 template <typename> class ColourRGBA;
@@ -23,6 +45,59 @@ class Renderer
 			static GLint savedViewPort[4]; /* This keeps track of the previous viewport coordinates. */
 		#endif
 
+		/* The current colour, which batched vertices are tinted with. */
+		static unsigned char currentColour[4];
+
+		enum enumBatchPrimitive { BATCH_QUADS, BATCH_LINES };
+
+		class BatchVertex
+		{
+			public:
+			float x, y;
+			float u, v;
+			unsigned char colour[4];
+		};
+
+		/* One draw call. */
+		class Batch
+		{
+			public:
+			int layer;
+			enumBatchPrimitive primitive;
+			bool textured;
+			unsigned int textureID;
+			std::vector <BatchVertex> vVertex;
+
+			bool sameKey(const int _layer, const enumBatchPrimitive _primitive, const bool _textured, const unsigned int _textureID) const
+			{ return layer==_layer && primitive==_primitive && textured==_textured && textureID==_textureID; }
+		};
+
+		static bool batching;
+		static bool groupByTexture;
+		static int batchLayer;
+		/* Batches are kept between frames so their vertex buffers don't need to be reallocated. Sorting moves
+			the vertex buffers between batches rather than copying them. */
+		static std::vector <Batch> vBatch;
+		static int nBatches;
+		/* When grouping, this finds the batch for a layer, primitive and texture. */
+		static std::map < std::tuple <int,int,unsigned int>, int > mBatchIndex;
+		static int lastBatchIndex;
+
+		static unsigned int nBatchesSubmitted;
+		static unsigned int nPrimitivesBatched;
+
+		/* Set the current colour, and the OpenGL colour. */
+		static void setCurrentColour(const unsigned char r, const unsigned char g, const unsigned char b, const unsigned char a);
+
+		/* Get the batch to add to, making a new one if needed. */
+		static Batch* getBatch(const enumBatchPrimitive _primitive, const bool _textured, const unsigned int _textureID);
+
+		/* These draw straight away, or add to the batch if batching. They use the current colour.
+			The texture coordinates of the 4 corners are (u1,v2), (u2,v2), (u2,v1), (u1,v1). */
+		static void submitTexturedQuad(const Texture* _texture, const float _x1, const float _y1, const float _x2, const float _y2, const float _x3, const float _y3, const float _x4, const float _y4);
+		static void submitColourQuad(const float _x1, const float _y1, const float _x2, const float _y2);
+		static void submitLine(const float _x1, const float _y1, const float _x2, const float _y2);
+
 	public:
 	
 	/* Save the current viewport so it can be quickly restored later. */
@@ -86,6 +161,21 @@ class Renderer
    // Draw a line between points
    static void placeLine(const unsigned char r, const unsigned char g, const unsigned char b, const int _x1, const int _y1, const int _x2, const int _y2);
    static void placeLineAlpha(const unsigned char r, const unsigned char g, const unsigned char b, const unsigned char a, const float _x1, const float _y1, const float _x2, const float _y2, const float lineThickness=1);
+
+	/* Start batching. groupByTexture allows quads to be drawn out of order within each layer. */
+	static void beginBatch(const bool _groupByTexture=false);
+	/* Draw everything in the batch and stop batching. */
+	static void endBatch();
+	/* Draw everything in the batch and keep batching. */
+	static void flushBatch();
+	static bool isBatching() { return batching; }
+	/* Only used when grouping by texture. Layers are drawn from lowest to highest. */
+	static void setBatchLayer(const int _layer) { batchLayer=_layer; }
+
+	/* Number of draw calls made by flushes, and the number of quads and lines which went into them. */
+	static unsigned int getBatchesSubmitted() { return nBatchesSubmitted; }
+	static unsigned int getPrimitivesBatched() { return nPrimitivesBatched; }
+	static void resetBatchStats() { nBatchesSubmitted=0; nPrimitivesBatched=0; }
 /* End of class. */
 };
 
@@ -0,0 +1,110 @@
+#include <climits> /* Colour.hpp needs UINT_MAX. */
+#include <Graphics/Render/Renderer.cpp>
+#include <Graphics/Texture/Texture.hpp>
+
+#include <iostream>
+
+// g++ Renderer_BatchTest.cpp -I %WILDCAT%/
+
+// Headless test of Renderer batching. Build without WILDCAT_USE_OPENGL: nothing is drawn, but the batches
+// are still counted.
+
+int nFailed = 0;
+
+void check(const std::string name, const unsigned int nBatches, const unsigned int nPrimitives)
+{
+	const bool passed = Renderer::getBatchesSubmitted()==nBatches && Renderer::getPrimitivesBatched()==nPrimitives;
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<": "<<Renderer::getBatchesSubmitted()<<" batches, "
+		<<Renderer::getPrimitivesBatched()<<" primitives. Expected "<<nBatches<<", "<<nPrimitives<<".\n";
+	if ( passed==false ) { ++nFailed; }
+	Renderer::resetBatchStats();
+}
+
+int main (int nArgs, char ** arg)
+{
+	Texture grass, water, grid;
+	grass.textureID=1;
+	water.textureID=2;
+	grid.textureID=3;
+
+	// Without a batch nothing is counted.
+	Renderer::placeTexture4(0,0,16,16,&grass);
+	check("Immediate",0,0);
+
+	// Quads in a row with the same texture share a batch.
+	Renderer::beginBatch();
+	for (int i=0;i<100;++i)
+	{ Renderer::placeTexture4(i*16,0,i*16+16,16,&grass); }
+	Renderer::endBatch();
+	check("Same texture",1,100);
+
+	// Keeping the draw order means a new batch every time the texture changes.
+	Renderer::beginBatch();
+	for (int i=0;i<100;++i)
+	{
+		Renderer::placeTexture4(i*16,0,i*16+16,16,&grass);
+		Renderer::placeTexture4(i*16,0,i*16+16,16,&grid);
+	}
+	Renderer::endBatch();
+	check("Alternating textures in order",200,200);
+
+	// Grouping by texture needs one batch per texture.
+	Renderer::beginBatch(true);
+	for (int i=0;i<100;++i)
+	{
+		Renderer::placeTexture4(i*16,0,i*16+16,16, i%2==0 ? &grass : &water);
+		Renderer::placeTexture4(i*16,0,i*16+16,16,&grid);
+	}
+	Renderer::endBatch();
+	check("Alternating textures grouped",3,200);
+
+	// A tile map with layers: terrain, fog, then grid. One batch per texture per layer.
+	Renderer::beginBatch(true);
+	for (int _y=0;_y<10;++_y)
+	{
+		for (int _x=0;_x<10;++_x)
+		{
+			const int x1=_x*16, y1=_y*16;
+			int layer=0;
+			Renderer::setBatchLayer(layer++);
+			Renderer::placeTexture4(x1,y1,x1+16,y1+16, (_x+_y)%2==0 ? &grass : &water);
+			Renderer::setBatchLayer(layer++);
+			Renderer::placeColour4a(0,0,0,120,x1,y1,x1+16,y1+16);
+			Renderer::setBatchLayer(layer++);
+			Renderer::placeTexture4(x1,y1,x1+16,y1+16,&grid);
+		}
+	}
+	Renderer::endBatch();
+	check("Layered tile map",4,300);
+
+	// Colours and lines.
+	Renderer::beginBatch();
+	Renderer::placeColour4(255,0,0,0,0,10,10);
+	Renderer::placeColour4a(0,255,0,100,0,0,10,10);
+	Renderer::placeBorder4(0,0,255,0,0,10,10);
+	Renderer::placeLine(0,0,255,0,0,10,10);
+	Renderer::endBatch();
+	check("Colours and lines",2,7);
+
+	// Thick lines can't be batched, so they flush the batch.
+	Renderer::beginBatch();
+	Renderer::placeTexture4(0,0,16,16,&grass);
+	Renderer::placeLineAlpha(255,255,255,255,0,0,10,10,3);
+	Renderer::placeTexture4(0,0,16,16,&grass);
+	Renderer::endBatch();
+	check("Thick line",2,2);
+
+	// Changing the viewport flushes the batch.
+	Renderer::beginBatch();
+	Renderer::placeTexture4(0,0,16,16,&grass);
+	Renderer::resizeViewPort(0,0,100,100);
+	Renderer::placeTexture4(0,0,16,16,&grass);
+	Renderer::endBatch();
+	check("Viewport change",2,2);
+
+	if ( nFailed==0 )
+	{ std::cout<<"All tests passed.\n"; }
+	else
+	{ std::cout<<nFailed<<" tests failed.\n"; }
+	return nFailed;
+}
@@ -37,8 +37,15 @@ class Texture: public CanLoadSave, public HasTexture
 	// And glew.h is a pretty big header.
 #ifdef WILDCAT_USE_OPENGL
 	GLuint textureID;
+#else
+	// Not used without OpenGL, but the Renderer still groups batches by it.
+	unsigned int textureID;
 #endif
 
+	// Texture coordinates of this image within textureID. These only change if the texture is packed into a
+	// TextureAtlas.
+	float u1, v1, u2, v2;
+
 		// LINUX G++ GIVES WARNING IF I TRY TO DELETE A POLYMORPHIC OBJECT WITHOUT A VIRTUAL DESTRUCTOR.
 	virtual ~Texture()
 	{
@@ -51,6 +58,8 @@ class Texture: public CanLoadSave, public HasTexture
 
 		/* NOTE: Earlier notes suggest that GLuint texture references need to be initialised. */
 		textureID=0;
+		u1=0; v1=0;
+		u2=1; v2=1;
 		
 		averageRed=0;
 		averageGreen=0;
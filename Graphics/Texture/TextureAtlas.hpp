@@ -0,0 +1,633 @@
+#pragma once
+#ifndef WILDCAT_GRAPHICS_TEXTURE_TEXTUREATLAS_HPP
+#define WILDCAT_GRAPHICS_TEXTURE_TEXTUREATLAS_HPP
+
+/* Wildcat: TextureAtlas
+	#include <Graphics/Texture/TextureAtlas.hpp>
+
+	Packs many small RGBA Textures into a few large pages, so that things like tiles and font glyphs can be drawn
+	from one bound texture. Combined with Renderer batching this means a whole tile map can be drawn with a few
+	draw calls instead of one per tile.
+
+		TextureAtlas atlas;
+		atlas.add("grass",&TEX_GRASS);
+		atlas.add("water",&TEX_WATER);
+		font.addToAtlas(atlas);
+		atlas.pack();
+		atlas.bind();
+
+	After bind(), every added Texture points at its page and has its texture coordinates set to its part of the
+	page, so Renderer::placeTexture4() and friends draw from the atlas without any other changes. The Textures
+	keep their own pixel data.
+
+	PACKING
+	Textures are sorted by height and placed using the skyline bottom-left method. A new page is started when a
+	texture doesn't fit on any of the existing pages. Pages are square powers of 2, except the height of each page
+	is cut down to the smallest power of 2 that holds everything on it.
+
+	PADDING
+	Each texture gets a border of padding pixels, filled by copying its edge pixels outwards. This stops
+	neighbouring textures bleeding in with linear filtering or mipmaps. Mipmaps only bleed once a level is smaller
+	than the padding, so bind() only makes mipmap levels which are covered. For example padding 4 gives
+	mipmap levels 0 to 2.
+
+	SAVING
+	save() writes each page as a PNG and an index of where everything is. load() reads them back, so startup
+	doesn't need to repack. Textures can then be linked to their regions by name with attach():
+
+		if ( atlas.load("atlas") == false )
+		{
+			atlas.add("grass",&TEX_GRASS);
+			atlas.pack();
+			atlas.save("atlas");
+		}
+		atlas.attach("grass",&TEX_GRASS);
+		atlas.bind();
+
+	The index stores the size of each texture, and attach() will refuse a texture which doesn't match.
+
+	UNBINDING
+	When a texture is linked to the atlas its own textureID and texture coordinates are kept in its region.
+	unbind() puts them back and deletes the page textures, so the texture can be drawn on its own again. Packing,
+	loading and destroying the atlas all unbind first, so the textures must outlive the atlas.
+*/
+
+#include <Graphics/Texture/Texture.hpp>
+#include <Graphics/Png/Png.hpp>
+#include <File/FileManager.hpp>
+#include <File/FileManagerStatic.hpp>
+#include <Container/Vector/Vector.hpp>
+
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+	// Where a texture is in the atlas. Coordinates are in pixels from the top left of the page, not including
+	// the padding.
+class TextureAtlasRegion
+{
+	public:
+	std::string name;
+	Texture* texture; // The texture this region came from. 0 if loaded from file and not attached.
+
+	int page; // -1 if it couldn't be packed.
+	int x, y;
+	int nX, nY;
+
+	float u1, v1, u2, v2; // Texture coordinates on the page.
+
+		// What the texture pointed at before it was linked to the page, so unbind() can put it back.
+	bool linked;
+	unsigned int oldTextureID;
+	float oldU1, oldV1, oldU2, oldV2;
+
+	TextureAtlasRegion()
+	{
+		texture=0;
+		page=-1;
+		x=0; y=0;
+		nX=0; nY=0;
+		u1=0; v1=0; u2=0; v2=0;
+		linked=false;
+		oldTextureID=0;
+		oldU1=0; oldV1=0; oldU2=0; oldV2=0;
+	}
+};
+
+class TextureAtlas
+{
+	private:
+
+		// One horizontal segment of the skyline.
+	class SkylineNode
+	{
+		public:
+		int x, y, width;
+	};
+
+	std::vector < std::vector <SkylineNode> > vSkyline; // One skyline per page.
+	Vector <int> vPageHeight; // Highest point used on each page.
+
+		// Find the lowest position the rectangle fits on this page. Returns the index of the first skyline node it
+		// sits on, or -1 if it doesn't fit.
+	int findPosition (const int page, const int _nX, const int _nY, int* bestX, int* bestY)
+	{
+		const std::vector <SkylineNode>& skyline = vSkyline[page];
+
+		int bestIndex = -1;
+		int bestTop = pageSize+1;
+		int bestWidth = pageSize+1;
+
+		for (unsigned int i=0;i<skyline.size();++i)
+		{
+			const int _x = skyline[i].x;
+			if ( _x+_nX > pageSize ) { break; }
+
+				// The rectangle rests on the highest node it spans.
+			int _y = 0;
+			int widthLeft = _nX;
+			for (unsigned int j=i;widthLeft>0;++j)
+			{
+				if ( skyline[j].y > _y ) { _y=skyline[j].y; }
+				widthLeft-=skyline[j].width;
+			}
+			if ( _y+_nY > pageSize ) { continue; }
+
+				// Prefer the lowest top, then the narrowest node to keep the skyline flat.
+			if ( _y+_nY < bestTop || (_y+_nY == bestTop && skyline[i].width < bestWidth) )
+			{
+				bestIndex=i;
+				bestTop=_y+_nY;
+				bestWidth=skyline[i].width;
+				*bestX=_x;
+				*bestY=_y;
+			}
+		}
+		return bestIndex;
+	}
+
+		// Raise the skyline over the rectangle.
+	void addToSkyline (const int page, const int index, const int _x, const int _y, const int _nX, const int _nY)
+	{
+		std::vector <SkylineNode>& skyline = vSkyline[page];
+
+		SkylineNode node;
+		node.x=_x;
+		node.y=_y+_nY;
+		node.width=_nX;
+		skyline.insert(skyline.begin()+index,node);
+
+			// Cut back or remove the nodes underneath.
+		for (unsigned int i=index+1;i<skyline.size();)
+		{
+			const int overlap = node.x+node.width - skyline[i].x;
+			if ( overlap <= 0 ) { break; }
+
+			if ( overlap >= skyline[i].width )
+			{ skyline.erase(skyline.begin()+i); }
+			else
+			{
+				skyline[i].x+=overlap;
+				skyline[i].width-=overlap;
+				break;
+			}
+		}
+
+			// Merge nodes at the same height.
+		for (unsigned int i=0;i+1<skyline.size();)
+		{
+			if ( skyline[i].y == skyline[i+1].y )
+			{
+				skyline[i].width+=skyline[i+1].width;
+				skyline.erase(skyline.begin()+i+1);
+			}
+			else { ++i; }
+		}
+
+		if ( node.y > vPageHeight(page) ) { vPageHeight(page)=node.y; }
+	}
+
+	void addPage()
+	{
+		SkylineNode node;
+		node.x=0;
+		node.y=0;
+		node.width=pageSize;
+		vSkyline.push_back(std::vector <SkylineNode> (1,node));
+		vPageHeight.push(0);
+	}
+
+		// Copy the texture onto the page, and extend its edge pixels into the padding.
+	void blit (const TextureAtlasRegion& region)
+	{
+		Texture* page = vPage(region.page);
+		const Texture* source = region.texture;
+
+		for (int _y=-padding;_y<region.nY+padding;++_y)
+		{
+			const int sourceY = std::min(std::max(_y,0),region.nY-1);
+			unsigned char* pageRow = &page->data[((region.y+_y)*page->nX + region.x-padding)*4];
+
+			for (int _x=-padding;_x<region.nX+padding;++_x)
+			{
+				const int sourceX = std::min(std::max(_x,0),region.nX-1);
+				const unsigned char* pixel = &source->data[(sourceY*source->nX+sourceX)*4];
+				*pageRow++ = pixel[0];
+				*pageRow++ = pixel[1];
+				*pageRow++ = pixel[2];
+				*pageRow++ = pixel[3];
+			}
+		}
+	}
+
+	void setUV (TextureAtlasRegion& region)
+	{
+		const Texture* page = vPage(region.page);
+		region.u1 = (float)region.x/page->nX;
+		region.v1 = (float)region.y/page->nY;
+		region.u2 = (float)(region.x+region.nX)/page->nX;
+		region.v2 = (float)(region.y+region.nY)/page->nY;
+	}
+
+		// Point a texture at its region. The first time, its own texture is remembered.
+	void link (TextureAtlasRegion& region)
+	{
+		if ( region.texture==0 || region.page==-1 ) { return; }
+
+		if ( region.linked==false )
+		{
+			region.oldTextureID=region.texture->textureID;
+			region.oldU1=region.texture->u1;
+			region.oldV1=region.texture->v1;
+			region.oldU2=region.texture->u2;
+			region.oldV2=region.texture->v2;
+			region.linked=true;
+		}
+		region.texture->textureID = vPage(region.page)->textureID;
+		region.texture->u1=region.u1;
+		region.texture->v1=region.v1;
+		region.texture->u2=region.u2;
+		region.texture->v2=region.v2;
+	}
+
+		// Point a texture back at its own texture.
+	void unlink (TextureAtlasRegion& region)
+	{
+		if ( region.linked==false || region.texture==0 ) { return; }
+
+		region.texture->textureID=region.oldTextureID;
+		region.texture->u1=region.oldU1;
+		region.texture->v1=region.oldV1;
+		region.texture->u2=region.oldU2;
+		region.texture->v2=region.oldV2;
+		region.linked=false;
+	}
+
+	void clearPages()
+	{
+		unbind();
+		for (int i=0;i<vPage.size();++i)
+		{
+			delete [] vPage(i)->data;
+			delete vPage(i);
+		}
+		vPage.clear();
+		vSkyline.clear();
+		vPageHeight.clear();
+	}
+
+	public:
+
+	int pageSize; // Maximum width and height of a page. Must be a power of 2.
+	int padding; // Pixels of padding around each texture.
+
+	Vector <Texture*> vPage;
+	Vector <TextureAtlasRegion> vRegion;
+
+	bool isBound;
+
+	TextureAtlas(const int _pageSize=2048, const int _padding=2)
+	{
+		pageSize=_pageSize;
+		padding=_padding;
+		isBound=false;
+	}
+	~TextureAtlas()
+	{
+		clearPages();
+	}
+
+		// Queue a texture to be packed. Returns its region index.
+	int add (const std::string _name, Texture* _texture)
+	{
+		if ( _texture==0 || _texture->data==0 || _texture->nX<=0 || _texture->nY<=0 )
+		{
+			std::cout<<"WARNING: TextureAtlas can't add texture "<<_name<<" because it has no data.\n";
+			return -1;
+		}
+		if ( getRegionIndex(_name) != -1 )
+		{
+			std::cout<<"WARNING: TextureAtlas already has a texture called "<<_name<<".\n";
+			return -1;
+		}
+
+		TextureAtlasRegion region;
+		region.name=_name;
+		region.texture=_texture;
+		region.nX=_texture->nX;
+		region.nY=_texture->nY;
+		vRegion.push(region);
+		return vRegion.size()-1;
+	}
+
+		// Pack every texture onto pages. Returns false if any texture didn't fit, but everything else will still
+		// be packed.
+	bool pack()
+	{
+		if ( pageSize<=0 || (pageSize & (pageSize-1)) != 0 )
+		{
+			std::cout<<"WARNING: TextureAtlas page size must be a power of 2.\n";
+			return false;
+		}
+		if ( padding < 0 ) { padding=0; }
+
+		clearPages();
+		isBound=false;
+
+			// Tallest first, then widest. Ties keep the order they were added, so packing is repeatable.
+		std::vector <int> vOrder (vRegion.size());
+		for (unsigned int i=0;i<vOrder.size();++i) { vOrder[i]=i; }
+		std::stable_sort(vOrder.begin(),vOrder.end(),[this](const int a, const int b)
+		{
+			const TextureAtlasRegion& ra = vRegion.data[a];
+			const TextureAtlasRegion& rb = vRegion.data[b];
+			if ( ra.nY != rb.nY ) { return ra.nY > rb.nY; }
+			return ra.nX > rb.nX;
+		});
+
+		bool allPacked = true;
+		for (unsigned int i=0;i<vOrder.size();++i)
+		{
+			TextureAtlasRegion& region = vRegion(vOrder[i]);
+			region.page=-1;
+
+			const int paddedX = region.nX+padding*2;
+			const int paddedY = region.nY+padding*2;
+			if ( paddedX > pageSize || paddedY > pageSize )
+			{
+				std::cout<<"WARNING: TextureAtlas texture "<<region.name<<" is too big for a page.\n";
+				allPacked=false;
+				continue;
+			}
+
+			for (int page=0;region.page==-1;++page)
+			{
+				if ( page == (int)vSkyline.size() ) { addPage(); }
+
+				int _x=0, _y=0;
+				const int index = findPosition(page,paddedX,paddedY,&_x,&_y);
+				if ( index != -1 )
+				{
+					addToSkyline(page,index,_x,_y,paddedX,paddedY);
+					region.page=page;
+					region.x=_x+padding;
+					region.y=_y+padding;
+				}
+			}
+		}
+
+			// Make the pages, cutting each one down to the height it needs.
+		for (unsigned int page=0;page<vSkyline.size();++page)
+		{
+			int pageHeight = 1;
+			while ( pageHeight < vPageHeight(page) ) { pageHeight*=2; }
+
+			Texture* texture = new Texture;
+			texture->create(pageSize,pageHeight,1,true);
+			vPage.push(texture);
+		}
+		for (int i=0;i<vRegion.size();++i)
+		{
+			if ( vRegion(i).page != -1 )
+			{
+				blit(vRegion(i));
+				setUV(vRegion(i));
+			}
+		}
+		return allPacked;
+	}
+
+		// Upload the pages and point every texture at its page. Mipmaps are only made for the levels the padding
+		// covers.
+	void bind (const bool linear=false, const bool mipmap=false)
+	{
+	#ifdef WILDCAT_USE_OPENGL
+		int maxLevel = 0;
+		if ( mipmap )
+		{
+			while ( (2<<maxLevel) <= padding ) { ++maxLevel; }
+		}
+
+		for (int i=0;i<vPage.size();++i)
+		{
+			Texture* page = vPage(i);
+			if ( page->textureID==0 ) { glGenTextures(1,&page->textureID); }
+			glBindTexture(GL_TEXTURE_2D, page->textureID);
+
+			if ( mipmap && maxLevel > 0 )
+			{
+				glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER, linear ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST);
+				glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAX_LEVEL,maxLevel);
+			}
+			else
+			{
+				glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER, linear ? GL_LINEAR : GL_NEAREST);
+				glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAX_LEVEL,0);
+			}
+			glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER, linear ? GL_LINEAR : GL_NEAREST);
+
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, page->nX, page->nY, 0, GL_RGBA, GL_UNSIGNED_BYTE, page->data);
+
+			if ( mipmap )
+			{
+				Texture* level = page->createMipMap();
+				for (int l=1;l<=maxLevel && level!=0;++l)
+				{
+					glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, level->nX, level->nY, 0, GL_RGBA, GL_UNSIGNED_BYTE, level->data);
+					Texture* next = level->createMipMap();
+					delete [] level->data;
+					delete level;
+					level=next;
+				}
+				if ( level!=0 )
+				{
+					delete [] level->data;
+					delete level;
+				}
+			}
+		}
+	#else
+		(void)linear;
+		(void)mipmap;
+	#endif
+
+		for (int i=0;i<vRegion.size();++i)
+		{ link(vRegion(i)); }
+		isBound=true;
+	}
+
+		// Point every texture back at its own texture, and delete the page textures. The pages keep their pixels,
+		// so bind() can be called again.
+	void unbind()
+	{
+		for (int i=0;i<vRegion.size();++i)
+		{ unlink(vRegion(i)); }
+
+		for (int i=0;i<vPage.size();++i)
+		{
+		#ifdef WILDCAT_USE_OPENGL
+			if ( vPage(i)->textureID!=0 ) { glDeleteTextures(1,&vPage(i)->textureID); }
+		#endif
+			vPage(i)->textureID=0;
+		}
+		isBound=false;
+	}
+
+		// Link a texture to a region loaded from file. The texture must be the same size as the region.
+	bool attach (const std::string _name, Texture* _texture)
+	{
+		const int i = getRegionIndex(_name);
+		if ( i==-1 )
+		{
+			std::cout<<"WARNING: TextureAtlas has no texture called "<<_name<<".\n";
+			return false;
+		}
+		if ( _texture==0 ) { return false; }
+
+		TextureAtlasRegion& region = vRegion(i);
+		if ( _texture->data!=0 && (_texture->nX!=region.nX || _texture->nY!=region.nY) )
+		{
+			std::cout<<"WARNING: TextureAtlas texture "<<_name<<" has changed size. The atlas needs to be repacked.\n";
+			return false;
+		}
+		if ( region.texture!=_texture ) { unlink(region); }
+		if ( _texture->data==0 )
+		{
+			_texture->nX=region.nX;
+			_texture->nY=region.nY;
+		}
+		region.texture=_texture;
+		if ( isBound ) { link(region); }
+		return true;
+	}
+
+	int getRegionIndex (const std::string _name) const
+	{
+		for (unsigned int i=0;i<vRegion.data.size();++i)
+		{
+			if ( vRegion.data[i].name == _name )
+			{ return i; }
+		}
+		return -1;
+	}
+	TextureAtlasRegion* getRegion (const std::string _name)
+	{
+		const int i = getRegionIndex(_name);
+		if ( i==-1 ) { return 0; }
+		return &vRegion(i);
+	}
+
+	inline int nPages() const
+	{ return vPage.data.size(); }
+
+		// Save the pages as basePath_0.png, basePath_1.png, etc, and the index as basePath.txt.
+	bool save (const std::string basePath)
+	{
+		std::ostringstream index;
+		index<<"ATLAS "<<nPages()<<" "<<pageSize<<" "<<padding<<"\n";
+
+		for (int i=0;i<nPages();++i)
+		{
+			const std::string pagePath = basePath+"_"+DataTools::toString(i)+".png";
+			if ( LodePNG_encode_file(pagePath.c_str(),vPage(i)->data,vPage(i)->nX,vPage(i)->nY,6,8) != 0 )
+			{
+				std::cout<<"WARNING: TextureAtlas couldn't save "<<pagePath<<".\n";
+				return false;
+			}
+			index<<"PAGE "<<i<<" "<<vPage(i)->nX<<" "<<vPage(i)->nY<<"\n";
+		}
+		for (int i=0;i<vRegion.size();++i)
+		{
+			const TextureAtlasRegion& region = vRegion(i);
+			index<<"REGION "<<region.page<<" "<<region.x<<" "<<region.y<<" "<<region.nX<<" "<<region.nY<<" "<<region.name<<"\n";
+		}
+
+		return FileManagerStatic::writeFreshString(index.str(),basePath+".txt");
+	}
+
+		// Load pages and regions saved by save(). Textures need to be attached before they can use the atlas.
+	bool load (const std::string basePath)
+	{
+		if ( FileManagerStatic::fileExists(basePath+".txt") == false )
+		{ return false; }
+
+		clearPages();
+		vRegion.clear();
+		isBound=false;
+
+		std::istringstream index (FileManagerStatic::getData(basePath+".txt"));
+		std::string tag;
+		int _nPages=0;
+
+		index>>tag>>_nPages>>pageSize>>padding;
+		if ( tag!="ATLAS" || _nPages < 0 )
+		{
+			std::cout<<"WARNING: TextureAtlas index "<<basePath<<".txt is corrupt.\n";
+			return false;
+		}
+
+		while ( index>>tag )
+		{
+			if ( tag=="PAGE" )
+			{
+				int i=0, _nX=0, _nY=0;
+				index>>i>>_nX>>_nY;
+
+				int fileSize = 0;
+				unsigned char* fileData = FileManager::getFile(basePath+"_"+DataTools::toString(i)+".png",&fileSize);
+				Png png;
+				if ( fileData==0 || png.load(fileData,fileSize)==false || png.nX!=_nX || png.nY!=_nY )
+				{
+					std::cout<<"WARNING: TextureAtlas page "<<i<<" of "<<basePath<<" didn't load.\n";
+					delete [] fileData;
+					clearPages();
+					vRegion.clear();
+					return false;
+				}
+				delete [] fileData;
+
+				Texture* page = new Texture;
+				page->create(_nX,_nY,1);
+				std::copy(png.data,png.data+_nX*_nY*4,page->data);
+				vPage.push(page);
+			}
+			else if ( tag=="REGION" )
+			{
+				TextureAtlasRegion region;
+				index>>region.page>>region.x>>region.y>>region.nX>>region.nY;
+				index.get(); // Skip the space before the name.
+				std::getline(index,region.name);
+
+				if ( region.page >= nPages() )
+				{
+					std::cout<<"WARNING: TextureAtlas region "<<region.name<<" is on a page that doesn't exist.\n";
+					region.page=-1;
+				}
+				if ( region.page != -1 ) { setUV(region); }
+				vRegion.push(region);
+			}
+		}
+		return nPages()==_nPages;
+	}
+
+		// Fraction of the page area actually used by textures, not including padding.
+	double getEfficiency() const
+	{
+		double pageArea = 0;
+		for (int i=0;i<nPages();++i)
+		{ pageArea += (double)vPage.data[i]->nX*vPage.data[i]->nY; }
+		if ( pageArea==0 ) { return 0; }
+
+		double usedArea = 0;
+		for (unsigned int i=0;i<vRegion.data.size();++i)
+		{
+			if ( vRegion.data[i].page != -1 )
+			{ usedArea += (double)vRegion.data[i].nX*vRegion.data[i].nY; }
+		}
+		return usedArea/pageArea;
+	}
+};
+
+#endif
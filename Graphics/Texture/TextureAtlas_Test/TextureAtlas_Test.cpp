@@ -0,0 +1,153 @@
+#include <climits> /* Colour.hpp needs UINT_MAX. */
+#include <Graphics/Texture/TextureAtlas.hpp>
+#include <Graphics/Render/Renderer.cpp>
+#include <Math/Random/RandomLehmer.hpp>
+
+#include <iostream>
+
+// g++ TextureAtlas_Test.cpp -I %WILDCAT%/
+
+// Headless test of TextureAtlas. Packs a set of random textures, checks every pixel and gutter, saves and
+// reloads the atlas, and counts how many batches the Renderer needs with and without it.
+
+const int N_TEXTURES = 500;
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+	// Every pixel of the region (and its padding) matches the clamped source pixel.
+bool regionMatches(TextureAtlas& atlas, TextureAtlasRegion& region, Texture* source)
+{
+	if ( region.page == -1 ) { return false; }
+	Texture* page = atlas.vPage(region.page);
+
+	for (int _y=-atlas.padding;_y<region.nY+atlas.padding;++_y)
+	{
+		for (int _x=-atlas.padding;_x<region.nX+atlas.padding;++_x)
+		{
+			const int sourceX = std::min(std::max(_x,0),region.nX-1);
+			const int sourceY = std::min(std::max(_y,0),region.nY-1);
+			for (int channel=0;channel<4;++channel)
+			{
+				if ( page->getPixel(region.x+_x,region.y+_y,channel) != source->getPixel(sourceX,sourceY,channel) )
+				{ return false; }
+			}
+		}
+	}
+	return true;
+}
+
+int main (int nArgs, char ** arg)
+{
+	RandomLehmer rng;
+	rng.seed(1234);
+
+	Texture aTexture [N_TEXTURES];
+	for (int i=0;i<N_TEXTURES;++i)
+	{
+		aTexture[i].create(4+rng.rand32()%61,4+rng.rand32()%61,1);
+		aTexture[i].textureID=i+1;
+		for (int j=0;j<aTexture[i].nX*aTexture[i].nY*4;++j)
+		{ aTexture[i].data[j]=rng.rand32()%256; }
+	}
+
+	TextureAtlas atlas (512,2);
+	for (int i=0;i<N_TEXTURES;++i)
+	{ atlas.add("texture "+DataTools::toString(i),&aTexture[i]); }
+
+	check("Pack",atlas.pack());
+	std::cout<<"  "<<atlas.nPages()<<" pages, "<<(int)(atlas.getEfficiency()*100)<<"% used.\n";
+
+	// Padded regions on the same page must not overlap.
+	bool noOverlap = true;
+	bool inside = true;
+	const int pad = atlas.padding;
+	for (int i=0;i<N_TEXTURES;++i)
+	{
+		TextureAtlasRegion& a = atlas.vRegion(i);
+		Texture* page = atlas.vPage(a.page);
+		if ( a.x-pad < 0 || a.y-pad < 0 || a.x+a.nX+pad > page->nX || a.y+a.nY+pad > page->nY )
+		{ inside=false; }
+
+		for (int j=i+1;j<N_TEXTURES;++j)
+		{
+			TextureAtlasRegion& b = atlas.vRegion(j);
+			if ( a.page==b.page && a.x-pad < b.x+b.nX+pad && b.x-pad < a.x+a.nX+pad && a.y-pad < b.y+b.nY+pad && b.y-pad < a.y+a.nY+pad )
+			{ noOverlap=false; }
+		}
+	}
+	check("Regions are inside their pages",inside);
+	check("Regions don't overlap",noOverlap);
+
+	bool allMatch = true;
+	for (int i=0;i<N_TEXTURES;++i)
+	{
+		if ( regionMatches(atlas,atlas.vRegion(i),&aTexture[i])==false ) { allMatch=false; }
+	}
+	check("Pixels and padding match",allMatch);
+
+	// Without the atlas every texture needs its own batch.
+	Renderer::resetBatchStats();
+	Renderer::beginBatch(true);
+	for (int i=0;i<N_TEXTURES;++i)
+	{ Renderer::placeTexture4(0,0,16,16,&aTexture[i]); }
+	Renderer::endBatch();
+	std::cout<<"  Without atlas: "<<Renderer::getBatchesSubmitted()<<" batches.\n";
+	check("Batches without atlas",Renderer::getBatchesSubmitted()==N_TEXTURES);
+
+	// Headless pages don't get an OpenGL texture, so give them IDs by hand.
+	for (int i=0;i<atlas.nPages();++i) { atlas.vPage(i)->textureID=1000+i; }
+	atlas.bind();
+
+	Renderer::resetBatchStats();
+	Renderer::beginBatch(true);
+	for (int i=0;i<N_TEXTURES;++i)
+	{ Renderer::placeTexture4(0,0,16,16,&aTexture[i]); }
+	Renderer::endBatch();
+	std::cout<<"  With atlas: "<<Renderer::getBatchesSubmitted()<<" batches.\n";
+	check("Batches with atlas",(int)Renderer::getBatchesSubmitted()==atlas.nPages());
+
+	TextureAtlasRegion* region = atlas.getRegion("texture 7");
+	check("Texture coordinates",aTexture[7].u1==region->u1 && aTexture[7].v2==region->v2 && aTexture[7].textureID==1000u+region->page);
+
+	// Unbinding gives each texture back its own ID, and binding again relinks it.
+	atlas.unbind();
+	check("Unbind restores textures",aTexture[7].textureID==8 && aTexture[7].u1==0 && aTexture[7].v2==1 && atlas.vPage(0)->textureID==0);
+	for (int i=0;i<atlas.nPages();++i) { atlas.vPage(i)->textureID=1000+i; }
+	atlas.bind();
+	atlas.unbind();
+	check("Binding twice keeps the original ID",aTexture[7].textureID==8);
+	for (int i=0;i<atlas.nPages();++i) { atlas.vPage(i)->textureID=1000+i; }
+	atlas.bind();
+
+	// Save and reload.
+	check("Save",atlas.save("TextureAtlas_Test"));
+
+	TextureAtlas atlas2;
+	check("Load",atlas2.load("TextureAtlas_Test"));
+	check("Same page count",atlas2.nPages()==atlas.nPages());
+
+	bool reloadMatches = atlas2.vRegion.size()==N_TEXTURES;
+	for (int i=0;i<N_TEXTURES && reloadMatches;++i)
+	{
+		TextureAtlasRegion* loaded = atlas2.getRegion("texture "+DataTools::toString(i));
+		if ( loaded==0 || regionMatches(atlas2,*loaded,&aTexture[i])==false ) { reloadMatches=false; }
+	}
+	check("Reloaded pixels match",reloadMatches);
+
+	Texture wrongSize;
+	wrongSize.create(3,3,1);
+	check("Attach rejects changed textures",atlas2.attach("texture 0",&wrongSize)==false);
+	check("Attach",atlas2.attach("texture 0",&aTexture[0]));
+
+	if ( nFailed==0 )
+	{ std::cout<<"All tests passed.\n"; }
+	else
+	{ std::cout<<nFailed<<" tests failed.\n"; }
+	return nFailed;
+}
@@ -5,6 +5,12 @@
 #include <Math/Random/RandomLehmer.hpp>
 #include <Container/ArrayS2/ArrayS2.hpp>
 
+#include <vector>
+
+#ifdef WILDCAT_THREADING
+#include <thread>
+#endif
+
 /* Wildcat: DiamondSquareAlgorithm.hpp
 	#include <Math/Fractal/DiamondSquareAlgorithm.hpp>
 
@@ -21,7 +27,7 @@
 
 	Using doubles for the array might reduce artifacts.
 
-	In the future I would like multithreading.
+	Multithreading is now supported (see below).
 
 	Algorithm will now respect non-zero entries by leaving them alone.
 
@@ -41,18 +47,253 @@
    I changed the RNG from Mersenne Twister to Lehmer. This should significantly improve performance.
    
    Todo: Add repeatable seeding and null seeding.
+
+   MULTITHREADING
+   Each square pass and each diamond pass only reads tiles which were set by the previous pass, so the rows of a
+   pass can be done in any order. Set nThreads to split each pass into bands of rows, with a thread per band.
+   0 means 1 thread per core. Threads are only used if WILDCAT_THREADING is defined, otherwise it runs in serial.
+
+   To make the output the same no matter how many threads are used, random numbers no longer come from a single
+   RandomLehmer stream. Instead each tile gets its own RandomLehmer, seeded from a hash of (seed, x, y, pass).
+   This means the same seed now makes a different map than it did with the old sequential stream, but it makes
+   exactly the same map in serial and parallel.
+
+   The diamond pass now only visits diamond tiles. It used to also redo any corner or center which had come out
+   as 0, using whichever diamond tiles had been done so far, which depends on the order tiles are done in.
+
+   The only tiles written outside their own row are the wrapY copies from row 0 to the last row in diamond mode,
+   so the last row of each diamond pass is done after the rest of the pass, like it would be in serial.
+
+   The value table is built at the end from per-band tables which are then added together.
 */
 
 class DiamondSquareAlgorithm
 {
 	private:
-   RandomLehmer rng;
 
-	static void addToValueTable(int* valueTable, int value)
+		// Don't split a pass into bands smaller than this, because starting a thread costs more than doing the rows.
+	static const int MIN_ROWS_PER_BAND = 16;
+
+		// 32 bit integer hash. Used to give each tile its own random stream.
+	static inline uint32_t hash32(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352d;
+		x ^= x >> 15;
+		x *= 0x846ca68b;
+		x ^= x >> 16;
+		return x;
+	}
+
+		// Each tile gets its own rng for each pass, so the output doesn't depend on the order tiles are done in.
+	inline RandomLehmer tileRng(const int _x, const int _y, const int pass) const
+	{
+		return RandomLehmer( hash32( (uint32_t)seed ^ hash32( (uint32_t)_x + hash32( (uint32_t)_y + hash32((uint32_t)pass) ) ) ) );
+	}
+
+		// Number of bands to split nRows rows into.
+	int countBands(const int nRows) const
+	{
+		int nBands = 1;
+#ifdef WILDCAT_THREADING
+		nBands = nThreads;
+		if ( nBands <= 0 ) { nBands = std::thread::hardware_concurrency(); }
+		if ( nBands > nRows/MIN_ROWS_PER_BAND ) { nBands = nRows/MIN_ROWS_PER_BAND; }
+#endif
+		if ( nBands < 1 ) { nBands = 1; }
+		return nBands;
+	}
+
+		// Run fn(band,yStart,yEnd) over rows yBegin to yEnd-1 in steps of yStep. The rows are split into
+		// countBands() bands, with a thread per band if threading is enabled.
+	template <class Function>
+	void forEachRowBand(const int yBegin, const int yEnd, const int yStep, Function fn) const
 	{
-		if ( valueTable!=0 )
+		if ( yEnd <= yBegin ) { return; }
+		const int nRows = (yEnd-yBegin+yStep-1)/yStep;
+		const int nBands = countBands(nRows);
+
+		auto bandRow = [&](const int b)
+		{
+			if ( b==nBands ) { return yEnd; }
+			return yBegin + (int)(((long long int)nRows*b)/nBands)*yStep;
+		};
+
+#ifdef WILDCAT_THREADING
+		std::vector <std::thread> vThread;
+		for (int b=1;b<nBands;++b)
+		{ vThread.emplace_back(fn,b,bandRow(b),bandRow(b+1)); }
+		fn(0,bandRow(0),bandRow(1));
+		for (auto& t: vThread) { t.join(); }
+#else
+		for (int b=0;b<nBands;++b)
+		{ fn(b,bandRow(b),bandRow(b+1)); }
+#endif
+	}
+
+		// Set the center of every square with its top left corner in rows yStart to yEnd-1.
+	void squareRows(ArrayS2 <unsigned char>* aMap, const int yStart, const int yEnd, const unsigned int squareSize,
+		const unsigned short int freeSteps, const float variance, const bool cratering, const int pass) const
+	{
+		const int freeStepValue = -1; // -1 == random.
+
+			// Skip the last tile because there's no need to do them.
+		for (int _y=yStart;_y<yEnd;_y+=squareSize)
 		{
-			valueTable[value]++;
+			for (int _x=0;_x<aMap->nX-1;_x+=squareSize)
+			{
+				int targetX = _x + (squareSize/2);
+				int targetY = _y + (squareSize/2);
+
+				if ( (*aMap)(targetX,targetY) != 0 ) // DON'T OVERWRITE NON-ZERO ENTRIES.
+				{ continue; }
+
+				RandomLehmer rng = tileRng(targetX,targetY,pass);
+
+				if ( freeSteps > 0 )
+				{
+					if ( freeStepValue == -1 )
+					{
+						(*aMap)(targetX,targetY)=rng.rand8();
+					}
+					else
+					{
+						(*aMap)(targetX,targetY)=freeStepValue;
+					}
+				}
+				else if ( squareSize > 6 && cratering==true && rng.rand32(100)==0 )
+				{
+					(*aMap)(targetX,targetY)=rng.rand8();
+				}
+				else
+				{
+					int nCorners = 0;
+					int totalCorners = 0;
+
+						// ADD UP CORNERS TO GET AVERAGE.
+					if ( aMap->isSafe(_x,_y) == true )
+					{
+						++nCorners;
+						totalCorners+=(*aMap)(_x,_y);
+					}
+					if ( aMap->isSafe(_x+squareSize,_y) == true )
+					{
+						++nCorners;
+						totalCorners+=(*aMap)(_x+squareSize,_y);
+					}
+					if ( aMap->isSafe(_x,_y+squareSize) == true )
+					{
+						++nCorners;
+						totalCorners+=(*aMap)(_x,_y+squareSize);
+					}
+					if ( aMap->isSafe(_x+squareSize,_y+squareSize) == true )
+					{
+						++nCorners;
+						totalCorners+=(*aMap)(_x+squareSize,_y+squareSize);
+					}
+
+						// NCORNERS SHOULD ALWAYS EQUAL. SO THE BOUNDS TESTING WOULD NOT NORMALLY BE REQUIRED.
+					const int average = totalCorners/4;
+
+					int result = average;
+					if ( variance > 0 )
+					{
+								// Ensure that random range stays in bounds to prevent biases from rounding. This pokes lots of holes in landmasses though, so I've disabled it.
+						int lowerRange = -variance;
+						int higherRange = variance;
+						result = average+rng.range32(lowerRange,higherRange);
+					}
+
+						// Just to be sure.
+					if (result<0) { result=0; }
+					if (result>255) { result=255; }
+
+					(*aMap)(targetX,targetY)=result;
+				}
+			}
+		}
+	}
+
+		// Set the diamond tiles in rows yStart to yEnd-1. squareSize has already been halved.
+	void diamondRows(ArrayS2 <unsigned char>* aMap, const int yStart, const int yEnd, const unsigned int squareSize,
+		const unsigned short int freeSteps, const float variance, const int pass) const
+	{
+		const int freeStepValue = -1; // -1 == random.
+
+			// NEED TO RECHECK THIS. EARLIER NOTES INDICATE POSSIBLE PROBLEM.
+		for (int _y=yStart;_y<yEnd;_y+=squareSize)
+		{
+				// Diamond tiles alternate with the corners and centers from previous passes, which are left alone
+				// even if they are 0. Otherwise a 0 tile would be averaged from diamond tiles of this pass.
+			const int xStart = ((_y/squareSize)%2==0) ? squareSize : 0;
+			for (int _x=xStart;_x<aMap->nX;_x+=squareSize*2)
+			{
+				if ( (*aMap)(_x,_y) != 0 ) // DON'T OVERWRITE NON-ZERO ENTRIES.
+				{ continue; }
+
+				RandomLehmer rng = tileRng(_x,_y,pass);
+
+				if ( freeSteps > 0 )
+				{
+					if ( freeStepValue == -1 )
+					{
+						(*aMap)(_x,_y)=rng.rand8();
+					}
+					else
+					{
+						(*aMap)(_x,_y)=freeStepValue;
+					}
+				}
+				else
+				{
+					double total=0;
+					int nSides=0; // NOTE THAT IN THIS CASE NSIDES MAY NOT BE 4.
+
+					if ( aMap->isSafe(_x-squareSize,_y) == true )
+					{
+						++nSides;
+						total+= (*aMap)(_x-squareSize,_y);
+					}
+					if ( aMap->isSafe(_x,_y+squareSize) == true )
+					{
+						++nSides;
+						total+= (*aMap)(_x,_y+squareSize);
+					}
+					if ( aMap->isSafe(_x+squareSize,_y) == true )
+					{
+						++nSides;
+						total+= (*aMap)(_x+squareSize,_y);
+					}
+					if ( aMap->isSafe(_x,_y-squareSize) == true )
+					{
+						++nSides;
+						total+= (*aMap)(_x,_y-squareSize);
+					}
+
+					int average = 0;
+					if (nSides!=0)
+					{
+						average = total/nSides;
+					}
+
+					int result = average+rng.range32(-variance,variance);
+
+					if (result<0) { result=0; }
+					if (result>255) { result=255; }
+
+					(*aMap)(_x,_y)=result;
+
+					// Wrap X and Y. This is a basic implementation which works well enough. Need to improve base case.
+					if ( wrapX == true && _x == 0 )
+					{
+						(*aMap)(aMap->nX-1,_y) = result;
+					}
+					if ( wrapY == true && _y == 0 )
+					{
+						(*aMap)(_x,aMap->nY-1) = result;
+					}
+				}
+			}
 		}
 	}
 
@@ -62,26 +303,20 @@ class DiamondSquareAlgorithm
 	
 	bool wrapX;
 	bool wrapY;
+
+		// Number of threads to split each pass over. 1 is serial, 0 is 1 per core. Needs WILDCAT_THREADING.
+	int nThreads;
 	
 	DiamondSquareAlgorithm()
 	{
 		seed = 0;
 		wrapX=false;
 		wrapY=false;
+		nThreads=1;
 	}
 
-		// Note that random numbers are generated even if they aren't used, to map rng output to each tile regardless of settings.
 	void generate(ArrayS2 <unsigned char>* aMap=0, int* aValueTable=0, unsigned short int freeSteps = 0, float smoothing = 0.85, float variance = 250, float varianceDecrement = 0.1, const bool cratering=false)
 	{
-		if ( seed==0 )
-		{
-			rng.seed();
-		}
-		else
-		{
-			rng.seed(seed);
-		}
-		
 			// RESET VALUE TABLE
 		if ( aValueTable!=0 )
 		{
@@ -91,255 +326,56 @@ class DiamondSquareAlgorithm
 			}
 		}
 
-		int freeStepValue = -1; // -1 == random.
-
-
 		if (aMap==0) { std::cout<<"ERROR\n"; return; }
-		unsigned int mapSize = aMap->nX;
 
 		unsigned int squareSize = aMap->nX-1;
 
-		
+		int pass = 0;
+
 		// BASE CASE: SET CORNER VALUES (ONLY IF THEY AREN'T ALREADY SET).
 		// NOTE THAT A VALUE OF 0 WILL ALWAYS BE OVERWRITTEN.
-		//if ( wrappingMode==false )
+		if ( (*aMap)(0,0) == 0 )
 		{
-			if ( (*aMap)(0,0) == 0 )
-			{
-				(*aMap)(0,0)=rng.rand8();
-			}
-		//	addToValueTable(aValueTable,(*aMap)(0,0));
-
-			if ( (*aMap)(0,aMap->nY-1) == 0 )
-			{
-				(*aMap)(0,aMap->nY-1)=rng.rand8();
-			}
-		//	addToValueTable(aValueTable,(*aMap)(0,aMap->nY-1));
-
-			if ( (*aMap)(aMap->nX-1,0) == 0 )
-			{
-				(*aMap)(aMap->nX-1,0)=rng.rand8();
-			}
-		//	addToValueTable(aValueTable,(*aMap)(aMap->nX-1,0));
-
-			if ( (*aMap)(aMap->nX-1,aMap->nY-1) == 0 )
-			{
-				(*aMap)(aMap->nX-1,aMap->nY-1)=rng.rand8();
-			}
-		//	addToValueTable(aValueTable,(*aMap)(aMap->nX-1,aMap->nY-1));
+			(*aMap)(0,0)=tileRng(0,0,pass).rand8();
+		}
+		if ( (*aMap)(0,aMap->nY-1) == 0 )
+		{
+			(*aMap)(0,aMap->nY-1)=tileRng(0,aMap->nY-1,pass).rand8();
+		}
+		if ( (*aMap)(aMap->nX-1,0) == 0 )
+		{
+			(*aMap)(aMap->nX-1,0)=tileRng(aMap->nX-1,0,pass).rand8();
+		}
+		if ( (*aMap)(aMap->nX-1,aMap->nY-1) == 0 )
+		{
+			(*aMap)(aMap->nX-1,aMap->nY-1)=tileRng(aMap->nX-1,aMap->nY-1,pass).rand8();
 		}
-		// else
-		// {
-			// const int cornerValue = random.randInt(255);
-			// addToValueTable(aValueTable,cornerValue);
-			// addToValueTable(aValueTable,cornerValue);
-			// addToValueTable(aValueTable,cornerValue);
-			// addToValueTable(aValueTable,cornerValue);
-			// (*aMap)(0,0)=cornerValue;
-			// (*aMap)(0,aMap->nY-1)=cornerValue;
-			// (*aMap)(aMap->nX-1,0)=cornerValue;
-			// (*aMap)(aMap->nX-1,aMap->nY-1)=cornerValue;
-		// }
 
 		bool squareMode = true;
 
 		while ( squareSize > 1 )
 		{
+			++pass;
+
 			if ( squareMode==true)
 			{
-
-				// Skip the last tile because there's no need to do them.
-				for (int _y=0;_y<aMap->nY-1;_y+=squareSize)
+					// Each square only reads its corners, so every row is independent.
+				forEachRowBand(0,aMap->nY-1,squareSize,[&](const int /* band */, const int yStart, const int yEnd)
 				{
-					for (int _x=0;_x<aMap->nX-1;_x+=squareSize)
-					{
-						
-						int targetX = _x + (squareSize/2);
-						int targetY = _y + (squareSize/2);
-
-						if ( (*aMap)(targetX,targetY) == 0 ) // DON'T OVERWRITE NON-ZERO ENTRIES.
-						{
-							if ( freeSteps > 0 )
-							{
-								if ( freeStepValue == -1 )
-								{
-									const int _rand = rng.rand8();
-									(*aMap)(targetX,targetY)=_rand;
-							//		addToValueTable(aValueTable,_rand);
-								}
-								else
-								{
-									(*aMap)(targetX,targetY)=freeStepValue;
-							//		addToValueTable(aValueTable,freeStepValue);
-									// Generate a random number to keep rng predictable for each tile.
-									rng.rand8();
-								}
-							}
-							else if ( squareSize > 6 && cratering==true && rng.rand32(100)==0 )
-							{
-								const int _rand = rng.rand8();
-								(*aMap)(targetX,targetY)=_rand;
-								//(*aMap)(targetX,targetY)=0;
-						//		addToValueTable(aValueTable,_rand);
-							}
-							else
-							{
-								int nCorners = 0;
-								int totalCorners = 0;
-
-									// ADD UP CORNERS TO GET AVERAGE.
-								if ( aMap->isSafe(_x,_y) == true )
-								{
-									++nCorners;
-									totalCorners+=(*aMap)(_x,_y);
-								}
-								if ( aMap->isSafe(_x+squareSize,_y) == true )
-								{
-									++nCorners;
-									totalCorners+=(*aMap)(_x+squareSize,_y);
-								}
-								if ( aMap->isSafe(_x,_y+squareSize) == true )
-								{
-									++nCorners;
-									totalCorners+=(*aMap)(_x,_y+squareSize);
-								}
-								if ( aMap->isSafe(_x+squareSize,_y+squareSize) == true )
-								{
-									++nCorners;
-									totalCorners+=(*aMap)(_x+squareSize,_y+squareSize);
-								}
-
-									// NCORNERS SHOULD ALWAYS EQUAL. SO THE BOUNDS TESTING WOULD NOT NORMALLY BE REQUIRED.
-									const int average = totalCorners/4;
-
-								//int variance2 = random.randInt(variance) - (variance/2);
-								int result = average;
-								if ( variance > 0 )
-								{
-											// Ensure that random range stays in bounds to prevent biases from rounding. This pokes lots of holes in landmasses though, so I've disabled it.
-									int lowerRange = -variance;
-									//if (lowerRange<0) { lowerRange=0; }
-									int higherRange = variance;
-									//if (higherRange > 255) { higherRange = 255; }
-									result = average+rng.range32(lowerRange,higherRange);
-								}
-								else
-								{
-									// Generate a random number to keep rng predictable for each tile.
-									rng.rand8();
-								}
-								
-									// Just to be sure.
-								if (result<0) { result=0; }
-								if (result>255) { result=255; }
-
-								(*aMap)(targetX,targetY)=result;
-							//	addToValueTable(aValueTable,result);
-							}
-						}
-						else
-						{
-							// MAKE SURE NON-ZERO VALUES STILL GET COUNTED IN THE TABLE.
-							//addToValueTable(aValueTable,(*aMap)(targetX,targetY));
-							// Generate a random number to keep rng predictable for each tile.
-							rng.rand8();
-						}
-					}
-				}
+					squareRows(aMap,yStart,yEnd,squareSize,freeSteps,variance,cratering,pass);
+				});
 			}
 			else // DIAMOND MODE
 			{
-
 				squareSize/=2;
-				
 
-					// NEED TO RECHECK THIS. EARLIER NOTES INDICATE POSSIBLE PROBLEM.
-				for (int _y=0;_y<aMap->nY;_y+=squareSize)
+					// The last row can be written by wrapY from row 0, so do it after everything else.
+				const int lastRow = ((aMap->nY-1)/squareSize)*squareSize;
+				forEachRowBand(0,lastRow,squareSize,[&](const int /* band */, const int yStart, const int yEnd)
 				{
-					for (int _x=0;_x<aMap->nX;_x+=squareSize)
-					{
-						if ( (*aMap)(_x,_y) == 0 ) // DON'T OVERWRITE NON-ZERO ENTRIES.
-						{
-							if ( freeSteps > 0 )
-							{
-								if ( freeStepValue == -1 )
-								{
-									const unsigned char _rand = rng.rand8();
-									(*aMap)(_x,_y)=_rand;
-								//	addToValueTable(aValueTable,_rand);
-								}
-								else
-								{
-									(*aMap)(_x,_y)=freeStepValue;
-								//	addToValueTable(aValueTable,freeStepValue);
-								
-									// Generate a random number to keep rng predictable for each tile.
-									rng.rand8();
-								}
-							}
-							else
-							{
-								double total=0;
-								int nSides=0; // NOTE THAT IN THIS CASE NSIDES MAY NOT BE 4.
-
-								if ( aMap->isSafe(_x-squareSize,_y) == true )
-								{
-									++nSides;
-									total+= (*aMap)(_x-squareSize,_y);
-								}
-								if ( aMap->isSafe(_x,_y+squareSize) == true )
-								{
-									++nSides;
-									total+= (*aMap)(_x,_y+squareSize);
-								}
-								if ( aMap->isSafe(_x+squareSize,_y) == true )
-								{
-									++nSides;
-									total+= (*aMap)(_x+squareSize,_y);
-								}
-								if ( aMap->isSafe(_x,_y-squareSize) == true )
-								{
-									++nSides;
-									total+= (*aMap)(_x,_y-squareSize);
-								}
-
-
-								int average = 0;
-								if (nSides!=0)
-								{
-									average = total/nSides;
-								}
-
-								int result = average+rng.range32(-variance,variance);
-
-								if (result<0) { result=0; }
-								if (result>255) { result=255; }
-
-								(*aMap)(_x,_y)=result;
-							//	addToValueTable(aValueTable,result);
-								
-								// Wrap X and Y. This is a basic implementation which works well enough. Need to improve base case.
-								if ( wrapX == true && _x == 0 )
-								{
-									(*aMap)(aMap->nX-1,_y) = result;
-								}
-								if ( wrapY == true && _y == 0 )
-								{
-									(*aMap)(_x,aMap->nY-1) = result;
-								}
-							}
-						}
-						else
-						{
-							// MAKE SURE NON-ZERO VALUES STILL GET COUNTED IN THE TABLE.
-							//std::cout<<"Notouch\n";
-							//addToValueTable(aValueTable,(*aMap)(_x,_y));
-							
-							// Generate a random number to keep rng predictable for each tile.
-							rng.rand8();
-						}
-					}
-				}
+					diamondRows(aMap,yStart,yEnd,squareSize,freeSteps,variance,pass);
+				});
+				diamondRows(aMap,lastRow,aMap->nY,squareSize,freeSteps,variance,pass);
 			}
 
 				// WE DON'T MODIFY VARIANCE UNTIL THE FREE STEPS RUN OUT.
@@ -359,21 +395,23 @@ class DiamondSquareAlgorithm
 			squareMode=!squareMode;
 		}
 
-			// TEMPORARY FIX FOR VALUE TABLE PROBLEMS.
+			// BUILD THE VALUE TABLE AT THE END. Each band counts into its own table, which are then added up.
 		if (aValueTable!=0)
 		{
-			for ( int i=0;i<256;++i)
+			std::vector < std::vector <int> > vPartialTable (countBands(aMap->nY), std::vector <int> (256,0));
+			forEachRowBand(0,aMap->nY,1,[&](const int band, const int yStart, const int yEnd)
 			{
-				aValueTable[i]=0;
-			}
-
-			for (int _y=0;_y<aMap->nY;++_y)
+				std::vector <int>& vTable = vPartialTable[band];
+				const unsigned char * i = &aMap->data[aMap->nX*yStart];
+				const unsigned char * const iEnd = &aMap->data[aMap->nX*yEnd];
+				for (;i!=iEnd;++i)
+				{ vTable[*i]++; }
+			});
+
+			for (auto& vTable: vPartialTable)
 			{
-				for (int _x=0;_x<aMap->nX;++_x)
-				{
-					//addToValueTable(aValue);
-					aValueTable[(*aMap)(_x,_y)]++;
-				}
+				for ( int i=0;i<256;++i)
+				{ aValueTable[i]+=vTable[i]; }
 			}
 		}
 	}
@@ -0,0 +1,293 @@
+#pragma once
+#ifndef WILDCAT_MATH_RANDOM_RANDOM_COUNTER_HPP
+#define WILDCAT_MATH_RANDOM_RANDOM_COUNTER_HPP
+
+/* Wildcat: RandomCounter
+	#include <Math/Random/RandomCounter.hpp>
+
+Counter-based RNG for generation which runs in parallel. RandomLehmer and GlobalRandom step a state along, so the
+values a thread gets depend on how many values other threads took first. Here every value is a pure function of
+(seed, stream, index), using the Philox4x32-10 generator from Salmon et al., "Parallel random numbers: as easy as
+1, 2, 3" (2011). Each block of 4 values is Philox of counter index/4 and key (seed, stream).
+
+Each call to rand32(), rand8(), flip() etc uses exactly one index, so a thread can jump to any index with setIndex()
+and get the same values it would have got in serial. rand8() is the top byte of the value and flip() is its top bit.
+
+child(n) gives an independent generator for part of the work, for example a biome or a row of tiles. Children are
+pure functions of their parent's key and n, so they don't depend on what order they were made in. This replaces
+deriving sub seeds from a sequential RNG:
+
+	RandomCounter rng (seed);
+	RandomCounter landformRng = rng.child(0);
+	RandomCounter biomeRng = rng.child(1+biomeIndex);
+
+fill() and fill8() write thousands of values per call for fractal and noise kernels. They give the same values as
+calling rand32() or rand8() in a loop, and compute 8 blocks at a time with SSE2 when it's available.
+
+*/
+
+#include <cstdint>
+#include <cstddef>
+
+#include <Math/Random/RandomInterface.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64)
+	#define WILDCAT_RANDOM_COUNTER_SSE2
+	#include <emmintrin.h>
+#endif
+
+class RandomCounter: public RandomInterface
+{
+	private:
+
+	uint32_t keySeed;
+	uint32_t keyStream;
+	uint64_t index; // index of the next value
+
+	// The last block computed, since values are made 4 at a time.
+	uint32_t aBlock[4];
+	uint64_t blockNumber;
+	bool hasBlock;
+
+	static inline void mulhilo(const uint32_t a, const uint32_t b, uint32_t& hi, uint32_t& lo)
+	{
+		const uint64_t product = (uint64_t)a*b;
+		hi = product>>32;
+		lo = (uint32_t)product;
+	}
+
+#ifdef WILDCAT_RANDOM_COUNTER_SSE2
+	static inline void mulhilo4(const __m128i a, const __m128i m, __m128i& hi, __m128i& lo)
+	{
+		const __m128i lowMask = _mm_set_epi32(0,-1,0,-1);
+		const __m128i even = _mm_mul_epu32(a,m); // lanes 0 and 2
+		const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a,32),m); // lanes 1 and 3
+		lo = _mm_or_si128(_mm_and_si128(even,lowMask),_mm_slli_epi64(odd,32));
+		hi = _mm_or_si128(_mm_srli_epi64(even,32),_mm_andnot_si128(lowMask,odd));
+	}
+
+	static inline void round4(__m128i& c0, __m128i& c1, __m128i& c2, __m128i& c3, const __m128i k0, const __m128i k1)
+	{
+		const __m128i m0 = _mm_set1_epi32(0xD2511F53);
+		const __m128i m1 = _mm_set1_epi32(0xCD9E8D57);
+		__m128i hi0, lo0, hi1, lo1;
+		mulhilo4(c0,m0,hi0,lo0);
+		mulhilo4(c2,m1,hi1,lo1);
+		c0 = _mm_xor_si128(_mm_xor_si128(hi1,c1),k0);
+		c1 = lo1;
+		c2 = _mm_xor_si128(_mm_xor_si128(hi0,c3),k1);
+		c3 = lo0;
+	}
+
+	// Transpose, so each block's 4 words are together.
+	static inline void store4(const __m128i c0, const __m128i c1, const __m128i c2, const __m128i c3, uint32_t* _out)
+	{
+		const __m128i t0 = _mm_unpacklo_epi32(c0,c1);
+		const __m128i t1 = _mm_unpacklo_epi32(c2,c3);
+		const __m128i t2 = _mm_unpackhi_epi32(c0,c1);
+		const __m128i t3 = _mm_unpackhi_epi32(c2,c3);
+		_mm_storeu_si128((__m128i*)_out,_mm_unpacklo_epi64(t0,t1));
+		_mm_storeu_si128((__m128i*)(_out+4),_mm_unpackhi_epi64(t0,t1));
+		_mm_storeu_si128((__m128i*)(_out+8),_mm_unpacklo_epi64(t2,t3));
+		_mm_storeu_si128((__m128i*)(_out+12),_mm_unpackhi_epi64(t2,t3));
+	}
+
+	// Blocks _block to _block+7 at once, written to _out in order. 2 groups of 4 are interleaved so the
+	// multiplies of one group overlap with the other.
+	static void philox8Blocks(const uint64_t _block, const uint32_t _seed, const uint32_t _stream, uint32_t* _out)
+	{
+		__m128i a0 = _mm_set_epi32((uint32_t)(_block+3),(uint32_t)(_block+2),(uint32_t)(_block+1),(uint32_t)_block);
+		__m128i a1 = _mm_set_epi32((uint32_t)((_block+3)>>32),(uint32_t)((_block+2)>>32),(uint32_t)((_block+1)>>32),
+			(uint32_t)(_block>>32));
+		__m128i b0 = _mm_add_epi32(a0,_mm_set1_epi32(4));
+		__m128i b1 = _mm_set_epi32((uint32_t)((_block+7)>>32),(uint32_t)((_block+6)>>32),(uint32_t)((_block+5)>>32),
+			(uint32_t)((_block+4)>>32));
+		__m128i a2 = _mm_setzero_si128();
+		__m128i a3 = _mm_setzero_si128();
+		__m128i b2 = _mm_setzero_si128();
+		__m128i b3 = _mm_setzero_si128();
+		uint32_t k0 = _seed;
+		uint32_t k1 = _stream;
+
+		for (int round=0;round<10;++round)
+		{
+			const __m128i key0 = _mm_set1_epi32(k0);
+			const __m128i key1 = _mm_set1_epi32(k1);
+			round4(a0,a1,a2,a3,key0,key1);
+			round4(b0,b1,b2,b3,key0,key1);
+			k0 += 0x9E3779B9;
+			k1 += 0xBB67AE85;
+		}
+		store4(a0,a1,a2,a3,_out);
+		store4(b0,b1,b2,b3,_out+16);
+	}
+#endif
+
+	inline uint32_t next()
+	{
+		const uint64_t block = index>>2;
+		if ( hasBlock==false || block!=blockNumber )
+		{
+			philox((uint32_t)block,(uint32_t)(block>>32),0,0,keySeed,keyStream,aBlock);
+			blockNumber=block;
+			hasBlock=true;
+		}
+		return aBlock[index++&3];
+	}
+
+	public:
+
+	// Philox4x32-10. Counter words 2 and 3 are 0 for values, and 1 for deriving children.
+	static void philox(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, uint32_t k0, uint32_t k1, uint32_t* _out)
+	{
+		for (int round=0;round<10;++round)
+		{
+			uint32_t hi0, lo0, hi1, lo1;
+			mulhilo(0xD2511F53,c0,hi0,lo0);
+			mulhilo(0xCD9E8D57,c2,hi1,lo1);
+			c0 = hi1^c1^k0;
+			c1 = lo1;
+			c2 = hi0^c3^k1;
+			c3 = lo0;
+			k0 += 0x9E3779B9;
+			k1 += 0xBB67AE85;
+		}
+		_out[0]=c0;
+		_out[1]=c1;
+		_out[2]=c2;
+		_out[3]=c3;
+	}
+
+	RandomCounter(const uint32_t _seed=0, const uint32_t _stream=0)
+	{
+		keySeed=_seed;
+		keyStream=_stream;
+		index=0;
+		blockNumber=0;
+		hasBlock=false;
+	}
+
+	// Restart with a new key.
+	void seed(const uint32_t _seed, const uint32_t _stream=0)
+	{
+		keySeed=_seed;
+		keyStream=_stream;
+		index=0;
+		hasBlock=false;
+	}
+
+	inline uint32_t getSeed() const
+	{ return keySeed; }
+	inline uint32_t getStream() const
+	{ return keyStream; }
+	inline uint64_t getIndex() const
+	{ return index; }
+	inline void setIndex(const uint64_t _index)
+	{ index=_index; }
+
+	// The value at any index, without changing anything.
+	static uint32_t at(const uint32_t _seed, const uint32_t _stream, const uint64_t _index)
+	{
+		uint32_t aOut[4];
+		const uint64_t block = _index>>2;
+		philox((uint32_t)block,(uint32_t)(block>>32),0,0,_seed,_stream,aOut);
+		return aOut[_index&3];
+	}
+	inline uint32_t at(const uint64_t _index) const
+	{ return at(keySeed,keyStream,_index); }
+
+	// An independent generator, which only depends on this generator's key and _n.
+	RandomCounter child(const uint32_t _n) const
+	{
+		uint32_t aOut[4];
+		philox(_n,0,1,0,keySeed,keyStream,aOut);
+		return RandomCounter(aOut[0],aOut[1]);
+	}
+
+	uint32_t rand32() override
+	{ return next(); }
+
+	// Return a number from 0 to _max-1.
+	uint32_t rand32(const uint32_t _max) override
+	{
+		if ( _max==0 ) { return 0; }
+		return next()%_max;
+	}
+
+	unsigned char rand8() override
+	{ return next()>>24; }
+
+	// Return a number from 0 to _max-1.
+	unsigned char rand8(const unsigned char _max) override
+	{
+		if ( _max==0 ) { return 0; }
+		return rand8()%_max;
+	}
+
+	bool flip() override
+	{ return next()>>31; }
+
+	// Return true one in _prob times.
+	bool oneIn(const uint16_t _prob) override
+	{ return rand32(_prob)==0; }
+
+	// Range is inclusive.
+	int32_t range32(const int32_t _min, const int32_t _max) override
+	{
+		if ( _max<=_min ) { return _min; }
+		const uint32_t span = (uint32_t)_max-(uint32_t)_min+1;
+		if ( span==0 ) { return (int32_t)next(); } // the whole range
+		return (int32_t)((uint32_t)_min+next()%span);
+	}
+
+	// Write the next _n values of rand32() to _out.
+	void fill(uint32_t* _out, size_t _n)
+	{
+		// Use up values until the index is at the start of a block.
+		while ( _n>0 && (index&3)!=0 )
+		{
+			*_out++ = next();
+			--_n;
+		}
+
+#ifdef WILDCAT_RANDOM_COUNTER_SSE2
+		while ( _n>=32 )
+		{
+			philox8Blocks(index>>2,keySeed,keyStream,_out);
+			index+=32;
+			_out+=32;
+			_n-=32;
+		}
+#endif
+		while ( _n>=4 )
+		{
+			const uint64_t block = index>>2;
+			philox((uint32_t)block,(uint32_t)(block>>32),0,0,keySeed,keyStream,_out);
+			index+=4;
+			_out+=4;
+			_n-=4;
+		}
+		while ( _n>0 )
+		{
+			*_out++ = next();
+			--_n;
+		}
+	}
+
+	// Write the next _n values of rand8() to _out.
+	void fill8(unsigned char* _out, size_t _n)
+	{
+		uint32_t aValue[256];
+		while ( _n>0 )
+		{
+			const size_t nBatch = _n<256 ? _n : 256;
+			fill(aValue,nBatch);
+			for (size_t i=0;i<nBatch;++i)
+			{ _out[i] = aValue[i]>>24; }
+			_out+=nBatch;
+			_n-=nBatch;
+		}
+	}
+};
+
+#endif
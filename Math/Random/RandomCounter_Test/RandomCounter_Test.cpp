@@ -0,0 +1,157 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <Math/Random/RandomCounter.hpp>
+#include <Math/Random/RandomLehmer.hpp>
+#include <System/Thread/TaskPool.hpp>
+#include <System/Time/Timer.hpp>
+
+// g++ RandomCounter_Test.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX -D WILDCAT_THREADING -pthread
+
+// Test of RandomCounter. Checks it against the Philox4x32-10 known answers, checks that values only depend on
+// (seed, stream, index), and that filling a map in parallel gives the same map as filling it in serial. Then
+// compares the speed of batch fills with calling rand32() in a loop.
+
+const int N_VALUES = 1<<24;
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+	std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+	if ( passed==false ) { ++nFailed; }
+}
+
+int main (int nArgs, char ** arg)
+{
+	// Known answers from the Random123 library: counter 0 with key 0, and all bits set for both.
+	RandomCounter zero (0,0);
+	check("Philox known answer 1", zero.rand32()==0x6627e8d5 && zero.rand32()==0xe169c58d && zero.rand32()==0xbc57ac4c
+		&& zero.rand32()==0x9b00dbd8);
+
+	uint32_t aBlock[4];
+	RandomCounter::philox(0xffffffff,0xffffffff,0xffffffff,0xffffffff,0xffffffff,0xffffffff,aBlock);
+	check("Philox known answer 2", aBlock[0]==0x408f276d && aBlock[1]==0x41c83b0e && aBlock[2]==0xa20bc7c6
+		&& aBlock[3]==0x6d5451fd);
+
+	RandomCounter last (7,8);
+	last.setIndex(0xffffffffffffffe0ULL);
+	std::vector <uint32_t> vLast (32);
+	last.fill(vLast.data(),32);
+	check("fill matches at() at the end of the counter", vLast[0]==RandomCounter::at(7,8,0xffffffffffffffe0ULL)
+		&& vLast[31]==RandomCounter::at(7,8,0xffffffffffffffffULL));
+
+	// Values only depend on the index.
+	RandomCounter rng (1234,5);
+	std::vector <uint32_t> vSerial (1000);
+	for (unsigned int i=0;i<vSerial.size();++i) { vSerial[i]=rng.rand32(); }
+	bool sameAt = true;
+	for (unsigned int i=0;sameAt && i<vSerial.size();++i) { sameAt = vSerial[i]==RandomCounter::at(1234,5,i); }
+	check("Values are a function of the index", sameAt);
+
+	rng.setIndex(777);
+	check("setIndex jumps to a value", rng.rand32()==vSerial[777] && rng.getIndex()==778);
+
+	RandomCounter otherStream (1234,6);
+	check("Streams differ", otherStream.rand32()!=vSerial[0]);
+
+	// fill() from any starting index and of any size matches rand32().
+	bool sameFill = true;
+	for (int start=0;sameFill && start<8;++start)
+	{
+		for (int n=0;sameFill && n<70;n+=7)
+		{
+			RandomCounter a (99,1);
+			RandomCounter b (99,1);
+			a.setIndex(start);
+			b.setIndex(start);
+			std::vector <uint32_t> vFill (n+1,0);
+			a.fill(vFill.data(),n);
+			for (int i=0;sameFill && i<n;++i) { sameFill = vFill[i]==b.rand32(); }
+			sameFill = sameFill && a.rand32()==b.rand32();
+		}
+	}
+	check("fill matches rand32", sameFill);
+
+	RandomCounter bytes1 (42);
+	RandomCounter bytes2 (42);
+	unsigned char aByte[1000];
+	bytes1.fill8(aByte,1000);
+	bool sameBytes = true;
+	for (int i=0;sameBytes && i<1000;++i) { sameBytes = aByte[i]==bytes2.rand8(); }
+	check("fill8 matches rand8", sameBytes);
+
+	// Children only depend on the parent's key and number.
+	RandomCounter parent (2024);
+	RandomCounter child3 = parent.child(3);
+	parent.rand32();
+	RandomCounter child3Again = parent.child(3);
+	check("Children are pure", child3.getSeed()==child3Again.getSeed() && child3.getStream()==child3Again.getStream());
+	check("Children differ", parent.child(3).rand32()!=parent.child(4).rand32() && parent.child(0).rand32()!=parent.rand32());
+
+	bool inRange = true;
+	int nFlips = 0;
+	for (int i=0;i<100000;++i)
+	{
+		const int32_t r = rng.range32(-3,3);
+		if ( r<-3 || r>3 ) { inRange=false; }
+		if ( rng.rand32(10)>=10 || rng.rand8(7)>=7 ) { inRange=false; }
+		if ( rng.flip() ) { ++nFlips; }
+	}
+	check("Ranges", inRange && rng.range32(5,5)==5 && rng.rand32(0)==0);
+	check("Flips are about half", nFlips>49000 && nFlips<51000);
+
+	// A map filled by rows in parallel is the same as in serial.
+	const int MAP_SIZE = 512;
+	std::vector <unsigned char> vSerialMap (MAP_SIZE*MAP_SIZE);
+	std::vector <unsigned char> vParallelMap (MAP_SIZE*MAP_SIZE);
+	RandomCounter mapRng (31337);
+	for (int y=0;y<MAP_SIZE;++y)
+	{
+		RandomCounter rowRng = mapRng.child(y);
+		for (int x=0;x<MAP_SIZE;++x) { vSerialMap[y*MAP_SIZE+x]=rowRng.rand8(); }
+	}
+	TaskPool pool (4);
+	pool.parallelFor(0,MAP_SIZE,[&](const int y)
+	{
+		RandomCounter rowRng = mapRng.child(y);
+		rowRng.fill8(&vParallelMap[y*MAP_SIZE],MAP_SIZE);
+	});
+	check("Parallel map matches serial map", vSerialMap==vParallelMap);
+
+	// Speed.
+	std::vector <uint32_t> vValue (N_VALUES);
+	Timer timer;
+	uint32_t total = 0;
+
+	RandomLehmer lehmer (1);
+	timer.init();
+	timer.start();
+	for (int i=0;i<N_VALUES;++i) { vValue[i]=lehmer.rand32(); }
+	timer.update();
+	total+=vValue[N_VALUES/2];
+	const double lehmerSeconds = timer.fullSeconds;
+
+	RandomCounter counter (1);
+	timer.init();
+	timer.start();
+	for (int i=0;i<N_VALUES;++i) { vValue[i]=counter.rand32(); }
+	timer.update();
+	total+=vValue[N_VALUES/2];
+	const double loopSeconds = timer.fullSeconds;
+
+	counter.setIndex(0);
+	timer.init();
+	timer.start();
+	counter.fill(vValue.data(),N_VALUES);
+	timer.update();
+	total+=vValue[N_VALUES/2];
+	const double fillSeconds = timer.fullSeconds;
+
+	std::cout<<N_VALUES<<" values. RandomLehmer rand32: "<<lehmerSeconds<<"s. RandomCounter rand32: "<<loopSeconds
+		<<"s. RandomCounter fill: "<<fillSeconds<<"s. ("<<total%2<<")\n";
+
+	std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+	return nFailed==0 ? 0 : 1;
+}
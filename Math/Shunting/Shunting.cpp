@@ -18,8 +18,7 @@
    
    Custom operators can be added, however left and right parentheses
    and positive/negative prefixes are special cases which are always processed.
-   Beware that the algorithm will find the first operator in the list which matches,
-   so for example >= should be added before > and =.
+   The longest matching operator is used, so for example >= is found before > and =.
    
    Current operator set uses BASIC conventions.
    
@@ -31,6 +30,11 @@
    (-1+1+(-1*2))*(-2*1) -> -1 1 + -1 2 * + -2 1 * *
    -(1*2*-3)-(5+5)+-(2) -> 0 1 2 * -3 * - 5 5 + - 2 -
    
+   Expressions which are evaluated many times should be compiled into a Shunting_Program
+   with compile(). The program can have variables, and evaluates without parsing or
+   allocating memory. Programs without variables or RND only evaluate once and then
+   return the cached result.
+   
 
    Credit to Takayuki MATSUOKA's implementation at
    https://gist.github.com/t-mat/b9f681b7591cdae712f6 and
@@ -53,27 +57,43 @@ class Shunting_Token
    std::string symbol; // if set to 0, then token is a value.
    bool rightAssociative;
    bool isPrefix;
+   bool isDeterministic; // false if the same values can give a different result, like RND
    unsigned short int precedence; // higher = higher precedence
    long int value; // only used for non-operator token
    
-   Shunting_Token(int _value=0, std::string _symbol = "", unsigned short int _precedence = 0, bool _rightAssociative = false, bool _isPrefix=false)
+   Shunting_Token(long int _value=0, std::string _symbol = "", unsigned short int _precedence = 0, bool _rightAssociative = false, bool _isPrefix=false)
    {
       value = _value;
       symbol = _symbol;
       precedence = _precedence;
       rightAssociative = _rightAssociative;
       isPrefix=_isPrefix;
+      isDeterministic=true;
    }
    
    virtual ~Shunting_Token()
    { }
    
    // overload this function for custom infix operators.
-   virtual Shunting_Token * operate(Shunting_Token * lv, Shunting_Token * rv)
+   virtual Shunting_Token * operate(Shunting_Token * /* lv */, Shunting_Token * /* rv */)
    {
       return 0;
    }
    
+   // Apply the operator to 2 values, for Shunting_Program. Returns false on error.
+   // By default this calls operate() on temporary tokens, so custom operators only need
+   // operate(), but the default set overloads this too so they skip the tokens.
+   virtual bool evaluate(const long int lv, const long int rv, long int& result)
+   {
+      Shunting_Token left (lv);
+      Shunting_Token right (rv);
+      Shunting_Token * token = isPrefix ? operate(0,&right) : operate(&left,&right);
+      if ( token==0 )
+      { return false; }
+      result = token->value;
+      return true;
+   }
+   
    bool isToken()
    {
       return symbol.size()>0;
@@ -108,6 +128,12 @@ class Shunting_Token_Add: public Shunting_Token
       lv->value = lv->value + rv->value;
       return lv;
    }
+   
+   bool evaluate(const long int lv, const long int rv, long int& result) override
+   {
+      result = lv + rv;
+      return true;
+   }
 };
 
 class Shunting_Token_Subtract: public Shunting_Token
@@ -128,6 +154,12 @@ class Shunting_Token_Subtract: public Shunting_Token
       lv->value = lv->value - rv->value;
       return lv;
    }
+   
+   bool evaluate(const long int lv, const long int rv, long int& result) override
+   {
+      result = lv - rv;
+      return true;
+   }
 };
 
 class Shunting_Token_Multiply: public Shunting_Token
@@ -148,6 +180,12 @@ class Shunting_Token_Multiply: public Shunting_Token
       lv->value = lv->value * rv->value;
       return lv;
    }
+   
+   bool evaluate(const long int lv, const long int rv, long int& result) override
+   {
+      result = lv * rv;
+      return true;
+   }
 };
 
 class Shunting_Token_Divide: public Shunting_Token
@@ -173,6 +211,17 @@ class Shunting_Token_Divide: public Shunting_Token
       lv->value = lv->value / rv->value;
       return lv;
    }
+   
+   bool evaluate(const long int lv, const long int rv, long int& result) override
+   {
+      if (rv==0)
+      {
+         std::cout<<"ERROR: Divide by 0.\n";
+         return false;
+      }
+      result = lv / rv;
+      return true;
+   }
 };
 
 class Shunting_Token_Power: public Shunting_Token
@@ -192,6 +241,12 @@ class Shunting_Token_Power: public Shunting_Token
       lv->value = pow(lv->value, rv->value);
       return lv;
    }
+   
+   bool evaluate(const long int lv, const long int rv, long int& result) override
+   {
+      result = pow(lv, rv);
+      return true;
+   }
 };
 
 class Shunting_Token_LeftParen: public Shunting_Token
@@ -235,6 +290,12 @@ class Shunting_Token_Equals: public Shunting_Token
       }
       return lv;
    }
+   
+   bool evaluate(const long int lv, const long int rv, long int& result) override
+   {
+      result = lv == rv ? -1 : 0;
+      return true;
+   }
 };
 
 class Shunting_Token_LessThan: public Shunting_Token
@@ -262,6 +323,12 @@ class Shunting_Token_LessThan: public Shunting_Token
       }
       return lv;
    }
+   
+   bool evaluate(const long int lv, const long int rv, long int& result) override
+   {
+      result = lv < rv ? -1 : 0;
+      return true;
+   }
 };
 
 class Shunting_Token_LessThanEqual: public Shunting_Token
@@ -289,6 +356,12 @@ class Shunting_Token_LessThanEqual: public Shunting_Token
       }
       return lv;
    }
+   
+   bool evaluate(const long int lv, const long int rv, long int& result) override
+   {
+      result = lv <= rv ? -1 : 0;
+      return true;
+   }
 };
 
 class Shunting_Token_GreaterThanEqual: public Shunting_Token
@@ -316,6 +389,12 @@ class Shunting_Token_GreaterThanEqual: public Shunting_Token
       }
       return lv;
    }
+   
+   bool evaluate(const long int lv, const long int rv, long int& result) override
+   {
+      result = lv >= rv ? -1 : 0;
+      return true;
+   }
 };
 
 class Shunting_Token_GreaterThan: public Shunting_Token
@@ -343,6 +422,12 @@ class Shunting_Token_GreaterThan: public Shunting_Token
       }
       return lv;
    }
+   
+   bool evaluate(const long int lv, const long int rv, long int& result) override
+   {
+      result = lv > rv ? -1 : 0;
+      return true;
+   }
 };
 
    // example custom operator
@@ -355,7 +440,7 @@ class Shunting_Token_Absolute: public Shunting_Token
    Shunting_Token_Absolute(): Shunting_Token(0, "ABS", 7, false, true)
    {}
    
-   Shunting_Token* operate(Shunting_Token * lv, Shunting_Token * rv) override
+   Shunting_Token* operate(Shunting_Token * /* lv */, Shunting_Token * rv) override
    {
       if (rv==0)
       {
@@ -366,6 +451,12 @@ class Shunting_Token_Absolute: public Shunting_Token
       rv->value = abs(rv->value);
       return rv;
    }
+   
+   bool evaluate(const long int /* lv */, const long int rv, long int& result) override
+   {
+      result = labs(rv);
+      return true;
+   }
 };
 
 class Shunting_Token_Rand: public Shunting_Token
@@ -373,9 +464,11 @@ class Shunting_Token_Rand: public Shunting_Token
    public:
    
    Shunting_Token_Rand(): Shunting_Token(0, "RND", 7, false, true)
-   {}
+   {
+      isDeterministic=false;
+   }
    
-   Shunting_Token* operate(Shunting_Token * lv, Shunting_Token * rv) override
+   Shunting_Token* operate(Shunting_Token * /* lv */, Shunting_Token * rv) override
    {
       if (rv==0)
       {
@@ -385,6 +478,255 @@ class Shunting_Token_Rand: public Shunting_Token
       rv->value = Random::randomInt(rv->value);
       return rv;
    }
+   
+   bool evaluate(const long int /* lv */, const long int rv, long int& result) override
+   {
+      result = Random::randomInt(rv);
+      return true;
+   }
+};
+
+   // Negative sign in front of something other than a number, such as -(1+2) or -A.
+   // Only used by Shunting::compile(), which has the same precedence as the M1* used by shunt().
+class Shunting_Token_Negate: public Shunting_Token
+{
+   public:
+   
+   Shunting_Token_Negate(): Shunting_Token(0, "-", 3, false, true)
+   {}
+   
+   Shunting_Token* operate(Shunting_Token * /* lv */, Shunting_Token * rv) override
+   {
+      if (rv==0)
+      {
+         std::cout<<"Null ptr error\n";
+         return 0;
+      }
+      rv->value = -rv->value;
+      return rv;
+   }
+   
+   bool evaluate(const long int /* lv */, const long int rv, long int& result) override
+   {
+      result = -rv;
+      return true;
+   }
+};
+
+// Finds the longest operator symbol at a position in a string, one character at a time,
+// instead of comparing the string against every operator in turn.
+class Shunting_OperatorTrie
+{
+   private:
+   
+   class Node
+   {
+      public:
+      char c;
+      Shunting_Token * token; // operator which ends at this node, if any
+      std::vector <int> vChild;
+   };
+   
+   std::vector <Node> vNode; // node 0 is the root
+   
+   public:
+   
+   Shunting_OperatorTrie()
+   {
+      clear();
+   }
+   
+   void clear()
+   {
+      vNode.clear();
+      Node root;
+      root.c=0;
+      root.token=0;
+      vNode.push_back(root);
+   }
+   
+   void add(Shunting_Token * _token)
+   {
+      int node=0;
+      for (unsigned int i=0;i<_token->symbol.size();++i)
+      {
+         int next=-1;
+         for (unsigned int i2=0;i2<vNode[node].vChild.size();++i2)
+         {
+            if ( vNode[vNode[node].vChild[i2]].c == _token->symbol[i] )
+            {
+               next=vNode[node].vChild[i2];
+               break;
+            }
+         }
+         if ( next==-1 )
+         {
+            Node child;
+            child.c=_token->symbol[i];
+            child.token=0;
+            vNode.push_back(child);
+            next=vNode.size()-1;
+            vNode[node].vChild.push_back(next);
+         }
+         node=next;
+      }
+      vNode[node].token=_token;
+   }
+   
+   // Return the longest operator starting at _str[_i], or 0 if there isn't one.
+   Shunting_Token * match(const std::string& _str, const unsigned int _i) const
+   {
+      Shunting_Token * longest = 0;
+      int node=0;
+      for (unsigned int i=_i;i<_str.size();++i)
+      {
+         int next=-1;
+         const Node& current = vNode[node];
+         for (unsigned int i2=0;i2<current.vChild.size();++i2)
+         {
+            if ( vNode[current.vChild[i2]].c == _str[i] )
+            {
+               next=current.vChild[i2];
+               break;
+            }
+         }
+         if ( next==-1 )
+         { break; }
+         node=next;
+         if ( vNode[node].token!=0 )
+         { longest=vNode[node].token; }
+      }
+      return longest;
+   }
+};
+
+// An expression compiled into postfix by Shunting::compile(). It can then be evaluated any
+// number of times without parsing or allocating memory. Variables in the expression are given
+// slots in the order they appear, and their values are passed to evaluate() as an array:
+//
+//   Shunting shunting;
+//   Shunting_Program program;
+//   shunting.compile("HP*2>MAXHP",program);
+//   long int aValue [2];
+//   aValue[program.getSlot("HP")]=5;
+//   aValue[program.getSlot("MAXHP")]=8;
+//   bool isTrue = program.evaluate(aValue) == -1;
+//
+// The program points to the Shunting's operators, so it must not outlive the Shunting.
+class Shunting_Program
+{
+   public:
+   
+   enum enumInstruction { PUSH_VALUE, PUSH_SLOT, OPERATOR };
+   
+   class Instruction
+   {
+      public:
+      unsigned char type;
+      int slot;
+      long int value;
+      Shunting_Token * token;
+   };
+   
+   std::vector <Instruction> vInstruction;
+   Vector <std::string> vVarName; // name of each slot
+   
+   std::vector <long int> vStack; // sized by compile() so evaluate() never allocates
+   
+   // An expression without variables or random operators always gives the same result,
+   // so it's only evaluated once.
+   bool isConstant;
+   bool isCached;
+   long int cachedValue;
+   
+   Shunting_Program()
+   {
+      clear();
+   }
+   
+   void clear()
+   {
+      vInstruction.clear();
+      vVarName.clear();
+      vStack.clear();
+      isConstant=true;
+      isCached=false;
+      cachedValue=0;
+   }
+   
+   // Slot of the variable, or -1 if the expression doesn't use it.
+   int getSlot(const std::string _name)
+   {
+      for (int i=0;i<vVarName.size();++i)
+      {
+         if ( vVarName(i)==_name )
+         { return i; }
+      }
+      return -1;
+   }
+   
+   inline int nSlots()
+   { return vVarName.size(); }
+   
+   // Evaluate with the given variable values, which must have nSlots() values.
+   // Errors (such as divide by 0) evaluate to 0, like Shunting::evaluate().
+   long int evaluate(const long int * _aSlot = 0)
+   {
+      if ( isCached )
+      { return cachedValue; }
+      if ( vInstruction.size()==0 )
+      { return 0; }
+      
+      long int * stack = vStack.data();
+      int top=-1;
+      
+      for (unsigned int i=0;i<vInstruction.size();++i)
+      {
+         const Instruction& instruction = vInstruction[i];
+         if ( instruction.type==PUSH_VALUE )
+         {
+            stack[++top]=instruction.value;
+         }
+         else if ( instruction.type==PUSH_SLOT )
+         {
+            stack[++top]=_aSlot[instruction.slot];
+         }
+         else if ( instruction.token->isPrefix )
+         {
+            if ( instruction.token->evaluate(0,stack[top],stack[top])==false )
+            { return 0; }
+         }
+         else
+         {
+            if ( instruction.token->evaluate(stack[top-1],stack[top],stack[top-1])==false )
+            { return 0; }
+            --top;
+         }
+      }
+      
+      if ( isConstant )
+      {
+         isCached=true;
+         cachedValue=stack[0];
+      }
+      return stack[0];
+   }
+   
+   std::string toString()
+   {
+      std::string retStr = "";
+      for (unsigned int i=0;i<vInstruction.size();++i)
+      {
+         if ( vInstruction[i].type==PUSH_VALUE )
+         { retStr += DataTools::toString(vInstruction[i].value); }
+         else if ( vInstruction[i].type==PUSH_SLOT )
+         { retStr += vVarName(vInstruction[i].slot); }
+         else
+         { retStr += vInstruction[i].token->symbol; }
+         retStr += " ";
+      }
+      return retStr;
+   }
 };
 
 // Main driver class. Initialise and create operators, or call
@@ -401,6 +743,60 @@ class Shunting
 
    std::vector<Shunting_Token*> stack2; // operator stack
    
+   Shunting_OperatorTrie operatorTrie; // for finding operators in expressions
+   
+   
+   private:
+   
+   Shunting_Token_Negate tokenNegate;
+   
+   // compile() helpers, which also track the evaluation stack depth.
+   void pushValue(Shunting_Program& program, const long int _value, int& depth, int& maxDepth)
+   {
+      Shunting_Program::Instruction instruction;
+      instruction.type=Shunting_Program::PUSH_VALUE;
+      instruction.slot=0;
+      instruction.value=_value;
+      instruction.token=0;
+      program.vInstruction.push_back(instruction);
+      if ( ++depth > maxDepth )
+      { maxDepth=depth; }
+   }
+   // Returns false if there aren't enough values for the operator.
+   bool pushOperator(Shunting_Program& program, Shunting_Token * _token, int& depth)
+   {
+      const int nValues = _token->isPrefix ? 1 : 2;
+      if ( depth < nValues )
+      { return false; }
+      depth -= nValues-1;
+      
+      Shunting_Program::Instruction instruction;
+      instruction.type=Shunting_Program::OPERATOR;
+      instruction.slot=0;
+      instruction.value=0;
+      instruction.token=_token;
+      program.vInstruction.push_back(instruction);
+      if ( _token->isDeterministic==false )
+      { program.isConstant=false; }
+      return true;
+   }
+   bool popOperator(Shunting_Program& program, int& depth)
+   {
+      Shunting_Token * token = stack2.back();
+      stack2.pop_back();
+      return pushOperator(program, token, depth);
+   }
+   
+   // Report a compile() error, and leave the program empty so evaluate() returns 0.
+   bool compileError(const std::string& _error, const std::string& expression, Shunting_Program& program)
+   {
+      std::cout<<"WARNING: Shunting: "<<_error<<" in "<<expression<<"\n";
+      program.clear();
+      stack2.clear();
+      return false;
+   }
+   
+   public:
    
    // Class will build the default operator set unless asked
    Shunting(bool bDefaults = true)
@@ -427,12 +823,12 @@ class Shunting
       }
       // delete all operators
       vTokenList.deleteAll();
+      operatorTrie.clear();
    }
    
    // Add operator to reference list.
    // Don't add duplicate symbols.
-   // Also, longer operators should be added first, otherwise
-   // shorter operators will be found before them.
+   // The longest matching operator is always used, so the order doesn't matter.
    void addOperator2(Shunting_Token * _toke)
    {
       if ( _toke == 0 )
@@ -450,30 +846,17 @@ class Shunting
       }
       
       vTokenList.push(_toke);
+      operatorTrie.add(_toke);
    }
    
-   Shunting_Token * getToken(std::string _op, unsigned int iStr)
+   Shunting_Token * getToken(const std::string& _op, unsigned int iStr)
    {
-      for (int i=0;i<vTokenList.size();++i)
-      {
-         if(_op.find(vTokenList(i)->symbol,iStr) == iStr)
-         {
-            return vTokenList(i);
-         }
-      }
-      return 0;
+      return operatorTrie.match(_op,iStr);
    }
    
-   bool isOperator(std::string _op, unsigned int iStr)
+   bool isOperator(const std::string& _op, unsigned int iStr)
    {
-      for (int i=0;i<vTokenList.size();++i)
-      {
-         if(_op.find(vTokenList(i)->symbol,iStr) == iStr)
-         {
-            return true;
-         }
-      }
-      return false;
+      return operatorTrie.match(_op,iStr) != 0;
    }
    
    
@@ -704,8 +1087,11 @@ class Shunting
                      // onto the output queue;
                      outputQueue2.push_back(o2);
                   }
-                  //otherwise exit
-                  break;
+                  else
+                  {
+                     //otherwise exit
+                     break;
+                  }
                }
                //push current operator onto stack
                stack2.push_back(currentToken);
@@ -840,6 +1226,182 @@ class Shunting
       return 0;
    }
    
+   // Compile the expression into a Shunting_Program, which can be evaluated repeatedly without
+   // parsing. Unlike shunt(), the expression may contain variables, which are runs of letters,
+   // digits and underscores that don't start with an operator. Returns false if the expression
+   // is invalid.
+   bool compile(const std::string& expression, Shunting_Program& program)
+   {
+      program.clear();
+      stack2.clear();
+      
+      bool expectValue = true; // true if the next token must be a value, so +- are signs.
+      int depth = 0; // values on the evaluation stack
+      int maxDepth = 0;
+      
+      unsigned int i=0;
+      while (i<expression.size())
+      {
+         const char c = expression[i];
+         
+         if ( c==' ' || c=='\t' )
+         {
+            ++i;
+            continue;
+         }
+         
+         if ( expectValue && (c=='-' || c=='+') )
+         {
+            // combine runs of signs like shunt(), for example --1 becomes 1.
+            const bool isExpressionStart = program.vInstruction.size()==0 && stack2.empty();
+            bool isNegative = false;
+            while ( i<expression.size() && (expression[i]=='-' || expression[i]=='+' || expression[i]==' ') )
+            {
+               if ( expression[i]=='-' )
+               { isNegative = !isNegative; }
+               ++i;
+            }
+            if ( isNegative==false )
+            { continue; }
+            
+            if ( isExpressionStart )
+            {
+               // shunt() puts a 0 before a leading -, so -2^2 is -4.
+               Shunting_Token * subtract = getToken("-",0);
+               if ( subtract==0 )
+               { return compileError("No - operator",expression,program); }
+               pushValue(program, 0, depth, maxDepth);
+               stack2.push_back(subtract);
+            }
+            else if ( i<expression.size() && std::isdigit(expression[i]) )
+            {
+               // negative number
+               const unsigned int iStart = i;
+               while ( i<expression.size() && std::isdigit(expression[i]) )
+               { ++i; }
+               pushValue(program, -strtol(expression.c_str()+iStart,0,10), depth, maxDepth);
+               expectValue=false;
+            }
+            else
+            {
+               stack2.push_back(&tokenNegate);
+            }
+            continue;
+         }
+         
+         if ( std::isdigit(c) )
+         {
+            if ( expectValue==false )
+            { return compileError("Missing operator",expression,program); }
+            const unsigned int iStart = i;
+            while ( i<expression.size() && std::isdigit(expression[i]) )
+            { ++i; }
+            pushValue(program, strtol(expression.c_str()+iStart,0,10), depth, maxDepth);
+            expectValue=false;
+            continue;
+         }
+         
+         Shunting_Token * currentToken = operatorTrie.match(expression,i);
+         if ( currentToken != 0 )
+         {
+            i+=currentToken->symbol.size();
+            
+            if ( currentToken->symbol == "(" )
+            {
+               if ( expectValue==false )
+               { return compileError("Missing operator",expression,program); }
+               stack2.push_back(currentToken);
+            }
+            else if ( currentToken->symbol == ")" )
+            {
+               while ( stack2.empty()==false && stack2.back()->symbol != "(" )
+               {
+                  if ( popOperator(program, depth)==false )
+                  { return compileError("Missing value",expression,program); }
+               }
+               if ( stack2.empty() || expectValue )
+               { return compileError("Mismatched parentheses",expression,program); }
+               stack2.pop_back();
+               expectValue=false;
+            }
+            else if ( currentToken->isPrefix )
+            {
+               if ( expectValue==false )
+               { return compileError("Missing operator",expression,program); }
+               stack2.push_back(currentToken);
+            }
+            else
+            {
+               if ( expectValue )
+               { return compileError("Missing value",expression,program); }
+               // pop operators which bind tighter than this one.
+               while ( stack2.empty()==false && stack2.back()->symbol != "(" )
+               {
+                  Shunting_Token * o2 = stack2.back();
+                  if ( (! currentToken->rightAssociative && currentToken->precedence <= o2->precedence)
+                  ||   (  currentToken->rightAssociative && currentToken->precedence <  o2->precedence) )
+                  {
+                     if ( popOperator(program, depth)==false )
+                     { return compileError("Missing value",expression,program); }
+                  }
+                  else
+                  { break; }
+               }
+               stack2.push_back(currentToken);
+               expectValue=true;
+            }
+            continue;
+         }
+         
+         if ( std::isalpha(c) || c=='_' )
+         {
+            if ( expectValue==false )
+            { return compileError("Missing operator",expression,program); }
+            const unsigned int iStart = i;
+            ++i;
+            while ( i<expression.size() && (std::isalnum(expression[i]) || expression[i]=='_')
+               && operatorTrie.match(expression,i)==0 )
+            { ++i; }
+            
+            const std::string name = expression.substr(iStart,i-iStart);
+            int slot = program.getSlot(name);
+            if ( slot==-1 )
+            {
+               program.vVarName.push(name);
+               slot = program.vVarName.size()-1;
+            }
+            
+            Shunting_Program::Instruction instruction;
+            instruction.type=Shunting_Program::PUSH_SLOT;
+            instruction.slot=slot;
+            instruction.value=0;
+            instruction.token=0;
+            program.vInstruction.push_back(instruction);
+            if ( ++depth > maxDepth )
+            { maxDepth=depth; }
+            program.isConstant=false;
+            expectValue=false;
+            continue;
+         }
+         
+         return compileError(std::string("Unknown symbol '")+c+"'",expression,program);
+      }
+      
+      while ( stack2.empty()==false )
+      {
+         if ( stack2.back()->symbol == "(" )
+         { return compileError("Mismatched parentheses",expression,program); }
+         if ( popOperator(program, depth)==false )
+         { return compileError("Missing value",expression,program); }
+      }
+      
+      if ( depth != 1 )
+      { return compileError("Invalid expression",expression,program); }
+      
+      program.vStack.assign(maxDepth,0);
+      return true;
+   }
+   
    std::string shuntEvaluate(std::string _input)
    {
       //automatically shunt and evaluate the string, and return string output.
@@ -0,0 +1,155 @@
+#include <climits> /* Colour.hpp needs UINT_MAX. */
+#include <iostream>
+#include <string>
+#include <deque>
+#include <stack>
+#include <vector>
+#include <cstdlib>
+#include <new>
+
+#include <Container/Vector/Vector.hpp>
+#include <Data/DataTools.hpp>
+#include <Math/Random/GlobalRandom.hpp>
+
+#include <Math/Shunting/Shunting.cpp>
+
+#include <System/Time/Timer.hpp>
+
+// g++ Shunting_Test.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX
+
+// Headless test of Shunting::compile(). Checks that compiled programs give the same results as
+// shunt() and evaluate(), that variables and cached constants work, and that evaluating doesn't
+// allocate. Then times both methods.
+
+   // Count allocations so we can check that Shunting_Program::evaluate() doesn't make any. Every
+   // form of new and delete is replaced, so they all use the same allocator.
+unsigned long int nAllocations = 0;
+void* countedAllocate(std::size_t size)
+{
+   ++nAllocations;
+   void* p = std::malloc(size==0 ? 1 : size);
+   if ( p==0 ) { throw std::bad_alloc(); }
+   return p;
+}
+void* operator new(std::size_t size)
+{ return countedAllocate(size); }
+void* operator new[](std::size_t size)
+{ return countedAllocate(size); }
+void operator delete(void* p) noexcept
+{ std::free(p); }
+void operator delete[](void* p) noexcept
+{ std::free(p); }
+void operator delete(void* p, std::size_t) noexcept
+{ std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept
+{ std::free(p); }
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+   std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+   if ( passed==false ) { ++nFailed; }
+}
+
+long int legacyEvaluate(Shunting& shunting, const std::string expression)
+{
+   shunting.shunt(expression);
+   return shunting.evaluate();
+}
+
+long int compiledEvaluate(Shunting& shunting, const std::string expression)
+{
+   Shunting_Program program;
+   if ( shunting.compile(expression,program)==false )
+   { return -999999; }
+   return program.evaluate();
+}
+
+int main (int nArgs, char ** arg)
+{
+   Shunting shunting;
+   
+      // The samples from the header, and some others.
+   const char* aExpression [] = { "3+4*2/(1-5)^2^3", "(2*3+3*4)", "20-30/3+4*2^3", "(-1+1+(-1*2))*(-2*1)",
+      "-(1*2*-3)-(5+5)+-(2)", "10-2-3", "2^3^2", "-2^2", "ABS(-5)+1", "3>=3", "2<=1", "--1", "7/2",
+      "(1+2)*3=9", "5>3" };
+   for (unsigned int i=0;i<sizeof(aExpression)/sizeof(aExpression[0]);++i)
+   {
+      const long int legacy = legacyEvaluate(shunting,aExpression[i]);
+      const long int compiled = compiledEvaluate(shunting,aExpression[i]);
+      check(std::string("Same result for ")+aExpression[i]+" ("+std::to_string(compiled)+")", legacy==compiled);
+   }
+   
+   check("Operator precedence is applied to the whole stack", compiledEvaluate(shunting,"1-2*3+4")==-1);
+   check("Negated variables and parentheses", compiledEvaluate(shunting,"2*-(3+4)")==-14);
+   
+   std::cout<<"Expect 3 warnings:\n";
+   Shunting_Program program;
+   check("Missing value is an error", shunting.compile("1+",program)==false);
+   check("Mismatched parentheses are an error", shunting.compile("(1+2",program)==false);
+   check("Unknown symbol is an error", shunting.compile("1#2",program)==false);
+   
+   // A failed compile leaves nothing to evaluate, even after a good compile.
+   std::cout<<"Expect 2 warnings:\n";
+   long int aFailedValue [1] = {3};
+   check("Failed program evaluates to 0", shunting.compile("1+",program)==false && program.evaluate(aFailedValue)==0);
+   shunting.compile("X+1",program);
+   check("Failed compile clears the old program", shunting.compile("X+(",program)==false && program.nSlots()==0
+      && program.evaluate(aFailedValue)==0);
+   
+   check("Compile with variables", shunting.compile("HP*2>MAXHP+ABS(BONUS)",program));
+   check("Variable slots", program.nSlots()==3 && program.getSlot("HP")==0 && program.getSlot("MAXHP")==1
+      && program.getSlot("BONUS")==2 && program.getSlot("X")==-1);
+   long int aValue [3] = {5,8,-1};
+   check("Evaluate with variables", program.evaluate(aValue)==-1);
+   aValue[0]=4;
+   check("Evaluate again with new values", program.evaluate(aValue)==0);
+   check("Programs with variables aren't cached", program.isCached==false);
+   
+   shunting.compile("2^10-24",program);
+   check("Constant program", program.evaluate()==1000 && program.isCached && program.evaluate()==1000);
+   shunting.compile("RND(10)",program);
+   program.evaluate();
+   check("RND isn't cached", program.isCached==false);
+   
+   shunting.compile("(A+B*2-C/3)^2+ABS(A-C)",program);
+   long int aABC [3] = {1,2,3};
+   program.evaluate(aABC);
+   const unsigned long int allocationsBefore = nAllocations;
+   long int total = 0;
+   for (int i=0;i<100000;++i)
+   {
+      aABC[0]=i%7;
+      total+=program.evaluate(aABC);
+   }
+   check("Evaluate doesn't allocate", nAllocations==allocationsBefore);
+   
+      // Timing.
+   const int N_EVALUATIONS = 200000;
+   const std::string expression = "(3+4*2)/(1+5)^2+ABS(-7)*3";
+   Timer timer;
+   timer.init();
+   timer.start();
+   long int legacyTotal = 0;
+   for (int i=0;i<N_EVALUATIONS;++i)
+   { legacyTotal+=legacyEvaluate(shunting,expression); }
+   timer.update();
+   const double legacySeconds = timer.fullSeconds;
+   
+   shunting.compile("(3+4*2)/(1+X)^2+ABS(-7)*3",program); // variable so it isn't cached
+   long int x = 5;
+   timer.init();
+   timer.start();
+   long int compiledTotal = 0;
+   for (int i=0;i<N_EVALUATIONS;++i)
+   { compiledTotal+=program.evaluate(&x); }
+   timer.update();
+   const double compiledSeconds = timer.fullSeconds;
+   
+   check("Timed results match", legacyTotal==compiledTotal);
+   std::cout<<N_EVALUATIONS<<" evaluations. shunt()+evaluate(): "<<legacySeconds<<"s. Compiled: "<<compiledSeconds<<"s.\n";
+   
+   std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+   return nFailed==0 ? 0 : 1;
+}
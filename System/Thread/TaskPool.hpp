@@ -0,0 +1,465 @@
+#pragma once
+#ifndef WILDCAT_SYSTEM_THREAD_TASK_POOL_HPP
+#define WILDCAT_SYSTEM_THREAD_TASK_POOL_HPP
+
+/* Wildcat: TaskPool
+#include <System/Thread/TaskPool.hpp>
+
+   A persistent pool of worker threads which run tasks, so world generation, texture loading and pathing can share
+   one set of threads instead of each starting their own.
+
+   Each worker has its own queue. A worker runs its newest task first, and when its queue is empty it steals the
+   oldest task from another worker. Tasks spawned by a task stay on the same thread while idle threads still find
+   work.
+
+   submit() returns a TaskHandle, which can be waited on and gives the task's return value. A task can be given a
+   list of tasks it depends on, and won't start until they have all finished. A thread which waits for a task runs
+   queued tasks in the meantime, so tasks can wait on other tasks without using up the pool.
+
+   parallelFor() splits a range into chunks and runs them on the pool, with the calling thread helping. The chunks
+   only depend on the range and grain size, not on the number of threads.
+
+   Deterministic mode runs every task on the calling thread when it is submitted, and parallelFor() runs its chunks
+   in order. Use it for generation which must be reproducible bit for bit.
+
+   Threads are only used if WILDCAT_THREADING is defined, otherwise every task runs when it is submitted. With a
+   single thread, tasks also run when submitted.
+
+   Usage:
+
+   TaskPool pool; // 1 thread per core, including the thread which waits
+   TaskHandle <int> a = pool.submit([]() { return 1; });
+   TaskHandle <int> b = pool.submit([]() { return 2; });
+   TaskHandle <int> sum = pool.submit([a,b]() { return a.get()+b.get(); }, {a,b});
+   std::cout<<sum.get()<<"\n"; // waits for the result
+
+   pool.parallelFor(0,aHeight.nY,[&](const int y) { ... row y ... });
+   pool.parallelFor2D(aHeight.nX,aHeight.nY,64,64,[&](const int x, const int y, const int nX, const int nY) { ... tile ... });
+
+   Tasks must not throw exceptions.
+*/
+
+#include <System/Thread/Mutex.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#ifdef WILDCAT_THREADING
+   #include <chrono>
+   #include <condition_variable>
+   #include <deque>
+   #include <mutex>
+   #include <thread>
+#endif
+
+class TaskPool;
+
+// Shared state of a submitted task.
+class TaskPool_Node
+{
+   public:
+   TaskPool* pool;
+   std::function <void()> run;
+   std::atomic <int> nWaiting; // unfinished dependencies, plus 1 until the task is submitted
+   std::atomic <bool> done;
+
+   Mutex mutex; // guards vContinuation and done
+   std::vector <std::shared_ptr<TaskPool_Node> > vContinuation; // tasks which depend on this one
+
+   TaskPool_Node(TaskPool* _pool): pool(_pool), nWaiting(1), done(false)
+   {
+   }
+};
+
+// Untyped handle, used for lists of dependencies.
+class Task
+{
+   public:
+   std::shared_ptr <TaskPool_Node> node;
+
+   inline bool isDone() const
+   { return node==0 || node->done; }
+
+   // Wait for the task to finish, running other tasks in the meantime.
+   void wait() const;
+};
+
+template <class T>
+class TaskHandle: public Task
+{
+   public:
+   std::shared_ptr <std::unique_ptr<T> > value;
+
+   // Wait for the task and return its result.
+   T& get() const
+   {
+      wait();
+      return **value;
+   }
+};
+
+template <>
+class TaskHandle <void>: public Task
+{
+   public:
+   void get() const
+   { wait(); }
+};
+
+// Wraps a function so its result is stored in the handle.
+template <class T>
+class TaskPool_Result
+{
+   public:
+   template <class F>
+   static TaskHandle <T> bind(F& _function, const std::shared_ptr<TaskPool_Node>& _node)
+   {
+      TaskHandle <T> handle;
+      handle.node=_node;
+      handle.value=std::make_shared<std::unique_ptr<T> >();
+      std::shared_ptr <std::unique_ptr<T> > value = handle.value;
+      _node->run = [_function,value]() mutable { value->reset(new T(_function())); };
+      return handle;
+   }
+};
+
+template <>
+class TaskPool_Result <void>
+{
+   public:
+   template <class F>
+   static TaskHandle <void> bind(F& _function, const std::shared_ptr<TaskPool_Node>& _node)
+   {
+      TaskHandle <void> handle;
+      handle.node=_node;
+      _node->run=_function;
+      return handle;
+   }
+};
+
+class TaskPool
+{
+   private:
+
+   bool deterministic;
+   int nWorkers;
+
+#ifdef WILDCAT_THREADING
+   class Queue
+   {
+      public:
+      std::mutex mutex;
+      std::deque <std::shared_ptr<TaskPool_Node> > dTask;
+   };
+
+   std::vector <std::thread> vThread;
+   std::unique_ptr <Queue[]> aQueue; // 1 per worker
+   std::atomic <int> nQueued;
+   std::atomic <unsigned int> nextQueue; // round robin for tasks submitted from outside the pool
+   std::atomic <int> nSleepingWaiters;
+   bool stopping;
+
+   std::mutex sleepMutex;
+   std::condition_variable workCondition; // workers sleep until there is a task
+   std::condition_variable doneCondition; // waiting threads sleep until a task finishes
+
+   // Which pool and worker the current thread belongs to.
+   static TaskPool*& threadPool()
+   {
+      static thread_local TaskPool* pool = 0;
+      return pool;
+   }
+   static int& threadIndex()
+   {
+      static thread_local int index = 0;
+      return index;
+   }
+
+   void schedule(const std::shared_ptr<TaskPool_Node>& _node)
+   {
+      const int index = threadPool()==this ? threadIndex() : nextQueue++ % nWorkers;
+      {
+         std::lock_guard <std::mutex> lock (aQueue[index].mutex);
+         aQueue[index].dTask.push_back(_node);
+      }
+      ++nQueued;
+      {
+         std::lock_guard <std::mutex> lock (sleepMutex);
+      }
+      workCondition.notify_one();
+   }
+
+   // Take a task from this worker's queue, or steal one from another worker. Returns 0 if there are none.
+   std::shared_ptr<TaskPool_Node> take()
+   {
+      if ( nQueued<=0 )
+      { return 0; }
+
+      const int own = threadPool()==this ? threadIndex() : -1;
+      if ( own>=0 )
+      {
+         std::lock_guard <std::mutex> lock (aQueue[own].mutex);
+         if ( aQueue[own].dTask.empty()==false )
+         {
+            std::shared_ptr<TaskPool_Node> node = aQueue[own].dTask.back();
+            aQueue[own].dTask.pop_back();
+            --nQueued;
+            return node;
+         }
+      }
+      for (int i=1;i<=nWorkers;++i)
+      {
+         Queue& queue = aQueue[(own+i+nWorkers)%nWorkers];
+         std::lock_guard <std::mutex> lock (queue.mutex);
+         if ( queue.dTask.empty()==false )
+         {
+            std::shared_ptr<TaskPool_Node> node = queue.dTask.front();
+            queue.dTask.pop_front();
+            --nQueued;
+            return node;
+         }
+      }
+      return 0;
+   }
+
+   void workerLoop(const int _index)
+   {
+      threadPool()=this;
+      threadIndex()=_index;
+      while ( true )
+      {
+         std::shared_ptr<TaskPool_Node> node = take();
+         if ( node )
+         {
+            execute(node);
+            continue;
+         }
+         std::unique_lock <std::mutex> lock (sleepMutex);
+         workCondition.wait(lock, [this]() { return stopping || nQueued>0; });
+         if ( stopping && nQueued<=0 )
+         { return; }
+      }
+   }
+#endif
+
+   inline bool runsInline() const
+   { return deterministic || nWorkers==0; }
+
+   // Run a task whose dependencies have finished.
+   void start(const std::shared_ptr<TaskPool_Node>& _node)
+   {
+#ifdef WILDCAT_THREADING
+      if ( runsInline()==false )
+      {
+         schedule(_node);
+         return;
+      }
+#endif
+      execute(_node);
+   }
+
+   void execute(const std::shared_ptr<TaskPool_Node>& _node)
+   {
+      _node->run();
+      _node->run=nullptr; // free anything the function captured
+
+      std::vector <std::shared_ptr<TaskPool_Node> > vContinuation;
+      _node->mutex.lock();
+      _node->done=true;
+      vContinuation.swap(_node->vContinuation);
+      _node->mutex.unlock();
+
+      for (unsigned int i=0;i<vContinuation.size();++i)
+      {
+         if ( --vContinuation[i]->nWaiting==0 )
+         { start(vContinuation[i]); }
+      }
+
+#ifdef WILDCAT_THREADING
+      if ( nSleepingWaiters>0 )
+      {
+         {
+            std::lock_guard <std::mutex> lock (sleepMutex);
+         }
+         doneCondition.notify_all();
+      }
+#endif
+   }
+
+   public:
+
+   // _nThreads includes the thread which waits for tasks. 0 is 1 per core.
+   TaskPool(int _nThreads=0)
+   {
+      deterministic=false;
+      nWorkers=0;
+
+#ifdef WILDCAT_THREADING
+      nQueued=0;
+      nextQueue=0;
+      nSleepingWaiters=0;
+      stopping=false;
+
+      if ( _nThreads<=0 )
+      { _nThreads = std::thread::hardware_concurrency(); }
+      nWorkers = std::max(0,_nThreads-1);
+      if ( nWorkers>0 )
+      {
+         aQueue.reset(new Queue [nWorkers]);
+         for (int i=0;i<nWorkers;++i)
+         { vThread.emplace_back(&TaskPool::workerLoop,this,i); }
+      }
+#endif
+   }
+
+   // Finishes every queued task before returning.
+   ~TaskPool()
+   {
+#ifdef WILDCAT_THREADING
+      {
+         std::lock_guard <std::mutex> lock (sleepMutex);
+         stopping=true;
+      }
+      workCondition.notify_all();
+      for (unsigned int i=0;i<vThread.size();++i)
+      { vThread[i].join(); }
+#endif
+   }
+
+   // Number of threads including the calling thread.
+   inline int nThreads() const
+   { return nWorkers+1; }
+
+   // Run tasks in order on the submitting thread. Set it while no tasks are running.
+   void setDeterministic(const bool _deterministic)
+   { deterministic=_deterministic; }
+
+   inline bool isDeterministic() const
+   { return deterministic; }
+
+   // Run _function on the pool once every task in _vDependency has finished.
+   template <class F>
+   TaskHandle <typename std::result_of<F()>::type> submit(F _function, const std::vector<Task>& _vDependency = std::vector<Task>())
+   {
+      typedef typename std::result_of<F()>::type Result;
+      std::shared_ptr<TaskPool_Node> node = std::make_shared<TaskPool_Node>(this);
+      TaskHandle <Result> handle = TaskPool_Result<Result>::bind(_function,node);
+
+      for (unsigned int i=0;i<_vDependency.size();++i)
+      {
+         TaskPool_Node* dependency = _vDependency[i].node.get();
+         if ( dependency==0 )
+         { continue; }
+         if ( deterministic )
+         { wait(_vDependency[i]); }
+
+         dependency->mutex.lock();
+         if ( dependency->done==false )
+         {
+            ++node->nWaiting;
+            dependency->vContinuation.push_back(node);
+         }
+         dependency->mutex.unlock();
+      }
+
+      if ( --node->nWaiting==0 )
+      { start(node); }
+      return handle;
+   }
+
+   // Wait for a task, running other tasks in the meantime.
+   void wait(const Task& _task)
+   {
+#ifdef WILDCAT_THREADING
+      while ( _task.isDone()==false )
+      {
+         std::shared_ptr<TaskPool_Node> node = take();
+         if ( node )
+         {
+            execute(node);
+            continue;
+         }
+         // The task is running on another thread, or waiting for one that is.
+         std::unique_lock <std::mutex> lock (sleepMutex);
+         ++nSleepingWaiters;
+         doneCondition.wait_for(lock, std::chrono::milliseconds(1), [this,&_task]() { return _task.isDone() || nQueued>0; });
+         --nSleepingWaiters;
+      }
+#endif
+   }
+
+   void wait(const std::vector<Task>& _vTask)
+   {
+      for (unsigned int i=0;i<_vTask.size();++i)
+      { wait(_vTask[i]); }
+   }
+
+   // Call _function(i) for every i from _begin up to but not including _end, in chunks of _grain indexes. A grain of
+   // 0 splits the range into about 256 chunks.
+   template <class F>
+   void parallelFor(const int _begin, const int _end, F _function, int _grain=0)
+   {
+      if ( _end<=_begin )
+      { return; }
+      const int n = _end-_begin;
+      if ( _grain<=0 )
+      { _grain = (n+255)/256; }
+      const int nChunks = (n+_grain-1)/_grain;
+
+      auto runChunk = [&](const int _chunk)
+      {
+         const int chunkEnd = std::min(_end, _begin+(_chunk+1)*_grain);
+         for (int i=_begin+_chunk*_grain;i<chunkEnd;++i)
+         { _function(i); }
+      };
+
+      if ( runsInline() || nChunks==1 )
+      {
+         for (int i=0;i<nChunks;++i)
+         { runChunk(i); }
+         return;
+      }
+
+      // Each helper takes chunks until there are none left.
+      std::atomic <int> nextChunk (0);
+      auto helper = [&]()
+      {
+         for (int i=nextChunk++; i<nChunks; i=nextChunk++)
+         { runChunk(i); }
+      };
+      std::vector <Task> vHelper;
+      for (int i=0;i<std::min(nWorkers,nChunks-1);++i)
+      { vHelper.push_back(submit(helper)); }
+      helper();
+      wait(vHelper);
+   }
+
+   // Call _function(x, y, nX, nY) for each tile of a _nX by _nY area, where x,y is the tile's corner and nX,nY is
+   // its size. Tiles on the far edges may be smaller than _tileX by _tileY.
+   template <class F>
+   void parallelFor2D(const int _nX, const int _nY, const int _tileX, const int _tileY, F _function)
+   {
+      if ( _nX<=0 || _nY<=0 || _tileX<=0 || _tileY<=0 )
+      { return; }
+      const int nTilesX = (_nX+_tileX-1)/_tileX;
+      const int nTilesY = (_nY+_tileY-1)/_tileY;
+      parallelFor(0, nTilesX*nTilesY, [&](const int _tile)
+      {
+         const int x = (_tile%nTilesX)*_tileX;
+         const int y = (_tile/nTilesX)*_tileY;
+         _function(x, y, std::min(_tileX,_nX-x), std::min(_tileY,_nY-y));
+      }, 1);
+   }
+};
+
+inline void Task::wait() const
+{
+   if ( node )
+   { node->pool->wait(*this); }
+}
+
+#endif
@@ -0,0 +1,164 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <System/Thread/TaskPool.hpp>
+#include <System/Time/Timer.hpp>
+#include <Container/ArrayS2/ArrayS2.hpp>
+
+#ifdef WILDCAT_THREADING
+   #include <thread>
+#endif
+
+// g++ TaskPool_Test.cpp -I %WILDCAT%/ -O2 -D WILDCAT_LINUX -D WILDCAT_THREADING -pthread
+
+// Test of TaskPool. Checks results, dependencies, nested waits, parallelFor coverage and deterministic mode, then
+// compares running many small jobs on the pool with starting a thread for each job.
+
+const int N_JOBS = 2000;
+
+int nFailed = 0;
+
+void check(const std::string name, const bool passed)
+{
+   std::cout<<(passed ? "PASS: " : "FAIL: ")<<name<<"\n";
+   if ( passed==false ) { ++nFailed; }
+}
+
+// Naive recursive sum, which spawns a task for each half.
+long int sumRange(TaskPool& pool, const int begin, const int end)
+{
+   if ( end-begin < 1000 )
+   {
+      long int total = 0;
+      for (int i=begin;i<end;++i) { total+=i; }
+      return total;
+   }
+   const int middle = (begin+end)/2;
+   TaskHandle <long int> left = pool.submit([&pool,begin,middle]() { return sumRange(pool,begin,middle); });
+   const long int right = sumRange(pool,middle,end);
+   return left.get()+right;
+}
+
+// Order-dependent hash, to tell if tasks ran in a different order.
+void mixInto(unsigned long int& hash, const int value)
+{ hash = hash*31+value; }
+
+int main (int nArgs, char ** arg)
+{
+   TaskPool pool (4);
+   std::cout<<"Pool has "<<pool.nThreads()<<" threads.\n";
+
+   TaskHandle <int> a = pool.submit([]() { return 20; });
+   TaskHandle <int> b = pool.submit([]() { return 22; });
+   TaskHandle <int> sum = pool.submit([a,b]() { return a.get()+b.get(); }, {a,b});
+   check("Task results", sum.get()==42);
+
+   TaskHandle <std::string> text = pool.submit([]() { return std::string("pool"); });
+   check("Non-trivial result type", text.get()=="pool");
+
+   // A chain where each task appends to a shared list. Dependencies must keep the order.
+   std::vector <int> vOrder;
+   Task previous;
+   for (int i=0;i<100;++i)
+   { previous = pool.submit([&vOrder,i]() { vOrder.push_back(i); }, {previous}); }
+   previous.wait();
+   bool inOrder = vOrder.size()==100;
+   for (unsigned int i=0;inOrder && i<vOrder.size();++i)
+   { inOrder = vOrder[i]==(int)i; }
+   check("Dependency chain runs in order", inOrder);
+
+   // Diamond: d depends on b and c, which both depend on a.
+   std::atomic <int> stage (0);
+   std::atomic <bool> diamondOrder (true);
+   Task dA = pool.submit([&]() { stage=1; });
+   Task dB = pool.submit([&]() { if ( stage<1 ) { diamondOrder=false; } }, {dA});
+   Task dC = pool.submit([&]() { if ( stage<1 ) { diamondOrder=false; } }, {dA});
+   Task dD = pool.submit([&]() { if ( dB.isDone()==false || dC.isDone()==false ) { diamondOrder=false; } stage=2; }, {dB,dC});
+   dD.wait();
+   check("Diamond dependencies", diamondOrder && stage==2);
+
+   // Depending on a task which has already finished.
+   Task late = pool.submit([]() {}, {dA});
+   late.wait();
+   check("Dependency which already finished", late.isDone());
+
+   check("Nested tasks which wait on each other", sumRange(pool,0,1000000)==499999500000L);
+
+   // parallelFor should visit every index exactly once.
+   std::vector <std::atomic <int> > vVisit (100003);
+   for (unsigned int i=0;i<vVisit.size();++i) { vVisit[i]=0; }
+   pool.parallelFor(0,vVisit.size(),[&](const int i) { ++vVisit[i]; });
+   bool visitedOnce = true;
+   for (unsigned int i=0;visitedOnce && i<vVisit.size();++i)
+   { visitedOnce = vVisit[i]==1; }
+   check("parallelFor visits each index once", visitedOnce);
+
+   pool.parallelFor(5,5,[&](const int i) { visitedOnce=false; });
+   check("Empty parallelFor", visitedOnce);
+
+   // parallelFor2D over an array with a size which isn't a multiple of the tile size.
+   ArrayS2 <int> aTile (1000,777,0);
+   pool.parallelFor2D(aTile.nX,aTile.nY,64,64,[&](const int x, const int y, const int nX, const int nY)
+   {
+      for (int _x=x;_x<x+nX;++_x)
+      {
+         for (int _y=y;_y<y+nY;++_y)
+         { aTile(_x,_y)+=1; }
+      }
+   });
+   bool tiledOnce = true;
+   for (int i=0;tiledOnce && i<1000*777;++i)
+   { tiledOnce = aTile.data[i]==1; }
+   check("parallelFor2D covers each tile once", tiledOnce);
+
+   // Deterministic mode runs tasks and chunks in order, so order-dependent results repeat.
+   pool.setDeterministic(true);
+   unsigned long int hash1 = 0;
+   unsigned long int hash2 = 0;
+   for (int i=0;i<50;++i)
+   { pool.submit([&hash1,i]() { mixInto(hash1,i); }); }
+   pool.parallelFor(0,10000,[&](const int i) { mixInto(hash1,i); });
+   for (int i=0;i<50;++i)
+   { mixInto(hash2,i); }
+   for (int i=0;i<10000;++i)
+   { mixInto(hash2,i); }
+   check("Deterministic mode runs in order", hash1==hash2);
+   pool.setDeterministic(false);
+
+   // Many small jobs: on the pool, and with a thread started for each one.
+   std::atomic <long int> total (0);
+   Timer timer;
+   timer.init();
+   timer.start();
+   std::vector <Task> vJob;
+   for (int i=0;i<N_JOBS;++i)
+   { vJob.push_back(pool.submit([&total,i]() { total+=i; })); }
+   pool.wait(vJob);
+   timer.update();
+   const double poolSeconds = timer.fullSeconds;
+   check("Pool jobs", total==(long int)N_JOBS*(N_JOBS-1)/2);
+   std::cout<<N_JOBS<<" small jobs on the pool: "<<poolSeconds<<"s.\n";
+
+#ifdef WILDCAT_THREADING
+   total=0;
+   timer.init();
+   timer.start();
+   std::vector <std::thread> vThread;
+   for (int i=0;i<N_JOBS;++i)
+   {
+      vThread.emplace_back([&total,i]() { total+=i; });
+      if ( vThread.size()==4 )
+      {
+         for (auto& thread: vThread) { thread.join(); }
+         vThread.clear();
+      }
+   }
+   for (auto& thread: vThread) { thread.join(); }
+   timer.update();
+   std::cout<<N_JOBS<<" small jobs with a thread per job: "<<timer.fullSeconds<<"s.\n";
+#endif
+
+   std::cout<<(nFailed==0 ? "All tests passed.\n" : "Some tests failed.\n");
+   return nFailed==0 ? 0 : 1;
+}
@@ -99,7 +99,8 @@ class ThreadLock
 
 
 
-/* Container for threads. */
+/* Container for threads. Starts a new thread for every function, so TaskPool (System/Thread/TaskPool.hpp) should
+be used for jobs instead. */
 class ThreadManager
 {
 	public: